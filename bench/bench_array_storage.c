@@ -0,0 +1,216 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+
+// Parses a large array of numbers & small objects with boxed & inline array storage,
+// timing parsing + freeing and summing over all values of the parsed arrays.
+// Inline arrays hold their values one after another, so iterating them doesn't chase pointers.
+
+#define COUNT 200000
+#define RUNS 10
+#define SUM_RUNS 50
+#define SCATTER_COUNT 50000
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Generates array of numbers.
+// Returned string must be freed once done.
+static char* generate_numbers(size_t* length)
+{
+    size_t size = COUNT * 16 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[");
+
+    for (int i = 0; i < COUNT; i++)
+        pos += sprintf(json + pos, "%d.%d%s", i, i % 10, (i == COUNT - 1) ? "" : ",");
+
+    pos += sprintf(json + pos, "]");
+
+    *length = pos;
+    return json;
+}
+
+// Generates array of small arrays of numbers.
+// Returned string must be freed once done.
+static char* generate_points(size_t* length)
+{
+    size_t size = COUNT * 32 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[");
+
+    for (int i = 0; i < COUNT; i++)
+        pos += sprintf(json + pos, "[%d,%d,%d]%s", i, i * 2, i % 7, (i == COUNT - 1) ? "" : ",");
+
+    pos += sprintf(json + pos, "]");
+
+    *length = pos;
+    return json;
+}
+
+// Sums all numbers in json value, recursing into arrays.
+static double sum_numbers(struct ki_json_val* val)
+{
+    if (val->type == KI_JSON_VAL_NUMBER)
+        return val->value.number;
+
+    if (val->type != KI_JSON_VAL_ARRAY)
+        return 0.0;
+
+    double sum = 0.0;
+    struct ki_json_array* array = &val->value.array;
+
+    for (size_t i = 0; i < array->count; i++)
+        sum += (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS) ? ki_json_array_number_at(array, i) : sum_numbers(ki_json_array_at(array, i));
+
+    return sum;
+}
+
+// Prints throughput of parsing + freeing and of iterating document using given array storage.
+// Returns true on success, false on fail.
+static bool bench_document(const char* name, const char* json, size_t length, enum ki_json_array_storage storage)
+{
+    struct ki_json_parser_options options = ki_json_parser_options_default();
+    options.array_storage = storage;
+
+    struct ki_json_parser* parser = ki_json_parser_create(&options);
+
+    if (parser == NULL)
+        return false;
+
+    struct ki_json_parser_err err = {0};
+    struct ki_json_val* val = NULL;
+
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        val = ki_json_parser_parse(parser, json, length, &err);
+
+        if (val == NULL)
+        {
+            printf("failed to parse: %s\n", ki_json_err_get_message(err.type));
+            ki_json_parser_free(parser);
+            return false;
+        }
+
+        ki_json_val_free(val);
+    }
+
+    double parse_time = now_seconds() - start;
+
+    val = ki_json_parser_parse(parser, json, length, &err);
+    ki_json_parser_free(parser);
+
+    if (val == NULL)
+        return false;
+
+    double sum = 0.0;
+    start = now_seconds();
+
+    for (int run = 0; run < SUM_RUNS; run++)
+        sum += sum_numbers(val);
+
+    double sum_time = now_seconds() - start;
+
+    ki_json_val_free(val);
+
+    printf("%-8s %-8s %10.1f %12.1f %16.0f\n", name, (storage == KI_JSON_ARRAY_STORAGE_INLINE) ? "inline" : "boxed",
+        (double)length * RUNS / (1024.0 * 1024.0) / parse_time, (double)COUNT * SUM_RUNS / 1e6 / sum_time, sum);
+
+    return true;
+}
+
+// Prints throughput of iterating array of numbers inserted at scattered indices using given array storage,
+// like arrays that were edited over time. Boxed values end up in a different order than they're in memory.
+// Returns true on success, false on fail.
+static bool bench_scattered(enum ki_json_array_storage storage)
+{
+    struct ki_json_val* val = ki_json_val_create_array(0);
+
+    if (val == NULL || !ki_json_array_set_storage(&val->value.array, storage))
+    {
+        ki_json_val_free(val);
+        return false;
+    }
+
+    struct ki_json_array* array = &val->value.array;
+
+    for (size_t i = 0; i < SCATTER_COUNT; i++)
+    {
+        if (ki_json_array_insert_new_number(array, (i * 7919) % (array->count + 1), (double)i) == NULL)
+        {
+            ki_json_val_free(val);
+            return false;
+        }
+    }
+
+    double sum = 0.0;
+    double start = now_seconds();
+
+    for (int run = 0; run < SUM_RUNS; run++)
+        sum += sum_numbers(val);
+
+    double sum_time = now_seconds() - start;
+
+    ki_json_val_free(val);
+
+    printf("%-8s %-8s %10s %12.1f %16.0f\n", "scatter", (storage == KI_JSON_ARRAY_STORAGE_INLINE) ? "inline" : "boxed",
+        "-", (double)SCATTER_COUNT * SUM_RUNS / 1e6 / sum_time, sum);
+
+    return true;
+}
+
+int main(void)
+{
+    printf("%-8s %-8s %10s %12s %16s\n", "document", "storage", "parse MB/s", "iter M/s", "checksum");
+
+    char* (*generators[])(size_t*) = { generate_numbers, generate_points };
+    const char* names[] = { "numbers", "points" };
+
+    for (int i = 0; i < 2; i++)
+    {
+        size_t length = 0;
+        char* json = generators[i](&length);
+
+        if (json == NULL
+            || !bench_document(names[i], json, length, KI_JSON_ARRAY_STORAGE_BOXED)
+            || !bench_document(names[i], json, length, KI_JSON_ARRAY_STORAGE_INLINE))
+        {
+            printf("failed to bench %s\n", names[i]);
+            free(json);
+            return 1;
+        }
+
+        free(json);
+    }
+
+    if (!bench_scattered(KI_JSON_ARRAY_STORAGE_BOXED) || !bench_scattered(KI_JSON_ARRAY_STORAGE_INLINE))
+    {
+        printf("failed to bench scatter\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+
+// Builds arrays of numbers & of strings one value at a time and in bulk,
+// timing building + freeing them.
+
+#define COUNT 100000
+#define RUNS 50
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+static double numbers[COUNT];
+static const char* strings[COUNT];
+
+// Adds all numbers one at a time.
+static bool build_numbers_one_by_one(struct ki_json_array* array)
+{
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        if (ki_json_array_add_new_number(array, numbers[i]) == NULL)
+            return false;
+    }
+
+    return true;
+}
+
+// Adds all numbers in one go.
+static bool build_numbers_bulk(struct ki_json_array* array)
+{
+    return ki_json_array_add_numbers(array, numbers, COUNT) == KI_JSON_ERR_NONE;
+}
+
+// Adds all strings one at a time.
+static bool build_strings_one_by_one(struct ki_json_array* array)
+{
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        if (ki_json_array_add_new_string(array, strings[i]) == NULL)
+            return false;
+    }
+
+    return true;
+}
+
+// Adds all strings in one go.
+static bool build_strings_bulk(struct ki_json_array* array)
+{
+    return ki_json_array_add_strings(array, strings, COUNT) == KI_JSON_ERR_NONE;
+}
+
+// Prints values per second of building arrays using build & freeing them.
+// Returns true on success, false on fail.
+static bool bench_build(const char* name, bool (*build)(struct ki_json_array*))
+{
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        struct ki_json_val* val = ki_json_val_create_array(0);
+
+        if (val == NULL || !build(&val->value.array))
+        {
+            ki_json_val_free(val);
+            return false;
+        }
+
+        ki_json_val_free(val);
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-22s %12.1f\n", name, (double)COUNT * RUNS / 1e6 / time);
+
+    return true;
+}
+
+int main(void)
+{
+    static char string_data[COUNT][16];
+
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        numbers[i] = (double)i * 0.25;
+        snprintf(string_data[i], sizeof(string_data[i]), "item-%zu", i);
+        strings[i] = string_data[i];
+    }
+
+    printf("%-22s %12s\n", "build", "M values/s");
+
+    if (!bench_build("numbers one by one", build_numbers_one_by_one)
+        || !bench_build("numbers bulk", build_numbers_bulk)
+        || !bench_build("strings one by one", build_strings_one_by_one)
+        || !bench_build("strings bulk", build_strings_bulk))
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
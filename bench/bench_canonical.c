@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+#include "ki_json/json_generator.h"
+
+// Generates a document of records with many names added out of order, as plain json, as canonical json the first time
+// (sorting every object), again (with the order of big objects cached) & written piece by piece into a digest.
+
+#define RECORDS 20000
+#define FIELDS 32
+#define RUNS 5
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns document with RECORDS records of FIELDS fields & a few small objects each.
+// Returns NULL on fail.
+static struct ki_json_val* build_document(void)
+{
+    struct ki_json_parser_err err;
+    struct ki_json_val* doc = ki_json_parse_string("[]", &err);
+
+    for (int i = 0; doc != NULL && i < RECORDS; i++)
+    {
+        char string[4096];
+        size_t length = (size_t)sprintf(string, "{\"user\":{\"name\":\"user %d\",\"id\":%d,\"active\":%s},\"score\":%d.125", i, i, (i % 2) ? "true" : "false", i);
+
+        //names out of order, so every object has to be sorted
+        for (int field = FIELDS - 1; field >= 0; field--)
+            length += (size_t)sprintf(string + length, ",\"field_%02d\":%d.%d", (field * 7) % FIELDS, field, i % 10);
+
+        strcpy(string + length, "}");
+
+        struct ki_json_val* record = ki_json_parse_string(string, &err);
+
+        if (record == NULL || ki_json_array_add(&doc->value.array, record) != KI_JSON_ERR_NONE)
+        {
+            ki_json_val_free(record);
+            ki_json_val_free(doc);
+            return NULL;
+        }
+    }
+
+    return doc;
+}
+
+// Stand-in for a digest like SHA-256, FNV-1a over everything written to it.
+static bool digest_write(const char* bytes, size_t length, void* context)
+{
+    uint64_t* digest = context;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        *digest ^= (unsigned char)bytes[i];
+        *digest *= 1099511628211ULL;
+    }
+
+    return true;
+}
+
+// Prints ms per run of generating doc using gen, returns length of what was generated.
+static size_t bench_gen(const char* name, struct ki_json_val* doc, char* (*gen)(struct ki_json_val*), int runs)
+{
+    size_t length = 0;
+    double start = now_seconds();
+
+    for (int run = 0; run < runs; run++)
+    {
+        char* string = gen(doc);
+
+        if (string == NULL)
+            return 0;
+
+        length = strlen(string);
+        free(string);
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-28s %12zu %12.2f\n", name, length, time * 1000.0 / runs);
+
+    return length;
+}
+
+int main(void)
+{
+    struct ki_json_val* doc = build_document();
+    bool success = doc != NULL;
+
+    if (success)
+    {
+        printf("%-28s %12s %12s\n", "generate", "bytes", "ms");
+
+        success = bench_gen("plain", doc, ki_json_gen_string, RUNS) != 0;
+        success = success && bench_gen("canonical, sorting", doc, ki_json_gen_canonical, 1) != 0;
+
+        size_t length = bench_gen("canonical, cached order", doc, ki_json_gen_canonical, RUNS);
+        success = success && length != 0;
+
+        uint64_t digest = 14695981039346656037ULL;
+        struct ki_json_writer writer = { .write = digest_write, .context = &digest };
+        double start = now_seconds();
+
+        for (int run = 0; run < RUNS && success; run++)
+        {
+            digest = 14695981039346656037ULL;
+            success = ki_json_gen_canonical_write(doc, &writer);
+        }
+
+        double time = now_seconds() - start;
+
+        //same digest as hashing the whole string
+        char* string = ki_json_gen_canonical(doc);
+        uint64_t whole = 14695981039346656037ULL;
+
+        success = success && string != NULL && digest_write(string, length, &whole) && whole == digest;
+        free(string);
+
+        printf("%-28s %12zu %12.2f\n", "canonical, into digest", length, time * 1000.0 / RUNS);
+    }
+
+    ki_json_val_free(doc);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
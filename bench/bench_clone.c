@@ -0,0 +1,129 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+#include "ki_json/json_generator.h"
+
+// Copies a template document by generating & parsing it again and by cloning it,
+// timing copying + freeing the copies.
+
+#define ITEMS 200
+#define RUNS 2000
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns template document of ITEMS objects.
+// Returns NULL on fail.
+static struct ki_json_val* build_template(void)
+{
+    struct ki_json_val* root = ki_json_val_create_object(2);
+
+    if (root == NULL)
+        return NULL;
+
+    struct ki_json_val* items = ki_json_object_add_new_array(&root->value.object, "items", ITEMS);
+
+    if (items == NULL || ki_json_object_add_new_string(&root->value.object, "status", "ok") == NULL)
+    {
+        ki_json_val_free(root);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < ITEMS; i++)
+    {
+        struct ki_json_val* item = ki_json_array_add_new_object(&items->value.array, 4);
+
+        if (item == NULL
+            || ki_json_object_add_new_number(&item->value.object, "id", (double)i) == NULL
+            || ki_json_object_add_new_string(&item->value.object, "description", "a description too long to be stored inline") == NULL
+            || ki_json_object_add_new_bool(&item->value.object, "visible", true) == NULL
+            || ki_json_object_add_new_array(&item->value.object, "tags", 0) == NULL)
+        {
+            ki_json_val_free(root);
+            return NULL;
+        }
+    }
+
+    return root;
+}
+
+// Copies template by generating & parsing it.
+static struct ki_json_val* copy_reparse(struct ki_json_val* template)
+{
+    char* string = ki_json_gen_string(template);
+
+    if (string == NULL)
+        return NULL;
+
+    struct ki_json_parser_err err;
+    struct ki_json_val* copy = ki_json_parse_string(string, &err);
+
+    free(string);
+
+    return copy;
+}
+
+// Prints copies per second of copying template using copy & freeing the copies.
+// Returns true on success, false on fail.
+static bool bench_copy(const char* name, struct ki_json_val* template, struct ki_json_val* (*copy)(struct ki_json_val*))
+{
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        struct ki_json_val* val = copy(template);
+
+        if (val == NULL)
+            return false;
+
+        ki_json_val_free(val);
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-22s %12.1f\n", name, RUNS / 1e3 / time);
+
+    return true;
+}
+
+static struct ki_json_val* copy_clone(struct ki_json_val* template)
+{
+    return ki_json_val_clone(template);
+}
+
+int main(void)
+{
+    struct ki_json_val* template = build_template();
+
+    if (template == NULL)
+    {
+        printf("failed to build template\n");
+        return 1;
+    }
+
+    printf("%-22s %12s\n", "copy", "K copies/s");
+
+    bool success = bench_copy("generate + parse", template, copy_reparse)
+        && bench_copy("clone", template, copy_clone);
+
+    ki_json_val_free(template);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+#include "ki_json/json_generator.h"
+
+// Deduplicates an export repeating the same address & currency blocks in every order,
+// timing the pass & printing the memory it freed.
+// Also checks a tree holding a value, a share of it & copies of it, whose copies are replaced
+// after values inside of them were seen (build with KI_JSON_NODE_POOL off & a sanitizer to catch reuse of freed values).
+
+#define ORDERS 20000
+#define ADDRESSES 50
+// Value whose copies are deduplicated by the check, holding a nested object with a string too long to be inlined
+#define SHARED_COPY "{\"address\":{\"street\":\"A street name too long to be held inline\",\"zip\":[1,\"x\"]},\"id\":7}"
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns export of ORDERS orders, each with one of ADDRESSES addresses & one of 2 currencies.
+// Returns NULL on fail.
+static char* build_export(void)
+{
+    size_t capacity = (size_t)ORDERS * 320 + 64;
+    char* string = malloc(capacity);
+
+    if (string == NULL)
+        return NULL;
+
+    size_t length = (size_t)sprintf(string, "{\"orders\":[");
+
+    for (int i = 0; i < ORDERS; i++)
+    {
+        length += (size_t)sprintf(string + length,
+            "%s{\"id\":%d,\"address\":{\"street\":\"Long Street Name %d\",\"city\":\"Springfield\",\"country\":\"Somewhere Far Away\"},"
+            "\"currency\":{\"code\":\"%s\",\"digits\":2,\"name\":\"%s\"},\"paid\":true}",
+            (i > 0) ? "," : "", i, i % ADDRESSES, (i % 2) ? "EUR" : "USD", (i % 2) ? "Euro of the European Union" : "United States dollar");
+    }
+
+    strcpy(string + length, "]}");
+
+    return string;
+}
+
+// Deduplicates [X, share of X, copy of X, copy of X, [copy of X, copy of X]] & checks it still prints the same.
+// Returns true on success, false on fail.
+static bool check_shared_copies(void)
+{
+    struct ki_json_val* val = ki_json_parse_string("[" SHARED_COPY "," SHARED_COPY "," SHARED_COPY ",[" SHARED_COPY "," SHARED_COPY "]]", NULL);
+
+    if (val == NULL)
+        return false;
+
+    struct ki_json_val* shared = ki_json_val_share(ki_json_array_at(&val->value.array, 0));
+
+    if (shared == NULL || ki_json_array_insert(&val->value.array, shared, 1) != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(shared);
+        ki_json_val_free(val);
+        return false;
+    }
+
+    char* before = ki_json_gen_string(val);
+    bool success = before != NULL && ki_json_val_dedup(val, NULL);
+    char* after = success ? ki_json_gen_string(val) : NULL;
+
+    success = after != NULL && strcmp(before, after) == 0;
+
+    free(before);
+    free(after);
+    ki_json_val_free(val);
+
+    return success;
+}
+
+int main(void)
+{
+    if (!check_shared_copies())
+    {
+        printf("failed to dedup shared copies\n");
+        return 1;
+    }
+
+    char* string = build_export();
+
+    if (string == NULL)
+    {
+        printf("failed to build export\n");
+        return 1;
+    }
+
+    struct ki_json_parser_err err;
+    struct ki_json_val* val = ki_json_parse_string(string, &err);
+
+    free(string);
+
+    if (val == NULL)
+    {
+        printf("failed to parse export\n");
+        return 1;
+    }
+
+    struct ki_json_dedup_stats stats;
+    double start = now_seconds();
+    bool success = ki_json_val_dedup(val, &stats);
+    double time = now_seconds() - start;
+
+    ki_json_val_free(val);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    printf("%-22s %12.1f\n", "dedup ms", time * 1e3);
+    printf("%-22s %12zu\n", "values replaced", stats.values);
+    printf("%-22s %12.1f\n", "KiB freed", stats.bytes / 1024.0);
+
+    return 0;
+}
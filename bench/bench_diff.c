@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_generator.h"
+#include "ki_json/json_patch.h"
+
+// Diffs two versions of a document differing in a few items, timing diffing against generating the new version
+// and printing the size of the patch against the size of the new version.
+
+#define ITEMS 2000
+#define CHANGED_EVERY 500
+#define RUNS 200
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns version of document of ITEMS objects, the changed version hides every CHANGED_EVERY item & holds one more item.
+// Returns NULL on fail.
+static struct ki_json_val* build_version(bool changed)
+{
+    struct ki_json_val* root = ki_json_val_create_object(2);
+
+    if (root == NULL)
+        return NULL;
+
+    struct ki_json_val* items = ki_json_object_add_new_array(&root->value.object, "items", ITEMS + 1);
+
+    if (items == NULL || ki_json_object_add_new_string(&root->value.object, "status", "ok") == NULL)
+    {
+        ki_json_val_free(root);
+        return NULL;
+    }
+
+    size_t count = changed ? ITEMS + 1 : ITEMS;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        struct ki_json_val* item = ki_json_array_add_new_object(&items->value.array, 4);
+        bool visible = !changed || i % CHANGED_EVERY != 7;
+
+        if (item == NULL
+            || ki_json_object_add_new_number(&item->value.object, "id", (double)i) == NULL
+            || ki_json_object_add_new_string(&item->value.object, "description", "a description too long to be stored inline") == NULL
+            || ki_json_object_add_new_bool(&item->value.object, "visible", visible) == NULL
+            || ki_json_object_add_new_array(&item->value.object, "tags", 0) == NULL)
+        {
+            ki_json_val_free(root);
+            return NULL;
+        }
+    }
+
+    return root;
+}
+
+int main(void)
+{
+    struct ki_json_val* a = build_version(false);
+    struct ki_json_val* b = build_version(true);
+
+    if (a == NULL || b == NULL)
+    {
+        printf("failed to build versions\n");
+        ki_json_val_free(a);
+        ki_json_val_free(b);
+        return 1;
+    }
+
+    size_t patch_length = 0;
+    size_t full_length = 0;
+    bool success = true;
+
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS && success; run++)
+    {
+        struct ki_json_val* patch = ki_json_diff(a, b);
+        char* string = (patch != NULL) ? ki_json_gen_string(patch) : NULL;
+
+        success = string != NULL;
+        patch_length = success ? strlen(string) : 0;
+
+        free(string);
+        ki_json_val_free(patch);
+    }
+
+    double diff_time = now_seconds() - start;
+
+    start = now_seconds();
+
+    for (int run = 0; run < RUNS && success; run++)
+    {
+        char* string = ki_json_gen_string(b);
+
+        success = string != NULL;
+        full_length = success ? strlen(string) : 0;
+
+        free(string);
+    }
+
+    double full_time = now_seconds() - start;
+
+    ki_json_val_free(a);
+    ki_json_val_free(b);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    printf("%-22s %12s %12s\n", "send", "ms/run", "bytes");
+    printf("%-22s %12.3f %12zu\n", "diff + generate patch", diff_time * 1e3 / RUNS, patch_length);
+    printf("%-22s %12.3f %12zu\n", "generate full", full_time * 1e3 / RUNS, full_length);
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_generator.h"
+
+// Compares two equal documents by generating & comparing their strings and structurally,
+// timing comparing + hashing.
+
+#define ITEMS 200
+#define RUNS 2000
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns template document of ITEMS objects.
+// Returns NULL on fail.
+static struct ki_json_val* build_template(void)
+{
+    struct ki_json_val* root = ki_json_val_create_object(2);
+
+    if (root == NULL)
+        return NULL;
+
+    struct ki_json_val* items = ki_json_object_add_new_array(&root->value.object, "items", ITEMS);
+
+    if (items == NULL || ki_json_object_add_new_string(&root->value.object, "status", "ok") == NULL)
+    {
+        ki_json_val_free(root);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < ITEMS; i++)
+    {
+        struct ki_json_val* item = ki_json_array_add_new_object(&items->value.array, 4);
+
+        if (item == NULL
+            || ki_json_object_add_new_number(&item->value.object, "id", (double)i) == NULL
+            || ki_json_object_add_new_string(&item->value.object, "description", "a description too long to be stored inline") == NULL
+            || ki_json_object_add_new_bool(&item->value.object, "visible", true) == NULL
+            || ki_json_object_add_new_array(&item->value.object, "tags", 0) == NULL)
+        {
+            ki_json_val_free(root);
+            return NULL;
+        }
+    }
+
+    return root;
+}
+
+// Compares a & b by generating & comparing their strings.
+static bool equal_generate(struct ki_json_val* a, struct ki_json_val* b)
+{
+    char* string_a = ki_json_gen_string(a);
+    char* string_b = ki_json_gen_string(b);
+
+    bool equal = string_a != NULL && string_b != NULL && strcmp(string_a, string_b) == 0;
+
+    free(string_a);
+    free(string_b);
+
+    return equal;
+}
+
+// Compares a & b structurally.
+static bool equal_structural(struct ki_json_val* a, struct ki_json_val* b)
+{
+    return ki_json_val_equal(a, b);
+}
+
+// Compares a & b by their hashes, as a dedup cache would before comparing them.
+static bool equal_hash(struct ki_json_val* a, struct ki_json_val* b)
+{
+    return ki_json_val_hash(a) == ki_json_val_hash(b);
+}
+
+// Prints comparisons per second of comparing a & b using equal.
+// Returns true on success, false on fail.
+static bool bench_equal(const char* name, struct ki_json_val* a, struct ki_json_val* b, bool (*equal)(struct ki_json_val*, struct ki_json_val*))
+{
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        if (!equal(a, b))
+            return false;
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-22s %12.1f\n", name, RUNS / 1e3 / time);
+
+    return true;
+}
+
+int main(void)
+{
+    struct ki_json_val* a = build_template();
+    struct ki_json_val* b = build_template();
+
+    if (a == NULL || b == NULL)
+    {
+        printf("failed to build template\n");
+        ki_json_val_free(a);
+        ki_json_val_free(b);
+        return 1;
+    }
+
+    printf("%-22s %12s\n", "compare", "K compares/s");
+
+    bool success = bench_equal("generate + strcmp", a, b, equal_generate)
+        && bench_equal("equal", a, b, equal_structural)
+        && bench_equal("hash both", a, b, equal_hash);
+
+    ki_json_val_free(a);
+    ki_json_val_free(b);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+
+// Builds trees of objects & strings, timing freeing them on the calling thread
+// against handing them off to the background reclaimer.
+
+#define COUNT 100000
+#define RUNS 20
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns array of COUNT objects, each holding a few values.
+// Returns NULL on fail.
+static struct ki_json_val* build_tree(void)
+{
+    struct ki_json_val* root = ki_json_val_create_array(COUNT);
+
+    if (root == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < COUNT; i++)
+    {
+        struct ki_json_val* object = ki_json_array_add_new_object(&root->value.array, 4);
+
+        if (object == NULL
+            || ki_json_object_add_new_number(&object->value.object, "id", (double)i) == NULL
+            || ki_json_object_add_new_string(&object->value.object, "name", "a name too long to be stored inline") == NULL
+            || ki_json_object_add_new_bool(&object->value.object, "active", i % 2 == 0) == NULL)
+        {
+            ki_json_val_free(root);
+            return NULL;
+        }
+    }
+
+    return root;
+}
+
+// Prints milliseconds the calling thread spent freeing trees using free, on average.
+// Returns true on success, false on fail.
+static bool bench_free(const char* name, void (*free_tree)(struct ki_json_val*))
+{
+    double time = 0.0;
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        struct ki_json_val* root = build_tree();
+
+        if (root == NULL)
+            return false;
+
+        double start = now_seconds();
+        free_tree(root);
+        time += now_seconds() - start;
+
+        //don't let background freeing overlap with the next run
+        ki_json_reclaimer_flush();
+    }
+
+    printf("%-22s %12.3f\n", name, time * 1e3 / RUNS);
+
+    return true;
+}
+
+int main(void)
+{
+    printf("%-22s %12s\n", "free", "ms per tree");
+
+    if (!bench_free("inline", ki_json_val_free)
+        || !bench_free("background", ki_json_val_free_async))
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    ki_json_reclaimer_shutdown();
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+
+// Inserts numbers one at a time at the front & in the middle of arrays, with & without a gap buffer,
+// timing building + freeing them.
+
+#define COUNT 20000
+#define RUNS 20
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns index to insert i-th number at.
+typedef size_t (*position_fn)(size_t i);
+
+static size_t position_front(size_t i)
+{
+    (void)i;
+    return 0;
+}
+
+static size_t position_middle(size_t i)
+{
+    return i / 2;
+}
+
+// Prints values per second of inserting COUNT numbers at given positions & freeing them.
+// Returns true on success, false on fail.
+static bool bench_insert(const char* name, position_fn position, bool gap_buffer)
+{
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        struct ki_json_val* val = ki_json_val_create_array(0);
+
+        if (val == NULL)
+            return false;
+
+        ki_json_array_set_gap_buffer(&val->value.array, gap_buffer);
+
+        for (size_t i = 0; i < COUNT; i++)
+        {
+            struct ki_json_val* number = ki_json_val_create_from_number((double)i);
+
+            if (number == NULL || ki_json_array_insert(&val->value.array, number, position(i)) != KI_JSON_ERR_NONE)
+            {
+                ki_json_val_free(number);
+                ki_json_val_free(val);
+                return false;
+            }
+        }
+
+        ki_json_val_free(val);
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-22s %12.1f\n", name, (double)COUNT * RUNS / 1e6 / time);
+
+    return true;
+}
+
+int main(void)
+{
+    printf("%-22s %12s\n", "insert", "M values/s");
+
+    if (!bench_insert("front", position_front, false)
+        || !bench_insert("front gap buffer", position_front, true)
+        || !bench_insert("middle", position_middle, false)
+        || !bench_insert("middle gap buffer", position_middle, true))
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
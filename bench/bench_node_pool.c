@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "ki_json/json.h"
+
+// Builds & frees trees from several threads at once, once with pooled nodes (stdlib allocator)
+// and once with an allocator calling malloc for each node.
+
+#define TREES_PER_THREAD 2000
+#define ROWS_PER_TREE 64
+
+static void* plain_malloc(size_t size, void* context)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void* plain_realloc(void* ptr, size_t old_size, size_t new_size, void* context)
+{
+    (void)old_size;
+    (void)context;
+    return realloc(ptr, new_size);
+}
+
+static void plain_free(void* ptr, size_t size, void* context)
+{
+    (void)size;
+    (void)context;
+    free(ptr);
+}
+
+static const struct ki_json_allocator plain_allocator = {
+    .malloc = plain_malloc,
+    .realloc = plain_realloc,
+    .free = plain_free,
+    .context = NULL
+};
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Builds a request-like tree: an array of small objects.
+static struct ki_json_val* build_tree(const struct ki_json_allocator* allocator)
+{
+    struct ki_json_val* root = ki_json_val_create_array_with_allocator(ROWS_PER_TREE, allocator);
+
+    if (root == NULL)
+        return NULL;
+
+    for (int i = 0; i < ROWS_PER_TREE; i++)
+    {
+        struct ki_json_val* row = ki_json_array_add_new_object(&root->value.array, 4);
+
+        if (row == NULL)
+            continue;
+
+        ki_json_object_add_new_number(&row->value.object, "id", i);
+        ki_json_object_add_new_bool(&row->value.object, "active", i % 2 == 0);
+        ki_json_object_add_new_null(&row->value.object, "parent");
+        ki_json_object_add_new_number(&row->value.object, "score", i * 0.5);
+    }
+
+    return root;
+}
+
+static void* thread_main(void* data)
+{
+    const struct ki_json_allocator* allocator = data;
+
+    for (int i = 0; i < TREES_PER_THREAD; i++)
+        ki_json_val_free(build_tree(allocator));
+
+    return NULL;
+}
+
+// Runs thread_main on given amount of threads.
+// Returns time taken in seconds.
+static double run(int thread_count, const struct ki_json_allocator* allocator)
+{
+    pthread_t threads[64];
+
+    double start = now_seconds();
+
+    for (int i = 0; i < thread_count; i++)
+        pthread_create(&threads[i], NULL, thread_main, (void*)allocator);
+
+    for (int i = 0; i < thread_count; i++)
+        pthread_join(threads[i], NULL);
+
+    return now_seconds() - start;
+}
+
+int main(void)
+{
+    const int thread_counts[] = { 1, 2, 4, 8 };
+
+    printf("%d trees of %d objects per thread\n", TREES_PER_THREAD, ROWS_PER_TREE);
+    printf("%8s %14s %14s %8s\n", "threads", "malloc (s)", "pool (s)", "speedup");
+
+    for (size_t i = 0; i < sizeof(thread_counts) / sizeof(*thread_counts); i++)
+    {
+        double plain = run(thread_counts[i], &plain_allocator);
+        double pooled = run(thread_counts[i], ki_json_allocator_get_stdlib());
+
+        printf("%8d %14.4f %14.4f %7.2fx\n", thread_counts[i], plain, pooled, plain / pooled);
+    }
+
+    return 0;
+}
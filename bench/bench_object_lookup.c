@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+
+// Looks up random names in objects of growing size, once by scanning all names like objects
+// used to and once through ki_json_object_get(), which uses the hash index past KI_JSON_OBJECT_INDEX_THRESHOLD.
+
+#define LOOKUPS 200000
+// Scanning 100k names is slow, so scans are capped at this many names compared in total
+#define SCAN_BUDGET 500000000.0
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Looks up name by comparing it to every name in object.
+static struct ki_json_val* scan_object(struct ki_json_object* object, const char* name)
+{
+    for (size_t i = 0; i < object->count; i++)
+    {
+        if (strcmp(ki_json_object_name_at(object, i), name) == 0)
+            return ki_json_object_val_at(object, i);
+    }
+
+    return NULL;
+}
+
+// Times lookups of keys in object of given size, printing ns per lookup for both.
+// Returns true on success, false on fail.
+static bool bench_size(size_t size)
+{
+    struct ki_json_val* val = ki_json_val_create_object(size);
+    char (*names)[48] = malloc(sizeof(*names) * size);
+
+    if (val == NULL || names == NULL)
+    {
+        ki_json_val_free(val);
+        free(names);
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++)
+    {
+        snprintf(names[i], sizeof(names[i]), "route_%zu_handler", i);
+
+        if (ki_json_object_add_new_number(&val->value.object, names[i], (double)i) == NULL)
+        {
+            ki_json_val_free(val);
+            free(names);
+            return false;
+        }
+    }
+
+    //same random order for both
+    size_t* order = malloc(sizeof(*order) * LOOKUPS);
+
+    if (order == NULL)
+    {
+        ki_json_val_free(val);
+        free(names);
+        return false;
+    }
+
+    srand(42);
+
+    for (size_t i = 0; i < LOOKUPS; i++)
+        order[i] = (size_t)rand() % size;
+
+    size_t scan_lookups = LOOKUPS;
+
+    if ((double)scan_lookups * (double)size / 2.0 > SCAN_BUDGET)
+        scan_lookups = (size_t)(SCAN_BUDGET * 2.0 / (double)size);
+
+    double sum = 0.0;
+
+    double start = now_seconds();
+
+    for (size_t i = 0; i < scan_lookups; i++)
+        sum += scan_object(&val->value.object, names[order[i]])->value.number;
+
+    double scan_time = now_seconds() - start;
+
+    start = now_seconds();
+
+    for (size_t i = 0; i < LOOKUPS; i++)
+        sum += ki_json_object_get(&val->value.object, names[order[i]])->value.number;
+
+    double get_time = now_seconds() - start;
+
+    double scan_ns = scan_time * 1e9 / (double)scan_lookups;
+    double get_ns = get_time * 1e9 / (double)LOOKUPS;
+
+    printf("%8zu %12.1f %12.1f %8.1fx   (%.0f)\n", size, scan_ns, get_ns, scan_ns / get_ns, sum);
+
+    free(order);
+    free(names);
+    ki_json_val_free(val);
+
+    return true;
+}
+
+int main(void)
+{
+    const size_t sizes[] = { 4, 16, 64, 256, 1000, 10000, 100000 };
+
+    printf("%8s %12s %12s %9s\n", "keys", "scan ns", "get ns", "speedup");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        if (!bench_size(sizes[i]))
+        {
+            printf("failed to bench %zu keys\n", sizes[i]);
+            return 1;
+        }
+    }
+
+    return 0;
+}
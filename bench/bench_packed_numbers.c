@@ -0,0 +1,219 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+
+// Parses a flat time series & an array of coordinate pairs with & without packing arrays of numbers,
+// counting allocations & bytes held by the resulting tree and timing parse + free.
+// Also checks arrays of numbers parsed with the default options can still be read value by value.
+
+#define COUNT 500000
+#define RUNS 10
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Allocations made through counting_allocator
+struct counts
+{
+    size_t allocations;
+    size_t bytes;
+};
+
+static void* counting_malloc(size_t size, void* context)
+{
+    struct counts* counts = context;
+    counts->allocations++;
+    counts->bytes += size;
+    return malloc(size);
+}
+
+static void* counting_realloc(void* ptr, size_t old_size, size_t new_size, void* context)
+{
+    struct counts* counts = context;
+    counts->allocations += (ptr == NULL) ? 1 : 0;
+    counts->bytes += new_size - old_size;
+    return realloc(ptr, new_size);
+}
+
+static void counting_free(void* ptr, size_t size, void* context)
+{
+    struct counts* counts = context;
+    counts->allocations--;
+    counts->bytes -= size;
+    free(ptr);
+}
+
+// Generates flat array of samples.
+// Returned string must be freed once done.
+static char* generate_series(size_t* length)
+{
+    size_t size = COUNT * 16 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[");
+
+    for (int i = 0; i < COUNT; i++)
+        pos += sprintf(json + pos, "%d.%02d%s", i % 1000, i % 100, (i == COUNT - 1) ? "" : ",");
+
+    pos += sprintf(json + pos, "]");
+
+    *length = pos;
+    return json;
+}
+
+// Generates array of [x, y] coordinates.
+// Returned string must be freed once done.
+static char* generate_coordinates(size_t* length)
+{
+    size_t size = COUNT / 2 * 32 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[");
+
+    for (int i = 0; i < COUNT / 2; i++)
+        pos += sprintf(json + pos, "[%d.5,%d.25]%s", i % 180, i % 90, (i == COUNT / 2 - 1) ? "" : ",");
+
+    pos += sprintf(json + pos, "]");
+
+    *length = pos;
+    return json;
+}
+
+// Prints allocations & bytes held by parsed document, and throughput of parsing + freeing it.
+// Returns true on success, false on fail.
+static bool bench_document(const char* name, const char* json, size_t length, bool pack_numbers)
+{
+    struct counts counts = { 0, 0 };
+    struct ki_json_allocator allocator = {
+        .malloc = counting_malloc,
+        .realloc = counting_realloc,
+        .free = counting_free,
+        .context = &counts
+    };
+
+    struct ki_json_parser_options options = ki_json_parser_options_default();
+    options.pack_numbers = pack_numbers;
+    options.allocator = &allocator;
+
+    struct ki_json_parser* parser = ki_json_parser_create(&options);
+
+    if (parser == NULL)
+        return false;
+
+    struct ki_json_parser_err err = {0};
+    struct ki_json_val* val = ki_json_parser_parse(parser, json, length, &err);
+
+    if (val == NULL)
+    {
+        printf("failed to parse: %s\n", ki_json_err_get_message(err.type));
+        ki_json_parser_free(parser);
+        return false;
+    }
+
+    size_t allocations = counts.allocations;
+    size_t bytes = counts.bytes;
+
+    ki_json_val_free(val);
+
+    //default allocator, with pooled nodes
+    ki_json_parser_get_options(parser)->allocator = NULL;
+
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        val = ki_json_parser_parse(parser, json, length, &err);
+
+        if (val == NULL)
+        {
+            ki_json_parser_free(parser);
+            return false;
+        }
+
+        ki_json_val_free(val);
+    }
+
+    double time = now_seconds() - start;
+
+    ki_json_parser_free(parser);
+
+    printf("%-12s %-8s %10zu %12zu %12zu %10.1f\n", name, pack_numbers ? "packed" : "boxed", length, allocations, bytes,
+        (double)length * RUNS / (1024.0 * 1024.0) / time);
+
+    return true;
+}
+
+// Parses {"a":[1,2,3]} with the default options & checks its numbers are found by ki_json_array_at().
+// Returns true on success, false on fail.
+static bool check_default_options(void)
+{
+    struct ki_json_val* val = ki_json_parse_string("{\"a\":[1,2,3]}", NULL);
+
+    if (val == NULL)
+        return false;
+
+    struct ki_json_array* array = ki_json_object_get_array(&val->value.object, "a");
+    bool success = array != NULL;
+
+    for (size_t i = 0; success && i < 3; i++)
+    {
+        struct ki_json_val* number = ki_json_array_at(array, i);
+
+        success = number != NULL && number->type == KI_JSON_VAL_NUMBER && number->value.number == (double)(i + 1)
+            && ki_json_array_number_at(array, i) == (double)(i + 1);
+    }
+
+    ki_json_val_free(val);
+
+    return success;
+}
+
+int main(void)
+{
+    if (!check_default_options())
+    {
+        printf("failed to read numbers parsed with default options\n");
+        return 1;
+    }
+
+    printf("%-12s %-8s %10s %12s %12s %10s\n", "document", "arrays", "bytes", "allocations", "tree bytes", "MB/s");
+
+    char* (*generators[])(size_t*) = { generate_series, generate_coordinates };
+    const char* names[] = { "series", "coordinates" };
+
+    for (int i = 0; i < 2; i++)
+    {
+        size_t length = 0;
+        char* json = generators[i](&length);
+
+        if (json == NULL || !bench_document(names[i], json, length, false) || !bench_document(names[i], json, length, true))
+        {
+            printf("failed to bench %s\n", names[i]);
+            free(json);
+            return 1;
+        }
+
+        free(json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,189 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+
+// Parses the same documents with bounds checks on every byte and through the padded fast path.
+// Padding mostly pays off for documents spending their time scanning long strings & indentation,
+// for documents made of many tiny values allocating the tree itself dominates.
+
+#define ROWS 20000
+#define RUNS 30
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Generates pretty-printed array of objects with many small values.
+// Returned string must be freed once done.
+static char* generate_records(size_t* length)
+{
+    size_t size = ROWS * 256 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[\n");
+
+    for (int i = 0; i < ROWS; i++)
+    {
+        pos += sprintf(json + pos,
+            "    {\n"
+            "        \"id\": %d,\n"
+            "        \"name\": \"user_%d\",\n"
+            "        \"email\": \"user_%d@example.com\",\n"
+            "        \"tags\": [\"admin\", \"beta\\ttester\"],\n"
+            "        \"active\": %s,\n"
+            "        \"score\": %d.25,\n"
+            "        \"parent\": null\n"
+            "    }%s\n",
+            i, i, i, (i % 2 == 0) ? "true" : "false", i % 1000, (i == ROWS - 1) ? "" : ",");
+    }
+
+    pos += sprintf(json + pos, "]\n");
+
+    *length = pos;
+    return json;
+}
+
+// Generates deeply indented array of objects with long strings.
+// Returned string must be freed once done.
+static char* generate_text(size_t* length)
+{
+    size_t size = ROWS * 512 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[\n");
+
+    for (int i = 0; i < ROWS; i++)
+    {
+        pos += sprintf(json + pos,
+            "                {\n"
+            "                        \"title\": \"Chapter %d: on the parsing of rather long strings\",\n"
+            "                        \"body\": \"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation.\"\n"
+            "                }%s\n",
+            i, (i == ROWS - 1) ? "" : ",");
+    }
+
+    pos += sprintf(json + pos, "]\n");
+
+    *length = pos;
+    return json;
+}
+
+// Generates compact telemetry-like array of objects made up mostly of booleans and nulls.
+// Returned string must be freed once done.
+static char* generate_flags(size_t* length)
+{
+    size_t size = ROWS * 256 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[");
+
+    for (int i = 0; i < ROWS; i++)
+    {
+        pos += sprintf(json + pos,
+            "{\"ok\":%s,\"retry\":%s,\"cached\":%s,\"error\":null,\"flags\":[true,false,null,true,null,false,false,true]}%s",
+            (i % 2 == 0) ? "true" : "false", (i % 3 == 0) ? "true" : "false", (i % 5 == 0) ? "null" : "true", (i == ROWS - 1) ? "" : ",");
+    }
+
+    pos += sprintf(json + pos, "]");
+
+    *length = pos;
+    return json;
+}
+
+// Parses json RUNS times both with & without padding, printing throughput of both.
+// Returns true on success, false on fail.
+static bool bench_document(struct ki_json_parser* parser, const char* name, const char* json, size_t length)
+{
+    struct ki_json_padded_string padded;
+
+    if (!ki_json_padded_string_init(&padded, json, length))
+        return false;
+
+    struct ki_json_parser_err err = {0};
+    double times[2] = { 0.0, 0.0 };
+
+    //alternate between both to even out noise
+    for (int run = 0; run < RUNS; run++)
+    {
+        for (int padded_run = 0; padded_run < 2; padded_run++)
+        {
+            double start = now_seconds();
+
+            struct ki_json_val* val = padded_run ? ki_json_parser_parse_padded(parser, padded.string, padded.length, &err)
+                                                 : ki_json_parser_parse(parser, json, length, &err);
+
+            times[padded_run] += now_seconds() - start;
+
+            if (val == NULL)
+            {
+                printf("failed to parse: %s\n", ki_json_err_get_message(err.type));
+                ki_json_padded_string_fini(&padded);
+                return false;
+            }
+
+            ki_json_val_free(val);
+        }
+    }
+
+    double megabytes = (double)length * RUNS / (1024.0 * 1024.0);
+
+    printf("%-8s %10zu %12.1f %12.1f %8.2fx\n", name, length, megabytes / times[0], megabytes / times[1], times[0] / times[1]);
+
+    ki_json_padded_string_fini(&padded);
+    return true;
+}
+
+int main(void)
+{
+    struct ki_json_parser* parser = ki_json_parser_create(NULL);
+
+    if (parser == NULL)
+        return 1;
+
+    printf("%d runs per document\n", RUNS);
+    printf("%-8s %10s %12s %12s %9s\n", "document", "bytes", "checked MB/s", "padded MB/s", "speedup");
+
+    char* (*generators[])(size_t*) = { generate_records, generate_text, generate_flags };
+    const char* names[] = { "records", "text", "flags" };
+
+    for (int i = 0; i < 3; i++)
+    {
+        size_t length = 0;
+        char* json = generators[i](&length);
+
+        if (json == NULL || !bench_document(parser, names[i], json, length))
+        {
+            printf("failed to bench %s\n", names[i]);
+            free(json);
+            return 1;
+        }
+
+        free(json);
+    }
+
+    ki_json_parser_free(parser);
+
+    return 0;
+}
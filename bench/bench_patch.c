@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+#include "ki_json/json_patch.h"
+
+// Applies the same small patches to a small & a big document, timing JSON Patches (plain & atomic) & Merge Patches,
+// which should take about as long for both.
+
+#define SMALL_ITEMS 100
+#define BIG_ITEMS 100000
+#define CHANGED_ITEMS 8
+#define RUNS 20000
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns document of count objects.
+// Returns NULL on fail.
+static struct ki_json_val* build_document(size_t count)
+{
+    struct ki_json_val* root = ki_json_val_create_object(2);
+
+    if (root == NULL)
+        return NULL;
+
+    struct ki_json_val* items = ki_json_object_add_new_array(&root->value.object, "items", count);
+
+    if (items == NULL || ki_json_object_add_new_string(&root->value.object, "status", "ok") == NULL)
+    {
+        ki_json_val_free(root);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        struct ki_json_val* item = ki_json_array_add_new_object(&items->value.array, 3);
+
+        if (item == NULL
+            || ki_json_object_add_new_number(&item->value.object, "id", (double)i) == NULL
+            || ki_json_object_add_new_string(&item->value.object, "description", "a description too long to be stored inline") == NULL
+            || ki_json_object_add_new_bool(&item->value.object, "visible", true) == NULL)
+        {
+            ki_json_val_free(root);
+            return NULL;
+        }
+    }
+
+    return root;
+}
+
+// Returns JSON Patch setting "visible" of CHANGED_ITEMS items spread over count items to visible.
+// Returns NULL on fail.
+static struct ki_json_val* build_patch(size_t count, bool visible)
+{
+    char string[CHANGED_ITEMS * 96 + 64];
+    size_t length = (size_t)sprintf(string, "[{\"op\":\"test\",\"path\":\"/status\",\"value\":\"ok\"}");
+
+    for (size_t i = 0; i < CHANGED_ITEMS; i++)
+    {
+        length += (size_t)sprintf(string + length, ",{\"op\":\"replace\",\"path\":\"/items/%zu/visible\",\"value\":%s}",
+            i * (count / CHANGED_ITEMS), visible ? "true" : "false");
+    }
+
+    strcpy(string + length, "]");
+
+    struct ki_json_parser_err err;
+    return ki_json_parse_string(string, &err);
+}
+
+// Prints microseconds per patch of applying patches a & b to doc one after another using apply.
+// Returns true on success, false on fail.
+static bool bench_apply(const char* name, struct ki_json_val** doc, struct ki_json_val* a, struct ki_json_val* b,
+    enum ki_json_err_type (*apply)(struct ki_json_val**, struct ki_json_val*))
+{
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        if (apply(doc, (run % 2 == 0) ? a : b) != KI_JSON_ERR_NONE)
+            return false;
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-22s %12.3f\n", name, time * 1e6 / RUNS);
+
+    return true;
+}
+
+// Benches applying patches to a document of count items.
+// Returns true on success, false on fail.
+static bool bench_document(size_t count)
+{
+    struct ki_json_parser_err err;
+    struct ki_json_val* doc = build_document(count);
+    struct ki_json_val* hide = build_patch(count, false);
+    struct ki_json_val* show = build_patch(count, true);
+    struct ki_json_val* merge_a = ki_json_parse_string("{\"status\":\"busy\",\"progress\":{\"done\":1}}", &err);
+    struct ki_json_val* merge_b = ki_json_parse_string("{\"status\":\"ok\",\"progress\":null}", &err);
+
+    bool success = doc != NULL && hide != NULL && show != NULL && merge_a != NULL && merge_b != NULL;
+
+    if (success)
+    {
+        printf("%zu items\n", count);
+
+        success = bench_apply("patch", &doc, hide, show, ki_json_patch_apply)
+            && bench_apply("patch atomic", &doc, hide, show, ki_json_patch_apply_atomic)
+            && bench_apply("merge patch", &doc, merge_a, merge_b, ki_json_merge_patch);
+    }
+
+    ki_json_val_free(doc);
+    ki_json_val_free(hide);
+    ki_json_val_free(show);
+    ki_json_val_free(merge_a);
+    ki_json_val_free(merge_b);
+
+    return success;
+}
+
+int main(void)
+{
+    printf("%-22s %12s\n", "apply", "us/patch");
+
+    if (!bench_document(SMALL_ITEMS) || !bench_document(BIG_ITEMS))
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+#include "ki_json/json_path.h"
+
+// Runs compiled JSONPath queries on a big document: parsing it & querying the tree, querying the tree parsed already
+// & querying the json text itself without building a tree.
+
+#define BOOKS 100000
+#define RUNS 5
+#define RESULTS 4
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns json text of a store with BOOKS books, outs its length.
+// Returns NULL on fail.
+static char* build_document(size_t* length)
+{
+    size_t size = (size_t)BOOKS * 256 + 256;
+    char* string = malloc(size);
+
+    if (string == NULL)
+        return NULL;
+
+    size_t used = (size_t)sprintf(string, "{\"store\":{\"bicycle\":{\"color\":\"red\",\"price\":399},\"book\":[");
+
+    for (int i = 0; i < BOOKS; i++)
+    {
+        used += (size_t)sprintf(string + used,
+            "%s{\"category\":\"%s\",\"author\":\"Author %d\",\"title\":\"Title %d\",%s\"price\":%d.%02d,\"tags\":[\"a\",\"b\",\"c\"]}",
+            (i > 0) ? "," : "", (i % 3 == 0) ? "reference" : "fiction", i, i, (i % 7 == 0) ? "\"isbn\":\"0-553-21311-3\"," : "", i % 40, i % 100);
+    }
+
+    used += (size_t)sprintf(string + used, "]}}");
+
+    *length = used;
+
+    return string;
+}
+
+// Prints milliseconds per query of path on doc & on its json text, parsing it first & not.
+// Returns true on success, false on fail.
+static bool bench_path(const char* path_string, const char* json, size_t length, struct ki_json_val* doc)
+{
+    struct ki_json_path* path = ki_json_path_compile(path_string);
+
+    if (path == NULL)
+        return false;
+
+    struct ki_json_val* results[RESULTS];
+    struct ki_json_path_match matches[RESULTS];
+    size_t tree_count = 0;
+    size_t text_count = 0;
+    bool success = true;
+
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS && success; run++)
+    {
+        struct ki_json_val* parsed = ki_json_nparse_string(json, length, NULL);
+
+        success = parsed != NULL && ki_json_path_query(path, parsed, results, RESULTS, &tree_count) == KI_JSON_ERR_NONE;
+
+        ki_json_val_free(parsed);
+    }
+
+    double parse_time = now_seconds() - start;
+    start = now_seconds();
+
+    for (int run = 0; run < RUNS && success; run++)
+        success = ki_json_path_query(path, doc, results, RESULTS, &tree_count) == KI_JSON_ERR_NONE;
+
+    double tree_time = now_seconds() - start;
+    start = now_seconds();
+
+    for (int run = 0; run < RUNS && success; run++)
+        success = ki_json_path_query_string(path, json, length, matches, RESULTS, &text_count) == KI_JSON_ERR_NONE;
+
+    double text_time = now_seconds() - start;
+
+    ki_json_path_free(path);
+
+    if (!success || tree_count != text_count)
+        return false;
+
+    printf("%-40s %8zu %14.2f %12.2f %12.2f\n", path_string, tree_count, parse_time * 1e3 / RUNS, tree_time * 1e3 / RUNS, text_time * 1e3 / RUNS);
+
+    return true;
+}
+
+int main(void)
+{
+    const char* paths[] = {
+        "$.store.bicycle.color",
+        "$.store.book[-1].title",
+        "$.store.book[10:20].author",
+        "$.store.book[?@.price < 10].title",
+        "$..isbn"
+    };
+
+    size_t length = 0;
+    char* json = build_document(&length);
+    struct ki_json_val* doc = (json != NULL) ? ki_json_nparse_string(json, length, NULL) : NULL;
+    bool success = doc != NULL;
+
+    if (success)
+    {
+        printf("document: %zu bytes, %d books\n", length, BOOKS);
+        printf("%-40s %8s %14s %12s %12s\n", "path", "matches", "parse+tree ms", "tree ms", "text ms");
+    }
+
+    for (size_t i = 0; i < sizeof(paths) / sizeof(*paths) && success; i++)
+        success = bench_path(paths[i], json, length, doc);
+
+    ki_json_val_free(doc);
+    free(json);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
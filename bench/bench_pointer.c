@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+#include "ki_json/json_pointer.h"
+
+// Looks up the same values in many documents by chaining lookups by hand & by resolving compiled JSON Pointers.
+
+#define DOCS 100
+#define META_FIELDS 24
+#define RUNS 4000
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns document number i.
+// Returns NULL on fail.
+static struct ki_json_val* build_document(int i)
+{
+    char string[2048];
+    size_t length = (size_t)sprintf(string,
+        "{\"id\":%d,\"user\":{\"name\":\"user %d\",\"email\":\"user%d@example.com\",\"address\":{\"street\":\"Main Street\",\"city\":\"Springfield\",\"zip\":\"%05d\"}},"
+        "\"items\":[{\"sku\":\"a\",\"price\":1.5},{\"sku\":\"b\",\"price\":2.5},{\"sku\":\"c\",\"price\":%d.25}],\"meta\":{",
+        i, i, i, i, i % 100);
+
+    for (int field = 0; field < META_FIELDS; field++)
+        length += (size_t)sprintf(string + length, "%s\"field_%d\":%d", (field > 0) ? "," : "", field, field * i);
+
+    strcpy(string + length, "}}");
+
+    struct ki_json_parser_err err;
+    return ki_json_parse_string(string, &err);
+}
+
+// Returns sum of values looked up in doc by chaining lookups by hand.
+static double lookup_chained(struct ki_json_val* doc, struct ki_json_pointer** pointers)
+{
+    (void)pointers;
+
+    struct ki_json_object* root = &doc->value.object;
+    struct ki_json_object* user = ki_json_object_get_object(root, "user");
+    struct ki_json_object* address = ki_json_object_get_object(user, "address");
+    struct ki_json_object* item = ki_json_array_object_at(ki_json_object_get_array(root, "items"), 2);
+    struct ki_json_object* meta = ki_json_object_get_object(root, "meta");
+
+    return (double)ki_json_object_get_stringn(address, "zip", 3, NULL)[0]
+        + ki_json_object_get_number(item, "price")
+        + ki_json_object_get_number(meta, "field_17")
+        + ki_json_object_get_number(meta, "field_3")
+        + ki_json_object_get_number(root, "id");
+}
+
+// Returns sum of values looked up in doc by resolving compiled pointers.
+static double lookup_compiled(struct ki_json_val* doc, struct ki_json_pointer** pointers)
+{
+    return (double)ki_json_val_get_stringn(ki_json_pointer_get(pointers[0], doc), NULL)[0]
+        + ki_json_pointer_get(pointers[1], doc)->value.number
+        + ki_json_pointer_get(pointers[2], doc)->value.number
+        + ki_json_pointer_get(pointers[3], doc)->value.number
+        + ki_json_pointer_get(pointers[4], doc)->value.number;
+}
+
+// Prints million lookups per second of looking up values in all docs using lookup.
+static double bench_lookup(const char* name, struct ki_json_val** docs, struct ki_json_pointer** pointers, double (*lookup)(struct ki_json_val*, struct ki_json_pointer**))
+{
+    double sum = 0.0;
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        for (int i = 0; i < DOCS; i++)
+            sum += lookup(docs[i], pointers);
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-22s %12.1f\n", name, 5.0 * RUNS * DOCS / 1e6 / time);
+
+    return sum;
+}
+
+int main(void)
+{
+    const char* paths[] = { "/user/address/zip", "/items/2/price", "/meta/field_17", "/meta/field_3", "/id" };
+    struct ki_json_pointer* pointers[5] = { NULL };
+    struct ki_json_val** docs = calloc(DOCS, sizeof(*docs));
+    bool success = docs != NULL;
+
+    for (int i = 0; i < 5 && success; i++)
+        success = (pointers[i] = ki_json_pointer_compile(paths[i])) != NULL;
+
+    for (int i = 0; i < DOCS && success; i++)
+        success = (docs[i] = build_document(i)) != NULL;
+
+    if (success)
+    {
+        printf("%-22s %12s\n", "lookup", "M lookups/s");
+
+        double chained = bench_lookup("chained by hand", docs, pointers, lookup_chained);
+        double compiled = bench_lookup("compiled pointers", docs, pointers, lookup_compiled);
+
+        success = chained == compiled;
+    }
+
+    for (int i = 0; i < 5; i++)
+        ki_json_pointer_free(pointers[i]);
+
+    for (int i = 0; docs != NULL && i < DOCS; i++)
+        ki_json_val_free(docs[i]);
+
+    free(docs);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
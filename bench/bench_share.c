@@ -0,0 +1,167 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+
+// Derives variants of a template document differing in a single field by cloning it and by sharing it,
+// timing deriving + freeing the variants.
+
+#define ITEMS 200
+#define VARIANTS 2000
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Returns template document of ITEMS objects.
+// Returns NULL on fail.
+static struct ki_json_val* build_template(void)
+{
+    struct ki_json_val* root = ki_json_val_create_object(2);
+
+    if (root == NULL)
+        return NULL;
+
+    struct ki_json_val* items = ki_json_object_add_new_array(&root->value.object, "items", ITEMS);
+
+    if (items == NULL || ki_json_object_add_new_string(&root->value.object, "status", "ok") == NULL)
+    {
+        ki_json_val_free(root);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < ITEMS; i++)
+    {
+        struct ki_json_val* item = ki_json_array_add_new_object(&items->value.array, 4);
+
+        if (item == NULL
+            || ki_json_object_add_new_number(&item->value.object, "id", (double)i) == NULL
+            || ki_json_object_add_new_string(&item->value.object, "description", "a description too long to be stored inline") == NULL
+            || ki_json_object_add_new_bool(&item->value.object, "visible", true) == NULL
+            || ki_json_object_add_new_array(&item->value.object, "tags", 0) == NULL)
+        {
+            ki_json_val_free(root);
+            return NULL;
+        }
+    }
+
+    return root;
+}
+
+// Sets id of item index of variant to id.
+// Returns true on success, false on fail.
+static bool set_id(struct ki_json_val* variant, size_t index, double id)
+{
+    struct ki_json_val* items = ki_json_object_get_mut(&variant->value.object, "items");
+
+    if (items == NULL)
+        return false;
+
+    struct ki_json_val* item = ki_json_array_at_mut(&items->value.array, index);
+
+    return item != NULL && ki_json_object_set_number(&item->value.object, "id", id);
+}
+
+// Derives variant of template by cloning it.
+static struct ki_json_val* derive_clone(struct ki_json_val* template, size_t index)
+{
+    struct ki_json_val* variant = ki_json_val_clone(template);
+
+    if (variant != NULL && !set_id(variant, index % ITEMS, -1.0))
+    {
+        ki_json_val_free(variant);
+        return NULL;
+    }
+
+    return variant;
+}
+
+// Derives variant of template by sharing it, copying only the values on the way to the change.
+static struct ki_json_val* derive_share(struct ki_json_val* template, size_t index)
+{
+    struct ki_json_val* shared = ki_json_val_share(template);
+
+    if (shared == NULL)
+        return NULL;
+
+    struct ki_json_val* variant = ki_json_val_unshare(shared);
+
+    if (variant == NULL)
+    {
+        ki_json_val_free(shared);
+        return NULL;
+    }
+
+    if (!set_id(variant, index % ITEMS, -1.0))
+    {
+        ki_json_val_free(variant);
+        return NULL;
+    }
+
+    return variant;
+}
+
+// Prints variants per second of deriving VARIANTS variants of template using derive, keeping all of them alive until freeing.
+// Returns true on success, false on fail.
+static bool bench_derive(const char* name, struct ki_json_val* template, struct ki_json_val* (*derive)(struct ki_json_val*, size_t))
+{
+    struct ki_json_val** variants = calloc(VARIANTS, sizeof(*variants));
+
+    if (variants == NULL)
+        return false;
+
+    bool success = true;
+    double start = now_seconds();
+
+    for (size_t i = 0; i < VARIANTS && success; i++)
+    {
+        variants[i] = derive(template, i);
+        success = (variants[i] != NULL);
+    }
+
+    for (size_t i = 0; i < VARIANTS; i++)
+        ki_json_val_free(variants[i]);
+
+    double time = now_seconds() - start;
+
+    free(variants);
+
+    if (success)
+        printf("%-22s %12.1f\n", name, VARIANTS / 1e3 / time);
+
+    return success;
+}
+
+int main(void)
+{
+    struct ki_json_val* template = build_template();
+
+    if (template == NULL)
+    {
+        printf("failed to build template\n");
+        return 1;
+    }
+
+    printf("%-22s %12s\n", "variant", "K variants/s");
+
+    bool success = bench_derive("clone", template, derive_clone)
+        && bench_derive("share", template, derive_share);
+
+    ki_json_val_free(template);
+
+    if (!success)
+    {
+        printf("failed to bench\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+
+// Parses documents full of short strings (tags, ids, country codes) & of long strings,
+// counting allocations & bytes held by the resulting tree and timing parse + free.
+// Strings shorter than KI_JSON_INLINE_STRING_SIZE live inside their json value, so they shouldn't allocate.
+
+#define ROWS 20000
+#define RUNS 20
+
+static double now_seconds(void)
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Allocations made through counting_allocator
+struct counts
+{
+    size_t allocations;
+    size_t bytes;
+};
+
+static void* counting_malloc(size_t size, void* context)
+{
+    struct counts* counts = context;
+    counts->allocations++;
+    counts->bytes += size;
+    return malloc(size);
+}
+
+static void* counting_realloc(void* ptr, size_t old_size, size_t new_size, void* context)
+{
+    struct counts* counts = context;
+    counts->allocations += (ptr == NULL) ? 1 : 0;
+    counts->bytes += new_size - old_size;
+    return realloc(ptr, new_size);
+}
+
+static void counting_free(void* ptr, size_t size, void* context)
+{
+    struct counts* counts = context;
+    counts->allocations--;
+    counts->bytes -= size;
+    free(ptr);
+}
+
+// Generates array of objects with short string values.
+// Returned string must be freed once done.
+static char* generate_short(size_t* length)
+{
+    static const char* countries[] = { "NL", "DE", "US", "JP", "BR" };
+    static const char* states[] = { "active", "pending", "suspended" };
+
+    size_t size = ROWS * 160 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[");
+
+    for (int i = 0; i < ROWS; i++)
+    {
+        pos += sprintf(json + pos, "{\"id\":\"u%08d\",\"country\":\"%s\",\"state\":\"%s\",\"tags\":[\"beta\",\"admin\",\"eu-west-1\"]}%s",
+            i, countries[i % 5], states[i % 3], (i == ROWS - 1) ? "" : ",");
+    }
+
+    pos += sprintf(json + pos, "]");
+
+    *length = pos;
+    return json;
+}
+
+// Generates array of objects with string values too long to be stored inline.
+// Returned string must be freed once done.
+static char* generate_long(size_t* length)
+{
+    size_t size = ROWS * 200 + 16;
+    char* json = malloc(size);
+
+    if (json == NULL)
+        return NULL;
+
+    size_t pos = 0;
+    pos += sprintf(json + pos, "[");
+
+    for (int i = 0; i < ROWS; i++)
+    {
+        pos += sprintf(json + pos, "{\"url\":\"https://example.com/items/%08d\",\"title\":\"A somewhat longer item title %d\"}%s",
+            i, i, (i == ROWS - 1) ? "" : ",");
+    }
+
+    pos += sprintf(json + pos, "]");
+
+    *length = pos;
+    return json;
+}
+
+// Prints allocations & bytes held by parsed document, and throughput of parsing + freeing it.
+// Returns true on success, false on fail.
+static bool bench_document(const char* name, const char* json, size_t length)
+{
+    struct counts counts = { 0, 0 };
+    struct ki_json_allocator allocator = {
+        .malloc = counting_malloc,
+        .realloc = counting_realloc,
+        .free = counting_free,
+        .context = &counts
+    };
+
+    struct ki_json_parser_err err = {0};
+    struct ki_json_val* val = ki_json_nparse_string_with_allocator(json, length, &allocator, &err);
+
+    if (val == NULL)
+    {
+        printf("failed to parse: %s\n", ki_json_err_get_message(err.type));
+        return false;
+    }
+
+    size_t allocations = counts.allocations;
+    size_t bytes = counts.bytes;
+
+    ki_json_val_free(val);
+
+    //default allocator, with pooled nodes
+    double start = now_seconds();
+
+    for (int run = 0; run < RUNS; run++)
+    {
+        val = ki_json_nparse_string(json, length, &err);
+
+        if (val == NULL)
+            return false;
+
+        ki_json_val_free(val);
+    }
+
+    double time = now_seconds() - start;
+
+    printf("%-8s %10zu %12zu %12zu %10.1f\n", name, length, allocations, bytes, (double)length * RUNS / (1024.0 * 1024.0) / time);
+
+    return true;
+}
+
+int main(void)
+{
+    printf("%-8s %10s %12s %12s %10s\n", "document", "bytes", "allocations", "tree bytes", "MB/s");
+
+    char* (*generators[])(size_t*) = { generate_short, generate_long };
+    const char* names[] = { "short", "long" };
+
+    for (int i = 0; i < 2; i++)
+    {
+        size_t length = 0;
+        char* json = generators[i](&length);
+
+        if (json == NULL || !bench_document(names[i], json, length))
+        {
+            printf("failed to bench %s\n", names[i]);
+            free(json);
+            return 1;
+        }
+
+        free(json);
+    }
+
+    return 0;
+}
@@ -71,8 +71,8 @@ int main(void)
     enum ki_json_err_type err_type = KI_JSON_ERR_INTERNAL;
 
     struct json_reader test_reader = {
-        .json_string = "\"test lol lol\"\"can't see me yet!\"\"tab\\tta\\nb\\t\"\"aa\\u00AEabc\"truefalse true2.234-99.92.2",
-        .length = 87,
+        .json_string = "\"test lol lol\"\"can't see me yet!\"\"tab\\tta\\nb\\t\"\"aa\\u00AEabc\"true false true 2.234-99.92.2",
+        .length = 89,
         .offset = 0
     };
 
@@ -81,7 +81,7 @@ int main(void)
     //read 5 strings, 5th string will be fail as it has no start quote
     for (int i = 0; i < 5; i++)
     {
-        err_type = parse_string(&test_reader, &string);
+        err_type = parse_string(&test_reader, NULL, 0, &string, NULL);
         
         if (err_type == KI_JSON_ERR_NONE)
         {
@@ -94,7 +94,8 @@ int main(void)
         }
     }
 
-    //read 3 bools, only first 2 should be successful
+    //read 3 bools, skipping whitespace after each
+    //NOTE: literals must be followed by whitespace, a ',', ']', '}' or the end of the json string
     bool boolean = false;
     for (int i = 0; i < 3; i++)
     {
@@ -104,18 +105,9 @@ int main(void)
             printf("read bool %i: %i\n", i + 1, boolean);
         else
             printf("read bool %i failed (err: %s)\n", i + 1, ki_json_err_get_message(err_type));
-    }
-
-    printf("skipping whitespace...\n");
-
-    reader_skip_whitespace(&test_reader);
 
-    err_type = parse_boolean(&test_reader, &boolean);
-
-    if (err_type == KI_JSON_ERR_NONE)
-        printf("read bool %i: %i\n", 4, boolean);
-    else
-        printf("read bool %i failed (err: %s)\n", 4, ki_json_err_get_message(err_type));
+        reader_skip_whitespace(&test_reader);
+    }
 
     double number = 0.0;
     for (int i = 0; i < 3; i++)
@@ -143,7 +135,7 @@ int main(void)
     //read 3 strings
     for (int i = 0; i < 5; i++)
     {
-        err_type = parse_string(&reader2, &string);
+        err_type = parse_string(&reader2, NULL, 0, &string, NULL);
 
         if (err_type == KI_JSON_ERR_NONE)
         {
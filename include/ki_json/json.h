@@ -1,308 +1,718 @@
-#ifndef KI_JSON_JSON_H
-#define KI_JSON_JSON_H
-
-#include <stdbool.h>
-#include <stddef.h>
-
-#ifdef __cplusplus
-extern "C"
-{
-#endif
-
-// Contains what is needed to represent json trees, along with the functions neccessary for creating & interacting with them
-
-/* Structs & enums */
-
-enum ki_json_val_type
-{
-    KI_JSON_VAL_NULL = 0, //nothing, NULL
-    KI_JSON_VAL_OBJECT = 1, //object, struct ki_json_object
-    KI_JSON_VAL_ARRAY = 2, //array, struct ki_json_array
-    KI_JSON_VAL_STRING = 3, //string, char*
-    KI_JSON_VAL_NUMBER = 4, //number, double
-    KI_JSON_VAL_BOOL = 5 //boolean, bool
-};
-
-// A collection of json name/value pairs.
-struct ki_json_object
-{
-    // Names of pairs
-    char** names;
-    // Values of pairs
-    struct ki_json_val** values;
-    // Number of pairs currently in this json object
-    size_t count;
-    // Maximum amount of pairs this json object can currently hold.
-    // Expands automatically, will never shrink
-    size_t capacity;
-};
-
-// An ordered list of values.
-// Uses an array to hold the values.
-struct ki_json_array
-{
-    struct ki_json_val** values;
-    // Number of values currently in this json object
-    size_t count;
-    // Maximum amount of values this json object can currently hold.
-    // Expands automatically, will never shrink
-    size_t capacity;
-};
-
-// An json value.
-// NOTE: strings should be set using ki_json_val_set_string
-struct ki_json_val
-{
-    enum ki_json_val_type type;
-    
-    union
-    {
-        struct ki_json_object object;
-        struct ki_json_array array;
-        char* string;
-        double number;
-        bool boolean;
-        bool null; 
-    } value;
-};
-
-enum ki_json_err_type
-{
-    KI_JSON_ERR_NONE, //no error.
-    KI_JSON_ERR_INTERNAL, //internal error
-    KI_JSON_ERR_TOO_SHORT, //json string is too short
-
-    KI_JSON_ERR_INVALID_ARGS, //invalid arguments were given
-
-    KI_JSON_ERR_MEMORY, //memory error, for ex.: allocation fail
-
-    KI_JSON_ERR_OUT_OF_BOUNDS, //index out of bounds
-
-    KI_JSON_ERR_UNTERMINATED_STRING, //string value does not end
-    KI_JSON_ERR_UNTERMINATED_ARRAY, //array does not end
-    KI_JSON_ERR_UNTERMINATED_OBJECT, //object does not end
-
-    KI_JSON_ERR_EXPECTED_NAME, //expected a string as name for pair
-    KI_JSON_ERR_NAME_ALREADY_EXISTS, //name already exists in object
-    KI_JSON_ERR_EXPECTED_NAME_VALUE_SEPARATOR, //expected separator colon between name & value
-
-    KI_JSON_ERR_UNKNOWN_TOKEN, //parser can't resolve type of token (number, string, object, array, null)
-    KI_JSON_ERR_INVALID_ESCAPE_SEQUENCE,
-
-    KI_JSON_ERR_TRAILING_COMMA, //Trailing comma in array or object is not supported.
-    
-    KI_JSON_ERR_AMOUNT
-};
-
-/* Error handling */
-
-//TODO: add val, object and array is_type functions
-
-// Get error message for json error type.
-// Returns NULL for nonexistent error types.
-const char* ki_json_err_get_message(enum ki_json_err_type err);
-
-/* Json object functions */
-
-bool ki_json_object_init(struct ki_json_object* object, size_t capacity);
-void ki_json_object_fini(struct ki_json_object* object);
-
-// Returns val with given name in json object.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_object_get(struct ki_json_object* object, const char* name);
-// Returns json object with given name in json object.
-// Returns NULL on fail.
-struct ki_json_object* ki_json_object_get_object(struct ki_json_object* object, const char* name);
-// Returns json array with given name in json object.
-// Returns NULL on fail.
-struct ki_json_array* ki_json_object_get_array(struct ki_json_object* object, const char* name);
-// Returns string with given name in json object.
-// Returns NULL on fail.
-char* ki_json_object_get_string(struct ki_json_object* object, const char* name);
-// TODO: what to do on fail? ki_json_object_get_number
-// Returns number with given name in json object.
-// NOTE: Returns 0.0 on fail.
-double ki_json_object_get_number(struct ki_json_object* object, const char* name);
-// TODO: what to do on fail? ki_json_object_get_bool
-// Returns bool with given name in json object.
-// NOTE: Returns false on fail.
-bool ki_json_object_get_bool(struct ki_json_object* object, const char* name);
-
-//TODO: out error for add/insert new types?
-
-// Adds json value to json object as given name.
-// NOTE 1: Ownership of value is given to json object, and will free it once done.
-// NOTE 2: Name is copied.
-enum ki_json_err_type ki_json_object_add(struct ki_json_object* object, const char* name, struct ki_json_val* value);
-// Creates new json value for a json object and adds it to the json object.
-// NOTE: Name is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_object_add_new_object(struct ki_json_object* object, const char* name, size_t capacity);
-// Creates new json value for a json array and adds it to the json object.
-// NOTE: Name is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_object_add_new_array(struct ki_json_object* object, const char* name, size_t capacity);
-// Creates new json value for a string and adds it to the json object.
-// NOTE: Name & string is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_object_add_new_string(struct ki_json_object* object, const char* name, const char* string);
-// Creates new json value for a number and adds it to the json object.
-// NOTE: Name is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_object_add_new_number(struct ki_json_object* object, const char* name, double number);
-// Creates new json value for a bool and adds it to the json object.
-// NOTE: Name is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_object_add_new_bool(struct ki_json_object* object, const char* name, bool boolean);
-// Creates new json value representing null and adds it to the json object.
-// NOTE: Name is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_object_add_new_null(struct ki_json_object* object, const char* name);
-
-// NOTE 1: Value must be of type KI_JSON_VAL_STRING.
-// NOTE 2: String is copied.
-// Returns true on success, false on fail.
-bool ki_json_object_set_string(struct ki_json_object* object, const char* name, const char* string);
-// NOTE: Value must be of type KI_JSON_VAL_NUMBER.
-// Returns true on success, false on fail.
-bool ki_json_object_set_number(struct ki_json_object* object, const char* name, double number);
-// NOTE: Value must be of type KI_JSON_VAL_BOOL.
-// Returns true on success, false on fail.
-bool ki_json_object_set_bool(struct ki_json_object* object, const char* name, bool boolean);
-
-// Returns true on success, false on fail.
-bool ki_json_object_remove(struct ki_json_object* object, const char* name);
-
-/* Json array functions */
-
-bool ki_json_array_init(struct ki_json_array* array, size_t capacity);
-void ki_json_array_fini(struct ki_json_array* array);
-
-// Returns val at given index in json array.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_at(struct ki_json_array* array, size_t index);
-// Returns json object at given index in json array.
-// Returns NULL on fail.
-struct ki_json_object* ki_json_array_object_at(struct ki_json_array* array, size_t index);
-// Returns json array at given index in json array.
-// Returns NULL on fail.
-struct ki_json_array* ki_json_array_array_at(struct ki_json_array* array, size_t index);
-// Returns string at given index in json array.
-// Returns NULL on fail.
-char* ki_json_array_string_at(struct ki_json_array* array, size_t index);
-// TODO: what to do on fail? ki_json_array_get_number
-// Returns number at given index in json array.
-// NOTE: Returns 0.0 on fail.
-double ki_json_array_number_at(struct ki_json_array* array, size_t index);
-// TODO: what to do on fail? ki_json_array_get_bool
-// Returns bool at given index in json array.
-// NOTE: Returns false on fail.
-bool ki_json_array_bool_at(struct ki_json_array* array, size_t index);
-
-// Adds json value to json array at given index.
-// NOTE: Ownership of value is given to json array, and will free it once done.
-enum ki_json_err_type ki_json_array_insert(struct ki_json_array* array, struct ki_json_val* value, size_t index);
-// Creates new json value for a json object and adds it to the json array at given index.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_insert_new_object(struct ki_json_array* array, size_t index, size_t capacity);
-// Creates new json value for a json array and adds it to the json array at given index.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_insert_new_array(struct ki_json_array* array, size_t index, size_t capacity);
-// Creates new json value for a string and adds it to the json array at given index.
-// NOTE: String is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_insert_new_string(struct ki_json_array* array, size_t index, const char* string);
-// Creates new json value for a number and adds it to the json array at given index.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_insert_new_number(struct ki_json_array* array, size_t index, double number);
-// Creates new json value for a bool and adds it to the json array at given index.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_insert_new_bool(struct ki_json_array* array, size_t index, bool boolean);
-// Creates new json value representing null and adds it to the json array at given index.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_insert_new_null(struct ki_json_array* array, size_t index);
-
-// Adds json value to the end of a json array.
-// NOTE: Ownership of value is given to json array, and will free it once done.
-enum ki_json_err_type ki_json_array_add(struct ki_json_array* array, struct ki_json_val* value);
-// Creates new json value for a json object and adds it to the end of a json array.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_add_new_object(struct ki_json_array* array, size_t capacity);
-// Creates new json value for a json array and adds it to the end of a json array.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_add_new_array(struct ki_json_array* array, size_t capacity);
-// Creates new json value for a string and adds it to the end of a json array.
-// NOTE: String is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_add_new_string(struct ki_json_array* array, const char* string);
-// Creates new json value for a number and adds it to the end of a json array.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_add_new_number(struct ki_json_array* array, double number);
-// Creates new json value for a bool and adds it to the end of a json array.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_add_new_bool(struct ki_json_array* array, bool boolean);
-// Creates new json value representing null and adds it to the end of a json array.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_array_add_new_null(struct ki_json_array* array);
-
-// NOTE 1: Value must be of type KI_JSON_VAL_STRING.
-// NOTE 2: String is copied.
-// Returns true on success, false on fail.
-bool ki_json_array_set_string(struct ki_json_array* array, size_t index, const char* string);
-// NOTE: Value must be of type KI_JSON_VAL_NUMBER.
-// Returns true on success, false on fail.
-bool ki_json_array_set_number(struct ki_json_array* array, size_t index, double number);
-// NOTE: Value must be of type KI_JSON_VAL_BOOL.
-// Returns true on success, false on fail.
-bool ki_json_array_set_bool(struct ki_json_array* array, size_t index, bool boolean);
-
-// Returns true on success, false on fail.
-bool ki_json_array_remove_at(struct ki_json_array* array, size_t index);
-// Removes first occurence of reference to given json value.
-// Returns true on success, false on fail.
-bool ki_json_array_remove(struct ki_json_array* array, struct ki_json_val* value);
-
-/* Json val functions */
-
-// Creates a json value for a json object with given starting capacity.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_object(size_t capacity);
-// Creates a json value for a json array with given starting capacity.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_array(size_t capacity);
-// Creates a json value from a string.
-// NOTE: String is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_from_string(const char* string);
-// Creates a json value from a double.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_from_number(double number);
-// Creates a json value from a bool.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_from_bool(bool boolean);
-// Creates a json value representing null.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_null(void);
-
-bool ki_json_val_is_type(const struct ki_json_val* val, enum ki_json_val_type type);
-bool ki_json_val_is_object(const struct ki_json_val* val);
-bool ki_json_val_is_array(const struct ki_json_val* val);
-bool ki_json_val_is_string(const struct ki_json_val* val);
-bool ki_json_val_is_number(const struct ki_json_val* val);
-bool ki_json_val_is_bool(const struct ki_json_val* val);
-// NOTE: Checks for the json val null type, not for NULL.
-bool ki_json_val_is_null(const struct ki_json_val* val);
-
-// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
-// NOTE 2: String is copied.
-// Returns true on success, false on fail.
-bool ki_json_val_set_string(struct ki_json_val* val, const char* string);
-
-void ki_json_val_free(struct ki_json_val* val);
-
-#ifdef __cplusplus
-}
-#endif
-
-#endif //KI_JSON_JSON_H
-
+#ifndef KI_JSON_JSON_H
+#define KI_JSON_JSON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Contains what is needed to represent json trees, along with the functions neccessary for creating & interacting with them
+
+/* Structs & enums */
+
+// Allocator used for all memory of a json tree.
+// Sizes are always passed back to realloc & free, so sized allocators (arenas, pools, ...) can be used.
+struct ki_json_allocator
+{
+    // Allocates size bytes.
+    // Returns NULL on fail.
+    void* (*malloc)(size_t size, void* context);
+    // Resizes memory at ptr of old_size bytes to new_size bytes.
+    // Returns NULL on fail, ptr is left untouched in that case.
+    void* (*realloc)(void* ptr, size_t old_size, size_t new_size, void* context);
+    // Frees memory at ptr of size bytes.
+    void (*free)(void* ptr, size_t size, void* context);
+    // User context given to all functions above.
+    void* context;
+};
+
+enum ki_json_val_type
+{
+    KI_JSON_VAL_NULL = 0, //nothing, NULL
+    KI_JSON_VAL_OBJECT = 1, //object, struct ki_json_object
+    KI_JSON_VAL_ARRAY = 2, //array, struct ki_json_array
+    KI_JSON_VAL_STRING = 3, //string, char*
+    KI_JSON_VAL_NUMBER = 4, //number, double
+    KI_JSON_VAL_BOOL = 5 //boolean, bool
+};
+
+// Objects with at least this many pairs get a hash index for looking up names.
+#define KI_JSON_OBJECT_INDEX_THRESHOLD 16
+
+// A json name/value pair.
+struct ki_json_pair
+{
+    // Name of pair, null-terminated
+    char* name;
+    // Length of name, excluding null terminator
+    size_t name_length;
+    // Cached hash of name, compared before the name itself
+    size_t hash;
+    // Value of pair
+    struct ki_json_val* value;
+};
+
+// A collection of json name/value pairs.
+// Pairs are kept in insertion order.
+struct ki_json_object
+{
+    // Pairs, contiguous so lookups touch as little memory as possible.
+    // Use ki_json_object_name_at() & ki_json_object_val_at() instead of accessing these directly.
+    struct ki_json_pair* pairs;
+    // Number of pairs currently in this json object
+    size_t count;
+    // Maximum amount of pairs this json object can currently hold.
+    // Expands automatically, will never shrink
+    size_t capacity;
+    // Allocator used for names, values & the arrays here
+    const struct ki_json_allocator* allocator;
+    // Open-addressing hash index of pairs by name, built once count reaches KI_JSON_OBJECT_INDEX_THRESHOLD.
+    // Each slot holds index of a pair + 1, 0 if empty. NULL while not built.
+    // Slots are followed by the order of pairs by name, cached for canonical output (see ki_json_gen_canonical()).
+    size_t* index;
+    // Number of slots in index, always a power of 2
+    size_t index_capacity;
+};
+
+// How a json array holds its values.
+enum ki_json_array_storage
+{
+    // Pointers to separately allocated json values (default).
+    // Pointers to values in the array stay valid until those values are removed.
+    KI_JSON_ARRAY_STORAGE_BOXED = 0,
+    // Json values themselves, one after another in memory, so iterating doesn't chase pointers.
+    // NOTE 1: Pointers to values in the array (from ki_json_array_at() etc.) are invalidated by adding
+    // to the array once it has to grow, inserting or removing before them & changing its storage
+    // (with a gap buffer, see ki_json_array_set_gap_buffer(), by any insert or remove).
+    // NOTE 2: Values in the array are owned by it, never free them using ki_json_val_free().
+    // Shared values (see ki_json_val_share()) & roots of clones added to the array are copied.
+    KI_JSON_ARRAY_STORAGE_INLINE = 1,
+    // Plain doubles, for arrays holding only numbers (picked by the parser for those if asked to, see pack_numbers of
+    // struct ki_json_parser_options), see ki_json_array_numbers().
+    // Number accessors & setters, ki_json_array_add() of numbers & removing keep the array packed.
+    // NOTE 1: There are no json values in the array, read its numbers using ki_json_array_number_at() or ki_json_array_numbers().
+    // NOTE 2: Anything handing out a json value in the array (ki_json_array_at_mut(), ki_json_array_add_new_number(), ...)
+    // or adding a value that isn't a number first unpacks the array to KI_JSON_ARRAY_STORAGE_BOXED.
+    KI_JSON_ARRAY_STORAGE_NUMBERS = 2
+};
+
+// An ordered list of values.
+// Uses an array to hold the values.
+struct ki_json_array
+{
+    // Values, held as set by storage.
+    // Use ki_json_array_at() instead of accessing these directly.
+    union
+    {
+        // KI_JSON_ARRAY_STORAGE_BOXED
+        struct ki_json_val** values;
+        // KI_JSON_ARRAY_STORAGE_INLINE
+        struct ki_json_val* elements;
+        // KI_JSON_ARRAY_STORAGE_NUMBERS
+        double* numbers;
+    } data;
+    // Number of values currently in this json object
+    size_t count;
+    // Maximum amount of values this json object can currently hold.
+    // Expands automatically, will never shrink
+    size_t capacity;
+    // Allocator used for values & the array above
+    const struct ki_json_allocator* allocator;
+    // Number of values held after the gap, at the very end of data.
+    // Always 0 unless gap_buffer is set
+    size_t tail_count;
+    // How values are held, see ki_json_array_set_storage()
+    enum ki_json_array_storage storage;
+    // Whether unused space stays where values were last inserted or removed, see ki_json_array_set_gap_buffer()
+    bool gap_buffer;
+};
+
+// Strings shorter than this are stored inside the json value itself, see struct ki_json_string.
+#define KI_JSON_INLINE_STRING_SIZE 24
+
+// Storage of a string value.
+// Shares its first member with value.string, so strings can be read the same way whether inline or not.
+struct ki_json_string
+{
+    // Null-terminated characters of string, points to chars below if stored inline
+    char* string;
+    // Length of string in bytes, excluding null-terminator
+    // NOTE: String may contain '\0's, in which case this is more than strlen(string).
+    size_t length;
+    // Characters of strings shorter than KI_JSON_INLINE_STRING_SIZE
+    char chars[KI_JSON_INLINE_STRING_SIZE];
+};
+
+// Flags of a json value
+enum ki_json_val_flags
+{
+    // String is stored in value.string_storage.chars, instead of separately allocated
+    KI_JSON_VAL_FLAG_INLINE_STRING = 1 << 0,
+    // Value is part of a tree frozen using ki_json_val_freeze() & must not be changed
+    KI_JSON_VAL_FLAG_FROZEN = 1 << 1
+};
+
+// An json value.
+// NOTE: strings should be set using ki_json_val_set_string
+struct ki_json_val
+{
+    enum ki_json_val_type type;
+    // Combination of enum ki_json_val_flags
+    unsigned char flags;
+    // Number of owners besides the first one, changed atomically (see ki_json_val_share())
+    uint16_t refs;
+
+    // Allocator this value (and its string) was allocated with
+    const struct ki_json_allocator* allocator;
+    
+    union
+    {
+        struct ki_json_object object;
+        struct ki_json_array array;
+        // Use this to read strings, whether inline or not
+        char* string;
+        // Use ki_json_val_get_stringn() to also get the length of strings
+        struct ki_json_string string_storage;
+        double number;
+        bool boolean;
+        bool null; 
+    } value;
+};
+
+// Current version of a json tree, read by any number of threads while new versions are published, see ki_json_snapshot_acquire().
+// NOTE: Use the ki_json_snapshot functions instead of accessing these directly, all of them are changed atomically.
+struct ki_json_snapshot
+{
+    // Current version, owned by the snapshot (NULL if none)
+    struct ki_json_val* current;
+    // Number of readers between loading current & sharing it, per epoch
+    size_t readers[2];
+    // Epoch readers count themselves in, flipped by every publish
+    size_t epoch;
+    // Whether a publish is waiting for readers, so publishes to the snapshot are done one at a time
+    size_t publishing;
+};
+
+// What ki_json_val_dedup() deduplicated.
+struct ki_json_dedup_stats
+{
+    // Number of values replaced by a share of an equal value
+    size_t values;
+    // Bytes of memory freed by replacing them
+    size_t bytes;
+};
+
+enum ki_json_err_type
+{
+    KI_JSON_ERR_NONE, //no error.
+    KI_JSON_ERR_INTERNAL, //internal error
+    KI_JSON_ERR_TOO_SHORT, //json string is too short
+
+    KI_JSON_ERR_INVALID_ARGS, //invalid arguments were given
+
+    KI_JSON_ERR_MEMORY, //memory error, for ex.: allocation fail
+
+    KI_JSON_ERR_OUT_OF_BOUNDS, //index out of bounds
+
+    KI_JSON_ERR_UNTERMINATED_STRING, //string value does not end
+    KI_JSON_ERR_UNTERMINATED_ARRAY, //array does not end
+    KI_JSON_ERR_UNTERMINATED_OBJECT, //object does not end
+
+    KI_JSON_ERR_EXPECTED_NAME, //expected a string as name for pair
+    KI_JSON_ERR_NAME_ALREADY_EXISTS, //name already exists in object
+    KI_JSON_ERR_EXPECTED_NAME_VALUE_SEPARATOR, //expected separator colon between name & value
+
+    KI_JSON_ERR_UNKNOWN_TOKEN, //parser can't resolve type of token (number, string, object, array, null)
+    KI_JSON_ERR_INVALID_ESCAPE_SEQUENCE,
+
+    KI_JSON_ERR_TRAILING_COMMA, //Trailing comma in array or object is not supported.
+
+    KI_JSON_ERR_TOO_DEEP, //objects & arrays are nested deeper than allowed
+    KI_JSON_ERR_INVALID_NUMBER, //number does not follow the json grammar
+
+    KI_JSON_ERR_INVALID_PATCH, //patch is no valid JSON Patch
+    KI_JSON_ERR_PATH_NOT_FOUND, //JSON Pointer refers to no value
+    KI_JSON_ERR_TEST_FAILED, //value differs from the one a JSON Patch "test" operation expects
+    
+    KI_JSON_ERR_AMOUNT
+};
+
+/* Allocators */
+
+// Returns allocator wrapping malloc, realloc & free of the c standard library.
+const struct ki_json_allocator* ki_json_allocator_get_stdlib(void);
+// Returns process-wide default allocator, used whenever no allocator is given.
+const struct ki_json_allocator* ki_json_allocator_get_default(void);
+// Sets process-wide default allocator, NULL resets it to the stdlib allocator.
+// NOTE 1: Allocator must stay valid for as long as trees allocated with it exist.
+// NOTE 2: Not thread-safe, set it before creating or parsing any json trees.
+void ki_json_allocator_set_default(const struct ki_json_allocator* allocator);
+
+/* Node pool */
+
+// Json values using the stdlib allocator are taken from a per-thread pool instead of calling malloc for each of them.
+// Nodes cached by a thread are given back automatically once it exits,
+// call this to give them back earlier (for ex.: before a worker thread idles for a long time).
+void ki_json_pool_flush_thread(void);
+
+/* Background freeing */
+
+// Hands json value to a background thread which frees it & everything inside of it,
+// so the calling thread doesn't pay for freeing large trees. The thread is started on first use.
+// Frees val right away instead if it can't be handed off.
+// NOTE 1: Nothing may use val or anything inside of it afterwards.
+// NOTE 2: Custom allocators of trees handed off must be thread-safe.
+void ki_json_val_free_async(struct ki_json_val* val);
+// Blocks until every json value handed to ki_json_val_free_async() so far was freed.
+void ki_json_reclaimer_flush(void);
+// Frees every json value still handed off & stops the background thread, which starts again on next use.
+void ki_json_reclaimer_shutdown(void);
+
+/* Error handling */
+
+//TODO: add val, object and array is_type functions
+
+// Get error message for json error type.
+// Returns NULL for nonexistent error types.
+const char* ki_json_err_get_message(enum ki_json_err_type err);
+
+/* Json object functions */
+
+// Inits json object using the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_object_init(struct ki_json_object* object, size_t capacity);
+// Inits json object using given allocator, NULL for the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_object_init_with_allocator(struct ki_json_object* object, size_t capacity, const struct ki_json_allocator* allocator);
+void ki_json_object_fini(struct ki_json_object* object);
+
+// Returns val with given name in json object.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_get(struct ki_json_object* object, const char* name);
+// Returns val with given name in json object, replacing it with a copy first if it is shared, so it can be changed (see ki_json_val_share()).
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_get_mut(struct ki_json_object* object, const char* name);
+// Returns val with given name of name_length bytes in json object, see ki_json_object_get_mut().
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_getn_mut(struct ki_json_object* object, const char* name, size_t name_length);
+// Returns val with given name of name_length bytes in json object, name may contain '\0's.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_getn(struct ki_json_object* object, const char* name, size_t name_length);
+// Returns json object with given name in json object.
+// Returns NULL on fail.
+struct ki_json_object* ki_json_object_get_object(struct ki_json_object* object, const char* name);
+// Returns json array with given name in json object.
+// Returns NULL on fail.
+struct ki_json_array* ki_json_object_get_array(struct ki_json_object* object, const char* name);
+// Returns string with given name in json object.
+// Returns NULL on fail.
+char* ki_json_object_get_string(struct ki_json_object* object, const char* name);
+// Returns string with given name of name_length bytes in json object, outs its length.
+// Returns NULL on fail.
+char* ki_json_object_get_stringn(struct ki_json_object* object, const char* name, size_t name_length, size_t* length);
+// TODO: what to do on fail? ki_json_object_get_number
+// Returns number with given name in json object.
+// NOTE: Returns 0.0 on fail.
+double ki_json_object_get_number(struct ki_json_object* object, const char* name);
+// TODO: what to do on fail? ki_json_object_get_bool
+// Returns bool with given name in json object.
+// NOTE: Returns false on fail.
+bool ki_json_object_get_bool(struct ki_json_object* object, const char* name);
+// Returns name of pair at given index in json object.
+// Returns NULL on fail.
+const char* ki_json_object_name_at(const struct ki_json_object* object, size_t index);
+// Returns length of name of pair at given index in json object, 0 on fail.
+size_t ki_json_object_name_length_at(const struct ki_json_object* object, size_t index);
+// Returns value of pair at given index in json object.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_val_at(const struct ki_json_object* object, size_t index);
+
+//TODO: out error for add/insert new types?
+
+// Makes room for at least capacity pairs in json object, so adding up to that many doesn't reallocate.
+// NOTE: Never shrinks.
+// Returns true on success, false on fail.
+bool ki_json_object_reserve(struct ki_json_object* object, size_t capacity);
+// Adds json value to json object as given name.
+// NOTE 1: Ownership of value is given to json object, and will free it once done.
+// NOTE 2: Name is copied.
+enum ki_json_err_type ki_json_object_add(struct ki_json_object* object, const char* name, struct ki_json_val* value);
+// Adds json value to json object as given name of name_length bytes, name may contain '\0's.
+// NOTE 1: Ownership of value is given to json object, and will free it once done.
+// NOTE 2: Name is copied.
+enum ki_json_err_type ki_json_object_addn(struct ki_json_object* object, const char* name, size_t name_length, struct ki_json_val* value);
+// Adds json value to json object as given name, taking over name instead of copying it.
+// NOTE 1: Ownership of value & name is given to json object, and will free them once done. Both are left to the caller on fail.
+// NOTE 2: Name must be allocated using the allocator of the json object, strlen(name) + 1 bytes in size.
+enum ki_json_err_type ki_json_object_add_take_name(struct ki_json_object* object, char* name, struct ki_json_val* value);
+// Adds json value to json object as given null-terminated name of name_length bytes, taking over name instead of copying it.
+// NOTE 1: Ownership of value & name is given to json object, and will free them once done. Both are left to the caller on fail.
+// NOTE 2: Name must be allocated using the allocator of the json object, name_length + 1 bytes in size.
+enum ki_json_err_type ki_json_object_addn_take_name(struct ki_json_object* object, char* name, size_t name_length, struct ki_json_val* value);
+// Creates new json value for a json object and adds it to the json object.
+// NOTE: Name is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_add_new_object(struct ki_json_object* object, const char* name, size_t capacity);
+// Creates new json value for a json array and adds it to the json object.
+// NOTE: Name is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_add_new_array(struct ki_json_object* object, const char* name, size_t capacity);
+// Creates new json value for a string and adds it to the json object.
+// NOTE: Name & string is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_add_new_string(struct ki_json_object* object, const char* name, const char* string);
+// Creates new json value for a number and adds it to the json object.
+// NOTE: Name is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_add_new_number(struct ki_json_object* object, const char* name, double number);
+// Creates new json value for a bool and adds it to the json object.
+// NOTE: Name is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_add_new_bool(struct ki_json_object* object, const char* name, bool boolean);
+// Creates new json value representing null and adds it to the json object.
+// NOTE: Name is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_add_new_null(struct ki_json_object* object, const char* name);
+
+// Sets json value with given name in json object, adding it if there is no value with that name yet.
+// Old value with given name is freed.
+// NOTE 1: Ownership of value is given to json object, and will free it once done.
+// NOTE 2: Name is copied.
+enum ki_json_err_type ki_json_object_set(struct ki_json_object* object, const char* name, struct ki_json_val* value);
+// Sets json value with given name of name_length bytes in json object, see ki_json_object_set().
+enum ki_json_err_type ki_json_object_setn(struct ki_json_object* object, const char* name, size_t name_length, struct ki_json_val* value);
+
+// NOTE 1: Value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String is copied.
+// Returns true on success, false on fail.
+bool ki_json_object_set_string(struct ki_json_object* object, const char* name, const char* string);
+// NOTE: Value must be of type KI_JSON_VAL_NUMBER.
+// Returns true on success, false on fail.
+bool ki_json_object_set_number(struct ki_json_object* object, const char* name, double number);
+// NOTE: Value must be of type KI_JSON_VAL_BOOL.
+// Returns true on success, false on fail.
+bool ki_json_object_set_bool(struct ki_json_object* object, const char* name, bool boolean);
+
+// Removes pair with given name from json object, freeing it.
+// Returns true on success, false if there's no such pair.
+bool ki_json_object_remove(struct ki_json_object* object, const char* name);
+// Removes pair with given name of name_length bytes from json object, freeing it.
+// Returns true on success, false if there's no such pair.
+bool ki_json_object_removen(struct ki_json_object* object, const char* name, size_t name_length);
+
+/* Json array functions */
+
+// Inits json array using the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_array_init(struct ki_json_array* array, size_t capacity);
+// Inits json array using given allocator, NULL for the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_array_init_with_allocator(struct ki_json_array* array, size_t capacity, const struct ki_json_allocator* allocator);
+void ki_json_array_fini(struct ki_json_array* array);
+// Changes how json array holds its values, moving them over (see enum ki_json_array_storage).
+// Returns true on success, false on fail (array is left as it was).
+// NOTE: Fails for KI_JSON_ARRAY_STORAGE_NUMBERS if json array holds values that aren't numbers.
+bool ki_json_array_set_storage(struct ki_json_array* array, enum ki_json_array_storage storage);
+// Makes unused space of json array stay where values were last inserted or removed (a gap buffer),
+// instead of at the end, so repeatedly inserting or removing around the same index is amortized O(1).
+// Inserting or removing elsewhere moves only the values between there & the gap.
+// NOTE 1: Adding to the end & anything needing the values one after another (ki_json_array_numbers(), ...) moves the gap back to the end.
+// NOTE 2: With KI_JSON_ARRAY_STORAGE_INLINE, any insert or remove may move any value.
+void ki_json_array_set_gap_buffer(struct ki_json_array* array, bool gap_buffer);
+// Returns numbers of json array & outs their count (may be NULL), packing it first (see KI_JSON_ARRAY_STORAGE_NUMBERS).
+// NOTE: Numbers may be changed in place, the pointer stays valid until the array is changed otherwise.
+// Returns NULL if json array holds values that aren't numbers, or on fail.
+double* ki_json_array_numbers(struct ki_json_array* array, size_t* count);
+
+// Returns val at given index in json array.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_at(const struct ki_json_array* array, size_t index);
+// Returns val at given index in json array, replacing it with a copy first if it is shared, so it can be changed (see ki_json_val_share()).
+// NOTE: Unpacks json array with KI_JSON_ARRAY_STORAGE_NUMBERS to KI_JSON_ARRAY_STORAGE_BOXED.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_at_mut(struct ki_json_array* array, size_t index);
+// Returns json object at given index in json array.
+// Returns NULL on fail.
+struct ki_json_object* ki_json_array_object_at(struct ki_json_array* array, size_t index);
+// Returns json array at given index in json array.
+// Returns NULL on fail.
+struct ki_json_array* ki_json_array_array_at(struct ki_json_array* array, size_t index);
+// Returns string at given index in json array.
+// Returns NULL on fail.
+char* ki_json_array_string_at(struct ki_json_array* array, size_t index);
+// Returns string at given index in json array, outs its length.
+// Returns NULL on fail.
+char* ki_json_array_stringn_at(struct ki_json_array* array, size_t index, size_t* length);
+// TODO: what to do on fail? ki_json_array_get_number
+// Returns number at given index in json array.
+// NOTE: Returns 0.0 on fail.
+double ki_json_array_number_at(struct ki_json_array* array, size_t index);
+// TODO: what to do on fail? ki_json_array_get_bool
+// Returns bool at given index in json array.
+// NOTE: Returns false on fail.
+bool ki_json_array_bool_at(struct ki_json_array* array, size_t index);
+
+// Makes room for at least capacity values in json array, so adding up to that many doesn't reallocate.
+// NOTE: Never shrinks.
+// Returns true on success, false on fail.
+bool ki_json_array_reserve(struct ki_json_array* array, size_t capacity);
+
+// Adds json value to json array at given index.
+// NOTE 1: Ownership of value is given to json array, and will free it once done.
+// NOTE 2: Arrays with KI_JSON_ARRAY_STORAGE_INLINE or KI_JSON_ARRAY_STORAGE_NUMBERS move value into themselves, freeing the given value.
+enum ki_json_err_type ki_json_array_insert(struct ki_json_array* array, struct ki_json_val* value, size_t index);
+// Adds count json values to json array at given index, all or none of them.
+// NOTE: Ownership of values is given to json array, as with ki_json_array_insert().
+enum ki_json_err_type ki_json_array_insert_range(struct ki_json_array* array, size_t index, struct ki_json_val* const* values, size_t count);
+// Moves count values at src_index in json array src to json array dest at dest_index, all or none of them.
+// Values that are boxed in both arrays keep their nodes, so pointers to them stay valid.
+// NOTE: Arrays must differ.
+enum ki_json_err_type ki_json_array_move_range(struct ki_json_array* dest, size_t dest_index, struct ki_json_array* src, size_t src_index, size_t count);
+// Creates new json value for a json object and adds it to the json array at given index.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_insert_new_object(struct ki_json_array* array, size_t index, size_t capacity);
+// Creates new json value for a json array and adds it to the json array at given index.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_insert_new_array(struct ki_json_array* array, size_t index, size_t capacity);
+// Creates new json value for a string and adds it to the json array at given index.
+// NOTE: String is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_insert_new_string(struct ki_json_array* array, size_t index, const char* string);
+// Creates new json value for a number and adds it to the json array at given index.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_insert_new_number(struct ki_json_array* array, size_t index, double number);
+// Creates new json value for a bool and adds it to the json array at given index.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_insert_new_bool(struct ki_json_array* array, size_t index, bool boolean);
+// Creates new json value representing null and adds it to the json array at given index.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_insert_new_null(struct ki_json_array* array, size_t index);
+
+// Adds json value to the end of a json array.
+// NOTE: Ownership of value is given to json array, and will free it once done.
+enum ki_json_err_type ki_json_array_add(struct ki_json_array* array, struct ki_json_val* value);
+// Creates new json value for a json object and adds it to the end of a json array.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_add_new_object(struct ki_json_array* array, size_t capacity);
+// Creates new json value for a json array and adds it to the end of a json array.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_add_new_array(struct ki_json_array* array, size_t capacity);
+// Creates new json value for a string and adds it to the end of a json array.
+// NOTE: String is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_add_new_string(struct ki_json_array* array, const char* string);
+// Creates new json value for a number and adds it to the end of a json array.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_add_new_number(struct ki_json_array* array, double number);
+// Creates new json value for a bool and adds it to the end of a json array.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_add_new_bool(struct ki_json_array* array, bool boolean);
+// Creates new json value representing null and adds it to the end of a json array.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_add_new_null(struct ki_json_array* array);
+
+// Adds count numbers to the end of a json array, all or none of them.
+// NOTE: Empty arrays with KI_JSON_ARRAY_STORAGE_BOXED are packed (see KI_JSON_ARRAY_STORAGE_NUMBERS), so no values are allocated.
+enum ki_json_err_type ki_json_array_add_numbers(struct ki_json_array* array, const double* numbers, size_t count);
+// Adds count null-terminated strings to the end of a json array, all or none of them.
+// NOTE: Strings are copied.
+enum ki_json_err_type ki_json_array_add_strings(struct ki_json_array* array, const char* const* strings, size_t count);
+
+// Replaces json value at given index in json array with value, freeing the replaced one.
+// NOTE: Ownership of value is given to json array, as with ki_json_array_add().
+enum ki_json_err_type ki_json_array_set(struct ki_json_array* array, size_t index, struct ki_json_val* value);
+// NOTE 1: Value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String is copied.
+// Returns true on success, false on fail.
+bool ki_json_array_set_string(struct ki_json_array* array, size_t index, const char* string);
+// NOTE: Value must be of type KI_JSON_VAL_NUMBER.
+// Returns true on success, false on fail.
+bool ki_json_array_set_number(struct ki_json_array* array, size_t index, double number);
+// NOTE: Value must be of type KI_JSON_VAL_BOOL.
+// Returns true on success, false on fail.
+bool ki_json_array_set_bool(struct ki_json_array* array, size_t index, bool boolean);
+
+// Returns true on success, false on fail.
+bool ki_json_array_remove_at(struct ki_json_array* array, size_t index);
+// Removes count values starting at given index from json array.
+// Returns true on success, false on fail.
+bool ki_json_array_remove_range(struct ki_json_array* array, size_t index, size_t count);
+// Removes first occurence of reference to given json value.
+// Returns true on success, false on fail.
+bool ki_json_array_remove(struct ki_json_array* array, struct ki_json_val* value);
+
+/* Json val functions */
+
+// Creates a json value for a json object with given starting capacity.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_object(size_t capacity);
+// Creates a json value for a json array with given starting capacity.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_array(size_t capacity);
+// Creates a json value from a string.
+// NOTE: String is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_string(const char* string);
+// Creates a json value from a string of length bytes, string may contain '\0's.
+// NOTE: String is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_stringn(const char* string, size_t length);
+// Creates a json value from a string, taking over string instead of copying it.
+// NOTE: String must be allocated using the default allocator, strlen(string) + 1 bytes in size. It is left to the caller on fail.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_string_take(char* string);
+// Creates a json value from a null-terminated string of length bytes, taking over string instead of copying it.
+// NOTE: String must be allocated using the default allocator, length + 1 bytes in size. It is left to the caller on fail.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_stringn_take(char* string, size_t length);
+// Creates a json value from a double.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_number(double number);
+// Creates a json value from a bool.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_bool(bool boolean);
+// Creates a json value representing null.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_null(void);
+
+// Same as the create functions above, but the value and everything added to it later on is allocated using given allocator.
+// NULL uses the default allocator.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_object_with_allocator(size_t capacity, const struct ki_json_allocator* allocator);
+struct ki_json_val* ki_json_val_create_array_with_allocator(size_t capacity, const struct ki_json_allocator* allocator);
+struct ki_json_val* ki_json_val_create_from_string_with_allocator(const char* string, const struct ki_json_allocator* allocator);
+struct ki_json_val* ki_json_val_create_from_stringn_with_allocator(const char* string, size_t length, const struct ki_json_allocator* allocator);
+// NOTE: String must be allocated using given allocator.
+struct ki_json_val* ki_json_val_create_from_string_take_with_allocator(char* string, const struct ki_json_allocator* allocator);
+// NOTE: String must be allocated using given allocator.
+struct ki_json_val* ki_json_val_create_from_stringn_take_with_allocator(char* string, size_t length, const struct ki_json_allocator* allocator);
+struct ki_json_val* ki_json_val_create_from_number_with_allocator(double number, const struct ki_json_allocator* allocator);
+struct ki_json_val* ki_json_val_create_from_bool_with_allocator(bool boolean, const struct ki_json_allocator* allocator);
+struct ki_json_val* ki_json_val_create_null_with_allocator(const struct ki_json_allocator* allocator);
+
+bool ki_json_val_is_type(const struct ki_json_val* val, enum ki_json_val_type type);
+bool ki_json_val_is_object(const struct ki_json_val* val);
+bool ki_json_val_is_array(const struct ki_json_val* val);
+bool ki_json_val_is_string(const struct ki_json_val* val);
+bool ki_json_val_is_number(const struct ki_json_val* val);
+bool ki_json_val_is_bool(const struct ki_json_val* val);
+// NOTE: Checks for the json val null type, not for NULL.
+bool ki_json_val_is_null(const struct ki_json_val* val);
+
+// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String is copied, inside of the json value itself if it is shorter than KI_JSON_INLINE_STRING_SIZE.
+// Returns true on success, false on fail.
+bool ki_json_val_set_string(struct ki_json_val* val, const char* string);
+// Sets string of length bytes, string may contain '\0's.
+// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String is copied, inside of the json value itself if it is shorter than KI_JSON_INLINE_STRING_SIZE.
+// Returns true on success, false on fail.
+bool ki_json_val_set_stringn(struct ki_json_val* val, const char* string, size_t length);
+// Sets string, taking over string instead of copying it.
+// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String must be allocated using the allocator of the json value, strlen(string) + 1 bytes in size.
+// Strings shorter than KI_JSON_INLINE_STRING_SIZE are still copied into the json value, freeing string.
+// Returns true on success, false on fail (string is left to the caller).
+bool ki_json_val_set_string_take(struct ki_json_val* val, char* string);
+// Sets null-terminated string of length bytes, taking over string instead of copying it.
+// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String must be allocated using the allocator of the json value, length + 1 bytes in size.
+// Strings shorter than KI_JSON_INLINE_STRING_SIZE are still copied into the json value, freeing string.
+// Returns true on success, false on fail (string is left to the caller).
+bool ki_json_val_set_stringn_take(struct ki_json_val* val, char* string, size_t length);
+// Returns string of json value & outs its length (may be NULL).
+// Returns NULL if json value isn't a string.
+char* ki_json_val_get_stringn(const struct ki_json_val* val, size_t* length);
+
+// Deep copies json value & everything inside of it into a single allocation, using the allocator of val.
+// Freeing the clone using ki_json_val_free() frees that allocation in one go.
+// NOTE 1: Clone can be changed like any other tree, anything added to it is allocated separately.
+// NOTE 2: Values of the clone must not be moved into other trees, as they are freed along with it.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_clone(const struct ki_json_val* val);
+// Deep copies json value & everything inside of it into a single allocation, using given allocator (NULL = default).
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_clone_with_allocator(const struct ki_json_val* val, const struct ki_json_allocator* allocator);
+// Deep copies json value & everything inside of it into a single read-only allocation, using the allocator of val.
+// Lookups in the frozen copy never change it, so any number of threads can read it at once without locking.
+// Freeing it using ki_json_val_free() frees that allocation in one go.
+// NOTE 1: Objects get their hash index built up front & packed numbers of arrays are unpacked to inline values.
+// NOTE 2: Frozen values must not be changed, use ki_json_val_clone() to get a copy that can be changed.
+// Share the frozen copy between owners using ki_json_val_share(), see ki_json_snapshot_publish().
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_freeze(const struct ki_json_val* val);
+// Whether json value is part of a tree frozen using ki_json_val_freeze().
+bool ki_json_val_is_frozen(const struct ki_json_val* val);
+
+// Whether json values a & b are structurally equal.
+// Pairs of json objects may be in any order, values of json arrays must be in the same order.
+// Numbers are equal if they compare equal as doubles (0.0 equals -0.0).
+// NOTE: Neither value is changed, names are looked up in hash indices json objects already have, without building any.
+bool ki_json_val_equal(const struct ki_json_val* a, const struct ki_json_val* b);
+// Returns hash of json value & everything inside of it.
+// Equal json values (see ki_json_val_equal()) hash the same, so pairs of json objects may be in any order.
+// NOTE: Walks the whole tree every time, cache the hash of values that don't change (for ex.: frozen ones) if needed often,
+// ki_json_val_hash_each() hands out hashes of all values inside of it along the way.
+size_t ki_json_val_hash(const struct ki_json_val* val);
+// Returns hash of json value & everything inside of it (see ki_json_val_hash()), walking the tree only once to call visit
+// with each json value inside of it (val included) & its hash, so hashes of every subtree can be cached at once.
+// Values are visited before the json object or json array they are in.
+// NOTE: Numbers of packed arrays (see KI_JSON_ARRAY_STORAGE_NUMBERS) aren't json values, so they aren't visited.
+size_t ki_json_val_hash_each(const struct ki_json_val* val, void (*visit)(const struct ki_json_val* val, size_t hash, void* context), void* context);
+
+// Replaces every value inside of json value that is equal to another one inside of it by a share of that one (see ki_json_val_share()),
+// so each distinct value is held only once. Outs number of values replaced & bytes freed by that (stats may be NULL).
+// NOTE 1: Replaced values are shared afterwards, which makes changing them copy-on-write:
+// use ki_json_object_get_mut(), ki_json_array_at_mut() & ki_json_val_unshare() to change them.
+// NOTE 2: Values of arrays with KI_JSON_ARRAY_STORAGE_INLINE, values of clones & val itself are never replaced.
+// Shared & frozen json values aren't changed at all.
+// Returns true on success, false on fail (values replaced so far stay replaced).
+bool ki_json_val_dedup(struct ki_json_val* val, struct ki_json_dedup_stats* stats);
+
+// Frees json value and everything inside of it, using the allocator it was created with.
+// NOTE: Shared json values are only freed once every owner freed them.
+void ki_json_val_free(struct ki_json_val* val);
+
+// Shares json value with another owner instead of copying it, for ex.: to add it to another tree as well.
+// Returns val itself, or a copy of it if it can't be shared any further (or is part of a clone, see ki_json_val_clone()).
+// NOTE 1: Shared values must not be changed in place, as every owner would see it.
+// Use ki_json_val_unshare(), ki_json_object_get_mut() & ki_json_array_at_mut() to get copies that can be changed,
+// copying only the values on the way to what is changed.
+// NOTE 2: Values of arrays with KI_JSON_ARRAY_STORAGE_INLINE aren't allocated separately & can't be shared.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_share(struct ki_json_val* val);
+// Whether json value is owned by more than one owner.
+bool ki_json_val_is_shared(const struct ki_json_val* val);
+// Returns val itself if it isn't shared, otherwise gives up the caller's reference to it & returns a copy the caller owns alone.
+// Values inside of the copy are shared with val, not copied.
+// Returns NULL on fail (val is left to the caller).
+struct ki_json_val* ki_json_val_unshare(struct ki_json_val* val);
+
+/* Snapshots */
+
+// Inits snapshot, taking over val as its current version (may be NULL).
+void ki_json_snapshot_init(struct ki_json_snapshot* snapshot, struct ki_json_val* val);
+// Frees current version of snapshot.
+// NOTE: No thread may acquire from or publish to snapshot anymore.
+void ki_json_snapshot_fini(struct ki_json_snapshot* snapshot);
+// Returns current version of snapshot shared with the caller, who frees it using ki_json_val_free() once done reading.
+// Never locks, the version stays valid however often new ones are published meanwhile.
+// NOTE: Any number of threads may read it at once only if it was frozen (see ki_json_val_freeze()).
+// Returns NULL if there is no current version or on fail.
+struct ki_json_val* ki_json_snapshot_acquire(struct ki_json_snapshot* snapshot);
+// Makes val the current version of snapshot, taking it over.
+// Previous version is given up once every thread that may have loaded it without sharing it yet is done (grace period),
+// readers which acquired it free it once done.
+// NOTE: Waits for those readers, one publish to the same snapshot at a time.
+void ki_json_snapshot_publish(struct ki_json_snapshot* snapshot, struct ki_json_val* val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //KI_JSON_JSON_H
+
@@ -10,11 +10,48 @@ extern "C"
 {
 #endif
 
+// Size in bytes of the pieces ki_json_gen_canonical_write() hands to its writer (at most, besides long strings).
+#define KI_JSON_GEN_WRITE_SIZE 4096
+
+// Receives generated json piece by piece, see ki_json_gen_canonical_write().
+struct ki_json_writer
+{
+    // Takes length bytes of generated json, not null-terminated.
+    // Returns true on success, false to stop generating.
+    bool (*write)(const char* bytes, size_t length, void* context);
+    // User context given to write.
+    void* context;
+};
+
 // Generate string from json val.
-// Returned string must be freed once done.
+// Returned string must be freed once done, using the default allocator (free() unless changed).
 // Returns NULL on fail.
 char* ki_json_gen_string(struct ki_json_val* val);
 
+// Generate string from json val, allocated using given allocator (NULL = default).
+// Returned string of strlen() + 1 bytes must be freed using the same allocator once done.
+// Returns NULL on fail.
+char* ki_json_gen_string_with_allocator(struct ki_json_val* val, const struct ki_json_allocator* allocator);
+
+// Generate canonical json string (RFC 8785, JSON Canonicalization Scheme) from json val, for hashing & signing.
+// Pairs of json objects are sorted by name without changing them, numbers printed as ECMAScript does
+// & only what has to be escaped in strings is, without any whitespace.
+// Returned string must be freed once done, using the default allocator (free() unless changed).
+// NOTE 1: Order of pairs of big json objects is cached along with their hash index until they change,
+// so generating them again doesn't sort them again.
+// NOTE 2: NaN & infinities can't be printed, strings are expected to be valid UTF-8.
+// Returns NULL on fail.
+char* ki_json_gen_canonical(struct ki_json_val* val);
+// Generate canonical json string from json val, allocated using given allocator (NULL = default), see ki_json_gen_canonical().
+// Returned string of strlen() + 1 bytes must be freed using the same allocator once done.
+// Returns NULL on fail.
+char* ki_json_gen_canonical_with_allocator(struct ki_json_val* val, const struct ki_json_allocator* allocator);
+// Generates canonical json from json val piece by piece, handing the pieces to writer in order, see ki_json_gen_canonical().
+// Only a small buffer is used (allocated using the allocator of val), so a digest (for ex.: SHA-256) can be fed
+// without ever holding the whole string.
+// Returns true on success, false on fail (including writer failing, which stops generating).
+bool ki_json_gen_canonical_write(struct ki_json_val* val, const struct ki_json_writer* writer);
+
 #ifdef __cplusplus
 }
 #endif
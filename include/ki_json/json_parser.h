@@ -12,6 +12,9 @@ extern "C"
 {
 #endif
 
+// Amount of bytes that must be readable after a padded json string.
+#define KI_JSON_PADDING 64
+
 struct ki_json_parser_err
 {
     enum ki_json_err_type type;
@@ -19,6 +22,52 @@ struct ki_json_parser_err
     size_t pos;
 };
 
+// What to do when a name appears more than once inside the same json object.
+enum ki_json_duplicate_names
+{
+    KI_JSON_DUPLICATE_NAMES_ERROR = 0, //fail with KI_JSON_ERR_NAME_ALREADY_EXISTS
+    KI_JSON_DUPLICATE_NAMES_KEEP_FIRST = 1, //keep value of first pair with the name
+    KI_JSON_DUPLICATE_NAMES_KEEP_LAST = 2 //keep value of last pair with the name, at the position of the first
+};
+
+// How numbers are read.
+enum ki_json_number_mode
+{
+    KI_JSON_NUMBER_LENIENT = 0, //anything strtod() accepts made of digits, signs, dots & exponents (for ex.: .5, +1, 1.)
+    KI_JSON_NUMBER_STRICT = 1 //only numbers following the json grammar, fails with KI_JSON_ERR_INVALID_NUMBER otherwise
+};
+
+struct ki_json_parser_options
+{
+    // Maximum amount of nested objects & arrays, 0 for no limit.
+    // NOTE: Parsing is not recursive, so there is no limit needed to protect the stack.
+    size_t max_depth;
+    enum ki_json_duplicate_names duplicate_names;
+    enum ki_json_number_mode number_mode;
+    // Storage of parsed arrays, see enum ki_json_array_storage.
+    enum ki_json_array_storage array_storage;
+    // Whether arrays holding only numbers are packed (see KI_JSON_ARRAY_STORAGE_NUMBERS), off by default.
+    // Arrays starting with a number are parsed packed & unpacked to array_storage once anything else shows up.
+    bool pack_numbers;
+    // Allocator used for parsed trees, NULL for the default allocator.
+    const struct ki_json_allocator* allocator;
+};
+
+// Json string followed by KI_JSON_PADDING readable bytes, the first being '\0'.
+// Lets the parser skip most bounds checks while reading.
+struct ki_json_padded_string
+{
+    char* string;
+    // Length of json string, excluding padding
+    size_t length;
+    const struct ki_json_allocator* allocator;
+};
+
+// Reusable parser, keeping its buffers between parses.
+// Once warmed up, parsing allocates nothing but the resulting json trees themselves.
+// NOTE: A parser must not be used by multiple threads at once.
+struct ki_json_parser;
+
 // Parse null-terminated string to a json tree.
 // Val returned must be freed using ki_json_val_free() when done.
 // Returns NULL on fail and outs error to err.
@@ -29,6 +78,48 @@ struct ki_json_val* ki_json_parse_string(const char* string, struct ki_json_pars
 // Returns NULL on fail and outs error to err.
 struct ki_json_val* ki_json_nparse_string(const char* string, size_t n, struct ki_json_parser_err* err);
 
+// Parse no more than n characters of string to a json tree, allocating it using given allocator (NULL = default).
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_nparse_string_with_allocator(const char* string, size_t n, const struct ki_json_allocator* allocator, struct ki_json_parser_err* err);
+
+// Copies length bytes of string into a new padded string, allocated using the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_padded_string_init(struct ki_json_padded_string* padded, const char* string, size_t length);
+void ki_json_padded_string_fini(struct ki_json_padded_string* padded);
+
+// Parse padded string to a json tree.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_parse_padded_string(const struct ki_json_padded_string* padded, struct ki_json_parser_err* err);
+
+// Returns default parser options, also used by the ki_json_parse functions above.
+struct ki_json_parser_options ki_json_parser_options_default(void);
+
+// Creates reusable parser with given options (NULL for default options).
+// Buffers of the parser itself are allocated using the default allocator.
+// Returns NULL on fail.
+struct ki_json_parser* ki_json_parser_create(const struct ki_json_parser_options* options);
+void ki_json_parser_free(struct ki_json_parser* parser);
+
+// Forgets any state left behind by the last parse, keeping all buffers. O(1).
+// NOTE: Parsing resets the parser by itself as well.
+void ki_json_parser_reset(struct ki_json_parser* parser);
+
+// Returns options of parser, may be changed in between parses.
+struct ki_json_parser_options* ki_json_parser_get_options(struct ki_json_parser* parser);
+
+// Parse no more than n characters of string to a json tree, using parser's options & buffers.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_parser_parse(struct ki_json_parser* parser, const char* string, size_t n, struct ki_json_parser_err* err);
+
+// Same as ki_json_parser_parse(), but string must be followed by KI_JSON_PADDING readable bytes, the first being '\0'.
+// Skips most bounds checks, see ki_json_padded_string for a way to pad strings.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_parser_parse_padded(struct ki_json_parser* parser, const char* string, size_t n, struct ki_json_parser_err* err);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,49 @@
+#ifndef KI_JSON_PATCH_H
+#define KI_JSON_PATCH_H
+
+// Functions for finding differences between json trees as JSON Patches (RFC 6902) & applying JSON Patches & JSON Merge Patches (RFC 7386)
+
+#include "ki_json/json.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Returns JSON Patch (RFC 6902) turning json value a into json value b, a json array of "add", "remove" & "replace" operations.
+// Values equal in both (the very same values first of all, see ki_json_val_share()) are skipped without looking into them,
+// values of arrays are matched up by their longest common subsequence after skipping equal values at their start & end.
+// NOTE 1: Values in the patch are shared with b (see ki_json_val_share()), free the patch using ki_json_val_free().
+// NOTE 2: Looking up names may build hash indices of big json objects, like ki_json_object_get() does.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_diff(struct ki_json_val* a, struct ki_json_val* b);
+
+// Applies JSON Patch (RFC 6902) patch to json value *doc in place, one operation after another.
+// Only the values on the way to what is changed are looked at, values are shared with the patch instead of copied.
+// NOTE 1: *doc may be replaced, by operations on the root or when it is shared (see ki_json_val_unshare()).
+// NOTE 2: Operations applied before one fails stay applied, see ki_json_patch_apply_atomic().
+// NOTE 3: Frozen values can't be patched (see ki_json_val_freeze()), failing with KI_JSON_ERR_INVALID_ARGS.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_INVALID_PATCH, KI_JSON_ERR_PATH_NOT_FOUND, KI_JSON_ERR_OUT_OF_BOUNDS,
+// KI_JSON_ERR_TEST_FAILED or KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_patch_apply(struct ki_json_val** doc, struct ki_json_val* patch);
+// Applies JSON Patch (RFC 6902) patch to json value *doc in place, all operations or none of them, see ki_json_patch_apply().
+// Every change is logged along with what it replaced, undoing them in reverse order on fail.
+// NOTE: Values removed & added back on fail end up last in their json objects.
+enum ki_json_err_type ki_json_patch_apply_atomic(struct ki_json_val** doc, struct ki_json_val* patch);
+
+// Merges JSON Merge Patch (RFC 7386) patch into json value *doc in place:
+// json objects are merged name by name, null removes the value of a name & anything else replaces what is there.
+// NOTE 1: *doc may be replaced, by patches that aren't json objects or when it is shared (see ki_json_val_unshare()).
+// NOTE 2: Values merged before failing stay merged, see ki_json_merge_patch_atomic().
+// NOTE 3: Frozen values can't be patched (see ki_json_val_freeze()), failing with KI_JSON_ERR_INVALID_ARGS.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_merge_patch(struct ki_json_val** doc, struct ki_json_val* patch);
+// Merges JSON Merge Patch (RFC 7386) patch into json value *doc in place, completely or not at all, see ki_json_merge_patch().
+// NOTE: Values removed & added back on fail end up last in their json objects.
+enum ki_json_err_type ki_json_merge_patch_atomic(struct ki_json_val** doc, struct ki_json_val* patch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //KI_JSON_PATCH_H
@@ -0,0 +1,63 @@
+#ifndef KI_JSON_PATH_H
+#define KI_JSON_PATH_H
+
+// Functions for querying json trees & json text by JSONPath (RFC 9535), compiled once & run many times
+
+#include <stddef.h>
+
+#include "ki_json/json.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// JSONPath query compiled to a small program: one op per segment, followed by ops for its selectors.
+// Filters are compiled to postfix expressions, so running a query never recurses.
+// Supported are name, wildcard, index, slice & filter selectors in child & descendant segments.
+// Filters may compare & test singular queries (names & indices only, relative to the current node "@" or the root "$")
+// & literals, combined by "&&", "||", "!" & parentheses. Function extensions (length(), count(), ...) aren't supported.
+// NOTE: Any number of threads may run the same query at once.
+struct ki_json_path;
+
+// Value matched in json text by ki_json_path_query_string().
+struct ki_json_path_match
+{
+    // Offset of the first byte of the value in the json text
+    size_t offset;
+    // Length of the value in bytes
+    size_t length;
+};
+
+// Compiles null-terminated JSONPath query, for ex.: "$.store.book[?@.price < 10].title".
+// Path must be freed using ki_json_path_free() when done.
+// Returns NULL on fail (invalid or unsupported query or allocation fail).
+struct ki_json_path* ki_json_path_compile(const char* path);
+// Compiles JSONPath query of length bytes, see ki_json_path_compile().
+// Returns NULL on fail.
+struct ki_json_path* ki_json_path_compilen(const char* path, size_t length);
+void ki_json_path_free(struct ki_json_path* path);
+
+// Runs compiled path on json tree val, outs the values it selects to results in the order RFC 9535 gives them.
+// Results has room for capacity values (may be NULL if 0), only the first capacity values are written.
+// Outs amount of values selected to count, which may be more than capacity.
+// NOTE: Looking up names may build hash indices of big json objects, like ki_json_object_get() does,
+// & numbers of packed arrays are unpacked when selected from (see KI_JSON_ARRAY_STORAGE_NUMBERS).
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_path_query(const struct ki_json_path* path, struct ki_json_val* val, struct ki_json_val** results, size_t capacity, size_t* count);
+// Runs compiled path on json text of length bytes while reading it, without parsing it to a json tree.
+// Outs where the values it selects are in json to matches, see ki_json_path_query().
+// Values are skipped without being looked into once path can't select anything inside of them,
+// filters find the values they refer to in the text of the value they are run on & parse only those (one at a time),
+// json arrays are counted first for negative indices.
+// NOTE 1: Values are matched once each in the order they appear in json, unlike in ki_json_path_query().
+// NOTE 2: Paths with more than 63 segments or filters referring to the root ("$") can't be run on json text,
+// failing with KI_JSON_ERR_INVALID_ARGS.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_INVALID_ARGS, KI_JSON_ERR_MEMORY or the error parsing json fails with on fail.
+enum ki_json_err_type ki_json_path_query_string(const struct ki_json_path* path, const char* json, size_t length, struct ki_json_path_match* matches, size_t capacity, size_t* count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //KI_JSON_PATH_H
@@ -0,0 +1,56 @@
+#ifndef KI_JSON_POINTER_H
+#define KI_JSON_POINTER_H
+
+// Functions for looking up values of json trees by JSON Pointers (RFC 6901), compiled once & resolved many times
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "ki_json/json.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// JSON Pointer split into its reference tokens ahead of time: unescaped, with the hashes of names & array indices worked out.
+// Names are looked for where they were found last time first, so documents of the same layout skip looking them up.
+// NOTE: Any number of threads may resolve the same pointer at once.
+struct ki_json_pointer;
+
+// Compiles null-terminated JSON Pointer, for ex.: "/a/b/0/c" ("" refers to the whole tree).
+// Pointer must be freed using ki_json_pointer_free() when done.
+// Returns NULL on fail (invalid pointer or allocation fail).
+struct ki_json_pointer* ki_json_pointer_compile(const char* pointer);
+// Compiles JSON Pointer of length bytes, see ki_json_pointer_compile().
+// Returns NULL on fail.
+struct ki_json_pointer* ki_json_pointer_compilen(const char* pointer, size_t length);
+void ki_json_pointer_free(struct ki_json_pointer* pointer);
+
+// Returns amount of reference tokens of compiled pointer, 0 for the whole tree.
+size_t ki_json_pointer_count(const struct ki_json_pointer* pointer);
+
+// Returns val referred to by compiled pointer in json tree val.
+// NOTE: Looking up names may build hash indices of big json objects, like ki_json_object_get() does,
+// & numbers of packed arrays are unpacked (see KI_JSON_ARRAY_STORAGE_NUMBERS).
+// Returns NULL if there is none.
+struct ki_json_val* ki_json_pointer_get(const struct ki_json_pointer* pointer, struct ki_json_val* val);
+// Sets val referred to by compiled pointer in json tree *val to value, adding it if there is none yet.
+// Json objects get a pair with the name added, json arrays get value added to their end for "-" or an index equal to their count.
+// Shared values on the way are replaced with copies first (see ki_json_object_get_mut()).
+// NOTE 1: Ownership of value is given to the tree, and will be freed once done. Value is left to the caller on fail.
+// NOTE 2: *val is replaced if pointer refers to the whole tree or it is shared (see ki_json_val_unshare()).
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_PATH_NOT_FOUND, KI_JSON_ERR_OUT_OF_BOUNDS or KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_pointer_set(const struct ki_json_pointer* pointer, struct ki_json_val** val, struct ki_json_val* value);
+// Removes val referred to by compiled pointer from json tree *val.
+// Shared values on the way are replaced with copies first (see ki_json_object_get_mut()).
+// NOTE 1: The whole tree can't be removed.
+// NOTE 2: *val is replaced if it is shared (see ki_json_val_unshare()).
+// Returns true on success, false on fail.
+bool ki_json_pointer_remove(const struct ki_json_pointer* pointer, struct ki_json_val** val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //KI_JSON_POINTER_H
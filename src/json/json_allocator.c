@@ -0,0 +1,142 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "json_internal.h"
+
+static void* stdlib_malloc(size_t size, void* context)
+{
+    (void)context;
+    return malloc(size);
+}
+
+static void* stdlib_realloc(void* ptr, size_t old_size, size_t new_size, void* context)
+{
+    (void)old_size;
+    (void)context;
+    return realloc(ptr, new_size);
+}
+
+static void stdlib_free(void* ptr, size_t size, void* context)
+{
+    (void)size;
+    (void)context;
+    free(ptr);
+}
+
+static const struct ki_json_allocator stdlib_allocator = {
+    .malloc = stdlib_malloc,
+    .realloc = stdlib_realloc,
+    .free = stdlib_free,
+    .context = NULL
+};
+
+static const struct ki_json_allocator* default_allocator = &stdlib_allocator;
+
+/* Public */
+
+// Returns allocator wrapping malloc, realloc & free of the c standard library.
+const struct ki_json_allocator* ki_json_allocator_get_stdlib(void)
+{
+    return &stdlib_allocator;
+}
+
+// Returns process-wide default allocator, used whenever no allocator is given.
+const struct ki_json_allocator* ki_json_allocator_get_default(void)
+{
+    return default_allocator;
+}
+
+// Sets process-wide default allocator, NULL resets it to the stdlib allocator.
+// NOTE 1: Allocator must stay valid for as long as trees allocated with it exist.
+// NOTE 2: Not thread-safe, set it before creating or parsing any json trees.
+void ki_json_allocator_set_default(const struct ki_json_allocator* allocator)
+{
+    assert(allocator == NULL || (allocator->malloc && allocator->realloc && allocator->free));
+
+    default_allocator = (allocator != NULL) ? allocator : &stdlib_allocator;
+}
+
+/* Internal */
+
+// Returns given allocator, or the default allocator if NULL.
+const struct ki_json_allocator* ki_json_allocator_resolve(const struct ki_json_allocator* allocator)
+{
+    return (allocator != NULL) ? allocator : default_allocator;
+}
+
+// Allocates size bytes using allocator (NULL = default).
+// Returns NULL on fail.
+void* ki_json_alloc(const struct ki_json_allocator* allocator, size_t size)
+{
+    allocator = ki_json_allocator_resolve(allocator);
+
+    //never ask allocators for 0 bytes, as some return NULL for it
+    return allocator->malloc((size > 0) ? size : 1, allocator->context);
+}
+
+// Allocates count * size zeroed bytes using allocator (NULL = default).
+// Returns NULL on fail.
+void* ki_json_calloc(const struct ki_json_allocator* allocator, size_t count, size_t size)
+{
+    //overflow
+    if (size != 0 && count > SIZE_MAX / size)
+        return NULL;
+
+    void* ptr = ki_json_alloc(allocator, count * size);
+
+    if (ptr != NULL)
+        memset(ptr, 0, count * size);
+
+    return ptr;
+}
+
+// Resizes memory at ptr of old_size bytes to new_size bytes using allocator (NULL = default).
+// Returns NULL on fail, ptr is left untouched in that case.
+void* ki_json_realloc(const struct ki_json_allocator* allocator, void* ptr, size_t old_size, size_t new_size)
+{
+    if (ptr == NULL)
+        return ki_json_alloc(allocator, new_size);
+
+    allocator = ki_json_allocator_resolve(allocator);
+
+    return allocator->realloc(ptr, (old_size > 0) ? old_size : 1, (new_size > 0) ? new_size : 1, allocator->context);
+}
+
+// Frees memory at ptr of size bytes using allocator (NULL = default).
+void ki_json_dealloc(const struct ki_json_allocator* allocator, void* ptr, size_t size)
+{
+    if (ptr == NULL)
+        return;
+
+    allocator = ki_json_allocator_resolve(allocator);
+    allocator->free(ptr, (size > 0) ? size : 1, allocator->context);
+}
+
+// Copies length bytes of string into a new null-terminated string, allocated using allocator (NULL = default).
+// Returns NULL on fail.
+char* ki_json_strndup(const struct ki_json_allocator* allocator, const char* string, size_t length)
+{
+    assert(string);
+
+    char* copy = ki_json_alloc(allocator, length + 1);
+
+    if (copy == NULL)
+        return NULL;
+
+    memcpy(copy, string, length);
+    copy[length] = '\0'; //null-terminator
+
+    return copy;
+}
+
+// Frees null-terminated string of length (excluding null-terminator) allocated using allocator (NULL = default).
+void ki_json_strfree(const struct ki_json_allocator* allocator, char* string, size_t length)
+{
+    if (string != NULL)
+        ki_json_dealloc(allocator, string, length + 1);
+}
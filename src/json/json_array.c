@@ -1,23 +1,127 @@
 #include "ki_json/json.h"
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
+#include "json_internal.h"
+
+// Returns size in bytes of a single value in the data of a json array with given storage.
+size_t ki_json_array_slot_size(enum ki_json_array_storage storage)
+{
+    switch (storage)
+    {
+        case KI_JSON_ARRAY_STORAGE_INLINE:
+            return sizeof(struct ki_json_val);
+        case KI_JSON_ARRAY_STORAGE_NUMBERS:
+            return sizeof(double);
+        default: //KI_JSON_ARRAY_STORAGE_BOXED
+            return sizeof(struct ki_json_val*);
+    }
+}
+
+// Returns slot in the data of json array holding value at given index, skipping over the gap (see ki_json_array_set_gap_buffer()).
+static size_t ki_json_array_slot_of(const struct ki_json_array* array, size_t index)
+{
+    return (index < array->count - array->tail_count) ? index : index + (array->capacity - array->count);
+}
+
+// Returns address of given slot in the data of json array.
+static char* ki_json_array_slot(const struct ki_json_array* array, size_t slot)
+{
+    return (char*)array->data.values + ki_json_array_slot_size(array->storage) * slot;
+}
+
+// Copies bytes of value at given index in json array into val, making a json value for packed numbers.
+// NOTE: Val must be relocated once copied to where it stays.
+static void ki_json_array_copy_out(const struct ki_json_array* array, size_t index, struct ki_json_val* val)
+{
+    size_t slot = ki_json_array_slot_of(array, index);
+
+    switch (array->storage)
+    {
+        case KI_JSON_ARRAY_STORAGE_INLINE:
+            *val = array->data.elements[slot];
+            break;
+        case KI_JSON_ARRAY_STORAGE_NUMBERS:
+            memset(val, 0, sizeof(*val));
+            val->type = KI_JSON_VAL_NUMBER;
+            val->allocator = array->allocator;
+            val->value.number = array->data.numbers[slot];
+            break;
+        default: //KI_JSON_ARRAY_STORAGE_BOXED
+            *val = *array->data.values[slot];
+            break;
+    }
+}
+
+// Fixes up inline values in slots from start up to end after they were moved.
+static void ki_json_array_relocate(struct ki_json_array* array, size_t start, size_t end)
+{
+    if (array->storage != KI_JSON_ARRAY_STORAGE_INLINE)
+        return;
+
+    for (size_t i = start; i < end; i++)
+        ki_json_val_relocate(&array->data.elements[i]);
+}
+
+// Moves the gap of json array to right before value at given index, so values from index onwards come after it.
+// NOTE: Moving it to count closes it, leaving all values at the start.
+static void ki_json_array_move_gap(struct ki_json_array* array, size_t index)
+{
+    size_t head_count = array->count - array->tail_count;
+    size_t gap_size = array->capacity - array->count;
+    size_t slot_size = ki_json_array_slot_size(array->storage);
+
+    if (index < head_count)
+    {
+        //move values between index & the gap to after it
+        memmove(ki_json_array_slot(array, index + gap_size), ki_json_array_slot(array, index), slot_size * (head_count - index));
+        ki_json_array_relocate(array, index + gap_size, head_count + gap_size);
+    }
+    else if (index > head_count)
+    {
+        //move values between the gap & index to before it
+        memmove(ki_json_array_slot(array, head_count), ki_json_array_slot(array, head_count + gap_size), slot_size * (index - head_count));
+        ki_json_array_relocate(array, head_count, index);
+    }
+
+    array->tail_count = array->count - index;
+}
+
+// Inits json array using the default allocator.
+// Returns true on success, false on fail.
 bool ki_json_array_init(struct ki_json_array* array, size_t capacity)
+{
+    return ki_json_array_init_with_allocator(array, capacity, NULL);
+}
+
+// Inits json array using given allocator, NULL for the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_array_init_with_allocator(struct ki_json_array* array, size_t capacity, const struct ki_json_allocator* allocator)
+{
+    return ki_json_array_init_with_storage(array, capacity, KI_JSON_ARRAY_STORAGE_BOXED, allocator);
+}
+
+// Inits json array holding its values as given by storage, using given allocator (NULL = default).
+// Returns true on success, false on fail.
+bool ki_json_array_init_with_storage(struct ki_json_array* array, size_t capacity, enum ki_json_array_storage storage, const struct ki_json_allocator* allocator)
 {
     assert(array);
 
+    array->allocator = ki_json_allocator_resolve(allocator);
     array->capacity = capacity;
     array->count = 0;
+    array->storage = storage;
+    array->tail_count = 0;
+    array->gap_buffer = false;
 
-    array->values = calloc(array->capacity, sizeof(*array->values));
+    array->data.values = ki_json_calloc(array->allocator, array->capacity, ki_json_array_slot_size(storage));
 
-    if (array->values == NULL)
-    {
-        free(array);
+    if (array->data.values == NULL)
         return false;
-    }
     
     return true;
 }
@@ -26,35 +130,296 @@ void ki_json_array_fini(struct ki_json_array* array)
 {
     assert(array);
 
-    if (array->values != NULL)
+    if (array->data.values != NULL)
     {
         for (size_t i = 0; i < array->count; i++)
-            ki_json_val_free(array->values[i]);
+        {
+            size_t slot = ki_json_array_slot_of(array, i);
+
+            if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+                ki_json_val_fini(&array->data.elements[slot]);
+            else if (array->storage == KI_JSON_ARRAY_STORAGE_BOXED)
+                ki_json_val_free(array->data.values[slot]);
+        }
 
-        free(array->values);
-        array->values = NULL;
+        ki_json_dealloc(array->allocator, array->data.values, ki_json_array_slot_size(array->storage) * array->capacity);
+        array->data.values = NULL;
     }
 
     array->count = 0;
     array->capacity = 0;
+    array->tail_count = 0;
+}
+
+// Makes unused space of json array stay where values were last inserted or removed (a gap buffer),
+// instead of at the end, so repeatedly inserting or removing around the same index is amortized O(1).
+// Inserting or removing elsewhere moves only the values between there & the gap.
+// NOTE 1: Adding to the end & anything needing the values one after another (ki_json_array_numbers(), ...) moves the gap back to the end.
+// NOTE 2: With KI_JSON_ARRAY_STORAGE_INLINE, any insert or remove may move any value.
+void ki_json_array_set_gap_buffer(struct ki_json_array* array, bool gap_buffer)
+{
+    assert(array);
+
+    if (!gap_buffer)
+        ki_json_array_move_gap(array, array->count);
+
+    array->gap_buffer = gap_buffer;
+}
+
+// Frees copies made by ki_json_array_copy_shared() among the first done of count values, which weren't moved anywhere.
+static void ki_json_array_free_copies(const struct ki_json_allocator* allocator, struct ki_json_val* const* values, struct ki_json_val** copies, size_t done, size_t count)
+{
+    if (copies == NULL)
+        return;
+
+    for (size_t i = 0; i < done; i++)
+    {
+        if (copies[i] != values[i])
+            ki_json_val_free(copies[i]);
+    }
+
+    ki_json_dealloc(allocator, copies, sizeof(*copies) * count);
+}
+
+// Whether boxed value can't be moved into an inline slot as it is.
+// Shared values would be taken away from their other owners, roots of clones free everything inside of them along with their node.
+static bool ki_json_array_needs_copy(const struct ki_json_val* value)
+{
+    return ki_json_val_is_shared(value) || ki_json_clone_is_root(value);
+}
+
+// Copies shared values among count boxed values, as moving them into inline slots would take them away from their other owners.
+// Outs NULL if none of them are shared, otherwise count values to move instead: copies of shared values & the others as they are.
+// NOTE: Roots of clones are copied the same way, see ki_json_array_needs_copy().
+// Returns true on success, false on fail.
+static bool ki_json_array_copy_shared(const struct ki_json_allocator* allocator, struct ki_json_val* const* values, size_t count, struct ki_json_val*** copies)
+{
+    *copies = NULL;
+
+    size_t first_shared = 0;
+
+    while (first_shared < count && !ki_json_array_needs_copy(values[first_shared]))
+        first_shared++;
+
+    if (first_shared == count)
+        return true;
+
+    struct ki_json_val** moved = ki_json_alloc(allocator, sizeof(*moved) * count);
+
+    if (moved == NULL)
+        return false;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        moved[i] = ki_json_array_needs_copy(values[i]) ? ki_json_val_copy_shallow(values[i]) : values[i];
+
+        if (moved[i] == NULL)
+        {
+            ki_json_array_free_copies(allocator, values, moved, i, count);
+            return false;
+        }
+    }
+
+    *copies = moved;
+
+    return true;
+}
+
+// Moves boxed value into inline slot, freeing its node.
+// Copy is what ki_json_array_copy_shared() made of value (NULL if nothing), which is moved instead, giving up the reference to value.
+static void ki_json_array_move_into(struct ki_json_val* slot, struct ki_json_val* value, struct ki_json_val* copy)
+{
+    bool copied = (copy != NULL && copy != value);
+    struct ki_json_val* moved = copied ? copy : value;
+
+    *slot = *moved;
+    ki_json_val_relocate(slot);
+    ki_json_val_dealloc(moved);
+
+    if (copied)
+        ki_json_val_free(value);
+}
+
+// Changes how json array holds its values, moving them over (see enum ki_json_array_storage).
+// Returns true on success, false on fail (array is left as it was).
+bool ki_json_array_set_storage(struct ki_json_array* array, enum ki_json_array_storage storage)
+{
+    assert(array);
+
+    if (array->storage == storage)
+        return true;
+
+    //values are moved over one after another
+    ki_json_array_move_gap(array, array->count);
+
+    //only numbers can be packed
+    if (storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        for (size_t i = 0; i < array->count; i++)
+        {
+            const struct ki_json_val* val = (array->storage == KI_JSON_ARRAY_STORAGE_INLINE) ? &array->data.elements[i] : array->data.values[i];
+
+            if (val->type != KI_JSON_VAL_NUMBER)
+                return false;
+        }
+    }
+
+    //inline values can't be shared, copy shared ones first
+    struct ki_json_val** copies = NULL;
+    bool boxed_to_inline = (array->storage == KI_JSON_ARRAY_STORAGE_BOXED && storage == KI_JSON_ARRAY_STORAGE_INLINE);
+
+    if (boxed_to_inline && !ki_json_array_copy_shared(array->allocator, array->data.values, array->count, &copies))
+        return false;
+
+    size_t slot_size = ki_json_array_slot_size(storage);
+    void* new_data = ki_json_calloc(array->allocator, array->capacity, slot_size);
+
+    if (new_data == NULL)
+    {
+        ki_json_array_free_copies(array->allocator, array->data.values, copies, array->count, array->count);
+        return false;
+    }
+
+    //box every value, all boxes are allocated first so nothing has to be undone afterwards
+    if (storage == KI_JSON_ARRAY_STORAGE_BOXED)
+    {
+        struct ki_json_val** values = new_data;
+
+        for (size_t i = 0; i < array->count; i++)
+        {
+            const struct ki_json_allocator* allocator = (array->storage == KI_JSON_ARRAY_STORAGE_INLINE) ? array->data.elements[i].allocator : array->allocator;
+            values[i] = ki_json_val_alloc(allocator, KI_JSON_VAL_NULL);
+
+            if (values[i] == NULL)
+            {
+                for (size_t j = 0; j < i; j++)
+                    ki_json_val_dealloc(values[j]);
+
+                ki_json_dealloc(array->allocator, new_data, slot_size * array->capacity);
+                return false;
+            }
+        }
+    }
+
+    //move values over, freeing old boxes
+    for (size_t i = 0; i < array->count; i++)
+    {
+        if (boxed_to_inline)
+        {
+            ki_json_array_move_into(&((struct ki_json_val*)new_data)[i], array->data.values[i], (copies != NULL) ? copies[i] : NULL);
+            continue;
+        }
+
+        struct ki_json_val val;
+        ki_json_array_copy_out(array, i, &val);
+
+        //only numbers are left to unbox here, shared ones only lose this reference
+        if (array->storage == KI_JSON_ARRAY_STORAGE_BOXED)
+            ki_json_val_free(array->data.values[i]);
+
+        switch (storage)
+        {
+            case KI_JSON_ARRAY_STORAGE_INLINE:
+                ((struct ki_json_val*)new_data)[i] = val;
+                ki_json_val_relocate(&((struct ki_json_val*)new_data)[i]);
+                break;
+            case KI_JSON_ARRAY_STORAGE_NUMBERS:
+                ((double*)new_data)[i] = val.value.number;
+                break;
+            default: //KI_JSON_ARRAY_STORAGE_BOXED
+                *((struct ki_json_val**)new_data)[i] = val;
+                ki_json_val_relocate(((struct ki_json_val**)new_data)[i]);
+                break;
+        }
+    }
+
+    ki_json_array_free_copies(array->allocator, array->data.values, copies, 0, array->count);
+    ki_json_dealloc(array->allocator, array->data.values, ki_json_array_slot_size(array->storage) * array->capacity);
+
+    array->data.values = new_data;
+    array->storage = storage;
+
+    return true;
+}
+
+// Returns numbers of json array & outs their count (may be NULL), packing it first (see KI_JSON_ARRAY_STORAGE_NUMBERS).
+// NOTE: Numbers may be changed in place, the pointer stays valid until the array is changed otherwise.
+// Returns NULL if json array holds values that aren't numbers, or on fail.
+double* ki_json_array_numbers(struct ki_json_array* array, size_t* count)
+{
+    assert(array);
+
+    if (!ki_json_array_set_storage(array, KI_JSON_ARRAY_STORAGE_NUMBERS))
+        return NULL;
+
+    ki_json_array_move_gap(array, array->count);
+
+    if (count != NULL)
+        *count = array->count;
+
+    return array->data.numbers;
 }
 
 /* Getting values */
 
-struct ki_json_val* ki_json_array_at(struct ki_json_array* array, size_t index)
+struct ki_json_val* ki_json_array_at(const struct ki_json_array* array, size_t index)
+{
+    assert(array);
+
+    //packed numbers aren't json values, so there is nothing to point to
+    if (index >= array->count || array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return NULL;
+
+    size_t slot = ki_json_array_slot_of(array, index);
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+        return &array->data.elements[slot];
+
+    return array->data.values[slot];
+}
+
+// Returns val at given index in json array, unpacking json array with KI_JSON_ARRAY_STORAGE_NUMBERS
+// to KI_JSON_ARRAY_STORAGE_BOXED first.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_unpacked_at(struct ki_json_array* array, size_t index)
 {
     assert(array);
 
     if (index >= array->count)
         return NULL;
 
-    return array->values[index];
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS && !ki_json_array_set_storage(array, KI_JSON_ARRAY_STORAGE_BOXED))
+        return NULL;
+
+    return ki_json_array_at(array, index);
+}
+
+// Returns val at given index in json array, replacing it with a copy first if it is shared, so it can be changed (see ki_json_val_share()).
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_at_mut(struct ki_json_array* array, size_t index)
+{
+    struct ki_json_val* val = ki_json_array_unpacked_at(array, index);
+
+    //only boxed values can be shared
+    if (val == NULL || array->storage != KI_JSON_ARRAY_STORAGE_BOXED)
+        return val;
+
+    val = ki_json_val_unshare(val);
+
+    if (val != NULL)
+        array->data.values[ki_json_array_slot_of(array, index)] = val;
+
+    return val;
 }
 
 // Returns json object at given index in json array.
 // Returns NULL on fail.
 struct ki_json_object* ki_json_array_object_at(struct ki_json_array* array, size_t index)
 {
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return NULL;
+
     struct ki_json_val* val = ki_json_array_at(array, index);
 
     if (val == NULL || val->type != KI_JSON_VAL_OBJECT)
@@ -67,6 +432,10 @@ struct ki_json_object* ki_json_array_object_at(struct ki_json_array* array, size
 // Returns NULL on fail.
 struct ki_json_array* ki_json_array_array_at(struct ki_json_array* array, size_t index)
 {
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return NULL;
+
     struct ki_json_val* val = ki_json_array_at(array, index);
 
     if (val == NULL || val->type != KI_JSON_VAL_ARRAY)
@@ -79,6 +448,10 @@ struct ki_json_array* ki_json_array_array_at(struct ki_json_array* array, size_t
 // Returns NULL on fail.
 char* ki_json_array_string_at(struct ki_json_array* array, size_t index)
 {
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return NULL;
+
     struct ki_json_val* val = ki_json_array_at(array, index);
 
     if (val == NULL || val->type != KI_JSON_VAL_STRING)
@@ -87,10 +460,24 @@ char* ki_json_array_string_at(struct ki_json_array* array, size_t index)
     return val->value.string;
 }
 
+// Returns string at given index in json array, outs its length.
+// Returns NULL on fail.
+char* ki_json_array_stringn_at(struct ki_json_array* array, size_t index, size_t* length)
+{
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return NULL;
+
+    return ki_json_val_get_stringn(ki_json_array_at(array, index), length);
+}
+
 // TODO: what to do on fail? ki_json_array_get_number
 // Returns number at given index in json array.
 double ki_json_array_number_at(struct ki_json_array* array, size_t index)
 {
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return (index < array->count) ? array->data.numbers[ki_json_array_slot_of(array, index)] : 0.0;
+
     struct ki_json_val* val = ki_json_array_at(array, index);
 
     if (val == NULL || val->type != KI_JSON_VAL_NUMBER)
@@ -103,6 +490,10 @@ double ki_json_array_number_at(struct ki_json_array* array, size_t index)
 // Returns bool at given index in json array.
 bool ki_json_array_bool_at(struct ki_json_array* array, size_t index)
 {
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return false;
+
     struct ki_json_val* val = ki_json_array_at(array, index);
 
     if (val == NULL || val->type != KI_JSON_VAL_BOOL)
@@ -113,48 +504,345 @@ bool ki_json_array_bool_at(struct ki_json_array* array, size_t index)
 
 /* Inserting values */
 
-// Doubles capacity of json array.
-static bool ki_json_array_expand(struct ki_json_array* array)
+// Grows capacity of json array to new_capacity values.
+static bool ki_json_array_grow(struct ki_json_array* array, size_t new_capacity)
 {
+    size_t slot_size = ki_json_array_slot_size(array->storage);
+
+    //overflow
+    if (new_capacity > SIZE_MAX / slot_size)
+        return false;
+
     //allocate new arrays
-    struct ki_json_val** new_values = realloc(array->values, sizeof(*new_values) * array->capacity * 2);
+    char* new_data = ki_json_realloc(array->allocator, array->data.values, slot_size * array->capacity, slot_size * new_capacity);
 
-    if (new_values == NULL)
+    if (new_data == NULL)
         return false;
 
+    //values after the gap stay at the very end
+    size_t head_count = array->count - array->tail_count;
+    memmove(new_data + slot_size * (new_capacity - array->tail_count), new_data + slot_size * (array->capacity - array->tail_count), slot_size * array->tail_count);
+
     //fill new spots with NULL
-    for (size_t i = array->capacity; i < array->capacity * 2; i++)
-        new_values[i] = NULL;
+    memset(new_data + slot_size * head_count, 0, slot_size * (new_capacity - array->count));
 
     //set to new
-    array->values = new_values;
-    array->capacity *= 2;
+    array->data.values = (struct ki_json_val**)new_data;
+    array->capacity = new_capacity;
+
+    ki_json_array_relocate(array, 0, head_count);
+    ki_json_array_relocate(array, new_capacity - array->tail_count, new_capacity);
 
     return true;
 }
 
+// Doubles capacity of json array.
+static bool ki_json_array_expand(struct ki_json_array* array)
+{
+    return ki_json_array_grow(array, (array->capacity > 0) ? array->capacity * 2 : 1);
+}
+
+// Makes room for at least capacity values in json array, so adding up to that many doesn't reallocate.
+// NOTE: Never shrinks.
+// Returns true on success, false on fail.
+bool ki_json_array_reserve(struct ki_json_array* array, size_t capacity)
+{
+    assert(array);
+
+    if (capacity <= array->capacity)
+        return true;
+
+    return ki_json_array_grow(array, capacity);
+}
+
+// Makes room for count more values in json array, growing it geometrically so repeated bulk adds stay cheap.
+// Returns true on success, false on fail.
+static bool ki_json_array_reserve_more(struct ki_json_array* array, size_t count)
+{
+    //overflow
+    if (count > SIZE_MAX - array->count)
+        return false;
+
+    size_t needed = array->count + count;
+
+    if (needed <= array->capacity)
+        return true;
+
+    size_t doubled = (array->capacity <= SIZE_MAX / 2) ? array->capacity * 2 : SIZE_MAX;
+
+    return ki_json_array_grow(array, (doubled > needed) ? doubled : needed);
+}
+
+// Makes room for count values at given index in json array, which has to have room for them already.
+// NOTE: Slots of the new values are one after another, starting at slot index, and left as they were.
+static void ki_json_array_open(struct ki_json_array* array, size_t index, size_t count)
+{
+    assert(array->count + count <= array->capacity);
+
+    if (array->gap_buffer)
+    {
+        ki_json_array_move_gap(array, index);
+    }
+    else if (index < array->count)
+    {
+        //shift all items starting at given index to the right by count spaces
+        memmove(ki_json_array_slot(array, index + count), ki_json_array_slot(array, index), ki_json_array_slot_size(array->storage) * (array->count - index));
+        ki_json_array_relocate(array, index + count, array->count + count);
+    }
+
+    array->count += count;
+}
+
+// Closes count slots of values at given index in json array, whose values were freed or moved out already.
+static void ki_json_array_close(struct ki_json_array* array, size_t index, size_t count)
+{
+    if (array->gap_buffer)
+    {
+        //the gap takes over slots right before it
+        ki_json_array_move_gap(array, index + count);
+    }
+    else if (index + count < array->count)
+    {
+        //move values to right of them back count spaces
+        memmove(ki_json_array_slot(array, index), ki_json_array_slot(array, index + count), ki_json_array_slot_size(array->storage) * (array->count - index - count));
+        ki_json_array_relocate(array, index, array->count - count);
+    }
+
+    array->count -= count;
+}
+
+// Copies slots of all values in json array into out, one after another without the gap.
+// NOTE: Copied inline values must be relocated, copied boxed values are still owned by the array.
+void ki_json_array_copy_slots(const struct ki_json_array* array, void* out)
+{
+    assert(array && (out != NULL || array->count == 0));
+
+    size_t slot_size = ki_json_array_slot_size(array->storage);
+    size_t head_count = array->count - array->tail_count;
+
+    if (array->count == 0)
+        return;
+
+    memcpy(out, ki_json_array_slot(array, 0), slot_size * head_count);
+    memcpy((char*)out + slot_size * head_count, ki_json_array_slot(array, array->capacity - array->tail_count), slot_size * array->tail_count);
+}
+
+// Returns address of the pointer to the value at given index in json array with KI_JSON_ARRAY_STORAGE_BOXED, for replacing it.
+// Returns NULL on fail.
+struct ki_json_val** ki_json_array_boxed_slot(struct ki_json_array* array, size_t index)
+{
+    assert(array && array->storage == KI_JSON_ARRAY_STORAGE_BOXED);
+
+    if (index >= array->count)
+        return NULL;
+
+    return &array->data.values[ki_json_array_slot_of(array, index)];
+}
+
+// Returns zeroed slot past the last value of json array, expanding the array if needed.
+// Slot is a struct ki_json_val for KI_JSON_ARRAY_STORAGE_INLINE & a double for KI_JSON_ARRAY_STORAGE_NUMBERS.
+// NOTE: Value in the slot becomes part of the array once its count is incremented.
+// Returns NULL on fail.
+void* ki_json_array_next_slot(struct ki_json_array* array)
+{
+    assert(array && array->storage != KI_JSON_ARRAY_STORAGE_BOXED);
+
+    ki_json_array_move_gap(array, array->count);
+
+    if (array->count == array->capacity && !ki_json_array_expand(array))
+        return NULL;
+
+    size_t slot_size = ki_json_array_slot_size(array->storage);
+    char* slot = (char*)array->data.values + slot_size * array->count;
+    memset(slot, 0, slot_size);
+
+    return slot;
+}
+
 // Adds json value to json array at given index.
-// NOTE: Ownership of value is given to json array, and will free it once done.
+// NOTE 1: Ownership of value is given to json array, and will free it once done.
+// NOTE 2: Arrays with KI_JSON_ARRAY_STORAGE_INLINE or KI_JSON_ARRAY_STORAGE_NUMBERS move value into themselves, freeing the given value.
 enum ki_json_err_type ki_json_array_insert(struct ki_json_array* array, struct ki_json_val* value, size_t index)
 {
+    assert(array && value);
+
+    return ki_json_array_insert_range(array, index, &value, 1);
+}
+
+// Adds count json values to json array at given index, all or none of them.
+// NOTE: Ownership of values is given to json array, as with ki_json_array_insert().
+enum ki_json_err_type ki_json_array_insert_range(struct ki_json_array* array, size_t index, struct ki_json_val* const* values, size_t count)
+{
+    assert(array && (values != NULL || count == 0));
+
     //is index out-of-bounds?
     //allow inserting at array->count => at end of json array
     if (index > array->count)
         return KI_JSON_ERR_OUT_OF_BOUNDS;
 
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (values[i]->type != KI_JSON_VAL_NUMBER)
+            {
+                if (!ki_json_array_set_storage(array, KI_JSON_ARRAY_STORAGE_BOXED))
+                    return KI_JSON_ERR_MEMORY;
+
+                break;
+            }
+        }
+    }
+
+    //inline values can't be shared, copy shared ones first
+    struct ki_json_val** copies = NULL;
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE && !ki_json_array_copy_shared(array->allocator, values, count, &copies))
+        return KI_JSON_ERR_MEMORY;
+
     //if need to expand json array, but failed to do so
-    if (array->count == array->capacity && !ki_json_array_expand(array))
+    if (!ki_json_array_reserve_more(array, count))
+    {
+        ki_json_array_free_copies(array->allocator, values, copies, count, count);
+        return KI_JSON_ERR_MEMORY;
+    }
+
+    ki_json_array_open(array, index, count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        switch (array->storage)
+        {
+            case KI_JSON_ARRAY_STORAGE_NUMBERS:
+                array->data.numbers[index + i] = values[i]->value.number;
+                //number holds nothing else, shared ones only lose this reference
+                ki_json_val_free(values[i]);
+                break;
+            case KI_JSON_ARRAY_STORAGE_INLINE:
+                ki_json_array_move_into(&array->data.elements[index + i], values[i], (copies != NULL) ? copies[i] : NULL);
+                break;
+            default: //KI_JSON_ARRAY_STORAGE_BOXED
+                array->data.values[index + i] = values[i];
+                break;
+        }
+    }
+
+    ki_json_array_free_copies(array->allocator, values, copies, 0, count);
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Moves count values at src_index in json array src to json array dest at dest_index, all or none of them.
+// Values that are boxed in both arrays keep their nodes, so pointers to them stay valid.
+// NOTE: Arrays must differ.
+enum ki_json_err_type ki_json_array_move_range(struct ki_json_array* dest, size_t dest_index, struct ki_json_array* src, size_t src_index, size_t count)
+{
+    assert(dest && src && dest != src);
+
+    if (dest_index > dest->count || src_index > src->count || count > src->count - src_index)
+        return KI_JSON_ERR_OUT_OF_BOUNDS;
+
+    //values to move are one after another without the gap
+    ki_json_array_move_gap(src, src->count);
+
+    //packed arrays hold only numbers
+    if (dest->storage == KI_JSON_ARRAY_STORAGE_NUMBERS && src->storage != KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t slot = ki_json_array_slot_of(src, src_index + i);
+            const struct ki_json_val* val = (src->storage == KI_JSON_ARRAY_STORAGE_INLINE) ? &src->data.elements[slot] : src->data.values[slot];
+
+            if (val->type != KI_JSON_VAL_NUMBER)
+            {
+                if (!ki_json_array_set_storage(dest, KI_JSON_ARRAY_STORAGE_BOXED))
+                    return KI_JSON_ERR_MEMORY;
+
+                break;
+            }
+        }
+    }
+
+    //inline values can't be shared, copy shared ones first
+    struct ki_json_val** copies = NULL;
+    bool boxed_to_inline = (src->storage == KI_JSON_ARRAY_STORAGE_BOXED && dest->storage == KI_JSON_ARRAY_STORAGE_INLINE);
+
+    if (boxed_to_inline && !ki_json_array_copy_shared(dest->allocator, &src->data.values[src_index], count, &copies))
         return KI_JSON_ERR_MEMORY;
 
-    //shift all items starting at given index to the right by one space
-    if (array->count != 0)
+    if (!ki_json_array_reserve_more(dest, count))
+    {
+        ki_json_array_free_copies(dest->allocator, &src->data.values[src_index], copies, count, count);
+        return KI_JSON_ERR_MEMORY;
+    }
+
+    ki_json_array_open(dest, dest_index, count);
+
+    //box values that weren't boxed before moving anything, so failing leaves both arrays as they were
+    if (dest->storage == KI_JSON_ARRAY_STORAGE_BOXED && src->storage != KI_JSON_ARRAY_STORAGE_BOXED)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t slot = ki_json_array_slot_of(src, src_index + i);
+            const struct ki_json_allocator* allocator = (src->storage == KI_JSON_ARRAY_STORAGE_INLINE) ? src->data.elements[slot].allocator : src->allocator;
+
+            dest->data.values[dest_index + i] = ki_json_val_alloc(allocator, KI_JSON_VAL_NULL);
+
+            if (dest->data.values[dest_index + i] == NULL)
+            {
+                for (size_t j = 0; j < i; j++)
+                    ki_json_val_dealloc(dest->data.values[dest_index + j]);
+
+                ki_json_array_close(dest, dest_index, count);
+                return KI_JSON_ERR_MEMORY;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
     {
-        for (size_t i = array->count - 1; i >= index; i--)
-            array->values[i + 1] = array->values[i];
+        struct ki_json_val* boxed = (src->storage == KI_JSON_ARRAY_STORAGE_BOXED) ? src->data.values[src_index + i] : NULL;
+
+        switch (dest->storage)
+        {
+            case KI_JSON_ARRAY_STORAGE_NUMBERS:
+            {
+                struct ki_json_val val;
+                ki_json_array_copy_out(src, src_index + i, &val);
+                dest->data.numbers[dest_index + i] = val.value.number;
+                //number holds nothing else, shared ones only lose this reference
+                ki_json_val_free(boxed);
+                break;
+            }
+            case KI_JSON_ARRAY_STORAGE_INLINE:
+                if (boxed != NULL)
+                {
+                    ki_json_array_move_into(&dest->data.elements[dest_index + i], boxed, (copies != NULL) ? copies[i] : NULL);
+                }
+                else
+                {
+                    ki_json_array_copy_out(src, src_index + i, &dest->data.elements[dest_index + i]);
+                    ki_json_val_relocate(&dest->data.elements[dest_index + i]);
+                }
+                break;
+            default: //KI_JSON_ARRAY_STORAGE_BOXED
+                if (boxed != NULL)
+                {
+                    //node itself moves over
+                    dest->data.values[dest_index + i] = boxed;
+                }
+                else
+                {
+                    ki_json_array_copy_out(src, src_index + i, dest->data.values[dest_index + i]);
+                    ki_json_val_relocate(dest->data.values[dest_index + i]);
+                }
+                break;
+        }
     }
 
-    array->values[index] = value;
-    array->count++;
+    ki_json_array_free_copies(dest->allocator, &src->data.values[src_index], copies, 0, count);
+    ki_json_array_close(src, src_index, count);
 
     return KI_JSON_ERR_NONE;
 }
@@ -163,7 +851,7 @@ enum ki_json_err_type ki_json_array_insert(struct ki_json_array* array, struct k
 // Returns NULL on fail.
 struct ki_json_val* ki_json_array_insert_new_object(struct ki_json_array* array, size_t index, size_t capacity)
 {
-    struct ki_json_val* val = ki_json_val_create_object(capacity);
+    struct ki_json_val* val = ki_json_val_create_object_with_allocator(capacity, array->allocator);
 
     if (val == NULL)
         return NULL;
@@ -171,17 +859,18 @@ struct ki_json_val* ki_json_array_insert_new_object(struct ki_json_array* array,
     if (ki_json_array_insert(array, val, index) != KI_JSON_ERR_NONE)
     {
         ki_json_val_free(val);
-        val = NULL;
+        return NULL;
     }
 
-    return val;
+    //val may have been moved into the array
+    return ki_json_array_unpacked_at(array, index);
 }
 
 // Creates new json value for a json array and adds it to the json array at given index.
 // Returns NULL on fail.
 struct ki_json_val* ki_json_array_insert_new_array(struct ki_json_array* array, size_t index, size_t capacity)
 {
-    struct ki_json_val* val = ki_json_val_create_array(capacity);
+    struct ki_json_val* val = ki_json_val_create_array_with_allocator(capacity, array->allocator);
 
     if (val == NULL)
         return NULL;
@@ -189,10 +878,11 @@ struct ki_json_val* ki_json_array_insert_new_array(struct ki_json_array* array,
     if (ki_json_array_insert(array, val, index) != KI_JSON_ERR_NONE)
     {
         ki_json_val_free(val);
-        val = NULL;
+        return NULL;
     }
 
-    return val;
+    //val may have been moved into the array
+    return ki_json_array_unpacked_at(array, index);
 }
 
 // Creates new json value for a string and adds it to the json array at given index.
@@ -200,7 +890,7 @@ struct ki_json_val* ki_json_array_insert_new_array(struct ki_json_array* array,
 // Returns NULL on fail.
 struct ki_json_val* ki_json_array_insert_new_string(struct ki_json_array* array, size_t index, const char* string)
 {
-    struct ki_json_val* val = ki_json_val_create_from_string(string);
+    struct ki_json_val* val = ki_json_val_create_from_string_with_allocator(string, array->allocator);
 
     if (val == NULL)
         return NULL;
@@ -208,17 +898,18 @@ struct ki_json_val* ki_json_array_insert_new_string(struct ki_json_array* array,
     if (ki_json_array_insert(array, val, index) != KI_JSON_ERR_NONE)
     {
         ki_json_val_free(val);
-        val = NULL;
+        return NULL;
     }
 
-    return val;
+    //val may have been moved into the array
+    return ki_json_array_unpacked_at(array, index);
 }
 
 // Creates new json value for a number and adds it to the json array at given index.
 // Returns NULL on fail.
 struct ki_json_val* ki_json_array_insert_new_number(struct ki_json_array* array, size_t index, double number)
 {
-    struct ki_json_val* val = ki_json_val_create_from_number(number);
+    struct ki_json_val* val = ki_json_val_create_from_number_with_allocator(number, array->allocator);
 
     if (val == NULL)
         return NULL;
@@ -226,17 +917,18 @@ struct ki_json_val* ki_json_array_insert_new_number(struct ki_json_array* array,
     if (ki_json_array_insert(array, val, index) != KI_JSON_ERR_NONE)
     {
         ki_json_val_free(val);
-        val = NULL;
+        return NULL;
     }
 
-    return val;
+    //val may have been moved into the array
+    return ki_json_array_unpacked_at(array, index);
 }
 
 // Creates new json value for a bool and adds it to the json array at given index.
 // Returns NULL on fail.
 struct ki_json_val* ki_json_array_insert_new_bool(struct ki_json_array* array, size_t index, bool boolean)
 {
-    struct ki_json_val* val = ki_json_val_create_from_bool(boolean);
+    struct ki_json_val* val = ki_json_val_create_from_bool_with_allocator(boolean, array->allocator);
 
     if (val == NULL)
         return NULL;
@@ -244,17 +936,18 @@ struct ki_json_val* ki_json_array_insert_new_bool(struct ki_json_array* array, s
     if (ki_json_array_insert(array, val, index) != KI_JSON_ERR_NONE)
     {
         ki_json_val_free(val);
-        val = NULL;
+        return NULL;
     }
 
-    return val;
+    //val may have been moved into the array
+    return ki_json_array_unpacked_at(array, index);
 }
 
 // Creates new json value representing null and adds it to the json array at given index.
 // Returns NULL on fail.
 struct ki_json_val* ki_json_array_insert_new_null(struct ki_json_array* array, size_t index)
 {
-    struct ki_json_val* val = ki_json_val_create_null();
+    struct ki_json_val* val = ki_json_val_create_null_with_allocator(array->allocator);
 
     if (val == NULL)
         return NULL;
@@ -262,10 +955,11 @@ struct ki_json_val* ki_json_array_insert_new_null(struct ki_json_array* array, s
     if (ki_json_array_insert(array, val, index) != KI_JSON_ERR_NONE)
     {
         ki_json_val_free(val);
-        val = NULL;
+        return NULL;
     }
 
-    return val;
+    //val may have been moved into the array
+    return ki_json_array_unpacked_at(array, index);
 }
 
 /* Adding values */
@@ -320,14 +1014,180 @@ struct ki_json_val* ki_json_array_add_new_null(struct ki_json_array* array)
     return ki_json_array_insert_new_null(array, array->count);
 }
 
+/* Adding values in bulk */
+
+// Adds count numbers to the end of a json array, all or none of them.
+// NOTE: Empty arrays with KI_JSON_ARRAY_STORAGE_BOXED are packed (see KI_JSON_ARRAY_STORAGE_NUMBERS), so no values are allocated.
+enum ki_json_err_type ki_json_array_add_numbers(struct ki_json_array* array, const double* numbers, size_t count)
+{
+    assert(array && (numbers != NULL || count == 0));
+
+    if (array->count == 0 && array->storage == KI_JSON_ARRAY_STORAGE_BOXED && !ki_json_array_set_storage(array, KI_JSON_ARRAY_STORAGE_NUMBERS))
+        return KI_JSON_ERR_MEMORY;
+
+    if (!ki_json_array_reserve_more(array, count))
+        return KI_JSON_ERR_MEMORY;
+
+    ki_json_array_move_gap(array, array->count);
+
+    switch (array->storage)
+    {
+        case KI_JSON_ARRAY_STORAGE_NUMBERS:
+            memcpy(array->data.numbers + array->count, numbers, sizeof(*numbers) * count);
+            break;
+        case KI_JSON_ARRAY_STORAGE_INLINE:
+            for (size_t i = 0; i < count; i++)
+            {
+                struct ki_json_val* val = &array->data.elements[array->count + i];
+
+                memset(val, 0, sizeof(*val));
+                val->type = KI_JSON_VAL_NUMBER;
+                val->allocator = array->allocator;
+                val->value.number = numbers[i];
+            }
+            break;
+        default: //KI_JSON_ARRAY_STORAGE_BOXED
+            for (size_t i = 0; i < count; i++)
+            {
+                struct ki_json_val* val = ki_json_val_create_from_number_with_allocator(numbers[i], array->allocator);
+
+                if (val == NULL)
+                {
+                    //undo values added so far
+                    for (size_t j = 0; j < i; j++)
+                        ki_json_val_free(array->data.values[array->count + j]);
+
+                    memset(array->data.values + array->count, 0, sizeof(*array->data.values) * i);
+                    return KI_JSON_ERR_MEMORY;
+                }
+
+                array->data.values[array->count + i] = val;
+            }
+            break;
+    }
+
+    array->count += count;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Adds count null-terminated strings to the end of a json array, all or none of them.
+// NOTE: Strings are copied.
+enum ki_json_err_type ki_json_array_add_strings(struct ki_json_array* array, const char* const* strings, size_t count)
+{
+    assert(array && (strings != NULL || count == 0));
+
+    //packed arrays hold only numbers
+    if (count > 0 && array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS && !ki_json_array_set_storage(array, KI_JSON_ARRAY_STORAGE_BOXED))
+        return KI_JSON_ERR_MEMORY;
+
+    if (!ki_json_array_reserve_more(array, count))
+        return KI_JSON_ERR_MEMORY;
+
+    ki_json_array_move_gap(array, array->count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        bool added = false;
+
+        if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+        {
+            struct ki_json_val* val = &array->data.elements[array->count + i];
+
+            memset(val, 0, sizeof(*val));
+            val->type = KI_JSON_VAL_STRING;
+            val->allocator = array->allocator;
+
+            added = ki_json_val_set_string(val, strings[i]);
+        }
+        else
+        {
+            array->data.values[array->count + i] = ki_json_val_create_from_string_with_allocator(strings[i], array->allocator);
+            added = (array->data.values[array->count + i] != NULL);
+        }
+
+        if (!added)
+        {
+            //undo values added so far
+            for (size_t j = 0; j < i; j++)
+            {
+                if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+                    ki_json_val_fini(&array->data.elements[array->count + j]);
+                else
+                    ki_json_val_free(array->data.values[array->count + j]);
+            }
+
+            memset((char*)array->data.values + ki_json_array_slot_size(array->storage) * array->count, 0, ki_json_array_slot_size(array->storage) * (i + 1));
+            return KI_JSON_ERR_MEMORY;
+        }
+    }
+
+    array->count += count;
+
+    return KI_JSON_ERR_NONE;
+}
+
 /* Setting values */
 
+// Replaces json value at given index in json array with value, freeing the replaced one.
+// NOTE: Ownership of value is given to json array, as with ki_json_array_add().
+enum ki_json_err_type ki_json_array_set(struct ki_json_array* array, size_t index, struct ki_json_val* value)
+{
+    assert(array && value);
+
+    if (index >= array->count)
+        return KI_JSON_ERR_OUT_OF_BOUNDS;
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        if (value->type == KI_JSON_VAL_NUMBER)
+        {
+            array->data.numbers[ki_json_array_slot_of(array, index)] = value->value.number;
+            //number holds nothing else, shared ones only lose this reference
+            ki_json_val_free(value);
+            return KI_JSON_ERR_NONE;
+        }
+
+        //packed arrays hold only numbers
+        if (!ki_json_array_set_storage(array, KI_JSON_ARRAY_STORAGE_BOXED))
+            return KI_JSON_ERR_MEMORY;
+    }
+
+    size_t slot = ki_json_array_slot_of(array, index);
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+    {
+        //inline values can't be shared, copy a shared one first
+        struct ki_json_val** copies = NULL;
+
+        if (!ki_json_array_copy_shared(array->allocator, &value, 1, &copies))
+            return KI_JSON_ERR_MEMORY;
+
+        ki_json_val_fini(&array->data.elements[slot]);
+        ki_json_array_move_into(&array->data.elements[slot], value, (copies != NULL) ? copies[0] : NULL);
+        ki_json_array_free_copies(array->allocator, &value, copies, 0, 1);
+
+        return KI_JSON_ERR_NONE;
+    }
+
+    if (array->data.values[slot] != value)
+        ki_json_val_free(array->data.values[slot]);
+
+    array->data.values[slot] = value;
+
+    return KI_JSON_ERR_NONE;
+}
+
 // NOTE 1: Value must be of type KI_JSON_VAL_STRING.
 // NOTE 2: String is copied.
 // Returns true on success, false on fail.
 bool ki_json_array_set_string(struct ki_json_array* array, size_t index, const char* string)
 {
-    struct ki_json_val* val = ki_json_array_at(array, index);
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return false;
+
+    struct ki_json_val* val = ki_json_array_at_mut(array, index);
 
     if (val == NULL)
         return false;
@@ -339,7 +1199,16 @@ bool ki_json_array_set_string(struct ki_json_array* array, size_t index, const c
 // Returns true on success, false on fail.
 bool ki_json_array_set_number(struct ki_json_array* array, size_t index, double number)
 {
-    struct ki_json_val* val = ki_json_array_at(array, index);
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        if (index >= array->count)
+            return false;
+
+        array->data.numbers[ki_json_array_slot_of(array, index)] = number;
+        return true;
+    }
+
+    struct ki_json_val* val = ki_json_array_at_mut(array, index);
 
     if (val == NULL || val->type != KI_JSON_VAL_NUMBER)
         return false;
@@ -353,7 +1222,11 @@ bool ki_json_array_set_number(struct ki_json_array* array, size_t index, double
 // Returns true on success, false on fail.
 bool ki_json_array_set_bool(struct ki_json_array* array, size_t index, bool boolean)
 {
-    struct ki_json_val* val = ki_json_array_at(array, index);
+    //packed arrays hold only numbers
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return false;
+
+    struct ki_json_val* val = ki_json_array_at_mut(array, index);
 
     if (val == NULL || val->type != KI_JSON_VAL_BOOL)
         return false;
@@ -368,18 +1241,29 @@ bool ki_json_array_set_bool(struct ki_json_array* array, size_t index, bool bool
 // Returns true on success, false on fail.
 bool ki_json_array_remove_at(struct ki_json_array* array, size_t index)
 {
-    if (index >= array->count)
-        return false;
+    return ki_json_array_remove_range(array, index, 1);
+}
+
+// Removes count values starting at given index from json array.
+// Returns true on success, false on fail.
+bool ki_json_array_remove_range(struct ki_json_array* array, size_t index, size_t count)
+{
+    assert(array);
 
-    ki_json_val_free(array->values[index]);
+    if (index > array->count || count > array->count - index)
+        return false;
 
-    //move values to right of it back one space, overwriting index with free'd value
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t slot = ki_json_array_slot_of(array, index + i);
 
-    for (size_t i = index + 1; i < array->count; i++)
-        array->values[i - 1] = array->values[i];    
+        if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+            ki_json_val_fini(&array->data.elements[slot]);
+        else if (array->storage == KI_JSON_ARRAY_STORAGE_BOXED)
+            ki_json_val_free(array->data.values[slot]);
+    }
 
-    array->values[array->count - 1] = NULL;
-    array->count--;
+    ki_json_array_close(array, index, count);
 
     return true;
 }
@@ -388,10 +1272,14 @@ bool ki_json_array_remove_at(struct ki_json_array* array, size_t index)
 // Returns true on success, false on fail.
 bool ki_json_array_remove(struct ki_json_array* array, struct ki_json_val* value)
 {
+    //packed arrays hold no json values to point to
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return false;
+
     //find index of reference to value, and remove it at that index
     for (size_t i = 0; i < array->count; i++)
     {
-        if (array->values[i] == value)
+        if (ki_json_array_at(array, i) == value)
         {
             ki_json_array_remove_at(array, i);
             return true;
@@ -0,0 +1,630 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "json_internal.h"
+
+// Deep copies of json trees placed in a single block of memory.
+// Every value of a clone uses the allocator in the header of its block, which ignores frees of memory inside of the block
+// & frees the whole block once the root value (right after the header) is freed.
+// Anything allocated after cloning (values added, arrays growing, ...) comes from the allocator the block came from.
+
+// Alignment of nodes & arrays in a block, strings go after them unaligned
+#define CLONE_ALIGN sizeof(union { void* pointer; double number; size_t size; })
+// Amount of frames the stack for walking trees holds before allocating, enough for most trees
+#define CLONE_STACK_INLINE_SIZE 32
+
+struct clone_block
+{
+    // Allocator of every value in the clone, its context points back to this block
+    struct ki_json_allocator allocator;
+    // Allocator the block & anything allocated after cloning comes from
+    const struct ki_json_allocator* parent;
+    // Size of the whole block in bytes
+    size_t size;
+};
+
+// A json object or json array whose values are being walked.
+struct clone_frame
+{
+    const struct ki_json_val* val;
+    // Index of next value to walk
+    size_t next;
+};
+
+// Stack of containers being walked, one frame per level of the tree, so cloning never recurses.
+struct clone_stack
+{
+    struct clone_frame* frames;
+    size_t count;
+    size_t capacity;
+    // Allocator used for frames past the inline ones
+    const struct ki_json_allocator* allocator;
+    struct clone_frame inline_frames[CLONE_STACK_INLINE_SIZE];
+};
+
+// Total bytes needed for a clone, measured before copying anything.
+struct clone_size
+{
+    // Nodes & arrays, each aligned
+    size_t nodes;
+    // Strings & names, including null-terminators
+    size_t strings;
+};
+
+// Where next nodes, arrays & strings of a clone are placed in its block.
+struct clone_cursor
+{
+    char* nodes;
+    char* strings;
+    const struct ki_json_allocator* allocator;
+    // Whether the clone is frozen, see ki_json_val_freeze()
+    bool frozen;
+};
+
+/* Block */
+
+static size_t clone_align(size_t size)
+{
+    return (size + CLONE_ALIGN - 1) / CLONE_ALIGN * CLONE_ALIGN;
+}
+
+// Returns root value of block, placed right after its header.
+static struct ki_json_val* clone_block_root(struct clone_block* block)
+{
+    return (struct ki_json_val*)((char*)block + clone_align(sizeof(*block)));
+}
+
+// Whether ptr points into block.
+static bool clone_block_owns(const struct clone_block* block, const void* ptr)
+{
+    uintptr_t start = (uintptr_t)block;
+
+    return (uintptr_t)ptr >= start && (uintptr_t)ptr < start + block->size;
+}
+
+static void* clone_malloc(size_t size, void* context)
+{
+    struct clone_block* block = context;
+
+    return ki_json_alloc(block->parent, size);
+}
+
+static void* clone_realloc(void* ptr, size_t old_size, size_t new_size, void* context)
+{
+    struct clone_block* block = context;
+
+    if (!clone_block_owns(block, ptr))
+        return ki_json_realloc(block->parent, ptr, old_size, new_size);
+
+    //memory inside of the block can't grow, move it out of there
+    void* new_ptr = ki_json_alloc(block->parent, new_size);
+
+    if (new_ptr != NULL)
+        memcpy(new_ptr, ptr, (old_size < new_size) ? old_size : new_size);
+
+    return new_ptr;
+}
+
+static void clone_free(void* ptr, size_t size, void* context)
+{
+    struct clone_block* block = context;
+
+    //root is always freed last, everything else in the block goes along with it
+    if (ptr == clone_block_root(block))
+        ki_json_dealloc(block->parent, block, block->size);
+    else if (!clone_block_owns(block, ptr))
+        ki_json_dealloc(block->parent, ptr, size);
+}
+
+/* Stack */
+
+static void clone_stack_init(struct clone_stack* stack, const struct ki_json_allocator* allocator)
+{
+    stack->frames = stack->inline_frames;
+    stack->count = 0;
+    stack->capacity = CLONE_STACK_INLINE_SIZE;
+    stack->allocator = allocator;
+}
+
+static void clone_stack_fini(struct clone_stack* stack)
+{
+    if (stack->frames != stack->inline_frames)
+        ki_json_dealloc(stack->allocator, stack->frames, sizeof(*stack->frames) * stack->capacity);
+}
+
+// Pushes frame for walking values of json object or json array val onto stack.
+// Returns true on success, false on fail.
+static bool clone_stack_push(struct clone_stack* stack, const struct ki_json_val* val)
+{
+    if (stack->count == stack->capacity)
+    {
+        size_t new_capacity = stack->capacity * 2;
+        struct clone_frame* new_frames = NULL;
+
+        if (stack->frames == stack->inline_frames)
+        {
+            new_frames = ki_json_alloc(stack->allocator, sizeof(*new_frames) * new_capacity);
+
+            if (new_frames != NULL)
+                memcpy(new_frames, stack->frames, sizeof(*new_frames) * stack->count);
+        }
+        else
+        {
+            new_frames = ki_json_realloc(stack->allocator, stack->frames, sizeof(*new_frames) * stack->capacity, sizeof(*new_frames) * new_capacity);
+        }
+
+        if (new_frames == NULL)
+            return false;
+
+        stack->frames = new_frames;
+        stack->capacity = new_capacity;
+    }
+
+    stack->frames[stack->count].val = val;
+    stack->frames[stack->count].next = 0;
+    stack->count++;
+
+    return true;
+}
+
+/* Measuring */
+
+// Adds bytes needed for everything inside of json value to size, pushing containers with values onto stack.
+// Returns true on success, false on fail.
+static bool clone_measure_val(struct clone_stack* stack, const struct ki_json_val* val, bool frozen, struct clone_size* size)
+{
+    switch (val->type)
+    {
+        case KI_JSON_VAL_OBJECT:
+        {
+            const struct ki_json_object* object = &val->value.object;
+
+            if (object->count == 0)
+                return true;
+
+            size->nodes += clone_align(sizeof(*object->pairs) * object->count);
+
+            //frozen objects get a fresh index once big enough, as it can't be built lazily later on
+            if (frozen && object->count >= KI_JSON_OBJECT_INDEX_THRESHOLD)
+                size->nodes += clone_align(ki_json_object_index_size(ki_json_object_index_capacity(object->count)));
+            else if (!frozen && object->index != NULL)
+                size->nodes += clone_align(ki_json_object_index_size(object->index_capacity));
+
+            return clone_stack_push(stack, val);
+        }
+        case KI_JSON_VAL_ARRAY:
+        {
+            const struct ki_json_array* array = &val->value.array;
+
+            if (array->count == 0)
+                return true;
+
+            //frozen packed numbers are unpacked to inline values, as unpacking them lazily would change them
+            if (frozen && array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+                size->nodes += clone_align(sizeof(struct ki_json_val) * array->count);
+            else
+                size->nodes += clone_align(ki_json_array_slot_size(array->storage) * array->count);
+
+            //packed numbers hold no values to walk
+            return (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS) || clone_stack_push(stack, val);
+        }
+        case KI_JSON_VAL_STRING:
+            if (!(val->flags & KI_JSON_VAL_FLAG_INLINE_STRING))
+                size->strings += val->value.string_storage.length + 1;
+            return true;
+        default: //KI_JSON_VAL_BOOL, KI_JSON_VAL_NUMBER, KI_JSON_VAL_NULL
+            return true;
+    }
+}
+
+// Measures bytes needed for a clone of json value, excluding its block header & root node.
+// Returns true on success, false on fail.
+static bool clone_measure(const struct ki_json_val* val, bool frozen, struct clone_size* size)
+{
+    struct clone_stack stack;
+    clone_stack_init(&stack, val->allocator);
+
+    bool success = clone_measure_val(&stack, val, frozen, size);
+
+    while (success && stack.count > 0)
+    {
+        struct clone_frame* frame = &stack.frames[stack.count - 1];
+        const struct ki_json_val* child = NULL;
+
+        if (frame->val->type == KI_JSON_VAL_OBJECT)
+        {
+            const struct ki_json_object* object = &frame->val->value.object;
+
+            if (frame->next < object->count)
+            {
+                const struct ki_json_pair* pair = &object->pairs[frame->next++];
+
+                size->strings += pair->name_length + 1;
+                size->nodes += clone_align(sizeof(*pair->value));
+                child = pair->value;
+            }
+        }
+        else
+        {
+            //getting values of boxed & inline arrays doesn't change them
+            struct ki_json_array* array = (struct ki_json_array*)&frame->val->value.array;
+
+            if (frame->next < array->count)
+            {
+                if (array->storage == KI_JSON_ARRAY_STORAGE_BOXED)
+                    size->nodes += clone_align(sizeof(struct ki_json_val));
+
+                child = ki_json_array_at(array, frame->next++);
+            }
+        }
+
+        if (child == NULL)
+        {
+            stack.count--;
+            continue;
+        }
+
+        success = clone_measure_val(&stack, child, frozen, size);
+    }
+
+    clone_stack_fini(&stack);
+
+    return success;
+}
+
+/* Copying */
+
+// Returns next size bytes for nodes & arrays of the clone.
+static void* clone_take_nodes(struct clone_cursor* cursor, size_t size)
+{
+    void* ptr = cursor->nodes;
+    cursor->nodes += clone_align(size);
+
+    return ptr;
+}
+
+// Returns copy of string of length bytes in the strings of the clone.
+static char* clone_copy_string(struct clone_cursor* cursor, const char* string, size_t length)
+{
+    char* copy = cursor->strings;
+
+    memcpy(copy, string, length);
+    copy[length] = '\0'; //null-terminator
+    cursor->strings += length + 1;
+
+    return copy;
+}
+
+// Unpacks packed numbers of json array array, a bytewise copy of an array in the original tree, to inline values in the clone.
+static void clone_unpack_numbers(struct ki_json_array* array, struct clone_cursor* cursor)
+{
+    struct ki_json_val* elements = NULL;
+
+    if (array->count > 0)
+    {
+        elements = clone_take_nodes(cursor, sizeof(*elements) * array->count);
+
+        for (size_t i = 0; i < array->count; i++)
+        {
+            memset(&elements[i], 0, sizeof(elements[i]));
+            elements[i].type = KI_JSON_VAL_NUMBER;
+            elements[i].flags = KI_JSON_VAL_FLAG_FROZEN;
+            elements[i].allocator = cursor->allocator;
+            elements[i].value.number = ki_json_array_number_at(array, i);
+        }
+    }
+
+    array->data.elements = elements;
+    array->capacity = array->count;
+    array->tail_count = 0;
+    array->storage = KI_JSON_ARRAY_STORAGE_INLINE;
+    array->allocator = cursor->allocator;
+}
+
+// Moves everything inside of json value val, a bytewise copy of a value in the original tree, into the clone.
+// Containers with values are pushed onto stack, their values are still those of the original tree until walked.
+// Returns true on success, false on fail.
+static bool clone_copy_val(struct clone_stack* stack, struct ki_json_val* val, struct clone_cursor* cursor)
+{
+    //values of the clone are owned by it alone, even if the originals were shared
+    val->allocator = cursor->allocator;
+    val->refs = 0;
+
+    if (cursor->frozen)
+        val->flags |= KI_JSON_VAL_FLAG_FROZEN;
+    else
+        val->flags &= ~KI_JSON_VAL_FLAG_FROZEN;
+
+    switch (val->type)
+    {
+        case KI_JSON_VAL_OBJECT:
+        {
+            struct ki_json_object* object = &val->value.object;
+            const struct ki_json_pair* pairs = object->pairs;
+            const size_t* index = object->index;
+
+            object->allocator = cursor->allocator;
+            object->capacity = object->count;
+            object->pairs = NULL;
+            object->index = NULL;
+
+            if (object->count == 0)
+            {
+                object->index_capacity = 0;
+                return true;
+            }
+
+            object->pairs = clone_take_nodes(cursor, sizeof(*pairs) * object->count);
+            memcpy(object->pairs, pairs, sizeof(*pairs) * object->count);
+
+            if (cursor->frozen && object->count >= KI_JSON_OBJECT_INDEX_THRESHOLD)
+            {
+                object->index_capacity = ki_json_object_index_capacity(object->count);
+                object->index = clone_take_nodes(cursor, ki_json_object_index_size(object->index_capacity));
+                memset(object->index, 0, ki_json_object_index_size(object->index_capacity));
+                ki_json_object_index_fill(object);
+                //sorted up front too, as it can't be cached lazily later on
+                ki_json_object_order_fill(object);
+            }
+            //index & its cached order refer to pairs by position, so they stay valid as is
+            else if (!cursor->frozen && index != NULL)
+            {
+                object->index = clone_take_nodes(cursor, ki_json_object_index_size(object->index_capacity));
+                memcpy(object->index, index, ki_json_object_index_size(object->index_capacity));
+            }
+            else
+            {
+                object->index_capacity = 0;
+            }
+
+            return clone_stack_push(stack, val);
+        }
+        case KI_JSON_VAL_ARRAY:
+        {
+            struct ki_json_array* array = &val->value.array;
+            void* data = NULL;
+
+            if (cursor->frozen && array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+            {
+                clone_unpack_numbers(array, cursor);
+                return true;
+            }
+
+            if (array->count > 0)
+            {
+                data = clone_take_nodes(cursor, ki_json_array_slot_size(array->storage) * array->count);
+                ki_json_array_copy_slots(array, data);
+            }
+
+            array->data.values = data;
+            array->capacity = array->count;
+            array->tail_count = 0;
+            array->allocator = cursor->allocator;
+
+            if (array->count == 0 || array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+                return true;
+
+            return clone_stack_push(stack, val);
+        }
+        case KI_JSON_VAL_STRING:
+        {
+            struct ki_json_string* storage = &val->value.string_storage;
+
+            if (val->flags & KI_JSON_VAL_FLAG_INLINE_STRING)
+                ki_json_val_relocate(val);
+            else
+                storage->string = clone_copy_string(cursor, storage->string, storage->length);
+
+            return true;
+        }
+        default: //KI_JSON_VAL_BOOL, KI_JSON_VAL_NUMBER, KI_JSON_VAL_NULL
+            return true;
+    }
+}
+
+// Copies everything inside of json value root, a bytewise copy of the original root, into the clone.
+// Returns true on success, false on fail.
+static bool clone_copy(struct ki_json_val* root, struct clone_cursor* cursor, const struct ki_json_allocator* stack_allocator)
+{
+    struct clone_stack stack;
+    clone_stack_init(&stack, stack_allocator);
+
+    bool success = clone_copy_val(&stack, root, cursor);
+
+    while (success && stack.count > 0)
+    {
+        //frames move once the stack grows, only hold on to one until pushing
+        struct clone_frame* frame = &stack.frames[stack.count - 1];
+        struct ki_json_val* container = (struct ki_json_val*)frame->val;
+        struct ki_json_val* child = NULL;
+
+        if (container->type == KI_JSON_VAL_OBJECT)
+        {
+            struct ki_json_object* object = &container->value.object;
+
+            if (frame->next < object->count)
+            {
+                struct ki_json_pair* pair = &object->pairs[frame->next++];
+
+                pair->name = clone_copy_string(cursor, pair->name, pair->name_length);
+
+                child = clone_take_nodes(cursor, sizeof(*child));
+                *child = *pair->value;
+                pair->value = child;
+            }
+        }
+        else
+        {
+            struct ki_json_array* array = &container->value.array;
+
+            if (frame->next < array->count)
+            {
+                size_t index = frame->next++;
+
+                if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+                {
+                    child = &array->data.elements[index];
+                }
+                else //KI_JSON_ARRAY_STORAGE_BOXED
+                {
+                    child = clone_take_nodes(cursor, sizeof(*child));
+                    *child = *array->data.values[index];
+                    array->data.values[index] = child;
+                }
+            }
+        }
+
+        if (child == NULL)
+        {
+            stack.count--;
+            continue;
+        }
+
+        success = clone_copy_val(&stack, child, cursor);
+    }
+
+    clone_stack_fini(&stack);
+
+    return success;
+}
+
+/* Cloning */
+
+// Deep copies json value & everything inside of it into a single allocation, using given allocator (NULL = default).
+// Returns NULL on fail.
+static struct ki_json_val* clone_create(const struct ki_json_val* val, const struct ki_json_allocator* allocator, bool frozen)
+{
+    //clones of clones come from the same allocator as the original block
+    allocator = ki_json_clone_base_allocator(allocator);
+
+    struct clone_size size = { 0, 0 };
+
+    if (!clone_measure(val, frozen, &size))
+        return NULL;
+
+    size_t header_size = clone_align(sizeof(struct clone_block)) + clone_align(sizeof(*val));
+    size_t block_size = header_size + size.nodes + size.strings;
+
+    struct clone_block* block = ki_json_alloc(allocator, block_size);
+
+    if (block == NULL)
+        return NULL;
+
+    block->allocator.malloc = clone_malloc;
+    block->allocator.realloc = clone_realloc;
+    block->allocator.free = clone_free;
+    block->allocator.context = block;
+    block->parent = allocator;
+    block->size = block_size;
+
+    struct clone_cursor cursor;
+    cursor.nodes = (char*)block + header_size;
+    cursor.strings = cursor.nodes + size.nodes;
+    cursor.allocator = &block->allocator;
+    cursor.frozen = frozen;
+
+    struct ki_json_val* root = clone_block_root(block);
+    *root = *val;
+
+    //nothing outside of the block is owned by the clone yet, so failing only needs the block freed
+    if (!clone_copy(root, &cursor, allocator))
+    {
+        ki_json_dealloc(allocator, block, block_size);
+        return NULL;
+    }
+
+    assert(cursor.nodes == (char*)block + header_size + size.nodes && cursor.strings == (char*)block + block_size);
+
+    return root;
+}
+
+/* Internal */
+
+// Returns allocator of the block for allocators of clones, allocator itself otherwise.
+// Memory that may outlive a clone has to come from there.
+const struct ki_json_allocator* ki_json_clone_base_allocator(const struct ki_json_allocator* allocator)
+{
+    allocator = ki_json_allocator_resolve(allocator);
+
+    if (allocator->free == clone_free)
+        return ((const struct clone_block*)allocator->context)->parent;
+
+    return allocator;
+}
+
+// Whether json value is part of a clone, other than its root.
+// NOTE: Those are freed along with their clone, so they can't be shared.
+bool ki_json_clone_owns(const struct ki_json_val* val)
+{
+    assert(val);
+
+    if (val->allocator == NULL || val->allocator->free != clone_free)
+        return false;
+
+    struct clone_block* block = val->allocator->context;
+
+    return clone_block_owns(block, val) && val != clone_block_root(block);
+}
+
+// Whether json value is the root of a clone.
+// NOTE: Freeing its node frees the whole clone, so everything inside of it has to be freed before.
+bool ki_json_clone_is_root(const struct ki_json_val* val)
+{
+    assert(val);
+
+    return val->allocator != NULL && val->allocator->free == clone_free && val == clone_block_root(val->allocator->context);
+}
+
+/* Public */
+
+// Deep copies json value & everything inside of it into a single allocation, using the allocator of val.
+// Freeing the clone using ki_json_val_free() frees that allocation in one go.
+// NOTE 1: Clone can be changed like any other tree, anything added to it is allocated separately.
+// NOTE 2: Values of the clone must not be moved into other trees, as they are freed along with it.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_clone(const struct ki_json_val* val)
+{
+    assert(val);
+
+    return ki_json_val_clone_with_allocator(val, val->allocator);
+}
+
+// Deep copies json value & everything inside of it into a single allocation, using given allocator (NULL = default).
+// Freeing the clone using ki_json_val_free() frees that allocation in one go.
+// NOTE 1: Clone can be changed like any other tree, anything added to it is allocated separately.
+// NOTE 2: Values of the clone must not be moved into other trees, as they are freed along with it.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_clone_with_allocator(const struct ki_json_val* val, const struct ki_json_allocator* allocator)
+{
+    assert(val);
+
+    return clone_create(val, allocator, false);
+}
+
+// Deep copies json value & everything inside of it into a single read-only allocation, using the allocator of val.
+// Lookups in the frozen copy never change it, so any number of threads can read it at once without locking.
+// Freeing it using ki_json_val_free() frees that allocation in one go.
+// NOTE 1: Objects get their hash index built up front & packed numbers of arrays are unpacked to inline values.
+// NOTE 2: Frozen values must not be changed, use ki_json_val_clone() to get a copy that can be changed.
+// Share the frozen copy between owners using ki_json_val_share(), see ki_json_snapshot_publish().
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_freeze(const struct ki_json_val* val)
+{
+    assert(val);
+
+    return clone_create(val, val->allocator, true);
+}
+
+// Whether json value is part of a tree frozen using ki_json_val_freeze().
+bool ki_json_val_is_frozen(const struct ki_json_val* val)
+{
+    assert(val);
+
+    return (val->flags & KI_JSON_VAL_FLAG_FROZEN) != 0;
+}
@@ -0,0 +1,474 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "json_internal.h"
+
+// Structural equality & hashing of json trees.
+// Objects compare & hash the same whatever order their pairs are in, arrays compare & hash in order.
+// Both walk trees using an explicit stack, falling back to recursing only if the stack can't grow.
+
+// Amount of frames the stack for walking trees holds before allocating, enough for most trees
+#define COMPARE_STACK_INLINE_SIZE 32
+
+// Seeds of hashes of each type of json value, so for ex. an empty object & an empty array hash differently
+#define COMPARE_SEED_NULL 0x6a09e667f3bcc908ULL
+#define COMPARE_SEED_OBJECT 0xbb67ae8584caa73bULL
+#define COMPARE_SEED_ARRAY 0x3c6ef372fe94f82bULL
+#define COMPARE_SEED_STRING 0xa54ff53a5f1d36f1ULL
+#define COMPARE_SEED_NUMBER 0x510e527fade682d1ULL
+#define COMPARE_SEED_BOOL 0x9b05688c2b3e6c1fULL
+
+// A json object or json array whose values are being walked.
+struct compare_frame
+{
+    // Container being walked (a) & the one it is compared to (b, only when comparing)
+    const struct ki_json_val* a;
+    const struct ki_json_val* b;
+    // Index of next value to walk
+    size_t next;
+    // Hash of values walked so far (only when hashing)
+    uint64_t hash;
+};
+
+// Stack of containers being walked, one frame per level of the tree.
+struct compare_stack
+{
+    struct compare_frame* frames;
+    size_t count;
+    size_t capacity;
+    // Allocator used for frames past the inline ones
+    const struct ki_json_allocator* allocator;
+    struct compare_frame inline_frames[COMPARE_STACK_INLINE_SIZE];
+};
+
+/* Stack */
+
+static void compare_stack_init(struct compare_stack* stack, const struct ki_json_allocator* allocator)
+{
+    stack->frames = stack->inline_frames;
+    stack->count = 0;
+    stack->capacity = COMPARE_STACK_INLINE_SIZE;
+    stack->allocator = allocator;
+}
+
+static void compare_stack_fini(struct compare_stack* stack)
+{
+    if (stack->frames != stack->inline_frames)
+        ki_json_dealloc(stack->allocator, stack->frames, sizeof(*stack->frames) * stack->capacity);
+}
+
+// Pushes frame for walking values of json object or json array a (compared to b) onto stack.
+// Returns true on success, false on fail.
+static bool compare_stack_push(struct compare_stack* stack, const struct ki_json_val* a, const struct ki_json_val* b, uint64_t hash)
+{
+    if (stack->count == stack->capacity)
+    {
+        size_t new_capacity = stack->capacity * 2;
+        struct compare_frame* new_frames = NULL;
+
+        if (stack->frames == stack->inline_frames)
+        {
+            new_frames = ki_json_alloc(stack->allocator, sizeof(*new_frames) * new_capacity);
+
+            if (new_frames != NULL)
+                memcpy(new_frames, stack->frames, sizeof(*new_frames) * stack->count);
+        }
+        else
+        {
+            new_frames = ki_json_realloc(stack->allocator, stack->frames, sizeof(*new_frames) * stack->capacity, sizeof(*new_frames) * new_capacity);
+        }
+
+        if (new_frames == NULL)
+            return false;
+
+        stack->frames = new_frames;
+        stack->capacity = new_capacity;
+    }
+
+    struct compare_frame* frame = &stack->frames[stack->count++];
+    frame->a = a;
+    frame->b = b;
+    frame->next = 0;
+    frame->hash = hash;
+
+    return true;
+}
+
+/* Hashing */
+
+// Mixes bits of value, so similar values hash far apart (finalizer of splitmix64).
+static uint64_t compare_mix(uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+
+    return value;
+}
+
+// Returns hash of json value that isn't a json object or json array.
+static uint64_t compare_hash_scalar(const struct ki_json_val* val)
+{
+    switch (val->type)
+    {
+        case KI_JSON_VAL_STRING:
+            return compare_mix(ki_json_hash_bytes(val->value.string_storage.string, val->value.string_storage.length) ^ COMPARE_SEED_STRING);
+        case KI_JSON_VAL_NUMBER:
+            return ki_json_hash_number(val->value.number);
+        case KI_JSON_VAL_BOOL:
+            return compare_mix(COMPARE_SEED_BOOL + (val->value.boolean ? 1 : 0));
+        default: //KI_JSON_VAL_NULL
+            return COMPARE_SEED_NULL;
+    }
+}
+
+// Whether json value is a json object or json array with values to walk.
+static bool compare_has_values(const struct ki_json_val* val)
+{
+    if (val->type == KI_JSON_VAL_OBJECT)
+        return val->value.object.count > 0;
+
+    return val->type == KI_JSON_VAL_ARRAY && val->value.array.count > 0;
+}
+
+/* Internal */
+
+// Returns hash of number, equal numbers hash the same (0.0 & -0.0 included).
+uint64_t ki_json_hash_number(double number)
+{
+    uint64_t bits = 0;
+
+    if (number != 0.0)
+        memcpy(&bits, &number, sizeof(bits));
+
+    return compare_mix(bits ^ COMPARE_SEED_NUMBER);
+}
+
+// Returns hash of json object or json array container so far, after adding value_hash of its value at index.
+// Pairs of objects are summed up, so their order doesn't matter; values of arrays are chained in order.
+uint64_t ki_json_hash_add(const struct ki_json_val* container, size_t index, uint64_t hash, uint64_t value_hash)
+{
+    if (container->type == KI_JSON_VAL_OBJECT)
+        return hash + compare_mix(value_hash ^ (uint64_t)container->value.object.pairs[index].hash);
+
+    return compare_mix(hash ^ value_hash) + index;
+}
+
+// Returns hash of json object or json array, once hashes of all of its values were added.
+uint64_t ki_json_hash_finish(uint64_t hash)
+{
+    return compare_mix(hash);
+}
+
+// Returns hash of json object or json array before adding any of its values, covering its count.
+uint64_t ki_json_hash_seed(const struct ki_json_val* val)
+{
+    if (val->type == KI_JSON_VAL_OBJECT)
+        return COMPARE_SEED_OBJECT ^ val->value.object.count;
+
+    return COMPARE_SEED_ARRAY ^ val->value.array.count;
+}
+
+// Returns hash of json value without values to walk (anything but non-empty json objects & json arrays).
+uint64_t ki_json_hash_leaf(const struct ki_json_val* val)
+{
+    //empty containers hash the same as if their values had been walked
+    if (val->type == KI_JSON_VAL_OBJECT || val->type == KI_JSON_VAL_ARRAY)
+        return ki_json_hash_finish(ki_json_hash_seed(val));
+
+    return compare_hash_scalar(val);
+}
+
+/* Equality */
+
+// Returns number at given index of json array, which is only read.
+static double compare_number_at(const struct ki_json_array* array, size_t index)
+{
+    return ki_json_array_number_at((struct ki_json_array*)array, index);
+}
+
+// Whether json values a & b hold the same value, not looking into values of containers.
+static bool compare_shallow_equal(const struct ki_json_val* a, const struct ki_json_val* b)
+{
+    if (a->type != b->type)
+        return false;
+
+    switch (a->type)
+    {
+        case KI_JSON_VAL_OBJECT:
+            return a->value.object.count == b->value.object.count;
+        case KI_JSON_VAL_ARRAY:
+            return a->value.array.count == b->value.array.count;
+        case KI_JSON_VAL_STRING:
+            return a->value.string_storage.length == b->value.string_storage.length
+                && memcmp(a->value.string_storage.string, b->value.string_storage.string, a->value.string_storage.length) == 0;
+        case KI_JSON_VAL_NUMBER:
+            return a->value.number == b->value.number;
+        case KI_JSON_VAL_BOOL:
+            return a->value.boolean == b->value.boolean;
+        default: //KI_JSON_VAL_NULL
+            return true;
+    }
+}
+
+// Whether value at index of json array a equals that of json array b, if either of them holds packed numbers.
+// Returns true if both are numbers & equal, false otherwise.
+static bool compare_numbers_equal(const struct ki_json_array* a, const struct ki_json_array* b, size_t index)
+{
+    //packed numbers can't be pointed to, so compare them without unpacking
+    if (a->storage != KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        struct ki_json_val* val = ki_json_array_at(a, index);
+
+        if (val->type != KI_JSON_VAL_NUMBER)
+            return false;
+    }
+
+    if (b->storage != KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        struct ki_json_val* val = ki_json_array_at(b, index);
+
+        if (val->type != KI_JSON_VAL_NUMBER)
+            return false;
+    }
+
+    return compare_number_at(a, index) == compare_number_at(b, index);
+}
+
+// Returns the value of json object b with the name of pair of json object a at index, without building a hash index of b.
+// Returns NULL if there is none.
+static const struct ki_json_val* compare_object_match(const struct ki_json_object* a, const struct ki_json_object* b, size_t index)
+{
+    const struct ki_json_pair* pair = &a->pairs[index];
+    const struct ki_json_pair* same = &b->pairs[index];
+
+    //pairs are mostly in the same order, so try the same spot before looking anywhere else
+    if (same->hash == pair->hash && same->name_length == pair->name_length && memcmp(same->name, pair->name, pair->name_length) == 0)
+        return same->value;
+
+    size_t pair_index = 0;
+
+    if (!ki_json_object_peek_hashed(b, pair->name, pair->name_length, pair->hash, &pair_index))
+        return NULL;
+
+    return b->pairs[pair_index].value;
+}
+
+/* Public */
+
+// Whether json values a & b are structurally equal.
+// Pairs of json objects may be in any order, values of json arrays must be in the same order.
+// Numbers are equal if they compare equal as doubles (0.0 equals -0.0).
+// NOTE: Neither value is changed, names are looked up in hash indices json objects already have, without building any.
+bool ki_json_val_equal(const struct ki_json_val* a, const struct ki_json_val* b)
+{
+    assert(a && b);
+
+    if (a == b)
+        return true;
+
+    if (!compare_shallow_equal(a, b))
+        return false;
+
+    if (!compare_has_values(a))
+        return true;
+
+    struct compare_stack stack;
+    compare_stack_init(&stack, a->allocator);
+
+    //first frame is inline, so pushing it can't fail
+    compare_stack_push(&stack, a, b, 0);
+
+    while (stack.count > 0)
+    {
+        //frames move once the stack grows, only hold on to one until pushing
+        struct compare_frame* frame = &stack.frames[stack.count - 1];
+        const struct ki_json_val* child_a = NULL;
+        const struct ki_json_val* child_b = NULL;
+
+        if (frame->a->type == KI_JSON_VAL_OBJECT)
+        {
+            const struct ki_json_object* object = &frame->a->value.object;
+
+            if (frame->next < object->count)
+            {
+                //same count, so every name of a being found in b means b has no other names
+                child_a = object->pairs[frame->next].value;
+                child_b = compare_object_match(object, &frame->b->value.object, frame->next);
+                frame->next++;
+
+                if (child_b == NULL)
+                    break;
+            }
+        }
+        else
+        {
+            const struct ki_json_array* array_a = &frame->a->value.array;
+            const struct ki_json_array* array_b = &frame->b->value.array;
+
+            if (frame->next < array_a->count)
+            {
+                size_t index = frame->next++;
+
+                if (array_a->storage == KI_JSON_ARRAY_STORAGE_NUMBERS || array_b->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+                {
+                    if (!compare_numbers_equal(array_a, array_b, index))
+                        break;
+
+                    continue;
+                }
+
+                child_a = ki_json_array_at(array_a, index);
+                child_b = ki_json_array_at(array_b, index);
+            }
+        }
+
+        if (child_a == NULL)
+        {
+            stack.count--;
+            continue;
+        }
+
+        //shared values are often the very same value
+        if (child_a == child_b)
+            continue;
+
+        if (!compare_shallow_equal(child_a, child_b))
+            break;
+
+        //compare separately if the stack can't grow
+        if (compare_has_values(child_a) && !compare_stack_push(&stack, child_a, child_b, 0) && !ki_json_val_equal(child_a, child_b))
+            break;
+    }
+
+    //walk stops early at the first difference
+    bool equal = (stack.count == 0);
+
+    compare_stack_fini(&stack);
+
+    return equal;
+}
+
+// Returns hash of json value & everything inside of it, calling visit (may be NULL) with each json value inside of it
+// & its hash once that is known, see ki_json_val_hash_each().
+static uint64_t compare_hash_walk(const struct ki_json_val* val, void (*visit)(const struct ki_json_val* val, size_t hash, void* context), void* context)
+{
+    if (!compare_has_values(val))
+    {
+        uint64_t hash = ki_json_hash_leaf(val);
+
+        if (visit != NULL)
+            visit(val, (size_t)hash, context);
+
+        return hash;
+    }
+
+    struct compare_stack stack;
+    compare_stack_init(&stack, val->allocator);
+
+    //first frame is inline, so pushing it can't fail
+    compare_stack_push(&stack, val, NULL, ki_json_hash_seed(val));
+
+    uint64_t hash = 0;
+
+    while (stack.count > 0)
+    {
+        struct compare_frame* frame = &stack.frames[stack.count - 1];
+        const struct ki_json_val* child = NULL;
+        size_t index = frame->next;
+
+        if (frame->a->type == KI_JSON_VAL_OBJECT)
+        {
+            if (index < frame->a->value.object.count)
+                child = frame->a->value.object.pairs[frame->next++].value;
+        }
+        else
+        {
+            const struct ki_json_array* array = &frame->a->value.array;
+
+            if (index < array->count)
+            {
+                frame->next++;
+
+                //packed numbers hash the same as boxed ones, without unpacking them
+                if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+                {
+                    frame->hash = ki_json_hash_add(frame->a, index, frame->hash, ki_json_hash_number(compare_number_at(array, index)));
+                    continue;
+                }
+
+                child = ki_json_array_at(array, index);
+            }
+        }
+
+        if (child == NULL)
+        {
+            //hand hash of finished container to the one it is in
+            hash = ki_json_hash_finish(frame->hash);
+
+            if (visit != NULL)
+                visit(frame->a, (size_t)hash, context);
+
+            stack.count--;
+
+            if (stack.count > 0)
+            {
+                frame = &stack.frames[stack.count - 1];
+                frame->hash = ki_json_hash_add(frame->a, frame->next - 1, frame->hash, hash);
+            }
+
+            continue;
+        }
+
+        if (compare_has_values(child))
+        {
+            if (compare_stack_push(&stack, child, NULL, ki_json_hash_seed(child)))
+                continue;
+
+            //hash separately if the stack can't grow
+            frame->hash = ki_json_hash_add(frame->a, index, frame->hash, compare_hash_walk(child, visit, context));
+            continue;
+        }
+
+        uint64_t child_hash = ki_json_hash_leaf(child);
+
+        if (visit != NULL)
+            visit(child, (size_t)child_hash, context);
+
+        frame->hash = ki_json_hash_add(frame->a, index, frame->hash, child_hash);
+    }
+
+    compare_stack_fini(&stack);
+
+    return hash;
+}
+
+// Returns hash of json value & everything inside of it.
+// Equal json values (see ki_json_val_equal()) hash the same, so pairs of json objects may be in any order.
+// NOTE: Walks the whole tree every time, cache the hash of values that don't change (for ex.: frozen ones) if needed often,
+// ki_json_val_hash_each() hands out hashes of all values inside of it along the way.
+size_t ki_json_val_hash(const struct ki_json_val* val)
+{
+    assert(val);
+
+    return (size_t)compare_hash_walk(val, NULL, NULL);
+}
+
+// Returns hash of json value & everything inside of it (see ki_json_val_hash()), walking the tree only once to call visit
+// with each json value inside of it (val included) & its hash, so hashes of every subtree can be cached at once.
+// Values are visited before the json object or json array they are in.
+// NOTE: Numbers of packed arrays (see KI_JSON_ARRAY_STORAGE_NUMBERS) aren't json values, so they aren't visited.
+size_t ki_json_val_hash_each(const struct ki_json_val* val, void (*visit)(const struct ki_json_val* val, size_t hash, void* context), void* context)
+{
+    assert(val && visit);
+
+    return (size_t)compare_hash_walk(val, visit, context);
+}
@@ -0,0 +1,469 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "json_internal.h"
+
+// Hash-consing of json trees: every value equal to one seen before is replaced by a share of that one (see ki_json_val_share()).
+// Trees are walked bottom up, so values inside of containers are deduplicated before the containers themselves,
+// which makes equal containers hold the very same values & comparing them cheap.
+
+// Amount of frames the stack for walking trees holds before allocating, enough for most trees
+#define DEDUP_STACK_INLINE_SIZE 32
+// Amount of entries the table of distinct values starts with, always a power of 2
+#define DEDUP_TABLE_INITIAL_CAPACITY 64
+// Amount of replaced values the table holds on to before growing their list
+#define DEDUP_REPLACED_INITIAL_CAPACITY 64
+
+// A distinct value seen so far.
+struct dedup_entry
+{
+    uint64_t hash;
+    // NULL if the entry is empty
+    struct ki_json_val* val;
+};
+
+// Open-addressing hash table of distinct values seen so far, kept at most half full.
+// Entries may point into values that were replaced afterwards, so those are only freed once the pass is done.
+struct dedup_table
+{
+    struct dedup_entry* entries;
+    size_t count;
+    // Number of entries, always a power of 2
+    size_t capacity;
+    // Values replaced by shares, freed by dedup_table_fini()
+    struct ki_json_val** replaced;
+    size_t replaced_count;
+    size_t replaced_capacity;
+    const struct ki_json_allocator* allocator;
+};
+
+// A json object or json array whose values are being walked.
+struct dedup_frame
+{
+    struct ki_json_val* val;
+    // Index of next value to walk
+    size_t next;
+    // Hash of values walked so far
+    uint64_t hash;
+};
+
+// Stack of containers being walked, one frame per level of the tree.
+struct dedup_stack
+{
+    struct dedup_frame* frames;
+    size_t count;
+    size_t capacity;
+    // Allocator used for frames past the inline ones
+    const struct ki_json_allocator* allocator;
+    struct dedup_frame inline_frames[DEDUP_STACK_INLINE_SIZE];
+};
+
+/* Stack */
+
+static void dedup_stack_init(struct dedup_stack* stack, const struct ki_json_allocator* allocator)
+{
+    stack->frames = stack->inline_frames;
+    stack->count = 0;
+    stack->capacity = DEDUP_STACK_INLINE_SIZE;
+    stack->allocator = allocator;
+}
+
+static void dedup_stack_fini(struct dedup_stack* stack)
+{
+    if (stack->frames != stack->inline_frames)
+        ki_json_dealloc(stack->allocator, stack->frames, sizeof(*stack->frames) * stack->capacity);
+}
+
+// Pushes frame for walking values of json object or json array val onto stack.
+// Returns true on success, false on fail.
+static bool dedup_stack_push(struct dedup_stack* stack, struct ki_json_val* val)
+{
+    if (stack->count == stack->capacity)
+    {
+        size_t new_capacity = stack->capacity * 2;
+        struct dedup_frame* new_frames = NULL;
+
+        if (stack->frames == stack->inline_frames)
+        {
+            new_frames = ki_json_alloc(stack->allocator, sizeof(*new_frames) * new_capacity);
+
+            if (new_frames != NULL)
+                memcpy(new_frames, stack->frames, sizeof(*new_frames) * stack->count);
+        }
+        else
+        {
+            new_frames = ki_json_realloc(stack->allocator, stack->frames, sizeof(*new_frames) * stack->capacity, sizeof(*new_frames) * new_capacity);
+        }
+
+        if (new_frames == NULL)
+            return false;
+
+        stack->frames = new_frames;
+        stack->capacity = new_capacity;
+    }
+
+    struct dedup_frame* frame = &stack->frames[stack->count++];
+    frame->val = val;
+    frame->next = 0;
+    frame->hash = ki_json_hash_seed(val);
+
+    return true;
+}
+
+// Returns next value of container in frame to walk & outs where the container points to it (NULL for inline values).
+// Hashes of packed numbers are added to the frame on the way, as they aren't json values.
+// Returns NULL once all values were walked.
+static struct ki_json_val* dedup_frame_next(struct dedup_frame* frame, struct ki_json_val*** slot)
+{
+    *slot = NULL;
+
+    if (frame->val->type == KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_object* object = &frame->val->value.object;
+
+        if (frame->next == object->count)
+            return NULL;
+
+        *slot = &object->pairs[frame->next++].value;
+        return **slot;
+    }
+
+    struct ki_json_array* array = &frame->val->value.array;
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        for (; frame->next < array->count; frame->next++)
+            frame->hash = ki_json_hash_add(frame->val, frame->next, frame->hash, ki_json_hash_number(ki_json_array_number_at(array, frame->next)));
+
+        return NULL;
+    }
+
+    if (frame->next == array->count)
+        return NULL;
+
+    size_t index = frame->next++;
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+        return ki_json_array_at(array, index);
+
+    *slot = ki_json_array_boxed_slot(array, index);
+    return **slot;
+}
+
+/* Sizes */
+
+// Returns bytes of memory owned by json value itself, besides its node & the values inside of it.
+static size_t dedup_own_size(const struct ki_json_val* val)
+{
+    switch (val->type)
+    {
+        case KI_JSON_VAL_OBJECT:
+        {
+            const struct ki_json_object* object = &val->value.object;
+            size_t size = sizeof(*object->pairs) * object->capacity + ((object->index != NULL) ? ki_json_object_index_size(object->index_capacity) : 0);
+
+            for (size_t i = 0; i < object->count; i++)
+                size += object->pairs[i].name_length + 1;
+
+            return size;
+        }
+        case KI_JSON_VAL_ARRAY:
+            return ki_json_array_slot_size(val->value.array.storage) * val->value.array.capacity;
+        case KI_JSON_VAL_STRING:
+            return (val->flags & KI_JSON_VAL_FLAG_INLINE_STRING) ? 0 : val->value.string_storage.length + 1;
+        default: //KI_JSON_VAL_BOOL, KI_JSON_VAL_NUMBER, KI_JSON_VAL_NULL
+            return 0;
+    }
+}
+
+// Returns bytes of memory freeing json value val would free, values shared with others only lose a reference.
+static size_t dedup_freed_size(struct ki_json_val* val)
+{
+    if (ki_json_val_is_shared(val) || ki_json_clone_owns(val))
+        return 0;
+
+    size_t size = sizeof(*val) + dedup_own_size(val);
+
+    if (val->type != KI_JSON_VAL_OBJECT && val->type != KI_JSON_VAL_ARRAY)
+        return size;
+
+    struct dedup_stack stack;
+    dedup_stack_init(&stack, val->allocator);
+
+    //first frame is inline, so pushing it can't fail
+    dedup_stack_push(&stack, val);
+
+    while (stack.count > 0)
+    {
+        struct ki_json_val** slot = NULL;
+        struct ki_json_val* child = dedup_frame_next(&stack.frames[stack.count - 1], &slot);
+
+        if (child == NULL)
+        {
+            stack.count--;
+            continue;
+        }
+
+        //inline values live in the array already measured
+        if (slot != NULL && ki_json_val_is_shared(child))
+            continue;
+
+        size += dedup_own_size(child) + ((slot != NULL) ? sizeof(*child) : 0);
+
+        //values inside of it are left uncounted if the stack can't grow
+        if (child->type == KI_JSON_VAL_OBJECT || child->type == KI_JSON_VAL_ARRAY)
+            dedup_stack_push(&stack, child);
+    }
+
+    dedup_stack_fini(&stack);
+
+    return size;
+}
+
+/* Table */
+
+static bool dedup_table_init(struct dedup_table* table, const struct ki_json_allocator* allocator)
+{
+    table->count = 0;
+    table->capacity = DEDUP_TABLE_INITIAL_CAPACITY;
+    table->replaced = NULL;
+    table->replaced_count = 0;
+    table->replaced_capacity = 0;
+    table->allocator = allocator;
+    table->entries = ki_json_calloc(allocator, table->capacity, sizeof(*table->entries));
+
+    return table->entries != NULL;
+}
+
+// Frees table & the values it replaced, adding bytes of memory that frees to stats.
+static void dedup_table_fini(struct dedup_table* table, struct ki_json_dedup_stats* stats)
+{
+    //measured right before freeing, so parts still shared by the tree aren't counted
+    for (size_t i = 0; i < table->replaced_count; i++)
+    {
+        stats->bytes += dedup_freed_size(table->replaced[i]);
+        ki_json_val_free(table->replaced[i]);
+    }
+
+    if (table->replaced != NULL)
+        ki_json_dealloc(table->allocator, table->replaced, sizeof(*table->replaced) * table->replaced_capacity);
+
+    ki_json_dealloc(table->allocator, table->entries, sizeof(*table->entries) * table->capacity);
+}
+
+// Makes room for one more replaced value in table.
+// Returns true on success, false on fail.
+static bool dedup_table_reserve_replaced(struct dedup_table* table)
+{
+    if (table->replaced_count < table->replaced_capacity)
+        return true;
+
+    size_t new_capacity = (table->replaced_capacity > 0) ? table->replaced_capacity * 2 : DEDUP_REPLACED_INITIAL_CAPACITY;
+    struct ki_json_val** new_replaced = (table->replaced != NULL)
+        ? ki_json_realloc(table->allocator, table->replaced, sizeof(*new_replaced) * table->replaced_capacity, sizeof(*new_replaced) * new_capacity)
+        : ki_json_alloc(table->allocator, sizeof(*new_replaced) * new_capacity);
+
+    if (new_replaced == NULL)
+        return false;
+
+    table->replaced = new_replaced;
+    table->replaced_capacity = new_capacity;
+
+    return true;
+}
+
+// Returns entry holding a value equal to val with given hash, or the empty entry where it would go.
+static struct dedup_entry* dedup_table_find(struct dedup_table* table, struct ki_json_val* val, uint64_t hash)
+{
+    size_t mask = table->capacity - 1;
+    size_t i = (size_t)hash & mask;
+
+    //linear probing
+    while (table->entries[i].val != NULL)
+    {
+        if (table->entries[i].hash == hash && ki_json_val_equal(table->entries[i].val, val))
+            break;
+
+        i = (i + 1) & mask;
+    }
+
+    return &table->entries[i];
+}
+
+// Doubles number of entries of table.
+// Returns true on success, false on fail.
+static bool dedup_table_grow(struct dedup_table* table)
+{
+    size_t new_capacity = table->capacity * 2;
+    struct dedup_entry* new_entries = ki_json_calloc(table->allocator, new_capacity, sizeof(*new_entries));
+
+    if (new_entries == NULL)
+        return false;
+
+    for (size_t i = 0; i < table->capacity; i++)
+    {
+        if (table->entries[i].val == NULL)
+            continue;
+
+        size_t slot = (size_t)table->entries[i].hash & (new_capacity - 1);
+
+        while (new_entries[slot].val != NULL)
+            slot = (slot + 1) & (new_capacity - 1);
+
+        new_entries[slot] = table->entries[i];
+    }
+
+    ki_json_dealloc(table->allocator, table->entries, sizeof(*table->entries) * table->capacity);
+
+    table->entries = new_entries;
+    table->capacity = new_capacity;
+
+    return true;
+}
+
+/* Deduplicating */
+
+// Replaces value at slot with hash by a share of an equal value seen before, or remembers it if it is the first one.
+// Returns true on success, false on fail.
+static bool dedup_slot(struct dedup_table* table, struct ki_json_val** slot, uint64_t hash, struct ki_json_dedup_stats* stats)
+{
+    struct ki_json_val* val = *slot;
+
+    //values of clones are freed along with them, so neither sharing nor replacing them frees anything
+    if (ki_json_clone_owns(val))
+        return true;
+
+    struct dedup_entry* entry = dedup_table_find(table, val, hash);
+
+    if (entry->val == NULL)
+    {
+        entry->hash = hash;
+        entry->val = val;
+        table->count++;
+
+        return table->count * 2 <= table->capacity || dedup_table_grow(table);
+    }
+
+    if (entry->val == val)
+        return true;
+
+    if (!dedup_table_reserve_replaced(table))
+        return false;
+
+    struct ki_json_val* shared = ki_json_val_share(entry->val);
+
+    if (shared == NULL)
+        return false;
+
+    //shared too often already, later duplicates share this one instead
+    if (shared != entry->val)
+    {
+        ki_json_val_free(shared);
+        entry->val = val;
+
+        return true;
+    }
+
+    stats->values++;
+
+    //entries may point into val, so it is freed once the pass is done
+    *slot = shared;
+    table->replaced[table->replaced_count++] = val;
+
+    return true;
+}
+
+/* Public */
+
+// Replaces every value inside of json value that is equal to another one inside of it by a share of that one (see ki_json_val_share()),
+// so each distinct value is held only once. Outs number of values replaced & bytes freed by that (stats may be NULL).
+// NOTE 1: Replaced values are shared afterwards, which makes changing them copy-on-write:
+// use ki_json_object_get_mut(), ki_json_array_at_mut() & ki_json_val_unshare() to change them.
+// NOTE 2: Values of arrays with KI_JSON_ARRAY_STORAGE_INLINE, values of clones & val itself are never replaced.
+// Shared & frozen json values aren't changed at all.
+// Returns true on success, false on fail (values replaced so far stay replaced).
+bool ki_json_val_dedup(struct ki_json_val* val, struct ki_json_dedup_stats* stats)
+{
+    assert(val);
+
+    struct ki_json_dedup_stats ignored;
+
+    if (stats == NULL)
+        stats = &ignored;
+
+    stats->values = 0;
+    stats->bytes = 0;
+
+    bool has_values = (val->type == KI_JSON_VAL_OBJECT) ? val->value.object.count > 0 : (val->type == KI_JSON_VAL_ARRAY && val->value.array.count > 0);
+
+    //values of shared & frozen values must not be changed
+    if (!has_values || ki_json_val_is_shared(val) || ki_json_val_is_frozen(val))
+        return true;
+
+    struct dedup_table table;
+
+    if (!dedup_table_init(&table, val->allocator))
+        return false;
+
+    struct dedup_stack stack;
+    dedup_stack_init(&stack, val->allocator);
+
+    //first frame is inline, so pushing it can't fail
+    dedup_stack_push(&stack, val);
+
+    bool success = true;
+
+    while (success && stack.count > 0)
+    {
+        //frames move once the stack grows, only hold on to one until pushing
+        struct dedup_frame* frame = &stack.frames[stack.count - 1];
+        size_t index = frame->next;
+        struct ki_json_val** slot = NULL;
+        struct ki_json_val* child = dedup_frame_next(frame, &slot);
+
+        if (child == NULL)
+        {
+            //container is done, hand its hash to the one it is in & deduplicate it there
+            uint64_t hash = ki_json_hash_finish(frame->hash);
+            stack.count--;
+
+            if (stack.count == 0)
+                break;
+
+            frame = &stack.frames[stack.count - 1];
+            index = frame->next - 1;
+            frame->hash = ki_json_hash_add(frame->val, index, frame->hash, hash);
+
+            if (frame->val->type == KI_JSON_VAL_OBJECT)
+                success = dedup_slot(&table, &frame->val->value.object.pairs[index].value, hash, stats);
+            else if (frame->val->value.array.storage == KI_JSON_ARRAY_STORAGE_BOXED)
+                success = dedup_slot(&table, ki_json_array_boxed_slot(&frame->val->value.array, index), hash, stats);
+
+            continue;
+        }
+
+        bool container = (child->type == KI_JSON_VAL_OBJECT && child->value.object.count > 0)
+            || (child->type == KI_JSON_VAL_ARRAY && child->value.array.count > 0);
+
+        //values inside of shared values & clones are left as they are
+        if (container && !ki_json_val_is_shared(child) && !ki_json_clone_owns(child) && dedup_stack_push(&stack, child))
+            continue;
+
+        uint64_t hash = container ? (uint64_t)ki_json_val_hash(child) : ki_json_hash_leaf(child);
+        frame->hash = ki_json_hash_add(frame->val, index, frame->hash, hash);
+
+        if (slot != NULL)
+            success = dedup_slot(&table, slot, hash, stats);
+    }
+
+    dedup_stack_fini(&stack);
+    dedup_table_fini(&table, stats);
+
+    return success;
+}
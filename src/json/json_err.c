@@ -15,7 +15,12 @@ static const char* err_msgs[] = {
     [KI_JSON_ERR_EXPECTED_NAME_VALUE_SEPARATOR] = "Expected ':' to separate name and value.",
     [KI_JSON_ERR_UNKNOWN_TOKEN] = "Unable to resolve json token.",
     [KI_JSON_ERR_INVALID_ESCAPE_SEQUENCE] = "Invalid escape sequence.",
-    [KI_JSON_ERR_TRAILING_COMMA] = "Trailing commas are not allowed."
+    [KI_JSON_ERR_TRAILING_COMMA] = "Trailing commas are not allowed.",
+    [KI_JSON_ERR_TOO_DEEP] = "Objects and arrays are nested too deeply.",
+    [KI_JSON_ERR_INVALID_NUMBER] = "Number does not follow the json grammar.",
+    [KI_JSON_ERR_INVALID_PATCH] = "Patch is not a valid JSON Patch.",
+    [KI_JSON_ERR_PATH_NOT_FOUND] = "JSON Pointer does not refer to a value.",
+    [KI_JSON_ERR_TEST_FAILED] = "Value differs from the one expected by a test operation."
 };
 
 // Get error message for json error type.
@@ -0,0 +1,215 @@
+#ifndef KI_JSON_JSON_INTERNAL_H
+#define KI_JSON_JSON_INTERNAL_H
+
+// Functions shared between the json modules, not part of the public api
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ki_json/json.h"
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define KI_JSON_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+#define KI_JSON_THREAD_LOCAL __declspec(thread)
+#else
+#define KI_JSON_THREAD_LOCAL __thread
+#endif
+
+/* Allocators */
+
+// Returns given allocator, or the default allocator if NULL.
+const struct ki_json_allocator* ki_json_allocator_resolve(const struct ki_json_allocator* allocator);
+
+// Allocates size bytes using allocator (NULL = default).
+// Returns NULL on fail.
+void* ki_json_alloc(const struct ki_json_allocator* allocator, size_t size);
+// Allocates count * size zeroed bytes using allocator (NULL = default).
+// Returns NULL on fail.
+void* ki_json_calloc(const struct ki_json_allocator* allocator, size_t count, size_t size);
+// Resizes memory at ptr of old_size bytes to new_size bytes using allocator (NULL = default).
+// Returns NULL on fail, ptr is left untouched in that case.
+void* ki_json_realloc(const struct ki_json_allocator* allocator, void* ptr, size_t old_size, size_t new_size);
+// Frees memory at ptr of size bytes using allocator (NULL = default).
+void ki_json_dealloc(const struct ki_json_allocator* allocator, void* ptr, size_t size);
+
+// Copies length bytes of string into a new null-terminated string, allocated using allocator (NULL = default).
+// Returns NULL on fail.
+char* ki_json_strndup(const struct ki_json_allocator* allocator, const char* string, size_t length);
+// Frees null-terminated string of length (excluding null-terminator) allocated using allocator (NULL = default).
+void ki_json_strfree(const struct ki_json_allocator* allocator, char* string, size_t length);
+
+/* Node pool */
+
+// Takes a node from the calling thread's pool.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_pool_alloc(void);
+// Gives a node allocated using ki_json_pool_alloc() back to the calling thread's pool.
+void ki_json_pool_free(struct ki_json_val* val);
+
+/* Hashing */
+
+// Hashes length bytes of data (FNV-1a).
+size_t ki_json_hash_bytes(const void* data, size_t length);
+
+// Returns hash of number, equal numbers hash the same (0.0 & -0.0 included).
+uint64_t ki_json_hash_number(double number);
+// Returns hash of json value without values to walk (anything but non-empty json objects & json arrays).
+uint64_t ki_json_hash_leaf(const struct ki_json_val* val);
+// Returns hash of json object or json array before adding any of its values, covering its count.
+uint64_t ki_json_hash_seed(const struct ki_json_val* val);
+// Returns hash of json object or json array container so far, after adding value_hash of its value at index.
+// Pairs of objects are summed up, so their order doesn't matter; values of arrays are chained in order.
+uint64_t ki_json_hash_add(const struct ki_json_val* container, size_t index, uint64_t hash, uint64_t value_hash);
+// Returns hash of json object or json array, once hashes of all of its values were added.
+uint64_t ki_json_hash_finish(uint64_t hash);
+
+/* Objects */
+
+// Returns number of slots of a hash index with room for at least pair_count pairs while staying at most half full.
+size_t ki_json_object_index_capacity(size_t pair_count);
+// Returns size in bytes of the hash index of a json object with index_capacity slots, including its cached order.
+size_t ki_json_object_index_size(size_t index_capacity);
+// Inserts every pair of json object into its hash index.
+// NOTE: Index must be zeroed & have room for all pairs.
+void ki_json_object_index_fill(struct ki_json_object* object);
+// Finds index of pair with given name of name_length, whose hash (see ki_json_hash_bytes()) is known already, in json object.
+// Builds hash index first if the object has gotten big enough.
+// Returns true on success, false if there's no such pair.
+bool ki_json_object_find_hashed(struct ki_json_object* object, const char* name, size_t name_length, size_t hash, size_t* pair_index);
+// Finds index of pair with given name of name_length, whose hash (see ki_json_hash_bytes()) is known already, in json object.
+// Uses the hash index if the object has one, but never builds it, so the object is left as is.
+// Returns true on success, false if there's no such pair.
+bool ki_json_object_peek_hashed(const struct ki_json_object* object, const char* name, size_t name_length, size_t hash, size_t* pair_index);
+// Sorts pairs of json object with a hash index by name & caches their order after its slots, see ki_json_object_ordered().
+void ki_json_object_order_fill(struct ki_json_object* object);
+// Returns indices of pairs of json object ordered by name, comparing names by their UTF-16 code units like RFC 8785 does.
+// Order of objects with a hash index is cached along with it until pairs are added or removed (building the index first
+// if the object has gotten big enough), smaller objects are sorted into scratch of KI_JSON_OBJECT_INDEX_THRESHOLD indices.
+// NOTE: Frozen objects (see ki_json_val_freeze()) are never changed, their order was cached when they were frozen.
+// Returns NULL on fail.
+const size_t* ki_json_object_ordered(struct ki_json_object* object, bool frozen, size_t* scratch);
+
+/* Values */
+
+// Allocates a zeroed json value of given type using allocator (NULL = default).
+// Values using the stdlib allocator are taken from the node pool.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_alloc(const struct ki_json_allocator* allocator, enum ki_json_val_type type);
+// Frees memory of json value itself, not of anything inside of it.
+void ki_json_val_dealloc(struct ki_json_val* val);
+// Frees everything inside of json value, not the memory of the json value itself.
+void ki_json_val_fini(struct ki_json_val* val);
+// Fixes up json value after its bytes were moved to another address (memcpy, realloc, ...).
+// NOTE: Inline strings point into their own json value.
+void ki_json_val_relocate(struct ki_json_val* val);
+
+/* Sharing */
+
+// Gives up a reference to json value if it is shared.
+// Returns true if it was shared (so nothing else is to be done), false if the caller was its only owner.
+bool ki_json_val_unref(struct ki_json_val* val);
+// Returns new json value holding a copy of everything inside of val, where values inside of it are shared instead of copied.
+// NOTE: Values of arrays with KI_JSON_ARRAY_STORAGE_INLINE are copied the same way, as they can't be shared.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_copy_shallow(const struct ki_json_val* val);
+
+/* Clones */
+
+// Returns allocator of the block for allocators of clones, allocator itself otherwise.
+// Memory that may outlive a clone has to come from there.
+const struct ki_json_allocator* ki_json_clone_base_allocator(const struct ki_json_allocator* allocator);
+// Whether json value is part of a clone, other than its root.
+// NOTE: Those are freed along with their clone, so they can't be shared.
+bool ki_json_clone_owns(const struct ki_json_val* val);
+// Whether json value is the root of a clone.
+// NOTE: Freeing its node frees the whole clone, so everything inside of it has to be freed before.
+bool ki_json_clone_is_root(const struct ki_json_val* val);
+
+/* Arrays */
+
+// Inits json array holding its values as given by storage, using given allocator (NULL = default).
+// Returns true on success, false on fail.
+bool ki_json_array_init_with_storage(struct ki_json_array* array, size_t capacity, enum ki_json_array_storage storage, const struct ki_json_allocator* allocator);
+
+// Returns zeroed slot past the last value of json array, expanding the array if needed.
+// Slot is a struct ki_json_val for KI_JSON_ARRAY_STORAGE_INLINE & a double for KI_JSON_ARRAY_STORAGE_NUMBERS.
+// NOTE: Value in the slot becomes part of the array once its count is incremented.
+// Returns NULL on fail.
+void* ki_json_array_next_slot(struct ki_json_array* array);
+// Copies slots of all values in json array into out, one after another without the gap.
+// NOTE: Copied inline values must be relocated, copied boxed values are still owned by the array.
+void ki_json_array_copy_slots(const struct ki_json_array* array, void* out);
+// Returns size in bytes of a single value in the data of a json array with given storage.
+size_t ki_json_array_slot_size(enum ki_json_array_storage storage);
+// Returns address of the pointer to the value at given index in json array with KI_JSON_ARRAY_STORAGE_BOXED, for replacing it.
+// Returns NULL on fail.
+struct ki_json_val** ki_json_array_boxed_slot(struct ki_json_array* array, size_t index);
+// Returns val at given index in json array, unpacking json array with KI_JSON_ARRAY_STORAGE_NUMBERS
+// to KI_JSON_ARRAY_STORAGE_BOXED first.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_array_unpacked_at(struct ki_json_array* array, size_t index);
+
+/* Scanning */
+
+// What ki_json_scan_next() read.
+enum ki_json_scan_event
+{
+    KI_JSON_SCAN_SCALAR, //string, number, true, false or null
+    KI_JSON_SCAN_OBJECT, //start of a json object
+    KI_JSON_SCAN_ARRAY, //start of a json array
+    KI_JSON_SCAN_END, //end of the innermost json object or json array
+    KI_JSON_SCAN_DONE //root value was read completely
+};
+
+// Reads json text value by value following the parser's rules, without building a json tree.
+// NOTE: Only offset, depth, first & done change while reading, saving & restoring those goes back to where they were saved.
+struct ki_json_scanner
+{
+    const char* json;
+    // Length of json (excluding null terminator)
+    size_t length;
+    // Offset of the next byte to read
+    size_t offset;
+    // Kinds ('{' or '[') of the json objects & arrays being read, innermost last
+    char* kinds;
+    size_t depth;
+    size_t kinds_size;
+    // Decoded name of the last pair read, if it had escape sequences
+    char* names;
+    size_t names_size;
+    // Whether the next value of the innermost json object or json array is its first one
+    bool first;
+    // Whether the root value was read completely
+    bool done;
+};
+
+// Value read by ki_json_scan_next().
+struct ki_json_scan_value
+{
+    enum ki_json_scan_event event;
+    // Offset of the first byte of the value, for KI_JSON_SCAN_END of its json object or json array
+    size_t start;
+    // Offset past the last byte of scalars & ends of json objects & json arrays
+    size_t end;
+    // Name of the pair of values inside json objects, not null-terminated, NULL otherwise.
+    // NOTE: Valid until the next value is read.
+    const char* name;
+    size_t name_length;
+};
+
+// Inits scanner reading json text of length bytes.
+void ki_json_scanner_init(struct ki_json_scanner* scanner, const char* json, size_t length);
+// Starts reading json text of length bytes over, keeping the scanner's buffers.
+void ki_json_scanner_reset(struct ki_json_scanner* scanner, const char* json, size_t length);
+void ki_json_scanner_fini(struct ki_json_scanner* scanner);
+// Reads next value, or the end of the innermost json object or json array, outs it to value.
+// NOTE: Strings are checked to end, but their escape sequences aren't checked unless they are names.
+// Returns KI_JSON_ERR_NONE on success, the error the parser would fail with otherwise.
+enum ki_json_err_type ki_json_scan_next(struct ki_json_scanner* scanner, struct ki_json_scan_value* value);
+// Skips rest of the json object or json array just started (see KI_JSON_SCAN_OBJECT), outs offset past its end to end.
+// NOTE: Skipped values are only checked for strings ending & for json objects & json arrays to end.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_UNTERMINATED_STRING, KI_JSON_ERR_UNTERMINATED_OBJECT or KI_JSON_ERR_UNTERMINATED_ARRAY on fail.
+enum ki_json_err_type ki_json_scan_skip(struct ki_json_scanner* scanner, size_t* end);
+
+#endif //KI_JSON_JSON_INTERNAL_H
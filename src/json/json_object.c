@@ -5,6 +5,9 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
+
+#include "json_internal.h"
 
 // Frees data of pair at index.
 // NOTE: data of pair at index should be overwritten after calling this function.
@@ -14,38 +17,270 @@ static bool ki_json_object_free_pair_index(struct ki_json_object* object, size_t
     if (index >= object->count)
         return false;
 
-    free(object->names[index]);
-    ki_json_val_free(object->values[index]);
-    object->names[index] = NULL;
-    object->values[index] = NULL;
+    struct ki_json_pair* pair = &object->pairs[index];
+
+    ki_json_strfree(object->allocator, pair->name, pair->name_length);
+    ki_json_val_free(pair->value);
+    memset(pair, 0, sizeof(*pair));
 
     return true;
 }
 
-bool ki_json_object_init(struct ki_json_object* object, size_t capacity)
+/* Hash index */
+
+// Hashes length bytes of data (FNV-1a).
+size_t ki_json_hash_bytes(const void* data, size_t length)
 {
-    assert(object);
+    uint64_t hash = 14695981039346656037ULL;
+    const unsigned char* bytes = data;
 
-    object->capacity = capacity;
-    object->count = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
 
-    object->names = calloc(object->capacity, sizeof(*object->names));
+    return (size_t)hash;
+}
 
-    if (object->names == NULL)
-    {
-        free(object);
+// Whether pair has the given name of name_length with given hash.
+// Most pairs are told apart by their hash & length alone, without touching their name.
+static bool ki_json_pair_has_name(const struct ki_json_pair* pair, const char* name, size_t name_length, size_t hash)
+{
+    return pair->hash == hash && pair->name_length == name_length && memcmp(pair->name, name, name_length) == 0;
+}
+
+// Returns size in bytes of the hash index of a json object with index_capacity slots, including its cached order.
+// Slots are followed by whether the order is cached (0 or 1) & room for index_capacity / 2 pair indices,
+// as the index is at most half full.
+size_t ki_json_object_index_size(size_t index_capacity)
+{
+    return sizeof(size_t) * (index_capacity + 1 + index_capacity / 2);
+}
+
+// Frees hash index of json object, lookups fall back to scanning all names until it is rebuilt.
+static void ki_json_object_index_free(struct ki_json_object* object)
+{
+    if (object->index != NULL)
+        ki_json_dealloc(object->allocator, object->index, ki_json_object_index_size(object->index_capacity));
+
+    object->index = NULL;
+    object->index_capacity = 0;
+}
+
+// Inserts pair at pair_index into hash index of json object.
+// NOTE: Index must have a free slot.
+static void ki_json_object_index_insert(struct ki_json_object* object, size_t pair_index)
+{
+    size_t mask = object->index_capacity - 1;
+    size_t slot = object->pairs[pair_index].hash & mask;
+
+    //pairs changed, so order has to be sorted again
+    object->index[object->index_capacity] = 0;
+
+    //linear probing
+    while (object->index[slot] != 0)
+        slot = (slot + 1) & mask;
+
+    object->index[slot] = pair_index + 1;
+}
+
+// Returns number of slots of a hash index with room for at least pair_count pairs while staying at most half full.
+size_t ki_json_object_index_capacity(size_t pair_count)
+{
+    size_t capacity = KI_JSON_OBJECT_INDEX_THRESHOLD * 2;
+
+    while (capacity < pair_count * 2)
+        capacity *= 2;
+
+    return capacity;
+}
+
+// Inserts every pair of json object into its hash index.
+// NOTE: Index must be zeroed & have room for all pairs.
+void ki_json_object_index_fill(struct ki_json_object* object)
+{
+    for (size_t i = 0; i < object->count; i++)
+        ki_json_object_index_insert(object, i);
+}
+
+// (Re)builds hash index of json object, with room for at least pair_count pairs while staying at most half full.
+// Returns true on success, false on fail.
+static bool ki_json_object_index_build(struct ki_json_object* object, size_t pair_count)
+{
+    size_t new_capacity = ki_json_object_index_capacity(pair_count);
+    size_t* new_index = ki_json_calloc(object->allocator, ki_json_object_index_size(new_capacity) / sizeof(*new_index), sizeof(*new_index));
+
+    if (new_index == NULL)
         return false;
+
+    ki_json_object_index_free(object);
+
+    object->index = new_index;
+    object->index_capacity = new_capacity;
+
+    ki_json_object_index_fill(object);
+
+    return true;
+}
+
+// Finds slot of pair with given name of name_length & hash in hash index of json object.
+// Returns true on success, false if there's no such pair.
+static bool ki_json_object_index_find(const struct ki_json_object* object, const char* name, size_t name_length, size_t hash, size_t* slot)
+{
+    size_t mask = object->index_capacity - 1;
+    size_t i = hash & mask;
+
+    while (object->index[i] != 0)
+    {
+        if (ki_json_pair_has_name(&object->pairs[object->index[i] - 1], name, name_length, hash))
+        {
+            *slot = i;
+            return true;
+        }
+
+        i = (i + 1) & mask;
     }
 
-    object->values = calloc(object->capacity, sizeof(*object->values));
+    return false;
+}
+
+// Removes pair at pair_index from hash index of json object, pairs to the right of it move back one space.
+// Pairs after it in the same probe sequence are moved back into the hole, so no tombstones are needed.
+static void ki_json_object_index_remove(struct ki_json_object* object, size_t pair_index)
+{
+    size_t mask = object->index_capacity - 1;
+    size_t hole = object->pairs[pair_index].hash & mask;
+
+    object->index[object->index_capacity] = 0;
+
+    while (object->index[hole] != pair_index + 1)
+        hole = (hole + 1) & mask;
 
-    if (object->values == NULL)
+    for (size_t i = (hole + 1) & mask; object->index[i] != 0; i = (i + 1) & mask)
     {
-        free(object->names);
-        free(object);
-        return false;
+        size_t home = object->pairs[object->index[i] - 1].hash & mask;
+
+        //can only move back if hole lies between its home slot and where it is now
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            object->index[hole] = object->index[i];
+            hole = i;
+        }
     }
-    
+
+    object->index[hole] = 0;
+
+    for (size_t i = 0; i < object->index_capacity; i++)
+    {
+        if (object->index[i] > pair_index + 1)
+            object->index[i]--;
+    }
+}
+
+// Finds index of pair with given name of name_length in json object.
+// Builds hash index first if the object has gotten big enough.
+// Returns true on success, false if there's no such pair.
+static bool ki_json_object_find(struct ki_json_object* object, const char* name, size_t name_length, size_t* pair_index)
+{
+    //build lazily, scanning all pairs still works if it fails
+    if (object->index == NULL && object->count >= KI_JSON_OBJECT_INDEX_THRESHOLD)
+        ki_json_object_index_build(object, object->count);
+
+    if (object->index != NULL)
+    {
+        size_t slot = 0;
+
+        if (!ki_json_object_index_find(object, name, name_length, ki_json_hash_bytes(name, name_length), &slot))
+            return false;
+
+        *pair_index = object->index[slot] - 1;
+        return true;
+    }
+
+    //few pairs, hashing name would take longer than comparing lengths
+    for (size_t i = 0; i < object->count; i++)
+    {
+        const struct ki_json_pair* pair = &object->pairs[i];
+
+        if (pair->name_length == name_length && memcmp(pair->name, name, name_length) == 0)
+        {
+            *pair_index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Finds index of pair with given name of name_length, whose hash (see ki_json_hash_bytes()) is known already, in json object.
+// Builds hash index first if the object has gotten big enough, like ki_json_object_find().
+// Returns true on success, false if there's no such pair.
+bool ki_json_object_find_hashed(struct ki_json_object* object, const char* name, size_t name_length, size_t hash, size_t* pair_index)
+{
+    assert(object && name);
+
+    if (object->index == NULL && object->count >= KI_JSON_OBJECT_INDEX_THRESHOLD)
+        ki_json_object_index_build(object, object->count);
+
+    return ki_json_object_peek_hashed(object, name, name_length, hash, pair_index);
+}
+
+// Finds index of pair with given name of name_length, whose hash (see ki_json_hash_bytes()) is known already, in json object.
+// Uses the hash index if the object has one, but never builds it, so the object is left as is.
+// Returns true on success, false if there's no such pair.
+bool ki_json_object_peek_hashed(const struct ki_json_object* object, const char* name, size_t name_length, size_t hash, size_t* pair_index)
+{
+    assert(object && name);
+
+    if (object->index != NULL)
+    {
+        size_t slot = 0;
+
+        if (!ki_json_object_index_find(object, name, name_length, hash, &slot))
+            return false;
+
+        *pair_index = object->index[slot] - 1;
+        return true;
+    }
+
+    //with the hash at hand, pairs are told apart without touching their names
+    for (size_t i = 0; i < object->count; i++)
+    {
+        if (ki_json_pair_has_name(&object->pairs[i], name, name_length, hash))
+        {
+            *pair_index = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Inits json object using the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_object_init(struct ki_json_object* object, size_t capacity)
+{
+    return ki_json_object_init_with_allocator(object, capacity, NULL);
+}
+
+// Inits json object using given allocator, NULL for the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_object_init_with_allocator(struct ki_json_object* object, size_t capacity, const struct ki_json_allocator* allocator)
+{
+    assert(object);
+
+    object->allocator = ki_json_allocator_resolve(allocator);
+    object->capacity = capacity;
+    object->count = 0;
+    object->index = NULL;
+    object->index_capacity = 0;
+
+    object->pairs = ki_json_calloc(object->allocator, object->capacity, sizeof(*object->pairs));
+
+    if (object->pairs == NULL)
+        return false;
+
     return true;
 }
 
@@ -56,22 +291,152 @@ void ki_json_object_fini(struct ki_json_object* object)
     for (size_t i = 0; i < object->count; i++)
         ki_json_object_free_pair_index(object, i);
 
+    if (object->pairs != NULL)
+    {
+        ki_json_dealloc(object->allocator, object->pairs, sizeof(*object->pairs) * object->capacity);
+        object->pairs = NULL;
+    }
+
+    ki_json_object_index_free(object);
+
     object->count = 0;
     object->capacity = 0;
+}
 
-    if (object->names != NULL)
+/* Ordering */
+
+// Whether name a of a_length comes before name b of b_length when comparing their UTF-16 code units, as RFC 8785 sorts them.
+// UTF-8 bytes compare like code points, which only differ from UTF-16 code units for U+E000 - U+FFFF
+// (lead bytes 0xEE & 0xEF) coming after surrogate pairs (lead bytes 0xF0 - 0xF4).
+static bool ki_json_name_less(const char* a, size_t a_length, const char* b, size_t b_length)
+{
+    size_t length = (a_length < b_length) ? a_length : b_length;
+
+    for (size_t i = 0; i < length; i++)
     {
-        free(object->names);
-        object->names = NULL;
+        unsigned char a_byte = (unsigned char)a[i];
+        unsigned char b_byte = (unsigned char)b[i];
+
+        if (a_byte != b_byte)
+        {
+            //0xEE & 0xEF are only ever lead bytes, move them past the lead bytes of surrogate pairs
+            unsigned int a_unit = (a_byte == 0xEE || a_byte == 0xEF) ? a_byte + 0x10u : a_byte;
+            unsigned int b_unit = (b_byte == 0xEE || b_byte == 0xEF) ? b_byte + 0x10u : b_byte;
+
+            return a_unit < b_unit;
+        }
     }
-    
-    if (object->values != NULL)
+
+    return a_length < b_length;
+}
+
+// Whether pair at index a of json object comes before pair at index b, see ki_json_name_less().
+static bool ki_json_object_pair_less(const struct ki_json_object* object, size_t a, size_t b)
+{
+    const struct ki_json_pair* pair_a = &object->pairs[a];
+    const struct ki_json_pair* pair_b = &object->pairs[b];
+
+    return ki_json_name_less(pair_a->name, pair_a->name_length, pair_b->name, pair_b->name_length);
+}
+
+// Moves pair index at root of heap order of count indices down until the heap is ordered again.
+static void ki_json_object_order_sift(const struct ki_json_object* object, size_t* order, size_t root, size_t count)
+{
+    size_t child = 0;
+
+    while ((child = root * 2 + 1) < count)
     {
-        free(object->values);
-        object->values = NULL;
+        if (child + 1 < count && ki_json_object_pair_less(object, order[child], order[child + 1]))
+            child++;
+
+        if (!ki_json_object_pair_less(object, order[root], order[child]))
+            return;
+
+        size_t temp = order[root];
+        order[root] = order[child];
+        order[child] = temp;
+        root = child;
     }
 }
 
+// Sorts indices of all pairs of json object into order by name.
+// Small objects are insertion sorted, big ones heap sorted in place so no memory is needed.
+static void ki_json_object_order_sort(const struct ki_json_object* object, size_t* order)
+{
+    size_t count = object->count;
+
+    if (count < KI_JSON_OBJECT_INDEX_THRESHOLD)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t j = i;
+
+            for (; j > 0 && ki_json_object_pair_less(object, i, order[j - 1]); j--)
+                order[j] = order[j - 1];
+
+            order[j] = i;
+        }
+
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        order[i] = i;
+
+    for (size_t i = count / 2; i > 0; i--)
+        ki_json_object_order_sift(object, order, i - 1, count);
+
+    for (size_t i = count - 1; i > 0; i--)
+    {
+        size_t temp = order[0];
+        order[0] = order[i];
+        order[i] = temp;
+
+        ki_json_object_order_sift(object, order, 0, i);
+    }
+}
+
+// Sorts pairs of json object with a hash index by name & caches their order after its slots, see ki_json_object_ordered().
+void ki_json_object_order_fill(struct ki_json_object* object)
+{
+    assert(object && object->index != NULL);
+
+    ki_json_object_order_sort(object, object->index + object->index_capacity + 1);
+    object->index[object->index_capacity] = 1;
+}
+
+// Returns indices of pairs of json object ordered by name, comparing names by their UTF-16 code units like RFC 8785 does.
+// Order of objects with a hash index is cached along with it until pairs are added or removed (building the index first
+// if the object has gotten big enough), smaller objects are sorted into scratch of KI_JSON_OBJECT_INDEX_THRESHOLD indices.
+// NOTE: Frozen objects (see ki_json_val_freeze()) are never changed, their order was cached when they were frozen.
+// Returns NULL on fail.
+const size_t* ki_json_object_ordered(struct ki_json_object* object, bool frozen, size_t* scratch)
+{
+    assert(object && scratch);
+
+    if (object->index == NULL && object->count >= KI_JSON_OBJECT_INDEX_THRESHOLD && !frozen)
+        ki_json_object_index_build(object, object->count);
+
+    if (object->index != NULL)
+    {
+        if (object->index[object->index_capacity] == 0)
+        {
+            if (frozen)
+                return NULL;
+
+            ki_json_object_order_fill(object);
+        }
+
+        return object->index + object->index_capacity + 1;
+    }
+
+    if (object->count >= KI_JSON_OBJECT_INDEX_THRESHOLD)
+        return NULL;
+
+    ki_json_object_order_sort(object, scratch);
+    return scratch;
+}
+
 /* Getting values */
 
 // Returns val with given name in json object.
@@ -80,13 +445,84 @@ struct ki_json_val* ki_json_object_get(struct ki_json_object* object, const char
 {
     assert(object && name);
 
-    for (size_t i = 0; i < object->count; i++)
-    {
-        if (strcmp(object->names[i], name) == 0)
-            return object->values[i];
-    }
+    return ki_json_object_getn(object, name, strlen(name));
+}
+
+// Returns val with given name of name_length bytes in json object, name may contain '\0's.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_getn(struct ki_json_object* object, const char* name, size_t name_length)
+{
+    assert(object && name);
+
+    size_t index = 0;
+
+    if (!ki_json_object_find(object, name, name_length, &index))
+        return NULL;
+
+    return object->pairs[index].value;
+}
+
+// Returns val with given name in json object, replacing it with a copy first if it is shared, so it can be changed (see ki_json_val_share()).
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_get_mut(struct ki_json_object* object, const char* name)
+{
+    assert(object && name);
+
+    return ki_json_object_getn_mut(object, name, strlen(name));
+}
+
+// Returns val with given name of name_length bytes in json object, see ki_json_object_get_mut().
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_getn_mut(struct ki_json_object* object, const char* name, size_t name_length)
+{
+    assert(object && name);
 
-    return NULL;
+    size_t index = 0;
+
+    if (!ki_json_object_find(object, name, name_length, &index))
+        return NULL;
+
+    struct ki_json_val* val = ki_json_val_unshare(object->pairs[index].value);
+
+    if (val != NULL)
+        object->pairs[index].value = val;
+
+    return val;
+}
+
+// Returns name of pair at given index in json object.
+// Returns NULL on fail.
+const char* ki_json_object_name_at(const struct ki_json_object* object, size_t index)
+{
+    assert(object);
+
+    if (index >= object->count)
+        return NULL;
+
+    return object->pairs[index].name;
+}
+
+// Returns length of name of pair at given index in json object, 0 on fail.
+size_t ki_json_object_name_length_at(const struct ki_json_object* object, size_t index)
+{
+    assert(object);
+
+    if (index >= object->count)
+        return 0;
+
+    return object->pairs[index].name_length;
+}
+
+// Returns value of pair at given index in json object.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_object_val_at(const struct ki_json_object* object, size_t index)
+{
+    assert(object);
+
+    if (index >= object->count)
+        return NULL;
+
+    return object->pairs[index].value;
 }
 
 // Returns json object with given name in json object.
@@ -131,6 +567,15 @@ char* ki_json_object_get_string(struct ki_json_object* object, const char* name)
     return val->value.string;
 }
 
+// Returns string with given name of name_length bytes in json object, outs its length.
+// Returns NULL on fail.
+char* ki_json_object_get_stringn(struct ki_json_object* object, const char* name, size_t name_length, size_t* length)
+{
+    assert(object && name);
+
+    return ki_json_val_get_stringn(ki_json_object_getn(object, name, name_length), length);
+}
+
 // TODO: what to do on fail? ki_json_object_get_number
 // Returns number with given name in json object.
 double ki_json_object_get_number(struct ki_json_object* object, const char* name)
@@ -161,38 +606,49 @@ bool ki_json_object_get_bool(struct ki_json_object* object, const char* name)
 
 /* Adding values */
 
-// Doubles capacity of json object.
-static bool ki_json_object_expand(struct ki_json_object* object)
+// Grows capacity of json object to new_capacity pairs.
+static bool ki_json_object_grow(struct ki_json_object* object, size_t new_capacity)
 {
-    // allocate new arrays
+    struct ki_json_pair* new_pairs = ki_json_realloc(object->allocator, object->pairs, sizeof(*new_pairs) * object->capacity, sizeof(*new_pairs) * new_capacity);
 
-    char** new_names = realloc(object->names, sizeof(*new_names) * object->capacity * 2);
-
-    if (object->names == NULL)
+    if (new_pairs == NULL)
         return false;
 
-    struct ki_json_val** new_values = realloc(object->values, sizeof(*new_values) * object->capacity * 2);
+    // fill new spots with empty pairs
+    memset(new_pairs + object->capacity, 0, sizeof(*new_pairs) * (new_capacity - object->capacity));
 
-    if (new_values == NULL)
-    {
-        free(new_names);
+    // set to new
+
+    object->pairs = new_pairs;
+    object->capacity = new_capacity;
+
+    return true;
+}
+
+// Doubles capacity of json object.
+static bool ki_json_object_expand(struct ki_json_object* object)
+{
+    return ki_json_object_grow(object, (object->capacity > 0) ? object->capacity * 2 : 1);
+}
+
+// Makes room for at least capacity pairs in json object, so adding up to that many doesn't reallocate.
+// NOTE: Never shrinks.
+// Returns true on success, false on fail.
+bool ki_json_object_reserve(struct ki_json_object* object, size_t capacity)
+{
+    assert(object);
+
+    if (capacity > object->capacity && !ki_json_object_grow(object, capacity))
         return false;
-    }
 
-    // fill new spots with NULL
-    for (size_t i = object->capacity; i < object->capacity * 2; i++)
+    //size hash index for all of them up front instead of rebuilding it while adding
+    //if that fails it's (re)built on a later lookup
+    if (capacity >= KI_JSON_OBJECT_INDEX_THRESHOLD && (object->index == NULL || capacity * 2 > object->index_capacity))
     {
-        new_names[i] = NULL;
-        new_values[i] = NULL;
+        if (!ki_json_object_index_build(object, capacity))
+            ki_json_object_index_free(object);
     }
 
-    // set to new
-
-    object->names = new_names;
-    object->values = new_values;
-    
-    object->capacity *= 2;
-
     return true;
 }
 
@@ -201,31 +657,82 @@ static bool ki_json_object_expand(struct ki_json_object* object)
 // NOTE 2: Name is copied.
 enum ki_json_err_type ki_json_object_add(struct ki_json_object* object, const char* name, struct ki_json_val* value)
 {
-    //check if name already exists
-    if (ki_json_object_get(object, name) != NULL)
-        return KI_JSON_ERR_NAME_ALREADY_EXISTS;
+    assert(object && name);
 
-    //if need to expand, but failed to do so
-    if (object->count == object->capacity && !ki_json_object_expand(object))
-        return KI_JSON_ERR_MEMORY;
+    return ki_json_object_addn(object, name, strlen(name), value);
+}
+
+// Adds json value to json object as given name of name_length bytes, name may contain '\0's.
+// NOTE 1: Ownership of value is given to json object, and will free it once done.
+// NOTE 2: Name is copied.
+enum ki_json_err_type ki_json_object_addn(struct ki_json_object* object, const char* name, size_t name_length, struct ki_json_val* value)
+{
+    assert(object && name);
 
     //copy name into our own allocated space so we can free it once we're done
-    //FIXME: this has no limit on how much it can copy
-    
-    size_t name_length = strlen(name);
-    char* copy = calloc(name_length + 1, sizeof(*copy));
+    char* copy = ki_json_strndup(object->allocator, name, name_length);
 
     if (copy == NULL)
         return KI_JSON_ERR_MEMORY;
 
-    strncpy(copy, name, name_length);
+    enum ki_json_err_type err_type = ki_json_object_addn_take_name(object, copy, name_length, value);
 
-    copy[name_length] = '\0'; //null-terminator
+    if (err_type != KI_JSON_ERR_NONE)
+        ki_json_strfree(object->allocator, copy, name_length);
+
+    return err_type;
+}
 
-    object->names[object->count] = copy;
-    object->values[object->count] = value; 
+// Adds json value to json object as given name, taking over name instead of copying it.
+// NOTE 1: Ownership of value & name is given to json object, and will free them once done. Both are left to the caller on fail.
+// NOTE 2: Name must be allocated using the allocator of the json object, strlen(name) + 1 bytes in size.
+enum ki_json_err_type ki_json_object_add_take_name(struct ki_json_object* object, char* name, struct ki_json_val* value)
+{
+    assert(object && name);
+
+    return ki_json_object_addn_take_name(object, name, strlen(name), value);
+}
+
+// Adds json value to json object as given null-terminated name of name_length bytes, taking over name instead of copying it.
+// NOTE 1: Ownership of value & name is given to json object, and will free them once done. Both are left to the caller on fail.
+// NOTE 2: Name must be allocated using the allocator of the json object, name_length + 1 bytes in size.
+enum ki_json_err_type ki_json_object_addn_take_name(struct ki_json_object* object, char* name, size_t name_length, struct ki_json_val* value)
+{
+    assert(object && name);
+
+    size_t index = 0;
+
+    //check if name already exists
+    if (ki_json_object_find(object, name, name_length, &index))
+        return KI_JSON_ERR_NAME_ALREADY_EXISTS;
+
+    //if need to expand, but failed to do so
+    if (object->count == object->capacity && !ki_json_object_expand(object))
+        return KI_JSON_ERR_MEMORY;
+
+    struct ki_json_pair* pair = &object->pairs[object->count];
+
+    pair->name = name;
+    pair->name_length = name_length;
+    pair->hash = ki_json_hash_bytes(name, name_length);
+    pair->value = value;
     object->count++;
 
+    //keep hash index up to date, growing it once it's half full
+    //if that fails it's dropped & rebuilt on the next lookup
+    if (object->index != NULL)
+    {
+        if (object->count * 2 > object->index_capacity)
+        {
+            if (!ki_json_object_index_build(object, object->count))
+                ki_json_object_index_free(object);
+        }
+        else
+        {
+            ki_json_object_index_insert(object, object->count - 1);
+        }
+    }
+
     return KI_JSON_ERR_NONE;
 }
 
@@ -234,7 +741,7 @@ enum ki_json_err_type ki_json_object_add(struct ki_json_object* object, const ch
 // Returns NULL on fail.
 struct ki_json_val* ki_json_object_add_new_object(struct ki_json_object* object, const char* name, size_t capacity)
 {
-    struct ki_json_val* val = ki_json_val_create_object(capacity);
+    struct ki_json_val* val = ki_json_val_create_object_with_allocator(capacity, object->allocator);
 
     if (val == NULL)
         return NULL;
@@ -253,7 +760,7 @@ struct ki_json_val* ki_json_object_add_new_object(struct ki_json_object* object,
 // Returns NULL on fail.
 struct ki_json_val* ki_json_object_add_new_array(struct ki_json_object* object, const char* name, size_t capacity)
 {
-    struct ki_json_val* val = ki_json_val_create_array(capacity);
+    struct ki_json_val* val = ki_json_val_create_array_with_allocator(capacity, object->allocator);
 
     if (val == NULL)
         return NULL;
@@ -272,7 +779,7 @@ struct ki_json_val* ki_json_object_add_new_array(struct ki_json_object* object,
 // Returns NULL on fail.
 struct ki_json_val* ki_json_object_add_new_string(struct ki_json_object* object, const char* name, const char* string)
 {
-    struct ki_json_val* val = ki_json_val_create_from_string(string);
+    struct ki_json_val* val = ki_json_val_create_from_string_with_allocator(string, object->allocator);
 
     if (val == NULL)
         return NULL;
@@ -291,7 +798,7 @@ struct ki_json_val* ki_json_object_add_new_string(struct ki_json_object* object,
 // Returns NULL on fail.
 struct ki_json_val* ki_json_object_add_new_number(struct ki_json_object* object, const char* name, double number)
 {
-    struct ki_json_val* val = ki_json_val_create_from_number(number);
+    struct ki_json_val* val = ki_json_val_create_from_number_with_allocator(number, object->allocator);
 
     if (val == NULL)
         return NULL;
@@ -310,7 +817,7 @@ struct ki_json_val* ki_json_object_add_new_number(struct ki_json_object* object,
 // Returns NULL on fail.
 struct ki_json_val* ki_json_object_add_new_bool(struct ki_json_object* object, const char* name, bool boolean)
 {
-    struct ki_json_val* val = ki_json_val_create_from_bool(boolean);
+    struct ki_json_val* val = ki_json_val_create_from_bool_with_allocator(boolean, object->allocator);
 
     if (val == NULL)
         return NULL;
@@ -329,7 +836,7 @@ struct ki_json_val* ki_json_object_add_new_bool(struct ki_json_object* object, c
 // Returns NULL on fail.
 struct ki_json_val* ki_json_object_add_new_null(struct ki_json_object* object, const char* name)
 {
-    struct ki_json_val* val = ki_json_val_create_null();
+    struct ki_json_val* val = ki_json_val_create_null_with_allocator(object->allocator);
 
     if (val == NULL)
         return NULL;
@@ -345,12 +852,43 @@ struct ki_json_val* ki_json_object_add_new_null(struct ki_json_object* object, c
 
 /* Setting values */
 
+// Sets json value with given name in json object, adding it if there is no value with that name yet.
+// Old value with given name is freed.
+// NOTE 1: Ownership of value is given to json object, and will free it once done.
+// NOTE 2: Name is copied.
+enum ki_json_err_type ki_json_object_set(struct ki_json_object* object, const char* name, struct ki_json_val* value)
+{
+    assert(object && name);
+
+    return ki_json_object_setn(object, name, strlen(name), value);
+}
+
+// Sets json value with given name of name_length bytes in json object, see ki_json_object_set().
+enum ki_json_err_type ki_json_object_setn(struct ki_json_object* object, const char* name, size_t name_length, struct ki_json_val* value)
+{
+    assert(object && name);
+
+    size_t index = 0;
+
+    if (!ki_json_object_find(object, name, name_length, &index))
+        return ki_json_object_addn(object, name, name_length, value);
+
+    struct ki_json_pair* pair = &object->pairs[index];
+
+    if (pair->value != value)
+        ki_json_val_free(pair->value);
+
+    pair->value = value;
+
+    return KI_JSON_ERR_NONE;
+}
+
 // NOTE 1: Value must be of type KI_JSON_VAL_STRING.
 // NOTE 2: String is copied.
 // Returns true on success, false on fail.
 bool ki_json_object_set_string(struct ki_json_object* object, const char* name, const char* string)
 {
-    struct ki_json_val* val = ki_json_object_get(object, name);
+    struct ki_json_val* val = ki_json_object_get_mut(object, name);
 
     if (val == NULL)
         return false;
@@ -362,7 +900,7 @@ bool ki_json_object_set_string(struct ki_json_object* object, const char* name,
 // Returns true on success, false on fail.
 bool ki_json_object_set_number(struct ki_json_object* object, const char* name, double number)
 {
-    struct ki_json_val* val = ki_json_object_get(object, name);
+    struct ki_json_val* val = ki_json_object_get_mut(object, name);
 
     if (val == NULL || val->type != KI_JSON_VAL_NUMBER)
         return false;
@@ -376,7 +914,7 @@ bool ki_json_object_set_number(struct ki_json_object* object, const char* name,
 // Returns true on success, false on fail.
 bool ki_json_object_set_bool(struct ki_json_object* object, const char* name, bool boolean)
 {
-    struct ki_json_val* val = ki_json_object_get(object, name);
+    struct ki_json_val* val = ki_json_object_get_mut(object, name);
 
     if (val == NULL || val->type != KI_JSON_VAL_BOOL)
         return false;
@@ -388,40 +926,40 @@ bool ki_json_object_set_bool(struct ki_json_object* object, const char* name, bo
 
 /* Removing values */
 
+// Removes pair with given name from json object, freeing it.
+// Returns true on success, false if there's no such pair.
 bool ki_json_object_remove(struct ki_json_object* object, const char* name)
 {
+    assert(object && name);
+
+    return ki_json_object_removen(object, name, strlen(name));
+}
+
+// Removes pair with given name of name_length bytes from json object, freeing it.
+// Returns true on success, false if there's no such pair.
+bool ki_json_object_removen(struct ki_json_object* object, const char* name, size_t name_length)
+{
+    assert(object && name);
+
     //find index of pair with name
 
-    int index = -1;
-    
-    for (size_t i = 0; i < object->count; i++)
-    {
-        if (strcmp(object->names[i], name) == 0)
-        {
-            index = i;
-            break;
-        }
-    }
+    size_t index = 0;
 
-    //failed to find pair with name
-    if (index == -1)
+    if (!ki_json_object_find(object, name, name_length, &index))
         return false;
 
+    if (object->index != NULL)
+        ki_json_object_index_remove(object, index);
+
     //free found pair
     ki_json_object_free_pair_index(object, index);
 
     //move pairs to right of it back one space, overwriting index with freed pair
 
-    for (size_t i = index + 1; i < object->count; i++)
-    {
-        object->names[i - 1] = object->names[i];
-        object->values[i - 1] = object->values[i];    
-    }
+    memmove(object->pairs + index, object->pairs + index + 1, sizeof(*object->pairs) * (object->count - index - 1));
 
-    object->names[object->count - 1] = NULL;
-    object->values[object->count - 1] = NULL;
+    memset(&object->pairs[object->count - 1], 0, sizeof(*object->pairs));
     object->count--;
 
-    return false;
+    return true;
 }
-
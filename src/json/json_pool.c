@@ -0,0 +1,242 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "json_internal.h"
+
+// Pool for json value nodes allocated with the stdlib allocator.
+// Every thread keeps its own free list of nodes, so allocating & freeing nodes needs no locking.
+// Once a thread's free list grows too large, a batch of nodes is handed back to a global pool other threads refill from.
+// NOTE: Slabs are never returned to the system, freed nodes are only ever reused.
+
+#ifndef KI_JSON_NO_NODE_POOL
+
+#include <pthread.h>
+
+// Amount of nodes moved between a thread's free list and the global pool at once
+#define POOL_BATCH_SIZE 256
+// Amount of nodes a thread's free list may hold before a batch is given back to the global pool
+#define POOL_CACHE_MAX (POOL_BATCH_SIZE * 4)
+// Amount of nodes allocated at once when the global pool is empty
+#define POOL_SLAB_SIZE POOL_BATCH_SIZE
+
+union pool_node
+{
+    struct ki_json_val val;
+
+    struct
+    {
+        // Next free node in free list or batch
+        union pool_node* next;
+        // Next batch in global pool, only used by the first node of a batch
+        union pool_node* next_batch;
+        // Amount of nodes in batch, only used by the first node of a batch
+        size_t batch_count;
+    } link;
+};
+
+struct pool_cache
+{
+    union pool_node* head;
+    size_t count;
+    // Whether thread-exit destructor was registered for this cache yet
+    bool registered;
+};
+
+static KI_JSON_THREAD_LOCAL struct pool_cache thread_cache;
+
+static pthread_mutex_t global_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Batches of at most POOL_BATCH_SIZE free nodes
+static union pool_node* global_batches = NULL;
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key_thread_exit;
+
+/* Global pool */
+
+// Gives given list of count nodes back to the global pool as a single batch.
+static void global_push_batch(union pool_node* batch, size_t count)
+{
+    batch->link.batch_count = count;
+
+    pthread_mutex_lock(&global_mutex);
+
+    batch->link.next_batch = global_batches;
+    global_batches = batch;
+
+    pthread_mutex_unlock(&global_mutex);
+}
+
+// Takes batch of at most POOL_BATCH_SIZE nodes from the global pool.
+// Returns NULL if it is empty.
+static union pool_node* global_pop_batch(void)
+{
+    pthread_mutex_lock(&global_mutex);
+
+    union pool_node* batch = global_batches;
+
+    if (batch != NULL)
+        global_batches = batch->link.next_batch;
+
+    pthread_mutex_unlock(&global_mutex);
+
+    return batch;
+}
+
+// Allocates new slab of POOL_SLAB_SIZE nodes, linked as a free list.
+// Returns NULL on fail.
+static union pool_node* slab_alloc(void)
+{
+    union pool_node* slab = malloc(sizeof(*slab) * POOL_SLAB_SIZE);
+
+    if (slab == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < POOL_SLAB_SIZE - 1; i++)
+        slab[i].link.next = &slab[i + 1];
+
+    slab[POOL_SLAB_SIZE - 1].link.next = NULL;
+    slab[0].link.batch_count = POOL_SLAB_SIZE;
+
+    return slab;
+}
+
+/* Thread cache */
+
+// Gives every node in thread cache back to the global pool.
+static void cache_flush(struct pool_cache* cache)
+{
+    while (cache->count > 0)
+    {
+        //detach up to one batch worth of nodes from the front of the free list
+        union pool_node* batch = cache->head;
+        union pool_node* last = batch;
+        size_t amount = 1;
+
+        while (amount < POOL_BATCH_SIZE && last->link.next != NULL)
+        {
+            last = last->link.next;
+            amount++;
+        }
+
+        cache->head = last->link.next;
+        cache->count -= amount;
+        last->link.next = NULL;
+
+        global_push_batch(batch, amount);
+    }
+
+    cache->head = NULL;
+}
+
+static void cache_on_thread_exit(void* data)
+{
+    cache_flush(data);
+}
+
+static void create_thread_exit_key(void)
+{
+    pthread_key_create(&key_thread_exit, cache_on_thread_exit);
+}
+
+// Refills empty thread cache from the global pool, or from a new slab if the global pool is empty.
+// Returns true on success, false on fail.
+static bool cache_refill(struct pool_cache* cache)
+{
+    assert(cache->head == NULL);
+
+    //make sure nodes cached by this thread aren't lost once it exits
+    if (!cache->registered)
+    {
+        pthread_once(&key_once, create_thread_exit_key);
+        pthread_setspecific(key_thread_exit, cache);
+        cache->registered = true;
+    }
+
+    union pool_node* nodes = global_pop_batch();
+
+    if (nodes == NULL)
+        nodes = slab_alloc();
+
+    if (nodes == NULL)
+        return false;
+
+    cache->head = nodes;
+    cache->count = nodes->link.batch_count;
+
+    return true;
+}
+
+/* Internal */
+
+// Takes a node from the calling thread's pool.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_pool_alloc(void)
+{
+    struct pool_cache* cache = &thread_cache;
+
+    if (cache->head == NULL && !cache_refill(cache))
+        return NULL;
+
+    union pool_node* node = cache->head;
+    cache->head = node->link.next;
+    cache->count--;
+
+    return &node->val;
+}
+
+// Gives a node allocated using ki_json_pool_alloc() back to the calling thread's pool.
+void ki_json_pool_free(struct ki_json_val* val)
+{
+    struct pool_cache* cache = &thread_cache;
+    union pool_node* node = (union pool_node*)val;
+
+    node->link.next = cache->head;
+    cache->head = node;
+    cache->count++;
+
+    //thread cache grew too large, give a batch back so other threads can use it
+    if (cache->count >= POOL_CACHE_MAX)
+    {
+        union pool_node* batch = cache->head;
+        union pool_node* last = batch;
+
+        for (size_t i = 1; i < POOL_BATCH_SIZE; i++)
+            last = last->link.next;
+
+        cache->head = last->link.next;
+        cache->count -= POOL_BATCH_SIZE;
+        last->link.next = NULL;
+
+        global_push_batch(batch, POOL_BATCH_SIZE);
+    }
+}
+
+/* Public */
+
+// Gives all json value nodes cached by the calling thread back to the global pool.
+void ki_json_pool_flush_thread(void)
+{
+    cache_flush(&thread_cache);
+}
+
+#else //KI_JSON_NO_NODE_POOL
+
+struct ki_json_val* ki_json_pool_alloc(void)
+{
+    return malloc(sizeof(struct ki_json_val));
+}
+
+void ki_json_pool_free(struct ki_json_val* val)
+{
+    free(val);
+}
+
+void ki_json_pool_flush_thread(void)
+{
+}
+
+#endif //KI_JSON_NO_NODE_POOL
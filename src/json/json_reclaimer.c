@@ -0,0 +1,189 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "json_internal.h"
+
+// Background thread freeing json values handed to it, so threads handing them off don't pay for freeing.
+// Values are queued in a plain array; the thread swaps it with an empty one & frees its values outside of the lock.
+
+struct reclaimer_queue
+{
+    struct ki_json_val** vals;
+    size_t count;
+    size_t capacity;
+};
+
+static pthread_mutex_t reclaimer_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Signalled once values were queued or the thread should stop
+static pthread_cond_t reclaimer_work = PTHREAD_COND_INITIALIZER;
+// Signalled once the thread freed everything queued
+static pthread_cond_t reclaimer_idle = PTHREAD_COND_INITIALIZER;
+
+static struct reclaimer_queue reclaimer_queue;
+static pthread_t reclaimer_thread;
+// Whether the thread was started & not joined yet
+static bool reclaimer_running = false;
+// Whether the thread should stop once the queue is empty
+static bool reclaimer_stopping = false;
+// Whether the thread is freeing values taken off the queue
+static bool reclaimer_busy = false;
+
+/* Queue */
+
+// Adds val to end of queue.
+// Returns true on success, false on fail.
+static bool queue_push(struct reclaimer_queue* queue, struct ki_json_val* val)
+{
+    if (queue->count == queue->capacity)
+    {
+        size_t new_capacity = (queue->capacity == 0) ? 64 : queue->capacity * 2;
+        struct ki_json_val** new_vals = realloc(queue->vals, sizeof(*new_vals) * new_capacity);
+
+        if (new_vals == NULL)
+            return false;
+
+        queue->vals = new_vals;
+        queue->capacity = new_capacity;
+    }
+
+    queue->vals[queue->count++] = val;
+
+    return true;
+}
+
+/* Thread */
+
+static void* reclaimer_main(void* arg)
+{
+    (void)arg;
+
+    //emptied queue, swapped back in for the full one
+    struct reclaimer_queue batch = { NULL, 0, 0 };
+
+    pthread_mutex_lock(&reclaimer_mutex);
+
+    for (;;)
+    {
+        while (reclaimer_queue.count == 0 && !reclaimer_stopping)
+            pthread_cond_wait(&reclaimer_work, &reclaimer_mutex);
+
+        //only stop once everything queued was freed
+        if (reclaimer_queue.count == 0)
+            break;
+
+        struct reclaimer_queue full = reclaimer_queue;
+        reclaimer_queue = batch;
+        reclaimer_busy = true;
+
+        pthread_mutex_unlock(&reclaimer_mutex);
+
+        for (size_t i = 0; i < full.count; i++)
+            ki_json_val_free(full.vals[i]);
+
+        //nodes are freed into this thread's pool, let threads allocating reuse them
+        ki_json_pool_flush_thread();
+
+        full.count = 0;
+        batch = full;
+
+        pthread_mutex_lock(&reclaimer_mutex);
+
+        reclaimer_busy = false;
+
+        if (reclaimer_queue.count == 0)
+            pthread_cond_broadcast(&reclaimer_idle);
+    }
+
+    pthread_mutex_unlock(&reclaimer_mutex);
+
+    free(batch.vals);
+
+    return NULL;
+}
+
+// Starts the thread if it isn't running yet, must be called with the lock held.
+// Returns true on success, false on fail.
+static bool reclaimer_start(void)
+{
+    if (reclaimer_running)
+        return true;
+
+    if (pthread_create(&reclaimer_thread, NULL, reclaimer_main, NULL) != 0)
+        return false;
+
+    reclaimer_running = true;
+
+    return true;
+}
+
+/* Public */
+
+// Hands json value to a background thread which frees it & everything inside of it,
+// so the calling thread doesn't pay for freeing large trees. The thread is started on first use.
+// Frees val right away instead if it can't be handed off.
+// NOTE 1: Nothing may use val or anything inside of it afterwards.
+// NOTE 2: Custom allocators of trees handed off must be thread-safe.
+void ki_json_val_free_async(struct ki_json_val* val)
+{
+    if (val == NULL)
+        return;
+
+    pthread_mutex_lock(&reclaimer_mutex);
+
+    bool queued = !reclaimer_stopping && reclaimer_start() && queue_push(&reclaimer_queue, val);
+
+    if (queued)
+        pthread_cond_signal(&reclaimer_work);
+
+    pthread_mutex_unlock(&reclaimer_mutex);
+
+    if (!queued)
+        ki_json_val_free(val);
+}
+
+// Blocks until every json value handed to ki_json_val_free_async() so far was freed.
+void ki_json_reclaimer_flush(void)
+{
+    pthread_mutex_lock(&reclaimer_mutex);
+
+    while (reclaimer_running && (reclaimer_queue.count > 0 || reclaimer_busy))
+        pthread_cond_wait(&reclaimer_idle, &reclaimer_mutex);
+
+    pthread_mutex_unlock(&reclaimer_mutex);
+}
+
+// Frees every json value still handed off & stops the background thread, which starts again on next use.
+void ki_json_reclaimer_shutdown(void)
+{
+    pthread_mutex_lock(&reclaimer_mutex);
+
+    //already stopped, or another thread is stopping it
+    if (!reclaimer_running || reclaimer_stopping)
+    {
+        pthread_mutex_unlock(&reclaimer_mutex);
+        return;
+    }
+
+    reclaimer_stopping = true;
+    pthread_cond_signal(&reclaimer_work);
+
+    pthread_mutex_unlock(&reclaimer_mutex);
+
+    pthread_join(reclaimer_thread, NULL);
+
+    pthread_mutex_lock(&reclaimer_mutex);
+
+    free(reclaimer_queue.vals);
+    reclaimer_queue.vals = NULL;
+    reclaimer_queue.count = 0;
+    reclaimer_queue.capacity = 0;
+
+    reclaimer_running = false;
+    reclaimer_stopping = false;
+
+    pthread_mutex_unlock(&reclaimer_mutex);
+}
@@ -0,0 +1,406 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "json_internal.h"
+
+// Json values shared by several owners (parents, trees, ...), changed copy-on-write.
+// Every value counts its owners besides the first one, so values that were never shared need no count set up.
+// Shared values are never changed in place, getting them for changing copies them & shares their values instead.
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+#include <intrin.h>
+
+static uint16_t refs_load(const uint16_t* refs)
+{
+    return (uint16_t)_InterlockedCompareExchange16((volatile short*)refs, 0, 0);
+}
+
+// Sets refs to desired if it still is expected, otherwise outs what it is now.
+// Returns true on success, false on fail.
+static bool refs_compare_exchange(uint16_t* refs, uint16_t* expected, uint16_t desired)
+{
+    uint16_t old = (uint16_t)_InterlockedCompareExchange16((volatile short*)refs, (short)desired, (short)*expected);
+
+    if (old == *expected)
+        return true;
+
+    *expected = old;
+    return false;
+}
+
+#else
+
+static uint16_t refs_load(const uint16_t* refs)
+{
+    return __atomic_load_n(refs, __ATOMIC_ACQUIRE);
+}
+
+// Sets refs to desired if it still is expected, otherwise outs what it is now.
+// Returns true on success, false on fail.
+static bool refs_compare_exchange(uint16_t* refs, uint16_t* expected, uint16_t desired)
+{
+    return __atomic_compare_exchange_n(refs, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+#endif
+
+// Amount of values the stack for copying holds before allocating
+#define SHARE_STACK_INLINE_SIZE 32
+
+// Values of a copy whose strings & arrays still belong to the original.
+struct share_stack
+{
+    struct ki_json_val** vals;
+    size_t count;
+    size_t capacity;
+    const struct ki_json_allocator* allocator;
+    struct ki_json_val* inline_vals[SHARE_STACK_INLINE_SIZE];
+};
+
+/* Stack */
+
+// Pushes val onto stack.
+// Returns true on success, false on fail.
+static bool share_stack_push(struct share_stack* stack, struct ki_json_val* val)
+{
+    if (stack->count == stack->capacity)
+    {
+        size_t new_capacity = stack->capacity * 2;
+        struct ki_json_val** new_vals = NULL;
+
+        if (stack->vals == stack->inline_vals)
+        {
+            new_vals = ki_json_alloc(stack->allocator, sizeof(*new_vals) * new_capacity);
+
+            if (new_vals != NULL)
+                memcpy(new_vals, stack->vals, sizeof(*new_vals) * stack->count);
+        }
+        else
+        {
+            new_vals = ki_json_realloc(stack->allocator, stack->vals, sizeof(*new_vals) * stack->capacity, sizeof(*new_vals) * new_capacity);
+        }
+
+        if (new_vals == NULL)
+            return false;
+
+        stack->vals = new_vals;
+        stack->capacity = new_capacity;
+    }
+
+    stack->vals[stack->count++] = val;
+
+    return true;
+}
+
+/* Copying */
+
+// Whether copying val needs anything of it copied besides its bytes.
+static bool share_owns_memory(const struct ki_json_val* val)
+{
+    switch (val->type)
+    {
+        case KI_JSON_VAL_OBJECT:
+            return val->value.object.pairs != NULL;
+        case KI_JSON_VAL_ARRAY:
+            return val->value.array.data.values != NULL;
+        case KI_JSON_VAL_STRING:
+            return !(val->flags & KI_JSON_VAL_FLAG_INLINE_STRING);
+        default: //KI_JSON_VAL_BOOL, KI_JSON_VAL_NUMBER, KI_JSON_VAL_NULL
+            return false;
+    }
+}
+
+// Gives up shares of the first count values.
+static void share_release(struct ki_json_val** values, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        ki_json_val_free(values[i]);
+}
+
+// Gives val, a bytewise copy of another value, a copy of its string or pairs & values, sharing values inside of them.
+// Inline values of arrays can't be shared, those are pushed onto stack to be copied the same way.
+// Returns true on success, false on fail (val is left as it was, still referring to memory of the other value).
+static bool share_copy_inside(struct share_stack* stack, struct ki_json_val* val)
+{
+    switch (val->type)
+    {
+        case KI_JSON_VAL_OBJECT:
+        {
+            struct ki_json_object* object = &val->value.object;
+
+            //empty objects may still have room for pairs, which isn't copied
+            if (object->count == 0)
+            {
+                object->pairs = NULL;
+                object->capacity = 0;
+                object->index = NULL;
+                object->index_capacity = 0;
+                return true;
+            }
+
+            struct ki_json_pair* pairs = ki_json_alloc(object->allocator, sizeof(*pairs) * object->count);
+
+            if (pairs == NULL)
+                return false;
+
+            memcpy(pairs, object->pairs, sizeof(*pairs) * object->count);
+
+            for (size_t i = 0; i < object->count; i++)
+            {
+                pairs[i].name = ki_json_strndup(object->allocator, object->pairs[i].name, object->pairs[i].name_length);
+                pairs[i].value = (pairs[i].name != NULL) ? ki_json_val_share(object->pairs[i].value) : NULL;
+
+                if (pairs[i].value == NULL)
+                {
+                    ki_json_strfree(object->allocator, pairs[i].name, pairs[i].name_length);
+
+                    for (size_t j = 0; j < i; j++)
+                    {
+                        ki_json_strfree(object->allocator, pairs[j].name, pairs[j].name_length);
+                        ki_json_val_free(pairs[j].value);
+                    }
+
+                    ki_json_dealloc(object->allocator, pairs, sizeof(*pairs) * object->count);
+                    return false;
+                }
+            }
+
+            //index is rebuilt once needed
+            object->pairs = pairs;
+            object->capacity = object->count;
+            object->index = NULL;
+            object->index_capacity = 0;
+
+            return true;
+        }
+        case KI_JSON_VAL_ARRAY:
+        {
+            struct ki_json_array* array = &val->value.array;
+
+            //empty arrays may still have room for values, which isn't copied
+            if (array->count == 0)
+            {
+                array->data.values = NULL;
+                array->capacity = 0;
+                array->tail_count = 0;
+                return true;
+            }
+
+            size_t slot_size = ki_json_array_slot_size(array->storage);
+            void* data = ki_json_alloc(array->allocator, slot_size * array->count);
+
+            if (data == NULL)
+                return false;
+
+            ki_json_array_copy_slots(array, data);
+
+            if (array->storage == KI_JSON_ARRAY_STORAGE_BOXED)
+            {
+                struct ki_json_val** values = data;
+
+                for (size_t i = 0; i < array->count; i++)
+                {
+                    values[i] = ki_json_val_share(values[i]);
+
+                    if (values[i] == NULL)
+                    {
+                        share_release(values, i);
+                        ki_json_dealloc(array->allocator, data, slot_size * array->count);
+                        return false;
+                    }
+                }
+            }
+            else if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+            {
+                struct ki_json_val* elements = data;
+                size_t pushed = stack->count;
+
+                for (size_t i = 0; i < array->count; i++)
+                {
+                    ki_json_val_relocate(&elements[i]);
+
+                    if (share_owns_memory(&elements[i]) && !share_stack_push(stack, &elements[i]))
+                    {
+                        stack->count = pushed;
+                        ki_json_dealloc(array->allocator, data, slot_size * array->count);
+                        return false;
+                    }
+                }
+            }
+
+            array->data.values = data;
+            array->capacity = array->count;
+            array->tail_count = 0;
+
+            return true;
+        }
+        case KI_JSON_VAL_STRING:
+        {
+            struct ki_json_string* storage = &val->value.string_storage;
+            char* copy = ki_json_strndup(val->allocator, storage->string, storage->length);
+
+            if (copy == NULL)
+                return false;
+
+            storage->string = copy;
+
+            return true;
+        }
+        default: //KI_JSON_VAL_BOOL, KI_JSON_VAL_NUMBER, KI_JSON_VAL_NULL
+            return true;
+    }
+}
+
+// Makes val & everything inside of it use allocators whose memory outlives clones.
+static void share_detach_allocators(struct ki_json_val* val)
+{
+    val->allocator = ki_json_clone_base_allocator(val->allocator);
+
+    if (val->type == KI_JSON_VAL_OBJECT)
+        val->value.object.allocator = ki_json_clone_base_allocator(val->value.object.allocator);
+    else if (val->type == KI_JSON_VAL_ARRAY)
+        val->value.array.allocator = ki_json_clone_base_allocator(val->value.array.allocator);
+}
+
+/* Internal */
+
+// Gives up a reference to json value if it is shared.
+// Returns true if it was shared (so nothing else is to be done), false if the caller was its only owner.
+bool ki_json_val_unref(struct ki_json_val* val)
+{
+    uint16_t refs = refs_load(&val->refs);
+
+    while (refs > 0)
+    {
+        if (refs_compare_exchange(&val->refs, &refs, refs - 1))
+            return true;
+    }
+
+    return false;
+}
+
+// Returns new json value holding a copy of everything inside of val, where values inside of it are shared instead of copied.
+// NOTE: Values of arrays with KI_JSON_ARRAY_STORAGE_INLINE are copied the same way, as they can't be shared.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_copy_shallow(const struct ki_json_val* val)
+{
+    assert(val);
+
+    //copy may outlive the clone val is part of
+    struct ki_json_val* copy = ki_json_val_alloc(ki_json_clone_base_allocator(val->allocator), val->type);
+
+    if (copy == NULL)
+        return NULL;
+
+    *copy = *val;
+    copy->refs = 0;
+
+    struct share_stack stack;
+    stack.vals = stack.inline_vals;
+    stack.count = 0;
+    stack.capacity = SHARE_STACK_INLINE_SIZE;
+    stack.allocator = copy->allocator;
+
+    bool success = true;
+    struct ki_json_val* current = copy;
+
+    while (current != NULL)
+    {
+        share_detach_allocators(current);
+        ki_json_val_relocate(current);
+
+        if (share_owns_memory(current) && !share_copy_inside(&stack, current))
+        {
+            success = false;
+            break;
+        }
+
+        current = (stack.count > 0) ? stack.vals[--stack.count] : NULL;
+    }
+
+    if (!success)
+    {
+        //values not copied yet still refer to memory of val, make them empty before freeing everything copied so far
+        memset(&current->value, 0, sizeof(current->value));
+        current->type = KI_JSON_VAL_NULL;
+
+        while (stack.count > 0)
+        {
+            struct ki_json_val* pending = stack.vals[--stack.count];
+
+            memset(&pending->value, 0, sizeof(pending->value));
+            pending->type = KI_JSON_VAL_NULL;
+        }
+
+        ki_json_val_free(copy);
+        copy = NULL;
+    }
+
+    if (stack.vals != stack.inline_vals)
+        ki_json_dealloc(stack.allocator, stack.vals, sizeof(*stack.vals) * stack.capacity);
+
+    return copy;
+}
+
+/* Public */
+
+// Shares json value with another owner instead of copying it, for ex.: to add it to another tree as well.
+// Returns val itself, or a copy of it if it can't be shared any further (or is part of a clone, see ki_json_val_clone()).
+// NOTE 1: Shared values must not be changed in place, as every owner would see it.
+// Use ki_json_val_unshare(), ki_json_object_get_mut() & ki_json_array_at_mut() to get copies that can be changed,
+// copying only the values on the way to what is changed.
+// NOTE 2: Values of arrays with KI_JSON_ARRAY_STORAGE_INLINE aren't allocated separately & can't be shared.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_share(struct ki_json_val* val)
+{
+    assert(val);
+
+    if (!ki_json_clone_owns(val))
+    {
+        uint16_t refs = refs_load(&val->refs);
+
+        while (refs < UINT16_MAX)
+        {
+            if (refs_compare_exchange(&val->refs, &refs, refs + 1))
+                return val;
+        }
+    }
+
+    return ki_json_val_clone(val);
+}
+
+// Whether json value is owned by more than one owner.
+bool ki_json_val_is_shared(const struct ki_json_val* val)
+{
+    assert(val);
+
+    return refs_load(&val->refs) > 0;
+}
+
+// Returns val itself if it isn't shared, otherwise gives up the caller's reference to it & returns a copy the caller owns alone.
+// Values inside of the copy are shared with val, not copied.
+// Returns NULL on fail (val is left to the caller).
+struct ki_json_val* ki_json_val_unshare(struct ki_json_val* val)
+{
+    assert(val);
+
+    if (!ki_json_val_is_shared(val))
+        return val;
+
+    struct ki_json_val* copy = ki_json_val_copy_shallow(val);
+
+    if (copy == NULL)
+        return NULL;
+
+    //val may have stopped being shared meanwhile, in which case this frees it
+    ki_json_val_free(val);
+
+    return copy;
+}
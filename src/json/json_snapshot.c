@@ -0,0 +1,201 @@
+#include "ki_json/json.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "json_internal.h"
+
+// Versions of json trees published by writers & read by any number of threads without locking.
+// Readers count themselves in the current epoch while loading the current version & sharing it.
+// Publishing swaps the version first & flips the epoch after, so readers counted in the previous epoch are the only ones
+// that may still be about to share the previous version. Once they are done, the snapshot's reference to it is given up.
+// Publishes to the same snapshot are done one at a time, as flipping its epoch twice at once would leave readers unaccounted for,
+// publishes to other snapshots don't wait on them.
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+
+// Sets value to desired if it still is expected.
+// Returns true on success, false on fail.
+static bool snapshot_compare_exchange(size_t* value, size_t expected, size_t desired)
+{
+    //size_t is as big as a pointer on windows
+    return _InterlockedCompareExchangePointer((void* volatile*)value, (void*)desired, (void*)expected) == (void*)expected;
+}
+
+static size_t snapshot_load(size_t* value)
+{
+    return (size_t)_InterlockedCompareExchangePointer((void* volatile*)value, NULL, NULL);
+}
+
+// Adds amount to value (wrapping around, so (size_t)-1 subtracts 1).
+// Returns value before adding.
+static size_t snapshot_fetch_add(size_t* value, size_t amount)
+{
+    size_t old = snapshot_load(value);
+
+    while (!snapshot_compare_exchange(value, old, old + amount))
+        old = snapshot_load(value);
+
+    return old;
+}
+
+// Flips bits of value set in mask.
+// Returns value before flipping.
+static size_t snapshot_fetch_xor(size_t* value, size_t mask)
+{
+    size_t old = snapshot_load(value);
+
+    while (!snapshot_compare_exchange(value, old, old ^ mask))
+        old = snapshot_load(value);
+
+    return old;
+}
+
+static struct ki_json_val* snapshot_load_val(struct ki_json_val** val)
+{
+    return _InterlockedCompareExchangePointer((void* volatile*)val, NULL, NULL);
+}
+
+// Returns val before setting it to desired.
+static struct ki_json_val* snapshot_exchange_val(struct ki_json_val** val, struct ki_json_val* desired)
+{
+    return _InterlockedExchangePointer((void* volatile*)val, desired);
+}
+
+// Lets other threads run while waiting.
+static void snapshot_yield(void)
+{
+    SwitchToThread();
+}
+
+#else
+
+#include <sched.h>
+
+// Sets value to desired if it still is expected.
+// Returns true on success, false on fail.
+static bool snapshot_compare_exchange(size_t* value, size_t expected, size_t desired)
+{
+    return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static size_t snapshot_load(size_t* value)
+{
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+}
+
+// Adds amount to value (wrapping around, so (size_t)-1 subtracts 1).
+// Returns value before adding.
+static size_t snapshot_fetch_add(size_t* value, size_t amount)
+{
+    return __atomic_fetch_add(value, amount, __ATOMIC_SEQ_CST);
+}
+
+// Flips bits of value set in mask.
+// Returns value before flipping.
+static size_t snapshot_fetch_xor(size_t* value, size_t mask)
+{
+    return __atomic_fetch_xor(value, mask, __ATOMIC_SEQ_CST);
+}
+
+static struct ki_json_val* snapshot_load_val(struct ki_json_val** val)
+{
+    return __atomic_load_n(val, __ATOMIC_SEQ_CST);
+}
+
+// Returns val before setting it to desired.
+static struct ki_json_val* snapshot_exchange_val(struct ki_json_val** val, struct ki_json_val* desired)
+{
+    return __atomic_exchange_n(val, desired, __ATOMIC_SEQ_CST);
+}
+
+// Lets other threads run while waiting.
+static void snapshot_yield(void)
+{
+    sched_yield();
+}
+
+#endif
+
+/* Public */
+
+// Inits snapshot, taking over val as its current version (may be NULL).
+void ki_json_snapshot_init(struct ki_json_snapshot* snapshot, struct ki_json_val* val)
+{
+    assert(snapshot);
+
+    snapshot->readers[0] = 0;
+    snapshot->readers[1] = 0;
+    snapshot->epoch = 0;
+    snapshot->publishing = 0;
+
+    snapshot_exchange_val(&snapshot->current, val);
+}
+
+// Frees current version of snapshot.
+// NOTE: No thread may acquire from or publish to snapshot anymore.
+void ki_json_snapshot_fini(struct ki_json_snapshot* snapshot)
+{
+    assert(snapshot);
+
+    ki_json_val_free(snapshot_exchange_val(&snapshot->current, NULL));
+}
+
+// Returns current version of snapshot shared with the caller, who frees it using ki_json_val_free() once done reading.
+// Never locks, the version stays valid however often new ones are published meanwhile.
+// NOTE: Any number of threads may read it at once only if it was frozen (see ki_json_val_freeze()).
+// Returns NULL if there is no current version or on fail.
+struct ki_json_val* ki_json_snapshot_acquire(struct ki_json_snapshot* snapshot)
+{
+    assert(snapshot);
+
+    size_t epoch = snapshot_load(&snapshot->epoch);
+    snapshot_fetch_add(&snapshot->readers[epoch], 1);
+
+    //counted in an epoch flipped meanwhile, the next publish would wait on the wrong readers
+    while (snapshot_load(&snapshot->epoch) != epoch)
+    {
+        snapshot_fetch_add(&snapshot->readers[epoch], (size_t)-1);
+
+        epoch = snapshot_load(&snapshot->epoch);
+        snapshot_fetch_add(&snapshot->readers[epoch], 1);
+    }
+
+    //a version loaded after counting in can't be given up until counting out again
+    struct ki_json_val* current = snapshot_load_val(&snapshot->current);
+    struct ki_json_val* shared = (current != NULL) ? ki_json_val_share(current) : NULL;
+
+    snapshot_fetch_add(&snapshot->readers[epoch], (size_t)-1);
+
+    return shared;
+}
+
+// Makes val the current version of snapshot, taking it over.
+// Previous version is given up once every thread that may have loaded it without sharing it yet is done (grace period),
+// readers which acquired it free it once done.
+// NOTE: Waits for those readers, one publish to the same snapshot at a time.
+void ki_json_snapshot_publish(struct ki_json_snapshot* snapshot, struct ki_json_val* val)
+{
+    assert(snapshot);
+
+    while (!snapshot_compare_exchange(&snapshot->publishing, 0, 1))
+        snapshot_yield();
+
+    struct ki_json_val* previous = snapshot_exchange_val(&snapshot->current, val);
+
+    //readers counting in from now on load val, only those of the previous epoch may still load previous
+    size_t epoch = snapshot_fetch_xor(&snapshot->epoch, 1);
+
+    while (snapshot_load(&snapshot->readers[epoch]) > 0)
+        snapshot_yield();
+
+    //only the publish that set it clears it, so this can't fail
+    snapshot_compare_exchange(&snapshot->publishing, 1, 0);
+
+    ki_json_val_free(previous);
+}
@@ -6,95 +6,225 @@
 #include <string.h>
 #include <assert.h>
 
-/* Creating */
+#include "json_internal.h"
 
-// Creates a json value for a json object with given starting capacity.
+/* Allocating */
+
+// Allocates a zeroed json value of given type using allocator (NULL = default).
+// Values using the stdlib allocator are taken from the node pool.
 // Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_object(size_t capacity)
+struct ki_json_val* ki_json_val_alloc(const struct ki_json_allocator* allocator, enum ki_json_val_type type)
 {
-    struct ki_json_val* val = calloc(1, sizeof(*val));
+    allocator = ki_json_allocator_resolve(allocator);
+
+    struct ki_json_val* val = NULL;
+
+    if (allocator == ki_json_allocator_get_stdlib())
+        val = ki_json_pool_alloc();
+    else
+        val = ki_json_alloc(allocator, sizeof(*val));
 
     if (val == NULL)
         return NULL;
 
-    val->type = KI_JSON_VAL_OBJECT;
-    ki_json_object_init(&val->value.object, capacity);
+    memset(val, 0, sizeof(*val));
+    val->type = type;
+    val->allocator = allocator;
 
     return val;
 }
 
+// Frees memory of json value itself, not of anything inside of it.
+void ki_json_val_dealloc(struct ki_json_val* val)
+{
+    if (val == NULL)
+        return;
+
+    if (val->allocator == ki_json_allocator_get_stdlib())
+        ki_json_pool_free(val);
+    else
+        ki_json_dealloc(val->allocator, val, sizeof(*val));
+}
+
+/* Creating */
+
+// Creates a json value for a json object with given starting capacity.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_object(size_t capacity)
+{
+    return ki_json_val_create_object_with_allocator(capacity, NULL);
+}
+
 // Creates a json value for a json array with given starting capacity.
 // Returns NULL on fail.
 struct ki_json_val* ki_json_val_create_array(size_t capacity)
 {
-    struct ki_json_val* val = calloc(1, sizeof(*val));
+    return ki_json_val_create_array_with_allocator(capacity, NULL);
+}
+
+// Creates a json value from a string.
+// NOTE: String is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_string(const char* string)
+{
+    return ki_json_val_create_from_string_with_allocator(string, NULL);
+}
+
+// Creates a json value from a string of length bytes, string may contain '\0's.
+// NOTE: String is copied.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_stringn(const char* string, size_t length)
+{
+    return ki_json_val_create_from_stringn_with_allocator(string, length, NULL);
+}
+
+// Creates a json value from a string, taking over string instead of copying it.
+// NOTE: String must be allocated using the default allocator, strlen(string) + 1 bytes in size. It is left to the caller on fail.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_string_take(char* string)
+{
+    return ki_json_val_create_from_string_take_with_allocator(string, NULL);
+}
+
+// Creates a json value from a null-terminated string of length bytes, taking over string instead of copying it.
+// NOTE: String must be allocated using the default allocator, length + 1 bytes in size. It is left to the caller on fail.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_stringn_take(char* string, size_t length)
+{
+    return ki_json_val_create_from_stringn_take_with_allocator(string, length, NULL);
+}
+
+// Creates a json value from a double.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_number(double number)
+{
+    return ki_json_val_create_from_number_with_allocator(number, NULL);
+}
+
+// Creates a json value from a bool.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_from_bool(bool boolean)
+{
+    return ki_json_val_create_from_bool_with_allocator(boolean, NULL);
+}
+
+// Creates a json value representing null.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_val_create_null(void)
+{
+    return ki_json_val_create_null_with_allocator(NULL);
+}
+
+/* Creating with allocator */
+
+struct ki_json_val* ki_json_val_create_object_with_allocator(size_t capacity, const struct ki_json_allocator* allocator)
+{
+    struct ki_json_val* val = ki_json_val_alloc(allocator, KI_JSON_VAL_OBJECT);
 
     if (val == NULL)
         return NULL;
 
-    val->type = KI_JSON_VAL_ARRAY;
-    ki_json_array_init(&val->value.array, capacity);
+    if (!ki_json_object_init_with_allocator(&val->value.object, capacity, val->allocator))
+    {
+        ki_json_val_dealloc(val);
+        return NULL;
+    }
 
     return val;
 }
 
-// Creates a json value from a string.
-// NOTE: String is copied.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_from_string(const char* string)
+struct ki_json_val* ki_json_val_create_array_with_allocator(size_t capacity, const struct ki_json_allocator* allocator)
+{
+    struct ki_json_val* val = ki_json_val_alloc(allocator, KI_JSON_VAL_ARRAY);
+
+    if (val == NULL)
+        return NULL;
+
+    if (!ki_json_array_init_with_allocator(&val->value.array, capacity, val->allocator))
+    {
+        ki_json_val_dealloc(val);
+        return NULL;
+    }
+
+    return val;
+}
+
+struct ki_json_val* ki_json_val_create_from_string_with_allocator(const char* string, const struct ki_json_allocator* allocator)
 {
-    struct ki_json_val* val = calloc(1, sizeof(*val));
+    assert(string);
+
+    return ki_json_val_create_from_stringn_with_allocator(string, strlen(string), allocator);
+}
+
+struct ki_json_val* ki_json_val_create_from_stringn_with_allocator(const char* string, size_t length, const struct ki_json_allocator* allocator)
+{
+    struct ki_json_val* val = ki_json_val_alloc(allocator, KI_JSON_VAL_STRING);
 
     if (val == NULL)
         return NULL;
 
-    val->type = KI_JSON_VAL_STRING;
     val->value.string = NULL;
-    ki_json_val_set_string(val, string);
+
+    if (!ki_json_val_set_stringn(val, string, length))
+    {
+        ki_json_val_dealloc(val);
+        return NULL;
+    }
 
     return val;
 }
 
-// Creates a json value from a double.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_from_number(double number)
+struct ki_json_val* ki_json_val_create_from_string_take_with_allocator(char* string, const struct ki_json_allocator* allocator)
+{
+    assert(string);
+
+    return ki_json_val_create_from_stringn_take_with_allocator(string, strlen(string), allocator);
+}
+
+struct ki_json_val* ki_json_val_create_from_stringn_take_with_allocator(char* string, size_t length, const struct ki_json_allocator* allocator)
+{
+    struct ki_json_val* val = ki_json_val_alloc(allocator, KI_JSON_VAL_STRING);
+
+    if (val == NULL)
+        return NULL;
+
+    //never fails, empty string needs no freeing
+    ki_json_val_set_stringn_take(val, string, length);
+
+    return val;
+}
+
+struct ki_json_val* ki_json_val_create_from_number_with_allocator(double number, const struct ki_json_allocator* allocator)
 {
-    struct ki_json_val* val = calloc(1, sizeof(*val));
+    struct ki_json_val* val = ki_json_val_alloc(allocator, KI_JSON_VAL_NUMBER);
 
     if (val == NULL)
         return NULL;
 
-    val->type = KI_JSON_VAL_NUMBER;
     val->value.number = number;
 
     return val;
 }
 
-// Creates a json value from a bool.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_from_bool(bool boolean)
+struct ki_json_val* ki_json_val_create_from_bool_with_allocator(bool boolean, const struct ki_json_allocator* allocator)
 {
-    struct ki_json_val* val = calloc(1, sizeof(*val));
+    struct ki_json_val* val = ki_json_val_alloc(allocator, KI_JSON_VAL_BOOL);
 
     if (val == NULL)
         return NULL;
-    
-    val->type = KI_JSON_VAL_BOOL;
+
     val->value.boolean = boolean;
 
     return val;
 }
 
-// Creates a json value representing null.
-// Returns NULL on fail.
-struct ki_json_val* ki_json_val_create_null(void)
+struct ki_json_val* ki_json_val_create_null_with_allocator(const struct ki_json_allocator* allocator)
 {
-    struct ki_json_val* val = calloc(1, sizeof(*val));
+    struct ki_json_val* val = ki_json_val_alloc(allocator, KI_JSON_VAL_NULL);
 
     if (val == NULL)
         return NULL;
 
-    val->type = KI_JSON_VAL_NULL;
     val->value.null = true;
 
     return val;
@@ -140,60 +270,343 @@ bool ki_json_val_is_null(const struct ki_json_val* val)
 
 /* Special setters */
 
+// Frees string of string val if it isn't stored inline.
+static void ki_json_val_free_string(struct ki_json_val* val)
+{
+    struct ki_json_string* storage = &val->value.string_storage;
+
+    if (!(val->flags & KI_JSON_VAL_FLAG_INLINE_STRING))
+        ki_json_strfree(val->allocator, storage->string, storage->length);
+
+    storage->string = NULL;
+    storage->length = 0;
+    val->flags &= ~KI_JSON_VAL_FLAG_INLINE_STRING;
+}
+
 // NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
-// NOTE 2: String is copied.
+// NOTE 2: String is copied, inside of the json value itself if it is shorter than KI_JSON_INLINE_STRING_SIZE.
 // Returns true on success, false on fail.
 bool ki_json_val_set_string(struct ki_json_val* val, const char* string)
+{
+    assert(val && string);
+
+    return ki_json_val_set_stringn(val, string, strlen(string));
+}
+
+// Sets string of length bytes, string may contain '\0's.
+// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String is copied, inside of the json value itself if it is shorter than KI_JSON_INLINE_STRING_SIZE.
+// Returns true on success, false on fail.
+bool ki_json_val_set_stringn(struct ki_json_val* val, const char* string, size_t length)
 {
     assert(val && string && val->type == KI_JSON_VAL_STRING);
 
+    struct ki_json_string* storage = &val->value.string_storage;
+
+    if (length < KI_JSON_INLINE_STRING_SIZE)
+    {
+        //string may be our own inline string
+        if (!(val->flags & KI_JSON_VAL_FLAG_INLINE_STRING))
+        {
+            char* old = storage->string;
+            size_t old_length = storage->length;
+
+            memcpy(storage->chars, string, length);
+            ki_json_strfree(val->allocator, old, old_length);
+        }
+        else
+        {
+            memmove(storage->chars, string, length);
+        }
+
+        storage->chars[length] = '\0';
+        storage->string = storage->chars;
+        storage->length = length;
+        val->flags |= KI_JSON_VAL_FLAG_INLINE_STRING;
+
+        return true;
+    }
+
     //copy string into our own allocated space so we can free it once we're done
-    //FIXME: this has no limit on how much it can copy
-    
-    size_t length = strlen(string);
-    char* copy = calloc(length + 1, sizeof(*(val->value.string)));
+    char* copy = ki_json_strndup(val->allocator, string, length);
 
     if (copy == NULL)
         return false;
 
-    strncpy(copy, string, length);
-    copy[length] = '\0'; //null-terminator
+    //free old string
+    ki_json_val_free_string(val);
+
+    storage->string = copy;
+    storage->length = length;
+
+    return true;
+}
+
+// Sets string, taking over string instead of copying it.
+// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String must be allocated using the allocator of the json value, strlen(string) + 1 bytes in size.
+// Strings shorter than KI_JSON_INLINE_STRING_SIZE are still copied into the json value, freeing string.
+// Returns true on success, false on fail (string is left to the caller).
+bool ki_json_val_set_string_take(struct ki_json_val* val, char* string)
+{
+    assert(val && string);
+
+    return ki_json_val_set_stringn_take(val, string, strlen(string));
+}
+
+// Sets null-terminated string of length bytes, taking over string instead of copying it.
+// NOTE 1: ki_json_value must be of type KI_JSON_VAL_STRING.
+// NOTE 2: String must be allocated using the allocator of the json value, length + 1 bytes in size.
+// Strings shorter than KI_JSON_INLINE_STRING_SIZE are still copied into the json value, freeing string.
+// Returns true on success, false on fail (string is left to the caller).
+bool ki_json_val_set_stringn_take(struct ki_json_val* val, char* string, size_t length)
+{
+    assert(val && string && val->type == KI_JSON_VAL_STRING);
+
+    //inline strings are smaller & faster to read than the given allocation, setting those never fails
+    if (length < KI_JSON_INLINE_STRING_SIZE)
+    {
+        ki_json_val_set_stringn(val, string, length);
+        ki_json_strfree(val->allocator, string, length);
+
+        return true;
+    }
 
     //free old string
-    if (val->value.string != NULL)
-        free(val->value.string);
+    ki_json_val_free_string(val);
 
-    val->value.string = copy;
+    val->value.string_storage.string = string;
+    val->value.string_storage.length = length;
 
     return true;
 }
 
+// Returns string of json value & outs its length (may be NULL).
+// Returns NULL if json value isn't a string.
+char* ki_json_val_get_stringn(const struct ki_json_val* val, size_t* length)
+{
+    if (val == NULL || val->type != KI_JSON_VAL_STRING)
+        return NULL;
+
+    if (length != NULL)
+        *length = val->value.string_storage.length;
+
+    return val->value.string_storage.string;
+}
+
 /* Freeing */
 
-void ki_json_val_free(struct ki_json_val* val)
+// Amount of frames the stack for freeing holds before allocating, enough for most trees
+#define KI_JSON_FREE_STACK_INLINE_SIZE 32
+
+// A json object or json array whose values are being freed, moved out of the json value holding it.
+struct ki_json_free_frame
 {
-    if (val == NULL)
-        return;
+    enum ki_json_val_type type;
+
+    union
+    {
+        struct ki_json_object object;
+        struct ki_json_array array;
+    } container;
 
+    // Index of next value to free
+    size_t next;
+};
+
+// Stack of containers being freed, one frame per level of the tree, so freeing never recurses.
+struct ki_json_free_stack
+{
+    struct ki_json_free_frame* frames;
+    size_t count;
+    size_t capacity;
+    // Allocator of the json value being freed, used for frames past the inline ones
+    const struct ki_json_allocator* allocator;
+    struct ki_json_free_frame inline_frames[KI_JSON_FREE_STACK_INLINE_SIZE];
+};
+
+// Pushes json object or json array of val onto stack, moving it out of val.
+// Returns true on success, false on fail (val is left as it was).
+static bool ki_json_free_stack_push(struct ki_json_free_stack* stack, struct ki_json_val* val)
+{
+    if (stack->count == stack->capacity)
+    {
+        size_t new_capacity = stack->capacity * 2;
+        struct ki_json_free_frame* new_frames = NULL;
+
+        if (stack->frames == stack->inline_frames)
+        {
+            new_frames = ki_json_alloc(stack->allocator, sizeof(*new_frames) * new_capacity);
+
+            if (new_frames != NULL)
+                memcpy(new_frames, stack->frames, sizeof(*new_frames) * stack->count);
+        }
+        else
+        {
+            new_frames = ki_json_realloc(stack->allocator, stack->frames, sizeof(*new_frames) * stack->capacity, sizeof(*new_frames) * new_capacity);
+        }
+
+        if (new_frames == NULL)
+            return false;
+
+        stack->frames = new_frames;
+        stack->capacity = new_capacity;
+    }
+
+    struct ki_json_free_frame* frame = &stack->frames[stack->count++];
+    frame->type = val->type;
+    frame->next = 0;
+
+    if (val->type == KI_JSON_VAL_OBJECT)
+    {
+        frame->container.object = val->value.object;
+        memset(&val->value.object, 0, sizeof(val->value.object));
+    }
+    else
+    {
+        frame->container.array = val->value.array;
+        memset(&val->value.array, 0, sizeof(val->value.array));
+    }
+
+    return true;
+}
+
+// Frees everything inside of json value, pushing non-empty containers onto stack instead of recursing into them.
+static void ki_json_val_fini_deferred(struct ki_json_free_stack* stack, struct ki_json_val* val)
+{
     switch (val->type)
     {
         case KI_JSON_VAL_OBJECT:
-            ki_json_object_fini(&val->value.object);
+            //fall back to freeing it right away if the stack can't grow
+            if (val->value.object.count == 0 || !ki_json_free_stack_push(stack, val))
+                ki_json_object_fini(&val->value.object);
             break;
         case KI_JSON_VAL_ARRAY:
-            ki_json_array_fini(&val->value.array);
+            if (val->value.array.count == 0 || !ki_json_free_stack_push(stack, val))
+                ki_json_array_fini(&val->value.array);
             break;
         case KI_JSON_VAL_STRING:
-            if (val->value.string != NULL)
-            {
-                free(val->value.string);
-                val->value.string = NULL;
-            }
+            ki_json_val_free_string(val);
             break;
         default: //KI_JSON_VAL_BOOL, KI_JSON_VAL_NUMBER, KI_JSON_VAL_NULL
             break;
     }
+}
+
+// Returns next value of container in frame to free, along with whether its node needs freeing too.
+// Names of pairs are freed on the way.
+// Returns NULL once all values were handed out.
+static struct ki_json_val* ki_json_free_frame_next(struct ki_json_free_frame* frame, bool* boxed)
+{
+    if (frame->type == KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_object* object = &frame->container.object;
+
+        if (frame->next == object->count)
+            return NULL;
+
+        struct ki_json_pair* pair = &object->pairs[frame->next++];
+        ki_json_strfree(object->allocator, pair->name, pair->name_length);
+
+        *boxed = true;
+        return pair->value;
+    }
+
+    struct ki_json_array* array = &frame->container.array;
+
+    //packed numbers need no freeing
+    if (frame->next == array->count || array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return NULL;
+
+    *boxed = (array->storage == KI_JSON_ARRAY_STORAGE_BOXED);
+    return ki_json_array_at(array, frame->next++);
+}
+
+// Frees memory of container in frame itself, once all of its values were freed.
+static void ki_json_free_frame_finish(struct ki_json_free_frame* frame)
+{
+    if (frame->type == KI_JSON_VAL_OBJECT)
+    {
+        frame->container.object.count = 0;
+        ki_json_object_fini(&frame->container.object);
+    }
+    else
+    {
+        frame->container.array.count = 0;
+        frame->container.array.tail_count = 0;
+        ki_json_array_fini(&frame->container.array);
+    }
+}
+
+// Frees everything inside of json value, not the memory of the json value itself.
+// NOTE: Walks the tree using an explicit stack, so deep trees can't overflow the call stack.
+void ki_json_val_fini(struct ki_json_val* val)
+{
+    assert(val);
+
+    struct ki_json_free_stack stack;
+    stack.frames = stack.inline_frames;
+    stack.count = 0;
+    stack.capacity = KI_JSON_FREE_STACK_INLINE_SIZE;
+    stack.allocator = val->allocator;
+
+    ki_json_val_fini_deferred(&stack, val);
+
+    while (stack.count > 0)
+    {
+        //frames move once the stack grows, only hold on to one until pushing
+        struct ki_json_free_frame* frame = &stack.frames[stack.count - 1];
+
+        bool boxed = false;
+        struct ki_json_val* child = ki_json_free_frame_next(frame, &boxed);
+
+        if (child == NULL)
+        {
+            ki_json_free_frame_finish(frame);
+            stack.count--;
+            continue;
+        }
+
+        //shared children only lose this reference
+        if (boxed && ki_json_val_unref(child))
+            continue;
+
+        //clones added to the tree free their memory along with their root, so they are freed on their own
+        if (boxed && ki_json_clone_is_root(child))
+        {
+            ki_json_val_fini(child);
+            ki_json_val_dealloc(child);
+            continue;
+        }
+
+        //inline children live in the container's array, which is only freed once the frame is done
+        ki_json_val_fini_deferred(&stack, child);
+
+        if (boxed)
+            ki_json_val_dealloc(child);
+    }
 
-    free(val);
+    if (stack.frames != stack.inline_frames)
+        ki_json_dealloc(stack.allocator, stack.frames, sizeof(*stack.frames) * stack.capacity);
 }
 
+// Fixes up json value after its bytes were moved to another address (memcpy, realloc, ...).
+// NOTE: Inline strings point into their own json value.
+void ki_json_val_relocate(struct ki_json_val* val)
+{
+    assert(val);
+
+    if (val->type == KI_JSON_VAL_STRING && (val->flags & KI_JSON_VAL_FLAG_INLINE_STRING))
+        val->value.string_storage.string = val->value.string_storage.chars;
+}
+
+// Frees json value and everything inside of it, using the allocator it was created with.
+// NOTE: Shared json values are only freed once every owner freed them.
+void ki_json_val_free(struct ki_json_val* val)
+{
+    if (val == NULL || ki_json_val_unref(val))
+        return;
+
+    ki_json_val_fini(val);
+    ki_json_val_dealloc(val);
+}
@@ -1,6 +1,8 @@
 #include "ki_json/json_generator.h"
 
 #include <assert.h>
+#include <float.h>
+#include <math.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -9,12 +11,16 @@
 #include <string.h>
 
 #include "ki_json/json.h"
+#include "json/json_internal.h"
 
 struct print_buffer
 {
     char* bytes;
     size_t pos;
     size_t size;
+    const struct ki_json_allocator* allocator;
+    // Writer bytes are handed to whenever the buffer fills up instead of growing it, NULL to keep them all
+    const struct ki_json_writer* writer;
 };
 
 struct json_generator
@@ -25,13 +31,14 @@ struct json_generator
 
 /* Buffer */
 
-// Init print buffer with given starting size.
+// Init print buffer with given starting size, allocated using given allocator (NULL = default).
 // Returns true on success, false on fail.
-static bool print_buffer_init(struct print_buffer* buffer, size_t size)
+static bool print_buffer_init(struct print_buffer* buffer, size_t size, const struct ki_json_allocator* allocator)
 {
     assert(buffer && size > 0);
 
-    buffer->bytes = calloc(size, sizeof(*buffer->bytes));
+    buffer->allocator = ki_json_allocator_resolve(allocator);
+    buffer->bytes = ki_json_calloc(buffer->allocator, size, sizeof(*buffer->bytes));
 
     if (buffer->bytes == NULL)
         return false;
@@ -39,6 +46,7 @@ static bool print_buffer_init(struct print_buffer* buffer, size_t size)
     buffer->size = size;
     buffer->pos = 0;
     buffer->bytes[buffer->pos] = '\0';
+    buffer->writer = NULL;
 
     return true;
 }
@@ -49,7 +57,7 @@ static void print_buffer_fini(struct print_buffer* buffer)
 
     if (buffer->bytes != NULL)
     {
-        free(buffer->bytes);
+        ki_json_dealloc(buffer->allocator, buffer->bytes, buffer->size);
         buffer->bytes = NULL;
     }
 
@@ -64,7 +72,23 @@ static size_t print_buffer_length(struct print_buffer* buffer)
     return buffer->pos;
 }
 
+// Hands everything in print buffer to its writer & empties it.
+// Returns true on success, and false on fail.
+static bool print_buffer_flush(struct print_buffer* buffer)
+{
+    assert(buffer && buffer->writer);
+
+    if (buffer->pos > 0 && !buffer->writer->write(buffer->bytes, buffer->pos, buffer->writer->context))
+        return false;
+
+    buffer->pos = 0;
+    buffer->bytes[buffer->pos] = '\0';
+
+    return true;
+}
+
 // Ensures that the print buffer has enough space for SIZE bytes.
+// Print buffers with a writer are flushed first, so SIZE bytes from the current position fit without growing.
 // Returns true on success, and false on fail.
 static bool print_buffer_ensure_size(struct print_buffer* buffer, size_t size)
 {
@@ -75,6 +99,16 @@ static bool print_buffer_ensure_size(struct print_buffer* buffer, size_t size)
     if (buffer->size == 0)
         return false;
 
+    if (buffer->writer != NULL && buffer->size < size && buffer->pos > 0)
+    {
+        size_t needed = size - buffer->pos;
+
+        if (!print_buffer_flush(buffer))
+            return false;
+
+        size = needed;
+    }
+
     //already have enough space, don't need to do anything
     if (buffer->size >= size)
         return true;
@@ -83,7 +117,7 @@ static bool print_buffer_ensure_size(struct print_buffer* buffer, size_t size)
     while (new_size < size)
         new_size *= 2;
 
-    char* new_bytes = realloc(buffer->bytes, sizeof(*new_bytes) * new_size);
+    char* new_bytes = ki_json_realloc(buffer->allocator, buffer->bytes, sizeof(*new_bytes) * buffer->size, sizeof(*new_bytes) * new_size);
 
     //alloc fail
     if (new_bytes == NULL)
@@ -115,27 +149,35 @@ static bool print_buffer_append_char(struct print_buffer* buffer, char character
     return true;
 }
 
-// Adds string to the end of print buffer.
+// Adds length bytes of string to the end of print buffer.
 // Returns true on success, and false on fail.
-static bool print_buffer_append_string(struct print_buffer* buffer, const char* string)
+static bool print_buffer_append_stringn(struct print_buffer* buffer, const char* string, size_t length)
 {
     assert(buffer && string);
 
-    size_t length = strlen(string);
+    //big runs go straight to the writer instead of growing the buffer for them
+    if (buffer->writer != NULL && length >= buffer->size)
+        return print_buffer_flush(buffer) && buffer->writer->write(string, length, buffer->writer->context);
 
     if (!print_buffer_ensure_size(buffer, buffer->pos + length + 1))
         return false;
 
-    for (size_t i = 0; i < length; i++)
-    {
-        buffer->bytes[buffer->pos] = (unsigned char)string[i];
-        buffer->pos++;
-    }
+    memcpy(buffer->bytes + buffer->pos, string, length);
+    buffer->pos += length;
 
     buffer->bytes[buffer->pos] = '\0'; //null-terminate
     return true;
 }
 
+// Adds string to the end of print buffer.
+// Returns true on success, and false on fail.
+static bool print_buffer_append_string(struct print_buffer* buffer, const char* string)
+{
+    assert(buffer && string);
+
+    return print_buffer_append_stringn(buffer, string, strlen(string));
+}
+
 // Truncates if necessary.
 // Returns whether src was completely copied over to dest.
 static bool print_buffer_copy_to_buffer(struct print_buffer* src, char* dest, size_t size)
@@ -160,8 +202,9 @@ static bool print_buffer_copy_to_buffer(struct print_buffer* src, char* dest, si
 /* Printing */
 
 // Prints json-formatted character into print buffer, through an escape sequence.
+// Canonical output (RFC 8785) has lowercase hex digits in \u escapes.
 // Returns true on success, and false on fail.
-static bool print_escape_sequence(struct print_buffer* buffer, unsigned char character)
+static bool print_escape_sequence(struct print_buffer* buffer, unsigned char character, bool canonical)
 {
     if (buffer == NULL)
         return false;
@@ -185,15 +228,21 @@ static bool print_escape_sequence(struct print_buffer* buffer, unsigned char cha
         default:
         {
             char escaped[7]; // \uXXXX\0
-            snprintf(escaped, sizeof(escaped), "\\u%04.4X", character);
+            snprintf(escaped, sizeof(escaped), canonical ? "\\u%04x" : "\\u%04X", (unsigned int)character);
             return print_buffer_append_string(buffer, escaped);
         }
     }
 }
 
-// Prints json-formatted string into print buffer.
+// Returns true if character must be printed through an escape sequence, else false.
+static bool char_needs_escape(char character)
+{
+    return ((unsigned char)character <= 0x1F) || character == '\"' || character == '\\';
+}
+
+// Prints json-formatted string of length bytes into print buffer, string may contain '\0's.
 // Returns true on success, and false on fail.
-static bool print_string(struct print_buffer* buffer, const char* string)
+static bool print_string(struct print_buffer* buffer, const char* string, size_t length, bool canonical)
 {
     if (buffer == NULL || string == NULL)
         return false;
@@ -204,19 +253,27 @@ static bool print_string(struct print_buffer* buffer, const char* string)
 
     size_t pos = 0;
     
-    while (string[pos] != '\0')
+    while (pos < length)
     {
-        if ((string[pos] >= 0x0000 && string[pos] <= 0x001F) || string[pos] == '\"' || string[pos] == '\\')
+        if (char_needs_escape(string[pos]))
         {
-            if (!print_escape_sequence(buffer, (unsigned char)string[pos]))
+            if (!print_escape_sequence(buffer, (unsigned char)string[pos], canonical))
                 return false;
+
+            pos++;
+            continue;
         }
-        else if (!print_buffer_append_char(buffer, string[pos]))
-        {
+
+        //copy everything up to the next character that needs escaping at once
+        size_t end = pos + 1;
+
+        while (end < length && !char_needs_escape(string[end]))
+            end++;
+
+        if (!print_buffer_append_stringn(buffer, string + pos, end - pos))
             return false;
-        }
 
-        pos++;
+        pos = end;
     }
 
     //end double quote
@@ -301,8 +358,12 @@ static bool print_array(struct json_generator* generator, struct ki_json_array*
         if (!print_depth(&generator->buffer, generator->depth))
             return false;
 
-        if (!print_value(generator, array->values[i]))
-            return false; 
+        //packed numbers aren't json values, print them as is instead of unpacking the array
+        bool printed = (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS) ? print_number(&generator->buffer, ki_json_array_number_at(array, i))
+                                                                         : print_value(generator, ki_json_array_at(array, i));
+
+        if (!printed)
+            return false;
 
         if (i != array->count - 1 && !print_buffer_append_char(&generator->buffer, ','))
             return false;
@@ -340,13 +401,13 @@ static bool print_object(struct json_generator* generator, struct ki_json_object
         if (!print_depth(&generator->buffer, generator->depth))
             return false;
         
-        if (!print_string(&generator->buffer, object->names[i]))
+        if (!print_string(&generator->buffer, ki_json_object_name_at(object, i), ki_json_object_name_length_at(object, i), false))
             return false;
 
         if (!print_buffer_append_string(&generator->buffer, ": "))
             return false;
         
-        if (!print_value(generator, object->values[i]))
+        if (!print_value(generator, ki_json_object_val_at(object, i)))
             return false; 
 
         if (i != object->count - 1 && !print_buffer_append_char(&generator->buffer, ','))
@@ -377,7 +438,7 @@ static bool print_value(struct json_generator* generator, struct ki_json_val* va
     switch(val->type)
     {
         case KI_JSON_VAL_STRING:
-            return print_string(&generator->buffer, val->value.string);
+            return print_string(&generator->buffer, val->value.string_storage.string, val->value.string_storage.length, false);
         case KI_JSON_VAL_NUMBER:
             return print_number(&generator->buffer, val->value.number);
         case KI_JSON_VAL_BOOL:
@@ -393,41 +454,306 @@ static bool print_value(struct json_generator* generator, struct ki_json_val* va
     }
 }
 
+/* Canonical printing */
+
+// Prints number into print buffer the way ECMAScript's Number.prototype.toString() does, as RFC 8785 requires:
+// the fewest digits reading back as the same number, in exponent notation only below 1e-6 & from 1e21 on.
+// Returns true on success, and false on fail (NaN & infinities aren't json numbers).
+static bool print_canonical_number(struct print_buffer* buffer, double number)
+{
+    if (buffer == NULL || !isfinite(number))
+        return false;
+
+    //-0 too
+    if (number == 0.0)
+        return print_buffer_append_char(buffer, '0');
+
+    char string[40];
+
+    //integers are printed exactly, without looking for their digits
+    if (number > -9007199254740992.0 && number < 9007199254740992.0 && number == (double)(int64_t)number)
+    {
+        snprintf(string, sizeof(string), "%.0f", number);
+        return print_buffer_append_string(buffer, string);
+    }
+
+    //doubles are only off by half an ulp from what they were read from, so with up to 15 digits those digits
+    //come back (padded with zeros) when rounding to 15 digits, only longer ones need 16 or 17
+    //subnormals have fewer bits, so all precisions are tried for those
+    char scientific[40];
+    bool subnormal = number > -DBL_MIN && number < DBL_MIN;
+
+    for (int precision = subnormal ? 1 : 15; precision <= 17; precision++)
+    {
+        snprintf(scientific, sizeof(scientific), "%.*e", precision - 1, number);
+
+        if (strtod(scientific, NULL) == number)
+            break;
+    }
+
+    //split into digits & exponent, "-d.ddde-xx"
+    char digits[20];
+    int digit_count = 0;
+    const char* pos = scientific + (number < 0.0);
+
+    for (; *pos != 'e'; pos++)
+    {
+        if (*pos != '.')
+            digits[digit_count++] = *pos;
+    }
+
+    while (digit_count > 1 && digits[digit_count - 1] == '0')
+        digit_count--;
+
+    //number is 0.digits times 10^point
+    int point = atoi(pos + 1) + 1;
+    size_t length = 0;
+
+    if (number < 0.0)
+        string[length++] = '-';
+
+    if (digit_count <= point && point <= 21)
+    {
+        memcpy(string + length, digits, digit_count);
+        length += digit_count;
+
+        for (int i = digit_count; i < point; i++)
+            string[length++] = '0';
+    }
+    else if (0 < point && point <= 21)
+    {
+        memcpy(string + length, digits, point);
+        length += point;
+        string[length++] = '.';
+        memcpy(string + length, digits + point, digit_count - point);
+        length += digit_count - point;
+    }
+    else if (-6 < point && point <= 0)
+    {
+        string[length++] = '0';
+        string[length++] = '.';
+
+        for (int i = point; i < 0; i++)
+            string[length++] = '0';
+
+        memcpy(string + length, digits, digit_count);
+        length += digit_count;
+    }
+    else
+    {
+        string[length++] = digits[0];
+
+        if (digit_count > 1)
+        {
+            string[length++] = '.';
+            memcpy(string + length, digits + 1, digit_count - 1);
+            length += digit_count - 1;
+        }
+
+        length += snprintf(string + length, sizeof(string) - length, "e%c%d", (point > 0) ? '+' : '-', abs(point - 1));
+    }
+
+    return print_buffer_append_stringn(buffer, string, length);
+}
+
+// Prints json value into generator's print buffer as canonical json (RFC 8785), without any whitespace.
+// Returns true on success, and false on fail.
+static bool print_canonical_value(struct json_generator* generator, struct ki_json_val* val);
+
+// Prints json array into generator's print buffer as canonical json.
+// Returns true on success, and false on fail.
+static bool print_canonical_array(struct json_generator* generator, struct ki_json_array* array)
+{
+    if (!print_buffer_append_char(&generator->buffer, '['))
+        return false;
+
+    for (size_t i = 0; i < array->count; i++)
+    {
+        if (i != 0 && !print_buffer_append_char(&generator->buffer, ','))
+            return false;
+
+        //packed numbers aren't json values, print them as is instead of unpacking the array
+        bool printed = (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS) ? print_canonical_number(&generator->buffer, ki_json_array_number_at(array, i))
+                                                                         : print_canonical_value(generator, ki_json_array_at(array, i));
+
+        if (!printed)
+            return false;
+    }
+
+    return print_buffer_append_char(&generator->buffer, ']');
+}
+
+// Prints json object into generator's print buffer as canonical json, pairs sorted by name without changing the object.
+// Returns true on success, and false on fail.
+static bool print_canonical_object(struct json_generator* generator, struct ki_json_object* object, bool frozen)
+{
+    size_t scratch[KI_JSON_OBJECT_INDEX_THRESHOLD];
+    const size_t* order = ki_json_object_ordered(object, frozen, scratch);
+
+    if (order == NULL)
+        return false;
+
+    if (!print_buffer_append_char(&generator->buffer, '{'))
+        return false;
+
+    for (size_t i = 0; i < object->count; i++)
+    {
+        const struct ki_json_pair* pair = &object->pairs[order[i]];
+
+        if (i != 0 && !print_buffer_append_char(&generator->buffer, ','))
+            return false;
+
+        if (!print_string(&generator->buffer, pair->name, pair->name_length, true))
+            return false;
+
+        if (!print_buffer_append_char(&generator->buffer, ':'))
+            return false;
+
+        if (!print_canonical_value(generator, pair->value))
+            return false;
+    }
+
+    return print_buffer_append_char(&generator->buffer, '}');
+}
+
+// Prints json value into generator's print buffer as canonical json (RFC 8785), without any whitespace.
+// Returns true on success, and false on fail.
+static bool print_canonical_value(struct json_generator* generator, struct ki_json_val* val)
+{
+    if (generator == NULL || val == NULL)
+        return false;
+
+    switch(val->type)
+    {
+        case KI_JSON_VAL_STRING:
+            return print_string(&generator->buffer, val->value.string_storage.string, val->value.string_storage.length, true);
+        case KI_JSON_VAL_NUMBER:
+            return print_canonical_number(&generator->buffer, val->value.number);
+        case KI_JSON_VAL_BOOL:
+            return print_boolean(&generator->buffer, val->value.boolean);
+        case KI_JSON_VAL_NULL:
+            return print_null(&generator->buffer);
+        case KI_JSON_VAL_ARRAY:
+            return print_canonical_array(generator, &val->value.array);
+        case KI_JSON_VAL_OBJECT:
+            return print_canonical_object(generator, &val->value.object, (val->flags & KI_JSON_VAL_FLAG_FROZEN) != 0);
+        default:
+            return false;
+    }
+}
+
+// Copies string printed by generator to a new string, allocated using the allocator of its print buffer & frees the buffer.
+// Returns NULL on fail.
+static char* generator_take_string(struct json_generator* generator)
+{
+    char* string = ki_json_alloc(generator->buffer.allocator, print_buffer_length(&generator->buffer) + 1);
+
+    if (string == NULL)
+    {
+        print_buffer_fini(&generator->buffer);
+        return NULL;
+    }
+
+    if (!print_buffer_copy_to_buffer(&generator->buffer, string, print_buffer_length(&generator->buffer) + 1))
+    {
+        ki_json_dealloc(generator->buffer.allocator, string, print_buffer_length(&generator->buffer) + 1);
+        print_buffer_fini(&generator->buffer);
+        return NULL;
+    }
+
+    print_buffer_fini(&generator->buffer);
+
+    return string;
+}
+
+/* Public */
+
 // Generate string from json val.
-// Returned string must be freed once done.
+// Returned string must be freed once done, using the default allocator (free() unless changed).
 // Returns NULL on fail.
 char* ki_json_gen_string(struct ki_json_val* val)
+{
+    return ki_json_gen_string_with_allocator(val, NULL);
+}
+
+// Generate string from json val, allocated using given allocator (NULL = default).
+// Returned string of strlen() + 1 bytes must be freed using the same allocator once done.
+// Returns NULL on fail.
+char* ki_json_gen_string_with_allocator(struct ki_json_val* val, const struct ki_json_allocator* allocator)
 {
     if (val == NULL)
         return NULL;
 
     struct json_generator generator = {0};
 
-    if (!print_buffer_init(&generator.buffer, 256))
+    if (!print_buffer_init(&generator.buffer, 256, allocator))
         return NULL;
 
     generator.depth = 0;
 
     if (!print_value(&generator, val))
-        return NULL;
-
-    char* string = calloc(print_buffer_length(&generator.buffer) + 1, sizeof(*string));
-
-    if (string == NULL)
     {
         print_buffer_fini(&generator.buffer);
         return NULL;
     }
 
-    if (!print_buffer_copy_to_buffer(&generator.buffer, string, print_buffer_length(&generator.buffer) + 1))
+    return generator_take_string(&generator);
+}
+
+// Generate canonical json string (RFC 8785, JSON Canonicalization Scheme) from json val, for hashing & signing.
+// Pairs of json objects are sorted by name without changing them, numbers printed as ECMAScript does
+// & only what has to be escaped in strings is, without any whitespace.
+// Returned string must be freed once done, using the default allocator (free() unless changed).
+// NOTE 1: Order of pairs of big json objects is cached along with their hash index until they change,
+// so generating them again doesn't sort them again.
+// NOTE 2: NaN & infinities can't be printed, strings are expected to be valid UTF-8.
+// Returns NULL on fail.
+char* ki_json_gen_canonical(struct ki_json_val* val)
+{
+    return ki_json_gen_canonical_with_allocator(val, NULL);
+}
+
+// Generate canonical json string from json val, allocated using given allocator (NULL = default), see ki_json_gen_canonical().
+// Returned string of strlen() + 1 bytes must be freed using the same allocator once done.
+// Returns NULL on fail.
+char* ki_json_gen_canonical_with_allocator(struct ki_json_val* val, const struct ki_json_allocator* allocator)
+{
+    if (val == NULL)
+        return NULL;
+
+    struct json_generator generator = {0};
+
+    if (!print_buffer_init(&generator.buffer, 256, allocator))
+        return NULL;
+
+    if (!print_canonical_value(&generator, val))
     {
         print_buffer_fini(&generator.buffer);
-        free(string);
         return NULL;
     }
 
+    return generator_take_string(&generator);
+}
+
+// Generates canonical json from json val piece by piece, handing the pieces to writer in order, see ki_json_gen_canonical().
+// Only a small buffer is used (allocated using the allocator of val), so a digest (for ex.: SHA-256) can be fed
+// without ever holding the whole string.
+// Returns true on success, false on fail (including writer failing, which stops generating).
+bool ki_json_gen_canonical_write(struct ki_json_val* val, const struct ki_json_writer* writer)
+{
+    if (val == NULL || writer == NULL || writer->write == NULL)
+        return false;
+
+    struct json_generator generator = {0};
+
+    if (!print_buffer_init(&generator.buffer, KI_JSON_GEN_WRITE_SIZE, val->allocator))
+        return false;
+
+    generator.buffer.writer = writer;
+
+    bool written = print_canonical_value(&generator, val) && print_buffer_flush(&generator.buffer);
+
     print_buffer_fini(&generator.buffer);
 
-    return string;
+    return written;
 }
-
@@ -1,871 +1,1991 @@
-#include "ki_json/json_parser.h"
-
-#include <stddef.h>
-#include <stdint.h>
-#include <stdlib.h>
-#include <stdbool.h>
-#include <string.h>
-#include <assert.h>
-
-#include "ki_json/json.h"
-
-// utf8 characters have 4 bytes max
-#define CHARACTER_MAX_BUFFER_SIZE 4
-
-#define IS_HIGH_SURROGATE(byte) (byte >= 0xD800 && byte <= 0xDBFF)
-#define IS_LOW_SURROGATE(byte) (byte >= 0xDC00 && byte <= 0xDFFF)
-#define COMBINE_SURROGATES(high, low) ((high - 0xD800) * 0x400 + (low - 0xDC00) + 0x10000);
-
-#define CODEPOINT_REPLACEMENT_CHAR 0xFFFD
-
-struct json_reader
-{
-    const char* json_string;
-    // Length of json_string (excluding null terminator)
-    size_t length; 
-    // Current reader index offset
-    size_t offset;
-};
-
-// Returns true if character is a space, horizontal tab, line feed/break or carriage return, else false.
-static bool char_is_whitespace(char character)
-{
-    return (character == ' ') || (character == '\t') || (character == '\n') || (character == '\r');
-}
-
-/* Reader */
-
-// Can reader access char at index pos offsetted by the reader's offset?
-static bool reader_can_access(struct json_reader* reader, size_t pos)
-{
-    assert(reader);
-
-    if (reader == NULL)
-        return false;
-    
-    return (reader->offset + pos < reader->length);
-}
-
-// Reads char in json string at index pos offsetted by the reader's offset, returns \0 on fail.
-static char reader_char_at(struct json_reader* reader, size_t pos)
-{
-    assert(reader);
-
-    if (!reader_can_access(reader, pos))
-        return '\0';
-
-    return reader->json_string[reader->offset + pos];
-}
-
-static bool reader_peek(struct json_reader* reader, char* character)
-{
-    assert(reader && character);
-
-    if (reader == NULL || !reader_can_access(reader, 0))
-    {
-        if (character != NULL)
-            *character = '\0';
-
-        return false;
-    }
-
-    if (character != NULL)
-        *character = reader->json_string[reader->offset];
-
-    return true;
-}
-
-// Returns buffer at index pos offsetted by reader's offset, NULL on fail.
-static const char* reader_buffer_at(struct json_reader* reader, size_t pos)
-{
-    assert(reader);
-
-    if (!reader_can_access(reader, pos))
-        return NULL;
-
-    return reader->json_string + reader->offset + pos;
-}
-
-static void reader_skip_whitespace(struct json_reader* reader)
-{
-    assert(reader);
-
-    while (reader_can_access(reader, 0) && char_is_whitespace(reader_char_at(reader, 0)))
-        reader->offset++;
-}
-
-/* Conversions */
-
-// Converts a hexidecimal digit to int, -1 if not a hexidecimal digit.
-static int hex_digit_to_int(char hex_digit)
-{
-    //calculate using ASCII table
-
-    if (hex_digit >= '0' && hex_digit <= '9')
-        return (int)(hex_digit) - (int)('0');
-    else if (hex_digit >= 'A' && hex_digit <= 'F')
-        return (int)(hex_digit) - (int)('A') + 10;
-    else if (hex_digit >= 'a' && hex_digit <= 'f')
-        return (int)(hex_digit) - (int)('a') + 10;
-    else
-        return -1;
-}
-
-// Reads 4 hex digits in string.
-// Returns read number, 0 on fail.
-static uint32_t read_hex4(const char* string)
-{
-    assert(string);
-
-    uint32_t num = 0;
-
-    //read in 4 hex digits and convert them to dec
-    for (int i = 0; i < 4; i++)
-    {
-        int digit = hex_digit_to_int(string[i]);
-
-        //digit must be valid
-        if (digit == -1)
-            return 0;
-
-        num <<= 4; //shift 4 bits to left, adding 4 zero-bits at the end
-        num += (uint32_t)digit; //fill those zero-bits
-    }
-
-    return num;
-}
-
-// Escapes given char with a backslash (n -> \n, r -> \r, ...).
-// Does not support \u, nor any character escape sequences that aren't used in json.
-// Returns '\0' on fail.
-static char char_to_single_escape_sequence_char(char type)
-{
-    switch(type) //escape char type
-    {
-        case '\"': //double quotation marks
-            return '\"';
-        case '\\': //reverse solidus
-            return '\\'; 
-        case 'b': //backspace
-            return '\b';
-        case 'f': //form feed
-            return '\f';
-        case 'n': //line feed, line break
-            return '\n';
-        case 'r': //carriage return
-            return '\r';
-        case 't': //horizontal tab
-            return '\t';
-        default:
-            return '\0';
-    }
-}
-
-// Convert an unicode code point to utf8 bytes.
-// Converts invalid code points to the replacement char.
-// Returns number of bytes written, 0 on fail.
-static int unicode_codepoint_to_utf8(uint32_t codepoint, unsigned char* utf8, size_t buffer_size)
-{
-    assert(utf8);
-
-    //oh my god text encoding really is something, isn't it
-    //SEE: https://en.wikipedia.org/wiki/UTF-8#Description
-
-    //codepoint is for null character (not supported) or outside 0x10FFFF, replace with replacement char codepoint
-    if (codepoint == 0 || codepoint > 0x10FFFF)
-        codepoint = CODEPOINT_REPLACEMENT_CHAR; //0xEF, 0xBF, 0xBD
-
-    //determine amount of utf8 bytes
-    
-    int bytes = 0;
-
-    if (codepoint <= 0x007F)
-        bytes = 1;
-    else if (codepoint >= 0x0080 && codepoint <= 0x07FF)
-        bytes = 2;
-    else if (codepoint >= 0x0800 && codepoint <= 0xFFFF)
-        bytes = 3;
-    else if (codepoint >= 0x010000 && codepoint <= 0x10FFFF)
-        bytes = 4;
-
-    //buffer size too small for utf8 bytes
-    if ((size_t)bytes > buffer_size)
-        return 0;
-
-    if (bytes == 1)
-    {
-        //use 7 least significant bits of codepoint
-        //keep most significant bit as 0
-        utf8[0] = (codepoint & ((1 << 7) - 1));
-        return bytes;
-    }
-
-    //set all used bytes except first byte to begin with bits 10 = 2
-    for (int i = 1; i < bytes; i++)
-        utf8[i] = 2 << 6;
-
-    //least significant bits are in last byte, so start from there
-    for (int i = bytes - 1; i > 0; i--)
-    {
-        //add 6 least significant bits of codepoint
-        utf8[i] |= (codepoint & ((1 << 6) - 1));
-        //shift codepoint over by read bits
-        codepoint >>= 6;
-    }
-
-    //remaining bits to fill with codepoint bits
-    int remaining_bits = 8 - bytes - 1;
-
-    //first byte uses bits before first 0-bit to keep track of the amount of bytes the utf8 character uses
-    //110 -> 2 bytes
-    //1110 -> 3 bytes
-    //11110 -> 4 bytes
-    utf8[0] = ((2 << bytes) - 2) << remaining_bits;
-
-    //fill remaining bits with remaining least significant bits of codepoint
-    utf8[0] |= (codepoint & ((1 << remaining_bits) - 1));
-
-    return bytes;
-}
-
-// Converts next utf16 literal (\uXXXX or \uXXXX\uXXXX where X is any hex digit) to codepoint, outs sequence length.
-// Returns codepoint, 0 on fail.
-static uint32_t utf16_literal_to_codepoint(const char* literal, const char* end, size_t* sequence_length)
-{
-    //surrogate pair ref: https://en.wikipedia.org/wiki/UTF-16#U+D800_to_U+DFFF_(surrogates)
-
-    if (literal == NULL || end == NULL)
-        return 0;
-
-    if (end - literal < 6)
-        return 0;
-
-    //check for \u
-    if (literal[0] != '\\' || literal[1] != 'u')
-        return 0;
-
-    uint32_t codepoint = read_hex4(literal + 2);
-
-    //low surrogates can't be first
-    if (IS_LOW_SURROGATE(codepoint))
-        return 0;
-
-    if (IS_HIGH_SURROGATE(codepoint))
-    {
-        if (end - literal < 12)
-            return 0;
-
-        //check for \u
-        if (literal[6] != '\\' || literal[7] != 'u')
-            return 0;
-
-        uint32_t low = read_hex4(literal + 8);
-
-        if (!IS_LOW_SURROGATE(low))
-            return 0;
-
-        codepoint = COMBINE_SURROGATES(codepoint, low);
-    
-        if (sequence_length != NULL)
-            *sequence_length = 12;
-    }
-    else if (sequence_length != NULL)
-    {
-        *sequence_length = 6;
-    }
-
-    return codepoint;
-}
-
-// Converts next utf16 literal (\uXXXX or \uXXXX\uXXXX where X is any hex digit) to utf 8 bytes, outs sequence length.
-// Returns number of bytes written, 0 on fail.
-static size_t utf16_literal_to_utf8(const char* literal, const char* end, unsigned char* utf8, size_t size, size_t* sequence_length)
-{
-    if (literal == NULL || utf8 == NULL)
-        return 0;
-
-    uint32_t codepoint = utf16_literal_to_codepoint(literal, end, sequence_length);
-
-    //encode codepoint as utf8 bytes into bytes buffer
-    return unicode_codepoint_to_utf8(codepoint, utf8, size);
-}
-
-// Converts escape sequence in (string) to utf8 bytes and output to (bytes) along with the length of read sequence.
-// Supports unicode code points \uXXXX (X = hex digit), converting to utf8.
-// Returns number of bytes written, 0 on fail.
-static int escape_sequence_to_utf8(const char* string, const char* string_end, unsigned char* bytes, size_t buffer_size, size_t* sequence_length)
-{
-    assert(string && string_end && bytes && buffer_size > 0 && sequence_length);
-
-    //backslash and escape sequence type char required
-    if (string_end - string < 2)
-        return 0;
-
-    //invalid escape sequence
-    if (string[0] != '\\')
-        return 0;
-
-    char escape_char_type = string[1];
-
-    //invalid escape sequence
-    if (escape_char_type == '\0')
-        return 0;
-
-    if (escape_char_type == 'u') //unicode code point, convert to utf8 bytes
-    {
-        return utf16_literal_to_utf8(string, string_end, bytes, buffer_size, sequence_length);
-    }
-    else //single char
-    {
-        //buffer size must be atleast 1 byte
-        if (buffer_size < 1)
-            return 0;
-
-        char escaped = char_to_single_escape_sequence_char(escape_char_type);
-
-        //invalid type
-        if (escaped == '\0')
-            return 0;
-
-        bytes[0] = (unsigned char)escaped;
-
-        *sequence_length = 2;
-
-        return 1;
-    }
-}
-
-/* Parsing */
-
-// Checks whether reader can read in a string value.
-// Returns KI_JSON_ERR_NONE if yes.
-// Length includes quotation marks.
-static enum ki_json_err_type has_next_string_val(struct json_reader* reader, size_t* length)
-{
-    if (reader == NULL)
-        return KI_JSON_ERR_INTERNAL;
-
-    char character = '\0';
-
-    //no start quote
-    if (!reader_peek(reader, &character) || character != '\"')
-        return KI_JSON_ERR_UNKNOWN_TOKEN;
-
-    size_t string_start = reader->offset;
-
-    reader->offset++;
-
-    while (reader_peek(reader, &character) && character != '\"' && character != '\n' && character != '\0')
-    {
-        //skip next char, as it is always part of this one
-        if (character == '\\')
-            reader->offset++;
-
-        reader->offset++;
-    }
-
-    //string must have an ending quote on the same line
-    if (!reader_peek(reader, &character) || character != '\"')
-        return KI_JSON_ERR_UNTERMINATED_STRING;
-
-    //out
-    if (length != NULL)
-        *length = reader->offset - string_start + 1;
-
-    //go back
-    reader->offset = string_start;
-
-    return KI_JSON_ERR_NONE;
-}
-
-// Parse next double-quoted json-formatted string in json string.
-// String must be freed once done.
-static enum ki_json_err_type parse_string(struct json_reader* reader, char** string)
-{
-    assert(reader && string);
-
-    //get input length and check whether we even have a string val
-    size_t input_length = 0;
-
-    enum ki_json_err_type err_type = has_next_string_val(reader, &input_length);
-
-    if (err_type != KI_JSON_ERR_NONE)
-        return err_type;
-
-    //result will always be smaller than or the same size as the string value (excluding start + end quote) in the input json
-    size_t result_max_length = input_length - 2;
-    char* result = calloc(result_max_length + 1, sizeof(*result)); //include space for null-terminator
-    
-    if (result == NULL)
-        return KI_JSON_ERR_MEMORY;
-    
-    const char* end = reader_buffer_at(reader, input_length - 1);
-    
-    reader->offset++; //skip first "
-    
-    const char* pos = reader_buffer_at(reader, 0);
-    size_t result_index = 0;
-    
-    //convert escape sequences in input string
-    //NOTE: only escaped utf8 characters are added in a single iteration, others are done byte per byte
-    while (pos < end && result_index < result_max_length)
-    {
-        size_t sequence_length = 0;
-
-        //start of an escape sequence
-        if (pos[0] == '\\')
-        {
-            unsigned char bytes[CHARACTER_MAX_BUFFER_SIZE]; //character bytes, max. 4 bytes (utf8)
-            size_t num_bytes = escape_sequence_to_utf8(pos, end, bytes, CHARACTER_MAX_BUFFER_SIZE, &sequence_length);
-
-            //invalid escape sequence or failed to parse it
-            if (num_bytes == 0)
-            {
-                free(result);
-                return KI_JSON_ERR_INVALID_ESCAPE_SEQUENCE;
-            }
-
-            //should never occur, but in just case
-            if (result_index + num_bytes >= result_max_length)
-            {
-                free(result);
-                return KI_JSON_ERR_INTERNAL;
-            }
-
-            //add bytes into result
-            for (size_t i = 0; i < num_bytes; i++)
-            {
-                result[result_index] = bytes[i];
-                result_index++;
-            }
-        }
-        else 
-        {
-            sequence_length = 1;
-
-            result[result_index] = pos[0];
-            result_index++;
-        }
-
-        pos += sequence_length;
-        reader->offset += sequence_length; //also move offset for error handling
-    }
-
-    result[result_index] = '\0'; //null-terminate
-
-    reader->offset++; //skip last "
-
-    //out
-    *string = result;
-
-    return KI_JSON_ERR_NONE;
-}
-
-// Parse next given number in the json string.
-static enum ki_json_err_type parse_number(struct json_reader* reader, double* number)
-{
-    assert(reader && number);
-
-    const char* buffer = reader_buffer_at(reader, 0);
-
-    if (buffer == NULL)
-        return KI_JSON_ERR_TOO_SHORT;
-
-    char* endptr;
-    *number = strtod(buffer, &endptr);
-
-    //move reader to endptr (char byte after last number character)
-    if (endptr != NULL)
-        reader->offset += (endptr - buffer);
-
-    if (endptr == buffer)
-        return KI_JSON_ERR_UNKNOWN_TOKEN;
-    else if (reader->offset > reader->length)
-        return KI_JSON_ERR_TOO_SHORT;
-    else
-        return KI_JSON_ERR_NONE;
-}
-
-// Checks whether the next characters are the given literal.
-// Returns true on success, returns false on fail.
-static bool has_next_literal(struct json_reader* reader, const char* literal)
-{
-    if (reader == NULL || literal == NULL)
-        return false;
-
-    //read characters, returning false if the characters aren't the same as in given literal until the end of the literal
-    size_t i = 0;
-    while (literal[i] != '\0')
-    {
-        if (reader_char_at(reader, i) != literal[i])
-            return false; //literal not found!
-
-        i++;
-    }
-
-    //found literal :)
-    return true;
-}
-
-// Parse next bool literal in the json string.
-static enum ki_json_err_type parse_boolean(struct json_reader* reader, bool* boolean)
-{
-    assert(reader && boolean);
-
-    if (has_next_literal(reader, "true"))
-    {
-        *boolean = true; //out boolean
-        reader->offset += 4;
-        return KI_JSON_ERR_NONE;
-    }
-    
-    if (has_next_literal(reader, "false"))
-    {
-        *boolean = false; //out boolean
-        reader->offset += 5;
-        return KI_JSON_ERR_NONE;
-    }
-
-    //false and true not found, not a boolean
-    return KI_JSON_ERR_UNKNOWN_TOKEN;
-}
-
-// Parses next null literal in the json string.
-static enum ki_json_err_type parse_null(struct json_reader* reader)
-{
-    assert(reader);
-
-    if (has_next_literal(reader, "null"))
-    {
-        reader->offset += 4;
-        return KI_JSON_ERR_NONE;
-    }
-    else 
-    {
-        return KI_JSON_ERR_UNKNOWN_TOKEN;
-    }
-}
-
-//forward declare parsing of values
-
-// Parses next json value in the json string.
-// Val must be freed using ki_json_val_free() when done.
-static enum ki_json_err_type parse_value(struct json_reader* reader, struct ki_json_val** val);
-
-// Parse next json array in the json string, using given INIT array.
-static enum ki_json_err_type parse_array(struct json_reader* reader, struct ki_json_array* array)
-{
-    assert(reader && array);
-
-    char character = '\0';
-
-    //invalid json array
-    if (!reader_peek(reader, &character) || character != '[')
-        return KI_JSON_ERR_UNKNOWN_TOKEN;
-
-    //parse values
-
-    reader->offset++; //skip first [
-
-    reader_skip_whitespace(reader);
-
-    bool value_expected = false;
-    size_t pos_comma = 0;
-
-    while (reader_peek(reader, &character) && character != ']')
-    {
-        #if KI_JSON_PARSER_VERBOSE
-        printf("Parsing array value index: %zu\n", array->count);
-        #endif
-
-        struct ki_json_val* val = NULL;
-        enum ki_json_err_type err_type = parse_value(reader, &val);
-
-        if (err_type != KI_JSON_ERR_NONE)
-            return err_type;
-
-        err_type = ki_json_array_add(array, val);
-
-        if (err_type != KI_JSON_ERR_NONE)
-            return err_type;
-
-        reader_skip_whitespace(reader);
-
-        //comma separates next value
-        if (reader_char_at(reader, 0) == ',')
-        {
-            pos_comma = reader->offset;
-            reader->offset++; //skip comma
-            reader_skip_whitespace(reader);
-            value_expected = true;
-        }
-        else
-        {
-            value_expected = false;
-        }
-    }
-
-    if (value_expected)
-    {
-        reader->offset = pos_comma; //go back to comma
-        return KI_JSON_ERR_TRAILING_COMMA;
-    }
-
-    //array never ended
-    if (!reader_peek(reader, &character) || character != ']')
-        return KI_JSON_ERR_UNTERMINATED_ARRAY;
-
-    reader->offset++; //skip last ]
-
-    return KI_JSON_ERR_NONE;
-}
-
-// Parse next json object in the json string, using given INIT object.
-static enum ki_json_err_type parse_object(struct json_reader* reader, struct ki_json_object* object)
-{
-    assert(reader && object);
-
-    //invalid json object
-    if (!reader_can_access(reader, 0) || reader_char_at(reader, 0) != '{')
-        return KI_JSON_ERR_UNKNOWN_TOKEN;
-
-    //parse values
-    reader->offset++; //skip first {
-
-    reader_skip_whitespace(reader);
-
-    bool pair_expected = false;
-    size_t pos_comma = 0;
-
-    while (reader_can_access(reader, 0) && reader_char_at(reader, 0) != '}')
-    {
-        enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
-
-        char* name = NULL;
-
-        err_type = parse_string(reader, &name);
-
-        if (err_type == KI_JSON_ERR_UNKNOWN_TOKEN)
-            return KI_JSON_ERR_EXPECTED_NAME;
-        else if (err_type != KI_JSON_ERR_NONE)
-            return err_type;
-
-        reader_skip_whitespace(reader);
-
-        //colon separates name and value
-        if (!reader_can_access(reader, 0) || reader_char_at(reader, 0) != ':')
-        {
-            free(name);
-            return KI_JSON_ERR_EXPECTED_NAME_VALUE_SEPARATOR;
-        }
-
-        #if KI_JSON_PARSER_VERBOSE
-        printf("Parsing object pair: %s\n", name);
-        #endif
-
-        reader->offset++; //skip :
-
-        reader_skip_whitespace(reader);
-
-        //parse value
-
-        struct ki_json_val* val = NULL;
-
-        err_type = parse_value(reader, &val);
-
-        if (err_type != KI_JSON_ERR_NONE)
-        {
-            free(name);
-            return err_type;
-        }
-
-        err_type = ki_json_object_add(object, name, val);
-        free(name); //name is copied, so we no longer need the original
-
-        if (err_type != KI_JSON_ERR_NONE)
-        {
-            ki_json_val_free(val);
-            return err_type;
-        }
-
-        reader_skip_whitespace(reader);
-
-        //comma separates next pair
-        if (reader_char_at(reader, 0) == ',')
-        {
-            pos_comma = reader->offset;
-            reader->offset++; //skip comma
-            reader_skip_whitespace(reader);
-            pair_expected = true;
-        }
-        else
-        {
-            pair_expected = false;
-        }
-    }
-
-    if (pair_expected)
-    {
-        reader->offset = pos_comma; //go back to comma
-        return KI_JSON_ERR_TRAILING_COMMA;
-    }
-
-    //object never ended
-    if (!reader_can_access(reader, 0) || reader_char_at(reader, 0) != '}')
-        return KI_JSON_ERR_UNTERMINATED_OBJECT;
-
-    reader->offset++; //skip last }
-
-    return KI_JSON_ERR_NONE;
-}
-
-// Parses next json value in the json string.
-// Val must be freed using ki_json_val_free() when done.
-static enum ki_json_err_type parse_value(struct json_reader* reader, struct ki_json_val** val)
-{
-    assert(reader && val);
-
-    char character = '\0';
-
-    if (!reader_peek(reader, &character))
-        return KI_JSON_ERR_TOO_SHORT;
-
-    //pick according to first character which type to try and parse, and parse it (duh)
-
-    struct ki_json_val* new_val = calloc(1, sizeof(*new_val));
-
-    //alloc fail
-    if (new_val == NULL)
-        return KI_JSON_ERR_MEMORY;
-
-    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
-
-    switch (character)
-    {
-        //string
-        case '\"':
-            new_val->type = KI_JSON_VAL_STRING;
-            new_val->value.string = NULL;
-            err_type = parse_string(reader, &new_val->value.string);
-            break;
-        //boolean
-        case 't':
-        case 'f':
-            new_val->type = KI_JSON_VAL_BOOL;
-            err_type = parse_boolean(reader, &new_val->value.boolean);
-            break;   
-        //json object (ki_json_object)
-        case '{':
-            new_val->type = KI_JSON_VAL_OBJECT;
-
-            //alloc default capacity
-            ki_json_object_init(&new_val->value.object, 5);
-
-            err_type = parse_object(reader, &new_val->value.object);
-            break;
-        //json array (ki_json_array)
-        case '[':
-            new_val->type = KI_JSON_VAL_ARRAY;
-
-            //alloc default capacity
-            ki_json_array_init(&new_val->value.array, 5);
-
-            err_type = parse_array(reader, &new_val->value.array);
-            break;
-        //null
-        case 'n':
-            new_val->type = KI_JSON_VAL_NULL;
-            err_type = parse_null(reader);
-            new_val->value.null = true;
-            break;
-        //number
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-        case '-':
-        case '.':
-            new_val->type = KI_JSON_VAL_NUMBER;
-            err_type = parse_number(reader, &new_val->value.number);
-            break;
-        default:
-            free(new_val);
-            new_val = NULL;
-            err_type = KI_JSON_ERR_UNKNOWN_TOKEN;
-            break;
-    }
-
-    if (err_type == KI_JSON_ERR_NONE)
-        *val = new_val; //out
-    else if (new_val != NULL)
-        ki_json_val_free(new_val);
-
-    return err_type;
-}
-
-// Parse null-terminated string to a json tree.
-// Val returned must be freed using ki_json_val_free() when done.
-// Returns NULL on fail and outs error to err.
-struct ki_json_val* ki_json_parse_string(const char* string, struct ki_json_parser_err* err)
-{
-    return ki_json_nparse_string(string, strlen(string), err);
-}
-
-// Parse no more than n characters of string to a json tree.
-// Val returned must be freed using ki_json_val_free() when done.
-// Returns NULL on fail and outs error to err.
-struct ki_json_val* ki_json_nparse_string(const char* string, size_t n, struct ki_json_parser_err* err)
-{
-    if (err != NULL)
-    {
-        err->json = string;
-        err->pos = 0;
-        err->type = KI_JSON_ERR_INTERNAL;
-    }
-
-    if (string == NULL)
-    {
-        if (err != NULL)
-            err->type = KI_JSON_ERR_INVALID_ARGS;
-        
-        return NULL;
-    }
-
-    struct json_reader reader = {
-        .json_string = string,
-        .length = n,
-        .offset = 0
-    };
-
-    //skip byte order mark if necessary
-    if (has_next_literal(&reader, "\uFEFF"))
-        reader.offset += 3;
-
-    struct ki_json_val* val = NULL;
-    enum ki_json_err_type err_type = parse_value(&reader, &val);
-
-    if (err != NULL)
-    {
-        err->pos = reader.offset;
-        err->type = err_type;
-    }
-
-    if (err_type != KI_JSON_ERR_NONE)
-    {
-        if (val != NULL)
-            ki_json_val_free(val);
-
-        return NULL;
-    }
-    else 
-    {
-        return val;
-    }
-}
-
+#include "ki_json/json_parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "ki_json/json.h"
+#include "json/json_internal.h"
+
+// utf8 characters have 4 bytes max
+#define CHARACTER_MAX_BUFFER_SIZE 4
+
+#define IS_HIGH_SURROGATE(byte) (byte >= 0xD800 && byte <= 0xDBFF)
+#define IS_LOW_SURROGATE(byte) (byte >= 0xDC00 && byte <= 0xDFFF)
+#define COMBINE_SURROGATES(high, low) ((high - 0xD800) * 0x400 + (low - 0xDC00) + 0x10000);
+
+#define CODEPOINT_REPLACEMENT_CHAR 0xFFFD
+
+struct json_reader
+{
+    const char* json_string;
+    // Length of json_string (excluding null terminator)
+    size_t length; 
+    // Current reader index offset
+    size_t offset;
+    // Allocator used for parsed values, NULL for the default allocator
+    const struct ki_json_allocator* allocator;
+    // Parser this reader belongs to, for its options & buffers, may be NULL
+    struct ki_json_parser* parser;
+    // Whether json_string is followed by KI_JSON_PADDING readable bytes, the first being '\0'.
+    // Hot loops then only check bounds once they stop, as they always stop at the '\0'.
+    bool padded;
+};
+
+// Broadcasts byte to all 8 bytes of a word.
+#define WORD_BROADCAST(byte) ((uint64_t)(byte) * 0x0101010101010101ULL)
+// Whether any byte in word is zero.
+#define WORD_HAS_ZERO_BYTE(word) ((((word) - 0x0101010101010101ULL) & ~(word) & 0x8080808080808080ULL) != 0)
+// Whether any byte in word equals byte.
+#define WORD_HAS_BYTE(word, byte) WORD_HAS_ZERO_BYTE((word) ^ WORD_BROADCAST(byte))
+
+// Loads 8 bytes at pos into a word.
+static uint64_t load_word(const char* pos)
+{
+    uint64_t word;
+    memcpy(&word, pos, sizeof(word));
+    return word;
+}
+
+// Returns true if character is a space, horizontal tab, line feed/break or carriage return, else false.
+static bool char_is_whitespace(char character)
+{
+    return (character == ' ') || (character == '\t') || (character == '\n') || (character == '\r');
+}
+
+/* Reader */
+
+// Can reader access char at index pos offsetted by the reader's offset?
+static bool reader_can_access(struct json_reader* reader, size_t pos)
+{
+    assert(reader);
+
+    if (reader == NULL)
+        return false;
+    
+    return (reader->offset + pos < reader->length);
+}
+
+// Reads char in json string at index pos offsetted by the reader's offset, returns \0 on fail.
+static char reader_char_at(struct json_reader* reader, size_t pos)
+{
+    assert(reader);
+
+    if (!reader_can_access(reader, pos))
+        return '\0';
+
+    return reader->json_string[reader->offset + pos];
+}
+
+static bool reader_peek(struct json_reader* reader, char* character)
+{
+    assert(reader && character);
+
+    if (reader == NULL || !reader_can_access(reader, 0))
+    {
+        if (character != NULL)
+            *character = '\0';
+
+        return false;
+    }
+
+    if (character != NULL)
+        *character = reader->json_string[reader->offset];
+
+    return true;
+}
+
+// Returns buffer at index pos offsetted by reader's offset, NULL on fail.
+static const char* reader_buffer_at(struct json_reader* reader, size_t pos)
+{
+    assert(reader);
+
+    if (!reader_can_access(reader, pos))
+        return NULL;
+
+    return reader->json_string + reader->offset + pos;
+}
+
+static void reader_skip_whitespace(struct json_reader* reader)
+{
+    assert(reader);
+
+    if (reader->padded)
+    {
+        //'\0' after json string is no whitespace, so this always stops in bounds
+        const char* pos = reader->json_string + reader->offset;
+
+        while (char_is_whitespace(*pos))
+        {
+            //skip indentation 8 spaces at a time, reading ahead into the padding is fine
+            while (load_word(pos) == WORD_BROADCAST(' '))
+                pos += 8;
+
+            while (char_is_whitespace(*pos))
+                pos++;
+        }
+
+        reader->offset = pos - reader->json_string;
+        return;
+    }
+
+    while (reader_can_access(reader, 0) && char_is_whitespace(reader_char_at(reader, 0)))
+        reader->offset++;
+}
+
+/* Conversions */
+
+// Converts a hexidecimal digit to int, -1 if not a hexidecimal digit.
+static int hex_digit_to_int(char hex_digit)
+{
+    //calculate using ASCII table
+
+    if (hex_digit >= '0' && hex_digit <= '9')
+        return (int)(hex_digit) - (int)('0');
+    else if (hex_digit >= 'A' && hex_digit <= 'F')
+        return (int)(hex_digit) - (int)('A') + 10;
+    else if (hex_digit >= 'a' && hex_digit <= 'f')
+        return (int)(hex_digit) - (int)('a') + 10;
+    else
+        return -1;
+}
+
+// Reads 4 hex digits in string, outs read number.
+// Returns true on success, false on fail.
+static bool read_hex4(const char* string, uint32_t* number)
+{
+    assert(string && number);
+
+    uint32_t num = 0;
+
+    //read in 4 hex digits and convert them to dec
+    for (int i = 0; i < 4; i++)
+    {
+        int digit = hex_digit_to_int(string[i]);
+
+        //digit must be valid
+        if (digit == -1)
+            return false;
+
+        num <<= 4; //shift 4 bits to left, adding 4 zero-bits at the end
+        num += (uint32_t)digit; //fill those zero-bits
+    }
+
+    *number = num;
+
+    return true;
+}
+
+// Escapes given char with a backslash (n -> \n, r -> \r, ...).
+// Does not support \u, nor any character escape sequences that aren't used in json.
+// Returns '\0' on fail.
+static char char_to_single_escape_sequence_char(char type)
+{
+    switch(type) //escape char type
+    {
+        case '\"': //double quotation marks
+            return '\"';
+        case '\\': //reverse solidus
+            return '\\'; 
+        case 'b': //backspace
+            return '\b';
+        case 'f': //form feed
+            return '\f';
+        case 'n': //line feed, line break
+            return '\n';
+        case 'r': //carriage return
+            return '\r';
+        case 't': //horizontal tab
+            return '\t';
+        default:
+            return '\0';
+    }
+}
+
+// Convert an unicode code point to utf8 bytes.
+// Converts invalid code points to the replacement char.
+// Returns number of bytes written, 0 on fail.
+static int unicode_codepoint_to_utf8(uint32_t codepoint, unsigned char* utf8, size_t buffer_size)
+{
+    assert(utf8);
+
+    //oh my god text encoding really is something, isn't it
+    //SEE: https://en.wikipedia.org/wiki/UTF-8#Description
+
+    //codepoint is outside 0x10FFFF, replace with replacement char codepoint
+    if (codepoint > 0x10FFFF)
+        codepoint = CODEPOINT_REPLACEMENT_CHAR; //0xEF, 0xBF, 0xBD
+
+    //determine amount of utf8 bytes
+    
+    int bytes = 0;
+
+    if (codepoint <= 0x007F)
+        bytes = 1;
+    else if (codepoint >= 0x0080 && codepoint <= 0x07FF)
+        bytes = 2;
+    else if (codepoint >= 0x0800 && codepoint <= 0xFFFF)
+        bytes = 3;
+    else if (codepoint >= 0x010000 && codepoint <= 0x10FFFF)
+        bytes = 4;
+
+    //buffer size too small for utf8 bytes
+    if ((size_t)bytes > buffer_size)
+        return 0;
+
+    if (bytes == 1)
+    {
+        //use 7 least significant bits of codepoint
+        //keep most significant bit as 0
+        utf8[0] = (codepoint & ((1 << 7) - 1));
+        return bytes;
+    }
+
+    //set all used bytes except first byte to begin with bits 10 = 2
+    for (int i = 1; i < bytes; i++)
+        utf8[i] = 2 << 6;
+
+    //least significant bits are in last byte, so start from there
+    for (int i = bytes - 1; i > 0; i--)
+    {
+        //add 6 least significant bits of codepoint
+        utf8[i] |= (codepoint & ((1 << 6) - 1));
+        //shift codepoint over by read bits
+        codepoint >>= 6;
+    }
+
+    //remaining bits to fill with codepoint bits
+    int remaining_bits = 8 - bytes - 1;
+
+    //first byte uses bits before first 0-bit to keep track of the amount of bytes the utf8 character uses
+    //110 -> 2 bytes
+    //1110 -> 3 bytes
+    //11110 -> 4 bytes
+    utf8[0] = ((2 << bytes) - 2) << remaining_bits;
+
+    //fill remaining bits with remaining least significant bits of codepoint
+    utf8[0] |= (codepoint & ((1 << remaining_bits) - 1));
+
+    return bytes;
+}
+
+// Converts next utf16 literal (\uXXXX or \uXXXX\uXXXX where X is any hex digit) to codepoint, outs codepoint & sequence length.
+// NOTE: \u0000 is a valid literal for codepoint 0.
+// Returns true on success, false on fail.
+static bool utf16_literal_to_codepoint(const char* literal, const char* end, uint32_t* out_codepoint, size_t* sequence_length)
+{
+    //surrogate pair ref: https://en.wikipedia.org/wiki/UTF-16#U+D800_to_U+DFFF_(surrogates)
+
+    if (literal == NULL || end == NULL || out_codepoint == NULL)
+        return false;
+
+    if (end - literal < 6)
+        return false;
+
+    //check for \u
+    if (literal[0] != '\\' || literal[1] != 'u')
+        return false;
+
+    uint32_t codepoint = 0;
+
+    if (!read_hex4(literal + 2, &codepoint))
+        return false;
+
+    //low surrogates can't be first
+    if (IS_LOW_SURROGATE(codepoint))
+        return false;
+
+    if (IS_HIGH_SURROGATE(codepoint))
+    {
+        if (end - literal < 12)
+            return false;
+
+        //check for \u
+        if (literal[6] != '\\' || literal[7] != 'u')
+            return false;
+
+        uint32_t low = 0;
+
+        if (!read_hex4(literal + 8, &low) || !IS_LOW_SURROGATE(low))
+            return false;
+
+        codepoint = COMBINE_SURROGATES(codepoint, low);
+    
+        if (sequence_length != NULL)
+            *sequence_length = 12;
+    }
+    else if (sequence_length != NULL)
+    {
+        *sequence_length = 6;
+    }
+
+    *out_codepoint = codepoint;
+
+    return true;
+}
+
+// Converts next utf16 literal (\uXXXX or \uXXXX\uXXXX where X is any hex digit) to utf 8 bytes, outs sequence length.
+// Returns number of bytes written, 0 on fail.
+static size_t utf16_literal_to_utf8(const char* literal, const char* end, unsigned char* utf8, size_t size, size_t* sequence_length)
+{
+    if (literal == NULL || utf8 == NULL)
+        return 0;
+
+    uint32_t codepoint = 0;
+
+    if (!utf16_literal_to_codepoint(literal, end, &codepoint, sequence_length))
+        return 0;
+
+    //encode codepoint as utf8 bytes into bytes buffer
+    return unicode_codepoint_to_utf8(codepoint, utf8, size);
+}
+
+// Converts escape sequence in (string) to utf8 bytes and output to (bytes) along with the length of read sequence.
+// Supports unicode code points \uXXXX (X = hex digit), converting to utf8.
+// Returns number of bytes written, 0 on fail.
+static int escape_sequence_to_utf8(const char* string, const char* string_end, unsigned char* bytes, size_t buffer_size, size_t* sequence_length)
+{
+    assert(string && string_end && bytes && buffer_size > 0 && sequence_length);
+
+    //backslash and escape sequence type char required
+    if (string_end - string < 2)
+        return 0;
+
+    //invalid escape sequence
+    if (string[0] != '\\')
+        return 0;
+
+    char escape_char_type = string[1];
+
+    //invalid escape sequence
+    if (escape_char_type == '\0')
+        return 0;
+
+    if (escape_char_type == 'u') //unicode code point, convert to utf8 bytes
+    {
+        return utf16_literal_to_utf8(string, string_end, bytes, buffer_size, sequence_length);
+    }
+    else //single char
+    {
+        //buffer size must be atleast 1 byte
+        if (buffer_size < 1)
+            return 0;
+
+        char escaped = char_to_single_escape_sequence_char(escape_char_type);
+
+        //invalid type
+        if (escaped == '\0')
+            return 0;
+
+        bytes[0] = (unsigned char)escaped;
+
+        *sequence_length = 2;
+
+        return 1;
+    }
+}
+
+/* Parser */
+
+// Container being parsed.
+struct parser_frame
+{
+    // Json object or array value
+    struct ki_json_val* val;
+    // Offset in names buffer of the name of the value currently being parsed, only used by objects
+    size_t name_offset;
+    // Length of that name, it may contain '\0's
+    size_t name_length;
+};
+
+struct ki_json_parser
+{
+    struct ki_json_parser_options options;
+    // Allocator used for the parser's own buffers
+    const struct ki_json_allocator* allocator;
+
+    // Stack of containers being parsed, innermost last
+    struct parser_frame* frames;
+    size_t frame_count;
+    size_t frame_capacity;
+
+    // Stack of null-terminated names of pairs being parsed, also used as scratch space
+    char* names;
+    size_t names_used;
+    size_t names_size;
+};
+
+// Returns default parser options, also used by the ki_json_parse functions.
+struct ki_json_parser_options ki_json_parser_options_default(void)
+{
+    struct ki_json_parser_options options = {
+        .max_depth = 0,
+        .duplicate_names = KI_JSON_DUPLICATE_NAMES_ERROR,
+        .number_mode = KI_JSON_NUMBER_LENIENT,
+        .array_storage = KI_JSON_ARRAY_STORAGE_BOXED,
+        .pack_numbers = false,
+        .allocator = NULL
+    };
+
+    return options;
+}
+
+static void parser_init(struct ki_json_parser* parser, const struct ki_json_parser_options* options)
+{
+    assert(parser);
+
+    memset(parser, 0, sizeof(*parser));
+
+    parser->options = (options != NULL) ? *options : ki_json_parser_options_default();
+    parser->allocator = ki_json_allocator_get_default();
+}
+
+static void parser_fini(struct ki_json_parser* parser)
+{
+    assert(parser);
+
+    ki_json_dealloc(parser->allocator, parser->frames, sizeof(*parser->frames) * parser->frame_capacity);
+    ki_json_dealloc(parser->allocator, parser->names, parser->names_size);
+
+    parser->frames = NULL;
+    parser->frame_count = 0;
+    parser->frame_capacity = 0;
+    parser->names = NULL;
+    parser->names_used = 0;
+    parser->names_size = 0;
+}
+
+// Ensures names buffer has room for size more bytes after the used ones.
+// Returns pointer to the first unused byte, NULL on fail.
+static char* parser_reserve_names(struct ki_json_parser* parser, size_t size)
+{
+    assert(parser);
+
+    if (parser->names_size - parser->names_used >= size)
+        return parser->names + parser->names_used;
+
+    size_t new_size = (parser->names_size > 0) ? parser->names_size : 256;
+
+    while (new_size - parser->names_used < size)
+        new_size *= 2;
+
+    char* new_names = ki_json_realloc(parser->allocator, parser->names, parser->names_size, new_size);
+
+    if (new_names == NULL)
+        return NULL;
+
+    parser->names = new_names;
+    parser->names_size = new_size;
+
+    return parser->names + parser->names_used;
+}
+
+// Pushes container value onto the parser's stack.
+// Returns true on success, false on fail.
+static bool parser_push(struct ki_json_parser* parser, struct ki_json_val* val)
+{
+    assert(parser && val);
+
+    if (parser->frame_count == parser->frame_capacity)
+    {
+        size_t new_capacity = (parser->frame_capacity > 0) ? parser->frame_capacity * 2 : 16;
+        struct parser_frame* new_frames = ki_json_realloc(parser->allocator, parser->frames, sizeof(*new_frames) * parser->frame_capacity, sizeof(*new_frames) * new_capacity);
+
+        if (new_frames == NULL)
+            return false;
+
+        parser->frames = new_frames;
+        parser->frame_capacity = new_capacity;
+    }
+
+    parser->frames[parser->frame_count].val = val;
+    parser->frames[parser->frame_count].name_offset = parser->names_used;
+    parser->frames[parser->frame_count].name_length = 0;
+    parser->frame_count++;
+
+    return true;
+}
+
+// Frees every container left on the parser's stack, along with everything already added to them.
+static void parser_clear(struct ki_json_parser* parser)
+{
+    assert(parser);
+
+    while (parser->frame_count > 0)
+    {
+        parser->frame_count--;
+        ki_json_val_free(parser->frames[parser->frame_count].val);
+    }
+
+    parser->names_used = 0;
+}
+
+/* Parsing */
+
+// Checks whether reader can read in a string value.
+// Returns KI_JSON_ERR_NONE if yes.
+// Length includes quotation marks.
+static enum ki_json_err_type has_next_string_val(struct json_reader* reader, size_t* length)
+{
+    if (reader == NULL)
+        return KI_JSON_ERR_INTERNAL;
+
+    char character = '\0';
+
+    //no start quote
+    if (!reader_peek(reader, &character) || character != '\"')
+        return KI_JSON_ERR_UNKNOWN_TOKEN;
+
+    size_t string_start = reader->offset;
+
+    reader->offset++;
+
+    if (reader->padded)
+    {
+        //stops at the '\0' after json string at the latest, bounds are checked below
+        const char* pos = reader->json_string + reader->offset;
+
+        while (true)
+        {
+            //skip 8 bytes at a time while none of them end the string or start an escape sequence
+            //reading ahead into the padding is fine, as the '\0' stops this before going past it
+            uint64_t word = load_word(pos);
+
+            if (!WORD_HAS_BYTE(word, '\"') && !WORD_HAS_BYTE(word, '\\') && !WORD_HAS_BYTE(word, '\n') && !WORD_HAS_ZERO_BYTE(word))
+            {
+                pos += 8;
+                continue;
+            }
+
+            //one of these 8 bytes does, find it
+            while (*pos != '\"' && *pos != '\\' && *pos != '\n' && *pos != '\0')
+                pos++;
+
+            if (*pos != '\\')
+                break;
+
+            //skip next char, as it is always part of this one
+            if (pos[1] != '\0')
+                pos++;
+
+            pos++;
+        }
+
+        reader->offset = pos - reader->json_string;
+    }
+    else
+    {
+        while (reader_peek(reader, &character) && character != '\"' && character != '\n' && character != '\0')
+        {
+            //skip next char, as it is always part of this one
+            if (character == '\\')
+                reader->offset++;
+
+            reader->offset++;
+        }
+    }
+
+    //string must have an ending quote on the same line
+    if (!reader_peek(reader, &character) || character != '\"')
+        return KI_JSON_ERR_UNTERMINATED_STRING;
+
+    //out
+    if (length != NULL)
+        *length = reader->offset - string_start + 1;
+
+    //go back
+    reader->offset = string_start;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Decodes next double-quoted json-formatted string of input_length (see has_next_string_val) in json string.
+// Result must have room for input_length - 1 bytes, it is null-terminated.
+// Outs length of result (excluding null-terminator).
+static enum ki_json_err_type decode_string(struct json_reader* reader, size_t input_length, char* result, size_t* length)
+{
+    assert(reader && result && length && input_length >= 2);
+
+    //result will always be smaller than or the same size as the string value (excluding start + end quote) in the input json
+    size_t result_max_length = input_length - 2;
+
+    const char* end = reader_buffer_at(reader, input_length - 1);
+    
+    reader->offset++; //skip first "
+    
+    const char* pos = reader_buffer_at(reader, 0);
+    size_t result_index = 0;
+    
+    //convert escape sequences in input string
+    //NOTE: only escaped utf8 characters are added in a single iteration, others are done byte per byte
+    while (pos < end && result_index < result_max_length)
+    {
+        size_t sequence_length = 0;
+
+        //start of an escape sequence
+        if (pos[0] == '\\')
+        {
+            unsigned char bytes[CHARACTER_MAX_BUFFER_SIZE]; //character bytes, max. 4 bytes (utf8)
+            size_t num_bytes = escape_sequence_to_utf8(pos, end, bytes, CHARACTER_MAX_BUFFER_SIZE, &sequence_length);
+
+            //invalid escape sequence or failed to parse it
+            if (num_bytes == 0)
+                return KI_JSON_ERR_INVALID_ESCAPE_SEQUENCE;
+
+            //should never occur, but in just case
+            if (result_index + num_bytes >= result_max_length)
+                return KI_JSON_ERR_INTERNAL;
+
+            //add bytes into result
+            for (size_t i = 0; i < num_bytes; i++)
+            {
+                result[result_index] = bytes[i];
+                result_index++;
+            }
+        }
+        else 
+        {
+            //copy everything up to the next escape sequence at once
+            const char* escape = memchr(pos, '\\', end - pos);
+            sequence_length = ((escape != NULL) ? escape : end) - pos;
+
+            memcpy(result + result_index, pos, sequence_length);
+            result_index += sequence_length;
+        }
+
+        pos += sequence_length;
+        reader->offset += sequence_length; //also move offset for error handling
+    }
+
+    result[result_index] = '\0'; //null-terminate
+
+    reader->offset++; //skip last "
+
+    //out
+    *length = result_index;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Parse next double-quoted json-formatted string in json string, outs it & its length (may be NULL).
+// Strings fitting into buffer of buffer_size (may be NULL) are decoded into it, others into newly allocated memory.
+// String must be freed once done using the reader's allocator, unless it is buffer.
+static enum ki_json_err_type parse_string(struct json_reader* reader, char* buffer, size_t buffer_size, char** string, size_t* length)
+{
+    assert(reader && string);
+
+    //get input length and check whether we even have a string val
+    size_t input_length = 0;
+
+    enum ki_json_err_type err_type = has_next_string_val(reader, &input_length);
+
+    if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    size_t result_size = input_length - 1; //include space for null-terminator
+    size_t result_length = 0;
+
+    //decoded string is never longer than input without quotes
+    if (buffer != NULL && result_size <= buffer_size)
+    {
+        err_type = decode_string(reader, input_length, buffer, &result_length);
+
+        if (err_type != KI_JSON_ERR_NONE)
+            return err_type;
+
+        //out
+        *string = buffer;
+
+        if (length != NULL)
+            *length = result_length;
+
+        return KI_JSON_ERR_NONE;
+    }
+
+    char* result = ki_json_alloc(reader->allocator, result_size);
+    
+    if (result == NULL)
+        return KI_JSON_ERR_MEMORY;
+
+    err_type = decode_string(reader, input_length, result, &result_length);
+
+    if (err_type != KI_JSON_ERR_NONE)
+    {
+        ki_json_dealloc(reader->allocator, result, result_size);
+        return err_type;
+    }
+
+    //escape sequences made result shorter, shrink it so it's freed with the right size later on
+    if (result_length + 1 < result_size)
+    {
+        char* shrunk = ki_json_realloc(reader->allocator, result, result_size, result_length + 1);
+
+        if (shrunk == NULL)
+        {
+            ki_json_dealloc(reader->allocator, result, result_size);
+            return KI_JSON_ERR_MEMORY;
+        }
+
+        result = shrunk;
+    }
+
+    //out
+    *string = result;
+
+    if (length != NULL)
+        *length = result_length;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Parse next double-quoted json-formatted string in json string into string val.
+// Short strings are decoded right into the val (see struct ki_json_string), without allocating.
+static enum ki_json_err_type parse_string_val(struct json_reader* reader, struct ki_json_val* val)
+{
+    assert(reader && val && val->type == KI_JSON_VAL_STRING);
+
+    struct ki_json_string* storage = &val->value.string_storage;
+
+    char* string = NULL;
+    size_t length = 0;
+
+    enum ki_json_err_type err_type = parse_string(reader, storage->chars, sizeof(storage->chars), &string, &length);
+
+    if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    if (string == storage->chars)
+    {
+        storage->string = storage->chars;
+        storage->length = length;
+        val->flags |= KI_JSON_VAL_FLAG_INLINE_STRING;
+    }
+    else
+    {
+        //hand over decoded string instead of copying it, moves strings escapes made short enough inline
+        ki_json_val_set_stringn_take(val, string, length);
+    }
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Returns whether character can be part of a number read by strtod().
+static bool char_is_number_part(char character)
+{
+    return (character >= '0' && character <= '9') || character == '-' || character == '+' || character == '.' || character == 'e' || character == 'E';
+}
+
+// Returns length of the number at the start of buffer following the json grammar, 0 if it does not.
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static size_t strict_number_length(const char* buffer, size_t available)
+{
+    size_t i = 0;
+
+    if (i < available && buffer[i] == '-')
+        i++;
+
+    //integer part, no leading zeros
+    if (i < available && buffer[i] == '0')
+    {
+        i++;
+    }
+    else if (i < available && buffer[i] >= '1' && buffer[i] <= '9')
+    {
+        while (i < available && buffer[i] >= '0' && buffer[i] <= '9')
+            i++;
+    }
+    else
+    {
+        return 0;
+    }
+
+    //fraction
+    if (i < available && buffer[i] == '.')
+    {
+        i++;
+
+        if (i >= available || buffer[i] < '0' || buffer[i] > '9')
+            return 0;
+
+        while (i < available && buffer[i] >= '0' && buffer[i] <= '9')
+            i++;
+    }
+
+    //exponent
+    if (i < available && (buffer[i] == 'e' || buffer[i] == 'E'))
+    {
+        i++;
+
+        if (i < available && (buffer[i] == '+' || buffer[i] == '-'))
+            i++;
+
+        if (i >= available || buffer[i] < '0' || buffer[i] > '9')
+            return 0;
+
+        while (i < available && buffer[i] >= '0' && buffer[i] <= '9')
+            i++;
+    }
+
+    return i;
+}
+
+// Parse next given number in the json string.
+static enum ki_json_err_type parse_number(struct json_reader* reader, double* number)
+{
+    assert(reader && number);
+
+    const char* buffer = reader_buffer_at(reader, 0);
+
+    if (buffer == NULL)
+        return KI_JSON_ERR_TOO_SHORT;
+
+    size_t available = reader->length - reader->offset;
+    size_t length = 0;
+
+    if (reader->parser != NULL && reader->parser->options.number_mode == KI_JSON_NUMBER_STRICT)
+    {
+        length = strict_number_length(buffer, available);
+
+        if (length == 0)
+            return KI_JSON_ERR_INVALID_NUMBER;
+    }
+    else if (reader->padded)
+    {
+        //'\0' after json string is no number part
+        while (char_is_number_part(buffer[length]))
+            length++;
+    }
+    else
+    {
+        while (length < available && char_is_number_part(buffer[length]))
+            length++;
+    }
+
+    //json string does not have to be null-terminated, so copy number over to a null-terminated buffer for strtod()
+    char small[64];
+    char* copy = small;
+    //readers without a parser (for ex.: of scanners) have no buffers to reuse, so long numbers get their own
+    bool allocated = false;
+
+    if (length >= sizeof(small))
+    {
+        allocated = (reader->parser == NULL);
+        copy = allocated ? ki_json_alloc(reader->allocator, length + 1) : parser_reserve_names(reader->parser, length + 1);
+
+        if (copy == NULL)
+            return KI_JSON_ERR_MEMORY;
+    }
+
+    memcpy(copy, buffer, length);
+    copy[length] = '\0';
+
+    char* endptr;
+    *number = strtod(copy, &endptr);
+
+    //move reader to endptr (char byte after last number character)
+    reader->offset += (endptr - copy);
+
+    if (allocated)
+        ki_json_dealloc(reader->allocator, copy, length + 1);
+
+    if (endptr == copy)
+        return KI_JSON_ERR_UNKNOWN_TOKEN;
+    else if (reader->offset > reader->length)
+        return KI_JSON_ERR_TOO_SHORT;
+    else
+        return KI_JSON_ERR_NONE;
+}
+
+// Returns true if character may follow a true, false or null literal, else false.
+// NOTE: '\0' marks the end of the json string (or the start of its padding).
+static bool char_is_delimiter(char character)
+{
+    return char_is_whitespace(character) || (character == ',') || (character == ']') || (character == '}') || (character == '\0');
+}
+
+// Whether the next 8 bytes of the json string can be read without bounds checks,
+// that is if the json string is padded or has at least 8 bytes left.
+static bool reader_can_access_word(struct json_reader* reader)
+{
+    assert(reader);
+
+    if (reader->padded)
+        return reader->offset <= reader->length;
+
+    return reader->offset + 8 <= reader->length;
+}
+
+// Checks whether the next characters are the given literal.
+// Returns true on success, returns false on fail.
+static bool has_next_literal(struct json_reader* reader, const char* literal)
+{
+    if (reader == NULL || literal == NULL)
+        return false;
+
+    //read characters, returning false if the characters aren't the same as in given literal until the end of the literal
+    size_t i = 0;
+    while (literal[i] != '\0')
+    {
+        if (reader_char_at(reader, i) != literal[i])
+            return false; //literal not found!
+
+        i++;
+    }
+
+    //found literal :)
+    return true;
+}
+
+// Literals checked for by has_next_keyword(), padded with zeroes to a full word.
+static const char literal_true[8] = "true";
+static const char literal_false[8] = "false";
+static const char literal_null[8] = "null";
+static const char literal_bom[8] = "\uFEFF";
+
+// Checks whether the next characters are the given literal of literal_length (< 8),
+// followed by a delimiter or the end of the json string if delimiter is true.
+// Used for true, false, null & the BOM, so e.g. "truex" or "nullify" are rejected right away.
+// NOTE: literal must be 8 bytes long, zero padded (see literal_true etc.).
+// Returns true on success, returns false on fail.
+static bool has_next_keyword(struct json_reader* reader, const char* literal, size_t literal_length, bool delimiter)
+{
+    assert(reader && literal && literal_length < 8);
+
+    //compare whole literal at once & check the following character if possible
+    if (reader_can_access_word(reader))
+    {
+        //first literal_length bytes set, works regardless of endianness
+        static const unsigned char mask_bytes[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+        const char* pos = reader->json_string + reader->offset;
+        uint64_t mask = load_word((const char*)mask_bytes + 8 - literal_length);
+
+        if (((load_word(pos) ^ load_word(literal)) & mask) != 0)
+            return false;
+
+        return !delimiter || char_is_delimiter(pos[literal_length]);
+    }
+
+    //reader_char_at() returns '\0' past the end, which is a delimiter
+    return has_next_literal(reader, literal) && (!delimiter || char_is_delimiter(reader_char_at(reader, literal_length)));
+}
+
+// Parse next bool literal in the json string.
+static enum ki_json_err_type parse_boolean(struct json_reader* reader, bool* boolean)
+{
+    assert(reader && boolean);
+
+    if (has_next_keyword(reader, literal_true, 4, true))
+    {
+        *boolean = true; //out boolean
+        reader->offset += 4;
+        return KI_JSON_ERR_NONE;
+    }
+    
+    if (has_next_keyword(reader, literal_false, 5, true))
+    {
+        *boolean = false; //out boolean
+        reader->offset += 5;
+        return KI_JSON_ERR_NONE;
+    }
+
+    //false and true not found, not a boolean
+    return KI_JSON_ERR_UNKNOWN_TOKEN;
+}
+
+// Parses next null literal in the json string.
+static enum ki_json_err_type parse_null(struct json_reader* reader)
+{
+    assert(reader);
+
+    if (has_next_keyword(reader, literal_null, 4, true))
+    {
+        reader->offset += 4;
+        return KI_JSON_ERR_NONE;
+    }
+    else 
+    {
+        return KI_JSON_ERR_UNKNOWN_TOKEN;
+    }
+}
+
+// Outs type of json value that isn't an object or array starting with character.
+// Returns true on success, false if no such value starts with character.
+static bool scalar_type(char character, enum ki_json_val_type* type)
+{
+    assert(type);
+
+    //pick according to first character which type to try and parse
+
+    switch (character)
+    {
+        case '\"':
+            *type = KI_JSON_VAL_STRING;
+            return true;
+        case 't':
+        case 'f':
+            *type = KI_JSON_VAL_BOOL;
+            return true;
+        case 'n':
+            *type = KI_JSON_VAL_NULL;
+            return true;
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+        case '-':
+        case '.':
+            *type = KI_JSON_VAL_NUMBER;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Parses next json value in the json string into val, which is zeroed & has its type set already.
+// Val must be finished using ki_json_val_fini() when done, even on fail.
+static enum ki_json_err_type parse_scalar_val(struct json_reader* reader, struct ki_json_val* val)
+{
+    assert(reader && val);
+
+    switch (val->type)
+    {
+        case KI_JSON_VAL_STRING:
+            return parse_string_val(reader, val);
+        case KI_JSON_VAL_BOOL:
+            return parse_boolean(reader, &val->value.boolean);
+        case KI_JSON_VAL_NULL:
+            val->value.null = true;
+            return parse_null(reader);
+        default: //KI_JSON_VAL_NUMBER
+            return parse_number(reader, &val->value.number);
+    }
+}
+
+// Parses next json value in the json string that isn't an object or array.
+// Val must be freed using ki_json_val_free() when done.
+static enum ki_json_err_type parse_scalar(struct json_reader* reader, char character, struct ki_json_val** val)
+{
+    assert(reader && val);
+
+    enum ki_json_val_type type = KI_JSON_VAL_NULL;
+
+    if (!scalar_type(character, &type))
+        return KI_JSON_ERR_UNKNOWN_TOKEN;
+
+    struct ki_json_val* new_val = ki_json_val_alloc(reader->allocator, type);
+
+    //alloc fail
+    if (new_val == NULL)
+        return KI_JSON_ERR_MEMORY;
+
+    enum ki_json_err_type err_type = parse_scalar_val(reader, new_val);
+
+    if (err_type == KI_JSON_ERR_NONE)
+        *val = new_val; //out
+    else
+        ki_json_val_free(new_val);
+
+    return err_type;
+}
+
+// Returns whether character starts a json number.
+static bool char_starts_number(char character)
+{
+    enum ki_json_val_type type = KI_JSON_VAL_NULL;
+
+    return scalar_type(character, &type) && type == KI_JSON_VAL_NUMBER;
+}
+
+// Parses next json value in the json string that isn't an object or array straight into the end of json array
+// with KI_JSON_ARRAY_STORAGE_INLINE or KI_JSON_ARRAY_STORAGE_NUMBERS, saving a node allocation & a copy.
+static enum ki_json_err_type parse_scalar_into_array(struct json_reader* reader, char character, struct ki_json_array* array)
+{
+    assert(reader && array && array->storage != KI_JSON_ARRAY_STORAGE_BOXED);
+
+    enum ki_json_val_type type = KI_JSON_VAL_NULL;
+
+    if (!scalar_type(character, &type))
+        return KI_JSON_ERR_UNKNOWN_TOKEN;
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        assert(type == KI_JSON_VAL_NUMBER);
+
+        double* number = ki_json_array_next_slot(array);
+
+        if (number == NULL)
+            return KI_JSON_ERR_MEMORY;
+
+        enum ki_json_err_type err_type = parse_number(reader, number);
+
+        if (err_type == KI_JSON_ERR_NONE)
+            array->count++;
+
+        return err_type;
+    }
+
+    struct ki_json_val* slot = ki_json_array_next_slot(array);
+
+    if (slot == NULL)
+        return KI_JSON_ERR_MEMORY;
+
+    slot->type = type;
+    slot->allocator = array->allocator;
+
+    enum ki_json_err_type err_type = parse_scalar_val(reader, slot);
+
+    if (err_type != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_fini(slot);
+        return err_type;
+    }
+
+    array->count++;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Parses name of next pair & the colon after it, for the json object on top of the parser's stack.
+static enum ki_json_err_type parse_pair_name(struct ki_json_parser* parser, struct json_reader* reader)
+{
+    assert(parser && reader && parser->frame_count > 0);
+
+    struct parser_frame* frame = &parser->frames[parser->frame_count - 1];
+
+    size_t input_length = 0;
+    enum ki_json_err_type err_type = has_next_string_val(reader, &input_length);
+
+    if (err_type == KI_JSON_ERR_UNKNOWN_TOKEN)
+        return KI_JSON_ERR_EXPECTED_NAME;
+    else if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    //decode name onto the names stack, so it doesn't have to be allocated
+    char* name = parser_reserve_names(parser, input_length - 1);
+
+    if (name == NULL)
+        return KI_JSON_ERR_MEMORY;
+
+    size_t name_length = 0;
+    err_type = decode_string(reader, input_length, name, &name_length);
+
+    if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    frame->name_offset = parser->names_used;
+    frame->name_length = name_length;
+    parser->names_used += name_length + 1;
+
+    #if KI_JSON_PARSER_VERBOSE
+    printf("Parsing object pair: %s\n", name);
+    #endif
+
+    reader_skip_whitespace(reader);
+
+    //colon separates name and value
+    if (!reader_can_access(reader, 0) || reader_char_at(reader, 0) != ':')
+        return KI_JSON_ERR_EXPECTED_NAME_VALUE_SEPARATOR;
+
+    reader->offset++; //skip :
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Returns storage of parsed arrays that aren't packed.
+static enum ki_json_array_storage parser_unpacked_storage(const struct ki_json_parser* parser)
+{
+    if (parser->options.array_storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        return KI_JSON_ARRAY_STORAGE_BOXED;
+
+    return parser->options.array_storage;
+}
+
+// Adds parsed value to the container on top of the parser's stack.
+// Value is freed on fail.
+static enum ki_json_err_type parser_add_value(struct ki_json_parser* parser, struct ki_json_val* val)
+{
+    assert(parser && val && parser->frame_count > 0);
+
+    struct parser_frame* frame = &parser->frames[parser->frame_count - 1];
+    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
+
+    if (frame->val->type == KI_JSON_VAL_ARRAY)
+    {
+        #if KI_JSON_PARSER_VERBOSE
+        printf("Parsing array value index: %zu\n", frame->val->value.array.count);
+        #endif
+
+        err_type = ki_json_array_add(&frame->val->value.array, val);
+    }
+    else
+    {
+        struct ki_json_object* object = &frame->val->value.object;
+        const char* name = parser->names + frame->name_offset;
+        size_t name_length = frame->name_length;
+
+        switch (parser->options.duplicate_names)
+        {
+            case KI_JSON_DUPLICATE_NAMES_KEEP_FIRST:
+                if (ki_json_object_getn(object, name, name_length) != NULL)
+                    ki_json_val_free(val);
+                else
+                    err_type = ki_json_object_addn(object, name, name_length, val);
+                break;
+            case KI_JSON_DUPLICATE_NAMES_KEEP_LAST:
+                err_type = ki_json_object_setn(object, name, name_length, val);
+                break;
+            default: //KI_JSON_DUPLICATE_NAMES_ERROR
+                err_type = ki_json_object_addn(object, name, name_length, val);
+                break;
+        }
+
+        //name is copied, so pop it off the names stack
+        parser->names_used = frame->name_offset;
+    }
+
+    if (err_type != KI_JSON_ERR_NONE)
+        ki_json_val_free(val);
+
+    return err_type;
+}
+
+// Parses next json value in the json string, along with everything inside of it.
+// Objects & arrays being parsed are kept on the parser's stack instead of recursing.
+// Val must be freed using ki_json_val_free() when done.
+static enum ki_json_err_type parse_value(struct ki_json_parser* parser, struct json_reader* reader, struct ki_json_val** val)
+{
+    assert(parser && reader && val);
+
+    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
+    char character = '\0';
+
+    //whether next token should be a value, instead of a separator or end of container
+    bool expect_value = true;
+    struct ki_json_val* new_val = NULL;
+
+    while (true)
+    {
+        if (expect_value)
+        {
+            reader_skip_whitespace(reader);
+
+            if (!reader_peek(reader, &character))
+                return KI_JSON_ERR_TOO_SHORT;
+
+            //array on top of the stack, if any
+            struct ki_json_val* top = (parser->frame_count > 0) ? parser->frames[parser->frame_count - 1].val : NULL;
+            struct ki_json_array* array = (top != NULL && top->type == KI_JSON_VAL_ARRAY) ? &top->value.array : NULL;
+
+            //packed arrays hold only numbers, unpack them once anything else shows up
+            if (array != NULL && array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS && !char_starts_number(character)
+                && !ki_json_array_set_storage(array, parser_unpacked_storage(parser)))
+                return KI_JSON_ERR_MEMORY;
+
+            if (character == '{' || character == '[')
+            {
+                if (parser->options.max_depth != 0 && parser->frame_count >= parser->options.max_depth)
+                    return KI_JSON_ERR_TOO_DEEP;
+
+                bool is_object = (character == '{');
+
+                reader->offset++; //skip first { or [
+
+                reader_skip_whitespace(reader);
+
+                bool is_empty = reader_peek(reader, &character) && character == (is_object ? '}' : ']');
+
+                //arrays starting with a number likely hold only numbers, so start those packed
+                enum ki_json_array_storage storage = parser_unpacked_storage(parser);
+
+                if (parser->options.pack_numbers && !is_empty && char_starts_number(character))
+                    storage = KI_JSON_ARRAY_STORAGE_NUMBERS;
+
+                new_val = ki_json_val_alloc(reader->allocator, is_object ? KI_JSON_VAL_OBJECT : KI_JSON_VAL_ARRAY);
+
+                if (new_val == NULL)
+                    return KI_JSON_ERR_MEMORY;
+
+                //alloc default capacity
+                bool initialized = is_object ? ki_json_object_init_with_allocator(&new_val->value.object, 5, new_val->allocator)
+                                             : ki_json_array_init_with_storage(&new_val->value.array, 5, storage, new_val->allocator);
+
+                if (!initialized)
+                {
+                    ki_json_val_dealloc(new_val);
+                    return KI_JSON_ERR_MEMORY;
+                }
+
+                if (!parser_push(parser, new_val))
+                {
+                    ki_json_val_free(new_val);
+                    return KI_JSON_ERR_MEMORY;
+                }
+
+                //empty container
+                if (is_empty)
+                {
+                    reader->offset++; //skip last } or ]
+                    parser->frame_count--;
+                }
+                else
+                {
+                    if (is_object && (err_type = parse_pair_name(parser, reader)) != KI_JSON_ERR_NONE)
+                        return err_type;
+
+                    continue;
+                }
+            }
+            else if (array != NULL && array->storage != KI_JSON_ARRAY_STORAGE_BOXED)
+            {
+                if ((err_type = parse_scalar_into_array(reader, character, array)) != KI_JSON_ERR_NONE)
+                    return err_type;
+
+                new_val = NULL;
+            }
+            else if ((err_type = parse_scalar(reader, character, &new_val)) != KI_JSON_ERR_NONE)
+            {
+                return err_type;
+            }
+        }
+
+        //completed value is the root value
+        if (parser->frame_count == 0)
+        {
+            *val = new_val; //out
+            return KI_JSON_ERR_NONE;
+        }
+
+        //values parsed straight into their array are added already
+        if (new_val != NULL && (err_type = parser_add_value(parser, new_val)) != KI_JSON_ERR_NONE)
+            return err_type;
+
+        new_val = NULL;
+
+        //after a value in a container comes either a comma or the end of the container
+        struct parser_frame* frame = &parser->frames[parser->frame_count - 1];
+        bool is_object = (frame->val->type == KI_JSON_VAL_OBJECT);
+        char end = is_object ? '}' : ']';
+
+        reader_skip_whitespace(reader);
+
+        //comma separates next value
+        if (reader_peek(reader, &character) && character == ',')
+        {
+            size_t pos_comma = reader->offset;
+            reader->offset++; //skip comma
+            reader_skip_whitespace(reader);
+
+            if (!reader_peek(reader, &character) || character == end)
+            {
+                reader->offset = pos_comma; //go back to comma
+                return KI_JSON_ERR_TRAILING_COMMA;
+            }
+
+            if (is_object && (err_type = parse_pair_name(parser, reader)) != KI_JSON_ERR_NONE)
+                return err_type;
+
+            expect_value = true;
+        }
+        else if (character == end)
+        {
+            reader->offset++; //skip last } or ]
+
+            //container is done, pop it & add it to its parent next iteration
+            parser->frame_count--;
+            new_val = frame->val;
+            expect_value = false;
+        }
+        else
+        {
+            //container never ended
+            return is_object ? KI_JSON_ERR_UNTERMINATED_OBJECT : KI_JSON_ERR_UNTERMINATED_ARRAY;
+        }
+    }
+}
+
+// Parse json string using parser, outs error to err.
+// Padded json strings must be followed by KI_JSON_PADDING readable bytes, the first being '\0'.
+static struct ki_json_val* parser_parse(struct ki_json_parser* parser, const char* string, size_t n, bool padded, struct ki_json_parser_err* err)
+{
+    assert(parser);
+
+    if (err != NULL)
+    {
+        err->json = string;
+        err->pos = 0;
+        err->type = KI_JSON_ERR_INTERNAL;
+    }
+
+    if (string == NULL)
+    {
+        if (err != NULL)
+            err->type = KI_JSON_ERR_INVALID_ARGS;
+        
+        return NULL;
+    }
+
+    ki_json_parser_reset(parser);
+
+    struct json_reader reader = {
+        .json_string = string,
+        .length = n,
+        .offset = 0,
+        .allocator = ki_json_allocator_resolve(parser->options.allocator),
+        .parser = parser,
+        .padded = padded
+    };
+
+    //skip byte order mark if necessary
+    if (has_next_keyword(&reader, literal_bom, 3, false))
+        reader.offset += 3;
+
+    struct ki_json_val* val = NULL;
+    enum ki_json_err_type err_type = parse_value(parser, &reader, &val);
+
+    if (err != NULL)
+    {
+        err->pos = reader.offset;
+        err->type = err_type;
+    }
+
+    //free whatever was parsed before failing
+    parser_clear(parser);
+
+    if (err_type != KI_JSON_ERR_NONE)
+        return NULL;
+    else
+        return val;
+}
+
+/* Scanning */
+
+// Returns reader for the rest of scanner's json text.
+static struct json_reader scanner_reader(const struct ki_json_scanner* scanner)
+{
+    struct json_reader reader = {
+        .json_string = scanner->json,
+        .length = scanner->length,
+        .offset = scanner->offset,
+        .allocator = NULL,
+        .parser = NULL,
+        .padded = false
+    };
+
+    return reader;
+}
+
+// Reads name of next pair & the colon after it, outs name to value.
+// Names with escape sequences are decoded into the scanner's names, others point into the json text.
+static enum ki_json_err_type scan_pair_name(struct ki_json_scanner* scanner, struct json_reader* reader, struct ki_json_scan_value* value)
+{
+    size_t input_length = 0;
+    enum ki_json_err_type err_type = has_next_string_val(reader, &input_length);
+
+    if (err_type == KI_JSON_ERR_UNKNOWN_TOKEN)
+        return KI_JSON_ERR_EXPECTED_NAME;
+    else if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    const char* name = reader->json_string + reader->offset + 1;
+
+    if (memchr(name, '\\', input_length - 2) == NULL)
+    {
+        value->name = name;
+        value->name_length = input_length - 2;
+        reader->offset += input_length;
+    }
+    else
+    {
+        if (scanner->names_size < input_length - 1)
+        {
+            char* new_names = ki_json_realloc(NULL, scanner->names, scanner->names_size, input_length - 1);
+
+            if (new_names == NULL)
+                return KI_JSON_ERR_MEMORY;
+
+            scanner->names = new_names;
+            scanner->names_size = input_length - 1;
+        }
+
+        if ((err_type = decode_string(reader, input_length, scanner->names, &value->name_length)) != KI_JSON_ERR_NONE)
+            return err_type;
+
+        value->name = scanner->names;
+    }
+
+    reader_skip_whitespace(reader);
+
+    //colon separates name and value
+    if (!reader_can_access(reader, 0) || reader_char_at(reader, 0) != ':')
+        return KI_JSON_ERR_EXPECTED_NAME_VALUE_SEPARATOR;
+
+    reader->offset++; //skip :
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Reads next value, or the end of the innermost json object or json array, see ki_json_scan_next().
+static enum ki_json_err_type scan_next(struct ki_json_scanner* scanner, struct json_reader* reader, struct ki_json_scan_value* value)
+{
+    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
+    char character = '\0';
+
+    reader_skip_whitespace(reader);
+
+    if (scanner->depth > 0)
+    {
+        bool is_object = (scanner->kinds[scanner->depth - 1] == '{');
+        char end = is_object ? '}' : ']';
+
+        if (!reader_peek(reader, &character))
+            return is_object ? KI_JSON_ERR_UNTERMINATED_OBJECT : KI_JSON_ERR_UNTERMINATED_ARRAY;
+
+        if (character == end)
+        {
+            reader->offset++; //skip last } or ]
+
+            scanner->depth--;
+            scanner->first = false;
+            scanner->done = (scanner->depth == 0);
+
+            value->event = KI_JSON_SCAN_END;
+            value->end = reader->offset;
+            return KI_JSON_ERR_NONE;
+        }
+
+        //comma separates next value
+        if (!scanner->first)
+        {
+            if (character != ',')
+                return is_object ? KI_JSON_ERR_UNTERMINATED_OBJECT : KI_JSON_ERR_UNTERMINATED_ARRAY;
+
+            size_t pos_comma = reader->offset;
+            reader->offset++; //skip comma
+            reader_skip_whitespace(reader);
+
+            if (!reader_peek(reader, &character) || character == end)
+            {
+                reader->offset = pos_comma; //go back to comma
+                return KI_JSON_ERR_TRAILING_COMMA;
+            }
+        }
+
+        if (is_object)
+        {
+            if ((err_type = scan_pair_name(scanner, reader, value)) != KI_JSON_ERR_NONE)
+                return err_type;
+
+            reader_skip_whitespace(reader);
+        }
+    }
+
+    if (!reader_peek(reader, &character))
+        return KI_JSON_ERR_TOO_SHORT;
+
+    value->start = reader->offset;
+
+    if (character == '{' || character == '[')
+    {
+        if (scanner->depth == scanner->kinds_size)
+        {
+            size_t new_size = (scanner->kinds_size > 0) ? scanner->kinds_size * 2 : 64;
+            char* new_kinds = ki_json_realloc(NULL, scanner->kinds, scanner->kinds_size, new_size);
+
+            if (new_kinds == NULL)
+                return KI_JSON_ERR_MEMORY;
+
+            scanner->kinds = new_kinds;
+            scanner->kinds_size = new_size;
+        }
+
+        reader->offset++; //skip first { or [
+
+        scanner->kinds[scanner->depth++] = character;
+        scanner->first = true;
+
+        value->event = (character == '{') ? KI_JSON_SCAN_OBJECT : KI_JSON_SCAN_ARRAY;
+        value->end = reader->offset;
+        return KI_JSON_ERR_NONE;
+    }
+
+    enum ki_json_val_type type = KI_JSON_VAL_NULL;
+
+    if (!scalar_type(character, &type))
+        return KI_JSON_ERR_UNKNOWN_TOKEN;
+
+    size_t input_length = 0;
+    double number = 0.0;
+    bool boolean = false;
+
+    switch (type)
+    {
+        case KI_JSON_VAL_STRING:
+            err_type = has_next_string_val(reader, &input_length);
+            reader->offset += (err_type == KI_JSON_ERR_NONE) ? input_length : 0;
+            break;
+        case KI_JSON_VAL_BOOL:
+            err_type = parse_boolean(reader, &boolean);
+            break;
+        case KI_JSON_VAL_NULL:
+            err_type = parse_null(reader);
+            break;
+        default: //KI_JSON_VAL_NUMBER
+            err_type = parse_number(reader, &number);
+            break;
+    }
+
+    if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    scanner->first = false;
+    scanner->done = (scanner->depth == 0);
+
+    value->event = KI_JSON_SCAN_SCALAR;
+    value->end = reader->offset;
+    return KI_JSON_ERR_NONE;
+}
+
+// Inits scanner reading json text of length bytes.
+void ki_json_scanner_init(struct ki_json_scanner* scanner, const char* json, size_t length)
+{
+    assert(scanner && (json || length == 0));
+
+    memset(scanner, 0, sizeof(*scanner));
+
+    ki_json_scanner_reset(scanner, json, length);
+}
+
+// Starts reading json text of length bytes over, keeping the scanner's buffers.
+void ki_json_scanner_reset(struct ki_json_scanner* scanner, const char* json, size_t length)
+{
+    assert(scanner && (json || length == 0));
+
+    scanner->json = json;
+    scanner->length = length;
+    scanner->offset = 0;
+    scanner->depth = 0;
+    scanner->first = false;
+    scanner->done = false;
+
+    //skip byte order mark if necessary
+    struct json_reader reader = scanner_reader(scanner);
+
+    if (has_next_keyword(&reader, literal_bom, 3, false))
+        scanner->offset += 3;
+}
+
+void ki_json_scanner_fini(struct ki_json_scanner* scanner)
+{
+    assert(scanner);
+
+    ki_json_dealloc(NULL, scanner->kinds, scanner->kinds_size);
+    ki_json_dealloc(NULL, scanner->names, scanner->names_size);
+
+    scanner->kinds = NULL;
+    scanner->kinds_size = 0;
+    scanner->names = NULL;
+    scanner->names_size = 0;
+}
+
+// Reads next value, or the end of the innermost json object or json array, outs it to value.
+// NOTE: Strings are checked to end, but their escape sequences aren't checked unless they are names.
+// Returns KI_JSON_ERR_NONE on success, the error the parser would fail with otherwise.
+enum ki_json_err_type ki_json_scan_next(struct ki_json_scanner* scanner, struct ki_json_scan_value* value)
+{
+    assert(scanner && value);
+
+    value->name = NULL;
+    value->name_length = 0;
+
+    if (scanner->done)
+    {
+        value->event = KI_JSON_SCAN_DONE;
+        value->start = scanner->offset;
+        value->end = scanner->offset;
+        return KI_JSON_ERR_NONE;
+    }
+
+    struct json_reader reader = scanner_reader(scanner);
+    enum ki_json_err_type err_type = scan_next(scanner, &reader, value);
+
+    scanner->offset = reader.offset;
+
+    return err_type;
+}
+
+// Skips rest of the json object or json array just started (see KI_JSON_SCAN_OBJECT), outs offset past its end to end.
+// NOTE: Skipped values are only checked for strings ending & for json objects & json arrays to end.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_UNTERMINATED_STRING, KI_JSON_ERR_UNTERMINATED_OBJECT or KI_JSON_ERR_UNTERMINATED_ARRAY on fail.
+enum ki_json_err_type ki_json_scan_skip(struct ki_json_scanner* scanner, size_t* end)
+{
+    assert(scanner && end && scanner->depth > 0);
+
+    bool is_object = (scanner->kinds[scanner->depth - 1] == '{');
+    const char* pos = scanner->json + scanner->offset;
+    const char* json_end = scanner->json + scanner->length;
+    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
+    size_t depth = 1;
+
+    while (depth > 0)
+    {
+        //only strings & brackets matter, skip 8 bytes at a time while none of them start or end either
+        //'{' & '}' only differ from '[' & ']' by bit 0x20, so setting it finds both
+        while (pos + 8 <= json_end)
+        {
+            uint64_t word = load_word(pos);
+            uint64_t folded = word | WORD_BROADCAST(0x20);
+
+            if (WORD_HAS_BYTE(word, '\"') || WORD_HAS_BYTE(folded, '{') || WORD_HAS_BYTE(folded, '}'))
+                break;
+
+            pos += 8;
+        }
+
+        while (pos < json_end && *pos != '\"' && *pos != '{' && *pos != '[' && *pos != '}' && *pos != ']')
+            pos++;
+
+        if (pos == json_end)
+        {
+            err_type = is_object ? KI_JSON_ERR_UNTERMINATED_OBJECT : KI_JSON_ERR_UNTERMINATED_ARRAY;
+            break;
+        }
+
+        if (*pos == '{' || *pos == '[')
+        {
+            depth++;
+            pos++;
+            continue;
+        }
+
+        if (*pos == '}' || *pos == ']')
+        {
+            depth--;
+            pos++;
+            continue;
+        }
+
+        //string must have an ending quote on the same line
+        pos++; //skip first "
+
+        while (true)
+        {
+            while (pos + 8 <= json_end)
+            {
+                uint64_t word = load_word(pos);
+
+                if (WORD_HAS_BYTE(word, '\"') || WORD_HAS_BYTE(word, '\\') || WORD_HAS_BYTE(word, '\n'))
+                    break;
+
+                pos += 8;
+            }
+
+            while (pos < json_end && *pos != '\"' && *pos != '\\' && *pos != '\n')
+                pos++;
+
+            if (pos == json_end || *pos == '\n')
+            {
+                err_type = KI_JSON_ERR_UNTERMINATED_STRING;
+                break;
+            }
+
+            if (*pos == '\"')
+                break;
+
+            //skip next char, as it is always part of this one
+            pos += (pos + 1 < json_end) ? 2 : 1;
+        }
+
+        if (err_type != KI_JSON_ERR_NONE)
+            break;
+
+        pos++; //skip last "
+    }
+
+    scanner->offset = pos - scanner->json;
+
+    if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    scanner->depth--;
+    scanner->first = false;
+    scanner->done = (scanner->depth == 0);
+
+    *end = scanner->offset;
+
+    return KI_JSON_ERR_NONE;
+}
+
+/* Public */
+
+// Parse null-terminated string to a json tree.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_parse_string(const char* string, struct ki_json_parser_err* err)
+{
+    return ki_json_nparse_string(string, (string != NULL) ? strlen(string) : 0, err);
+}
+
+// Parse no more than n characters of string to a json tree.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_nparse_string(const char* string, size_t n, struct ki_json_parser_err* err)
+{
+    return ki_json_nparse_string_with_allocator(string, n, NULL, err);
+}
+
+// Parse no more than n characters of string to a json tree, allocating it using given allocator (NULL = default).
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_nparse_string_with_allocator(const char* string, size_t n, const struct ki_json_allocator* allocator, struct ki_json_parser_err* err)
+{
+    struct ki_json_parser parser;
+    parser_init(&parser, NULL);
+    parser.options.allocator = allocator;
+
+    struct ki_json_val* val = parser_parse(&parser, string, n, false, err);
+
+    parser_fini(&parser);
+
+    return val;
+}
+
+// Copies length bytes of string into a new padded string, allocated using the default allocator.
+// Returns true on success, false on fail.
+bool ki_json_padded_string_init(struct ki_json_padded_string* padded, const char* string, size_t length)
+{
+    assert(padded && string);
+
+    padded->allocator = ki_json_allocator_get_default();
+    padded->length = length;
+    padded->string = ki_json_alloc(padded->allocator, length + KI_JSON_PADDING);
+
+    if (padded->string == NULL)
+        return false;
+
+    memcpy(padded->string, string, length);
+    memset(padded->string + length, 0, KI_JSON_PADDING);
+
+    return true;
+}
+
+void ki_json_padded_string_fini(struct ki_json_padded_string* padded)
+{
+    assert(padded);
+
+    ki_json_dealloc(padded->allocator, padded->string, padded->length + KI_JSON_PADDING);
+
+    padded->string = NULL;
+    padded->length = 0;
+}
+
+// Parse padded string to a json tree.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_parse_padded_string(const struct ki_json_padded_string* padded, struct ki_json_parser_err* err)
+{
+    struct ki_json_parser parser;
+    parser_init(&parser, NULL);
+
+    struct ki_json_val* val = parser_parse(&parser, (padded != NULL) ? padded->string : NULL, (padded != NULL) ? padded->length : 0, true, err);
+
+    parser_fini(&parser);
+
+    return val;
+}
+
+// Creates reusable parser with given options (NULL for default options).
+// Buffers of the parser itself are allocated using the default allocator.
+// Returns NULL on fail.
+struct ki_json_parser* ki_json_parser_create(const struct ki_json_parser_options* options)
+{
+    struct ki_json_parser* parser = ki_json_alloc(NULL, sizeof(*parser));
+
+    if (parser == NULL)
+        return NULL;
+
+    parser_init(parser, options);
+
+    return parser;
+}
+
+void ki_json_parser_free(struct ki_json_parser* parser)
+{
+    if (parser == NULL)
+        return;
+
+    parser_clear(parser);
+    parser_fini(parser);
+
+    ki_json_dealloc(parser->allocator, parser, sizeof(*parser));
+}
+
+// Forgets any state left behind by the last parse, keeping all buffers. O(1).
+// NOTE: Parsing resets the parser by itself as well.
+void ki_json_parser_reset(struct ki_json_parser* parser)
+{
+    assert(parser);
+
+    //containers on the stack are always freed once parsing stops, so there is nothing to free here
+    parser->frame_count = 0;
+    parser->names_used = 0;
+}
+
+// Returns options of parser, may be changed in between parses.
+struct ki_json_parser_options* ki_json_parser_get_options(struct ki_json_parser* parser)
+{
+    assert(parser);
+    return &parser->options;
+}
+
+// Parse no more than n characters of string to a json tree, using parser's options & buffers.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_parser_parse(struct ki_json_parser* parser, const char* string, size_t n, struct ki_json_parser_err* err)
+{
+    if (parser == NULL)
+    {
+        if (err != NULL)
+        {
+            err->json = string;
+            err->pos = 0;
+            err->type = KI_JSON_ERR_INVALID_ARGS;
+        }
+
+        return NULL;
+    }
+
+    return parser_parse(parser, string, n, false, err);
+}
+
+// Same as ki_json_parser_parse(), but string must be followed by KI_JSON_PADDING readable bytes, the first being '\0'.
+// Skips most bounds checks, see ki_json_padded_string for a way to pad strings.
+// Val returned must be freed using ki_json_val_free() when done.
+// Returns NULL on fail and outs error to err.
+struct ki_json_val* ki_json_parser_parse_padded(struct ki_json_parser* parser, const char* string, size_t n, struct ki_json_parser_err* err)
+{
+    if (parser == NULL)
+    {
+        if (err != NULL)
+        {
+            err->json = string;
+            err->pos = 0;
+            err->type = KI_JSON_ERR_INVALID_ARGS;
+        }
+
+        return NULL;
+    }
+
+    assert(string == NULL || string[n] == '\0');
+
+    return parser_parse(parser, string, n, true, err);
+}
@@ -0,0 +1,1604 @@
+#include "ki_json/json_patch.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ki_json/json.h"
+#include "json/json_internal.h"
+
+// Amount of frames the stack for walking trees holds before allocating, enough for most trees
+#define DIFF_STACK_INLINE_SIZE 32
+// Maximum number of cells of the table for finding the longest common subsequence of values of arrays,
+// arrays differing in more values are compared value by value instead
+#define DIFF_LCS_MAX_CELLS (1 << 20)
+
+// How a value of a json array changes.
+enum diff_step_type
+{
+    DIFF_STEP_KEEP, //value is equal in both
+    DIFF_STEP_CHANGE, //value of a is changed into value of b
+    DIFF_STEP_REMOVE, //value of a is removed
+    DIFF_STEP_ADD //value of b is added
+};
+
+struct diff_step
+{
+    enum diff_step_type type;
+    // Index of value in a (unless DIFF_STEP_ADD)
+    size_t a_index;
+    // Index of value in b (unless DIFF_STEP_REMOVE)
+    size_t b_index;
+};
+
+// Json objects or json arrays a & b whose values are being compared.
+struct diff_frame
+{
+    struct ki_json_val* a;
+    struct ki_json_val* b;
+    // Length of the JSON Pointer to a & b
+    size_t path_length;
+    // Objects: index of next pair of a to compare, past those the index of next pair of b to look for in a
+    // Arrays: index of next step
+    size_t next;
+    // Arrays: index in the array being patched that the next step applies to
+    size_t index;
+    // Arrays: changes to values, see diff_frame_init_steps()
+    struct diff_step* steps;
+    size_t step_count;
+    size_t step_capacity;
+};
+
+// Stack of containers being compared, one frame per level of the tree.
+struct diff_stack
+{
+    struct diff_frame* frames;
+    size_t count;
+    size_t capacity;
+    struct diff_frame inline_frames[DIFF_STACK_INLINE_SIZE];
+};
+
+// JSON Pointer (RFC 6901) to the values being compared.
+struct diff_path
+{
+    char* chars;
+    size_t length;
+    size_t capacity;
+};
+
+struct diff
+{
+    // Patch being built
+    struct ki_json_val* patch;
+    struct diff_path path;
+    struct diff_stack stack;
+    // Allocator used for everything besides the patch
+    const struct ki_json_allocator* allocator;
+};
+
+// Amount of changes the undo log holds at first
+#define PATCH_UNDO_INITIAL_CAPACITY 16
+// Amount of frames the stack for merging holds before allocating, enough for most patches
+#define MERGE_STACK_INLINE_SIZE 32
+
+// How a change to the document is undone.
+enum patch_undo_type
+{
+    PATCH_UNDO_REMOVE, //value was added, remove it
+    PATCH_UNDO_ADD, //value was removed, add it back
+    PATCH_UNDO_REPLACE //value was replaced, put it back
+};
+
+struct patch_undo_entry
+{
+    enum patch_undo_type type;
+    // JSON Patch: JSON Pointer to the changed value, Merge Patch: name of the changed value (both part of the patch)
+    const char* path;
+    size_t path_length;
+    // Merge Patch: json object holding the changed value, NULL for JSON Pointers
+    struct ki_json_object* object;
+    // Value to put back (owned), NULL for PATCH_UNDO_REMOVE
+    struct ki_json_val* value;
+};
+
+// Value referred to by a JSON Pointer, which may not exist yet.
+struct patch_location
+{
+    // Json object or json array holding the value, NULL for the root
+    struct ki_json_val* parent;
+    // Json objects: name of the value, unescaped
+    const char* name;
+    size_t name_length;
+    // Json arrays: index of the value, past the last value for "-"
+    size_t index;
+    bool end;
+};
+
+struct patch
+{
+    struct ki_json_val** doc;
+    // Whether changes are logged so they can be undone on fail, see patch_rollback()
+    bool atomic;
+    struct patch_undo_entry* undo;
+    size_t undo_count;
+    size_t undo_capacity;
+    // Buffer for unescaping reference tokens of JSON Pointers
+    char* name;
+    size_t name_capacity;
+    // Allocator used for everything besides the document
+    const struct ki_json_allocator* allocator;
+};
+
+// Json object of the document & json object of the Merge Patch merged into it.
+struct merge_frame
+{
+    struct ki_json_object* target;
+    struct ki_json_object* patch;
+    // Index of next pair of patch to merge
+    size_t next;
+};
+
+/* Path */
+
+// Appends length bytes of chars to path.
+// Returns true on success, false on fail.
+static bool diff_path_append(struct diff* diff, const char* chars, size_t length)
+{
+    struct diff_path* path = &diff->path;
+
+    if (path->length + length > path->capacity)
+    {
+        size_t new_capacity = (path->capacity > 0) ? path->capacity * 2 : 64;
+
+        while (new_capacity < path->length + length)
+            new_capacity *= 2;
+
+        char* new_chars = ki_json_realloc(diff->allocator, path->chars, path->capacity, new_capacity);
+
+        if (new_chars == NULL)
+            return false;
+
+        path->chars = new_chars;
+        path->capacity = new_capacity;
+    }
+
+    memcpy(path->chars + path->length, chars, length);
+    path->length += length;
+
+    return true;
+}
+
+// Appends reference token of name of name_length bytes to path, escaping '~' as "~0" & '/' as "~1".
+// Returns true on success, false on fail.
+static bool diff_path_append_name(struct diff* diff, const char* name, size_t name_length)
+{
+    if (!diff_path_append(diff, "/", 1))
+        return false;
+
+    size_t start = 0;
+
+    for (size_t i = 0; i < name_length; i++)
+    {
+        if (name[i] != '~' && name[i] != '/')
+            continue;
+
+        if (!diff_path_append(diff, name + start, i - start) || !diff_path_append(diff, (name[i] == '~') ? "~0" : "~1", 2))
+            return false;
+
+        start = i + 1;
+    }
+
+    return diff_path_append(diff, name + start, name_length - start);
+}
+
+// Appends reference token of index to path.
+// Returns true on success, false on fail.
+static bool diff_path_append_index(struct diff* diff, size_t index)
+{
+    char token[32];
+    int length = snprintf(token, sizeof(token), "/%zu", index);
+
+    return length > 0 && diff_path_append(diff, token, (size_t)length);
+}
+
+/* Patch */
+
+// Adds operation op on value at path to the patch, with value (taken over, NULL for none).
+// Returns true on success, false on fail.
+static bool diff_add_op(struct diff* diff, const char* op, struct ki_json_val* value)
+{
+    struct ki_json_val* operation = ki_json_array_add_new_object(&diff->patch->value.array, (value != NULL) ? 3 : 2);
+
+    if (operation == NULL)
+    {
+        ki_json_val_free(value);
+        return false;
+    }
+
+    //path of the root is empty
+    struct ki_json_val* path = ki_json_val_create_from_stringn((diff->path.chars != NULL) ? diff->path.chars : "", diff->path.length);
+
+    if (path == NULL || ki_json_object_add_new_string(&operation->value.object, "op", op) == NULL
+        || ki_json_object_add(&operation->value.object, "path", path) != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(path);
+        ki_json_val_free(value);
+        return false;
+    }
+
+    if (value != NULL && ki_json_object_add(&operation->value.object, "value", value) != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(value);
+        return false;
+    }
+
+    return true;
+}
+
+// Adds operation op on value at path to the patch, with a copy of value (NULL for none).
+// Returns true on success, false on fail.
+static bool diff_add_op_shared(struct diff* diff, const char* op, struct ki_json_val* value)
+{
+    struct ki_json_val* shared = ki_json_val_share(value);
+
+    return shared != NULL && diff_add_op(diff, op, shared);
+}
+
+/* Arrays */
+
+// Returns value at index of json array without changing the array, NULL for packed numbers (outs number instead).
+static struct ki_json_val* diff_element(struct ki_json_array* array, size_t index, double* number)
+{
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+    {
+        *number = ki_json_array_number_at(array, index);
+        return NULL;
+    }
+
+    return ki_json_array_at(array, index);
+}
+
+// Returns hash of value at index of json array, see ki_json_val_hash().
+static size_t diff_element_hash(struct ki_json_array* array, size_t index)
+{
+    double number = 0.0;
+    struct ki_json_val* val = diff_element(array, index, &number);
+
+    return (val != NULL) ? ki_json_val_hash(val) : (size_t)ki_json_hash_number(number);
+}
+
+// Whether value at a_index of json array a equals value at b_index of json array b.
+static bool diff_elements_equal(struct ki_json_array* a, size_t a_index, struct ki_json_array* b, size_t b_index)
+{
+    double a_number = 0.0;
+    double b_number = 0.0;
+    struct ki_json_val* a_val = diff_element(a, a_index, &a_number);
+    struct ki_json_val* b_val = diff_element(b, b_index, &b_number);
+
+    if (a_val != NULL && b_val != NULL)
+        return a_val == b_val || ki_json_val_equal(a_val, b_val);
+
+    if (a_val != NULL)
+        return a_val->type == KI_JSON_VAL_NUMBER && a_val->value.number == b_number;
+
+    if (b_val != NULL)
+        return b_val->type == KI_JSON_VAL_NUMBER && b_val->value.number == a_number;
+
+    return a_number == b_number;
+}
+
+// Returns copy of value at index of json array for the patch, shared if possible.
+// Returns NULL on fail.
+static struct ki_json_val* patch_element_copy(struct ki_json_array* array, size_t index)
+{
+    double number = 0.0;
+    struct ki_json_val* val = diff_element(array, index, &number);
+
+    if (val == NULL)
+        return ki_json_val_create_from_number(number);
+
+    //inline values can't be shared, only the values inside of them
+    if (array->storage == KI_JSON_ARRAY_STORAGE_INLINE)
+        return ki_json_val_copy_shallow(val);
+
+    return ki_json_val_share(val);
+}
+
+// Adds remove_count steps removing values of a from a_index & add_count steps adding values of b from b_index,
+// changing values into each other instead of removing & adding them where possible.
+static void diff_frame_add_steps(struct diff_frame* frame, size_t a_index, size_t remove_count, size_t b_index, size_t add_count)
+{
+    size_t change_count = (remove_count < add_count) ? remove_count : add_count;
+
+    for (size_t i = 0; i < change_count; i++)
+    {
+        struct diff_step* step = &frame->steps[frame->step_count++];
+        step->type = DIFF_STEP_CHANGE;
+        step->a_index = a_index + i;
+        step->b_index = b_index + i;
+    }
+
+    for (size_t i = change_count; i < remove_count; i++)
+    {
+        struct diff_step* step = &frame->steps[frame->step_count++];
+        step->type = DIFF_STEP_REMOVE;
+        step->a_index = a_index + i;
+    }
+
+    for (size_t i = change_count; i < add_count; i++)
+    {
+        struct diff_step* step = &frame->steps[frame->step_count++];
+        step->type = DIFF_STEP_ADD;
+        step->b_index = b_index + i;
+    }
+}
+
+// Adds steps for the a_count values of a from a_start & the b_count values of b from b_start,
+// keeping their longest common subsequence (found using a table of lengths of common subsequences of their ends).
+// Returns true on success, false on fail.
+static bool diff_frame_add_lcs_steps(struct diff* diff, struct diff_frame* frame, size_t a_start, size_t a_count, size_t b_start, size_t b_count)
+{
+    struct ki_json_array* a = &frame->a->value.array;
+    struct ki_json_array* b = &frame->b->value.array;
+
+    size_t width = b_count + 1;
+    size_t table_size = sizeof(uint32_t) * (a_count + 1) * width;
+    size_t hashes_size = sizeof(size_t) * (a_count + b_count);
+
+    uint32_t* lengths = ki_json_calloc(diff->allocator, (a_count + 1) * width, sizeof(*lengths));
+    size_t* hashes = ki_json_alloc(diff->allocator, hashes_size);
+
+    if (lengths == NULL || hashes == NULL)
+    {
+        if (lengths != NULL)
+            ki_json_dealloc(diff->allocator, lengths, table_size);
+        if (hashes != NULL)
+            ki_json_dealloc(diff->allocator, hashes, hashes_size);
+
+        return false;
+    }
+
+    //values hashing differently can't be equal, so most pairs are told apart without comparing them
+    size_t* a_hashes = hashes;
+    size_t* b_hashes = hashes + a_count;
+
+    for (size_t i = 0; i < a_count; i++)
+        a_hashes[i] = diff_element_hash(a, a_start + i);
+
+    for (size_t j = 0; j < b_count; j++)
+        b_hashes[j] = diff_element_hash(b, b_start + j);
+
+    for (size_t i = a_count; i-- > 0;)
+    {
+        for (size_t j = b_count; j-- > 0;)
+        {
+            uint32_t* length = &lengths[i * width + j];
+
+            if (a_hashes[i] == b_hashes[j] && diff_elements_equal(a, a_start + i, b, b_start + j))
+                *length = lengths[(i + 1) * width + j + 1] + 1;
+            else
+                *length = (lengths[(i + 1) * width + j] > lengths[i * width + j + 1]) ? lengths[(i + 1) * width + j] : lengths[i * width + j + 1];
+        }
+    }
+
+    //walk the table from the start, keeping equal values wherever they are part of a longest common subsequence
+    size_t i = 0;
+    size_t j = 0;
+    size_t remove_start = 0;
+    size_t add_start = 0;
+
+    while (i < a_count && j < b_count)
+    {
+        if (a_hashes[i] == b_hashes[j] && diff_elements_equal(a, a_start + i, b, b_start + j))
+        {
+            diff_frame_add_steps(frame, a_start + remove_start, i - remove_start, b_start + add_start, j - add_start);
+
+            struct diff_step* step = &frame->steps[frame->step_count++];
+            step->type = DIFF_STEP_KEEP;
+            step->a_index = a_start + i++;
+            step->b_index = b_start + j++;
+
+            remove_start = i;
+            add_start = j;
+        }
+        else if (lengths[(i + 1) * width + j] >= lengths[i * width + j + 1])
+        {
+            i++;
+        }
+        else
+        {
+            j++;
+        }
+    }
+
+    diff_frame_add_steps(frame, a_start + remove_start, a_count - remove_start, b_start + add_start, b_count - add_start);
+
+    ki_json_dealloc(diff->allocator, lengths, table_size);
+    ki_json_dealloc(diff->allocator, hashes, hashes_size);
+
+    return true;
+}
+
+// Finds steps turning values of json array a of frame into values of json array b.
+// Equal values at the start & end are skipped first, so typical edits never get to finding the longest common subsequence.
+// Returns true on success, false on fail.
+static bool diff_frame_init_steps(struct diff* diff, struct diff_frame* frame)
+{
+    struct ki_json_array* a = &frame->a->value.array;
+    struct ki_json_array* b = &frame->b->value.array;
+
+    size_t shorter = (a->count < b->count) ? a->count : b->count;
+    size_t prefix = 0;
+    size_t suffix = 0;
+
+    while (prefix < shorter && diff_elements_equal(a, prefix, b, prefix))
+        prefix++;
+
+    while (suffix < shorter - prefix && diff_elements_equal(a, a->count - 1 - suffix, b, b->count - 1 - suffix))
+        suffix++;
+
+    size_t a_count = a->count - prefix - suffix;
+    size_t b_count = b->count - prefix - suffix;
+
+    frame->index = prefix;
+
+    if (a_count == 0 && b_count == 0)
+        return true;
+
+    //every value differing is kept, changed, removed or added once
+    frame->step_capacity = a_count + b_count;
+    frame->steps = ki_json_alloc(diff->allocator, sizeof(*frame->steps) * frame->step_capacity);
+
+    if (frame->steps == NULL)
+        return false;
+
+    if (a_count > 0 && b_count > 0 && a_count < DIFF_LCS_MAX_CELLS && b_count < DIFF_LCS_MAX_CELLS
+        && (a_count + 1) * (b_count + 1) <= DIFF_LCS_MAX_CELLS)
+        return diff_frame_add_lcs_steps(diff, frame, prefix, a_count, prefix, b_count);
+
+    diff_frame_add_steps(frame, prefix, a_count, prefix, b_count);
+
+    return true;
+}
+
+/* Stack */
+
+// Pushes frame for comparing values of json objects or json arrays a & b at the current path onto stack.
+// Returns true on success, false on fail.
+static bool diff_stack_push(struct diff* diff, struct ki_json_val* a, struct ki_json_val* b)
+{
+    struct diff_stack* stack = &diff->stack;
+
+    if (stack->count == stack->capacity)
+    {
+        size_t new_capacity = stack->capacity * 2;
+        struct diff_frame* new_frames = NULL;
+
+        if (stack->frames == stack->inline_frames)
+        {
+            new_frames = ki_json_alloc(diff->allocator, sizeof(*new_frames) * new_capacity);
+
+            if (new_frames != NULL)
+                memcpy(new_frames, stack->frames, sizeof(*new_frames) * stack->count);
+        }
+        else
+        {
+            new_frames = ki_json_realloc(diff->allocator, stack->frames, sizeof(*new_frames) * stack->capacity, sizeof(*new_frames) * new_capacity);
+        }
+
+        if (new_frames == NULL)
+            return false;
+
+        stack->frames = new_frames;
+        stack->capacity = new_capacity;
+    }
+
+    struct diff_frame* frame = &stack->frames[stack->count];
+    frame->a = a;
+    frame->b = b;
+    frame->path_length = diff->path.length;
+    frame->next = 0;
+    frame->index = 0;
+    frame->steps = NULL;
+    frame->step_count = 0;
+    frame->step_capacity = 0;
+
+    if (a->type == KI_JSON_VAL_ARRAY && !diff_frame_init_steps(diff, frame))
+    {
+        if (frame->steps != NULL)
+            ki_json_dealloc(diff->allocator, frame->steps, sizeof(*frame->steps) * frame->step_capacity);
+
+        return false;
+    }
+
+    stack->count++;
+
+    return true;
+}
+
+// Pops top frame off stack.
+static void diff_stack_pop(struct diff* diff)
+{
+    struct diff_frame* frame = &diff->stack.frames[--diff->stack.count];
+
+    if (frame->steps != NULL)
+        ki_json_dealloc(diff->allocator, frame->steps, sizeof(*frame->steps) * frame->step_capacity);
+}
+
+/* Diffing */
+
+// What comparing two values at the current path resulted in.
+enum diff_result
+{
+    DIFF_RESULT_EQUAL, //nothing to do
+    DIFF_RESULT_PUSHED, //both are json objects or json arrays, pushed to compare their values
+    DIFF_RESULT_REPLACE, //value of a is to be replaced by value of b
+    DIFF_RESULT_FAIL
+};
+
+// Compares json values a & b at the current path.
+static enum diff_result diff_vals(struct diff* diff, struct ki_json_val* a, struct ki_json_val* b)
+{
+    //shared values are skipped right away
+    if (a == b)
+        return DIFF_RESULT_EQUAL;
+
+    if (a->type == b->type && (a->type == KI_JSON_VAL_OBJECT || a->type == KI_JSON_VAL_ARRAY))
+        return diff_stack_push(diff, a, b) ? DIFF_RESULT_PUSHED : DIFF_RESULT_FAIL;
+
+    return ki_json_val_equal(a, b) ? DIFF_RESULT_EQUAL : DIFF_RESULT_REPLACE;
+}
+
+// Compares next pair of json objects in frame.
+// Returns true on success, false on fail.
+static bool diff_object_next(struct diff* diff, struct diff_frame* frame)
+{
+    struct ki_json_object* a = &frame->a->value.object;
+    struct ki_json_object* b = &frame->b->value.object;
+
+    //removes & changes first, then adds
+    if (frame->next < a->count)
+    {
+        const struct ki_json_pair* pair = &a->pairs[frame->next++];
+        struct ki_json_val* b_val = ki_json_object_getn(b, pair->name, pair->name_length);
+
+        if (!diff_path_append_name(diff, pair->name, pair->name_length))
+            return false;
+
+        if (b_val == NULL)
+            return diff_add_op(diff, "remove", NULL);
+
+        switch (diff_vals(diff, pair->value, b_val))
+        {
+            case DIFF_RESULT_REPLACE:
+                return diff_add_op_shared(diff, "replace", b_val);
+            case DIFF_RESULT_FAIL:
+                return false;
+            default: //DIFF_RESULT_EQUAL, DIFF_RESULT_PUSHED
+                return true;
+        }
+    }
+
+    const struct ki_json_pair* pair = &b->pairs[frame->next++ - a->count];
+
+    if (ki_json_object_getn(a, pair->name, pair->name_length) != NULL)
+        return true;
+
+    return diff_path_append_name(diff, pair->name, pair->name_length) && diff_add_op_shared(diff, "add", pair->value);
+}
+
+// Applies next step of json arrays in frame.
+// Returns true on success, false on fail.
+static bool diff_array_next(struct diff* diff, struct diff_frame* frame)
+{
+    const struct diff_step* step = &frame->steps[frame->next++];
+    struct ki_json_array* a = &frame->a->value.array;
+    struct ki_json_array* b = &frame->b->value.array;
+
+    size_t index = frame->index;
+
+    if (step->type == DIFF_STEP_KEEP)
+    {
+        frame->index++;
+        return true;
+    }
+
+    if (!diff_path_append_index(diff, index))
+        return false;
+
+    if (step->type == DIFF_STEP_REMOVE)
+        return diff_add_op(diff, "remove", NULL);
+
+    frame->index++;
+
+    if (step->type == DIFF_STEP_ADD)
+    {
+        struct ki_json_val* copy = patch_element_copy(b, step->b_index);
+        return copy != NULL && diff_add_op(diff, "add", copy);
+    }
+
+    //DIFF_STEP_CHANGE
+    double a_number = 0.0;
+    double b_number = 0.0;
+    struct ki_json_val* a_val = diff_element(a, step->a_index, &a_number);
+    struct ki_json_val* b_val = diff_element(b, step->b_index, &b_number);
+
+    enum diff_result result = DIFF_RESULT_REPLACE;
+
+    if (a_val != NULL && b_val != NULL)
+        result = diff_vals(diff, a_val, b_val);
+    else if (diff_elements_equal(a, step->a_index, b, step->b_index))
+        result = DIFF_RESULT_EQUAL;
+
+    if (result == DIFF_RESULT_REPLACE)
+    {
+        struct ki_json_val* copy = patch_element_copy(b, step->b_index);
+        return copy != NULL && diff_add_op(diff, "replace", copy);
+    }
+
+    return result != DIFF_RESULT_FAIL;
+}
+
+/* Undo log */
+
+// Makes room for logging one more change, so logging it can't fail once it is done.
+// Returns true on success, false on fail.
+static bool patch_undo_reserve(struct patch* patch)
+{
+    if (!patch->atomic || patch->undo_count < patch->undo_capacity)
+        return true;
+
+    size_t new_capacity = (patch->undo_capacity > 0) ? patch->undo_capacity * 2 : PATCH_UNDO_INITIAL_CAPACITY;
+    struct patch_undo_entry* new_undo = ki_json_realloc(patch->allocator, patch->undo,
+        sizeof(*patch->undo) * patch->undo_capacity, sizeof(*patch->undo) * new_capacity);
+
+    if (new_undo == NULL)
+        return false;
+
+    patch->undo = new_undo;
+    patch->undo_capacity = new_capacity;
+
+    return true;
+}
+
+// Logs change to value at path (name in object for Merge Patches), undone by type using value (taken over).
+// NOTE: Room must have been made using patch_undo_reserve().
+static void patch_undo_push(struct patch* patch, enum patch_undo_type type, const char* path, size_t path_length, struct ki_json_object* object, struct ki_json_val* value)
+{
+    if (!patch->atomic)
+    {
+        ki_json_val_free(value);
+        return;
+    }
+
+    assert(patch->undo_count < patch->undo_capacity);
+
+    struct patch_undo_entry* entry = &patch->undo[patch->undo_count++];
+    entry->type = type;
+    entry->path = path;
+    entry->path_length = path_length;
+    entry->object = object;
+    entry->value = value;
+}
+
+/* JSON Pointers */
+
+// Outs reference token of token_length bytes unescaped ("~1" as '/' & "~0" as '~'), pointing into token unless it has escapes.
+// NOTE: Unescaped names stay valid until the next token is unescaped.
+static enum ki_json_err_type patch_token(struct patch* patch, const char* token, size_t token_length, const char** name, size_t* name_length)
+{
+    if (memchr(token, '~', token_length) == NULL)
+    {
+        *name = token;
+        *name_length = token_length;
+        return KI_JSON_ERR_NONE;
+    }
+
+    if (token_length > patch->name_capacity)
+    {
+        char* new_name = ki_json_realloc(patch->allocator, patch->name, patch->name_capacity, token_length);
+
+        if (new_name == NULL)
+            return KI_JSON_ERR_MEMORY;
+
+        patch->name = new_name;
+        patch->name_capacity = token_length;
+    }
+
+    size_t length = 0;
+
+    for (size_t i = 0; i < token_length; i++)
+    {
+        if (token[i] != '~')
+        {
+            patch->name[length++] = token[i];
+            continue;
+        }
+
+        if (i + 1 == token_length || (token[i + 1] != '0' && token[i + 1] != '1'))
+            return KI_JSON_ERR_INVALID_PATCH;
+
+        patch->name[length++] = (token[++i] == '0') ? '~' : '/';
+    }
+
+    *name = patch->name;
+    *name_length = length;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Outs index given by reference token of token_length bytes, digits without leading zeros.
+// Returns true on success, false if it is no index.
+static bool patch_index(const char* token, size_t token_length, size_t* index)
+{
+    if (token_length == 0 || (token[0] == '0' && token_length > 1))
+        return false;
+
+    size_t value = 0;
+
+    for (size_t i = 0; i < token_length; i++)
+    {
+        if (token[i] < '0' || token[i] > '9' || value > (SIZE_MAX - 9) / 10)
+            return false;
+
+        value = value * 10 + (size_t)(token[i] - '0');
+    }
+
+    *index = value;
+
+    return true;
+}
+
+// Returns value of json object or json array parent referred to by reference token of token_length bytes, outs NULL if none.
+// If change is true, shared values are replaced with copies first (see ki_json_object_get_mut()).
+static enum ki_json_err_type patch_child(struct patch* patch, struct ki_json_val* parent, const char* token, size_t token_length, bool change, struct ki_json_val** child)
+{
+    *child = NULL;
+
+    if (parent->type == KI_JSON_VAL_OBJECT)
+    {
+        const char* name = NULL;
+        size_t name_length = 0;
+        enum ki_json_err_type err = patch_token(patch, token, token_length, &name, &name_length);
+
+        if (err != KI_JSON_ERR_NONE)
+            return err;
+
+        *child = ki_json_object_getn(&parent->value.object, name, name_length);
+
+        if (*child == NULL)
+            return KI_JSON_ERR_PATH_NOT_FOUND;
+
+        if (change && ki_json_val_is_shared(*child))
+            *child = ki_json_object_getn_mut(&parent->value.object, name, name_length);
+
+        return (*child != NULL) ? KI_JSON_ERR_NONE : KI_JSON_ERR_MEMORY;
+    }
+
+    size_t index = 0;
+
+    //packed numbers hold no values to look into
+    if (parent->type != KI_JSON_VAL_ARRAY || parent->value.array.storage == KI_JSON_ARRAY_STORAGE_NUMBERS
+        || !patch_index(token, token_length, &index) || index >= parent->value.array.count)
+        return KI_JSON_ERR_PATH_NOT_FOUND;
+
+    *child = change ? ki_json_array_at_mut(&parent->value.array, index) : ki_json_array_at(&parent->value.array, index);
+
+    return (*child != NULL) ? KI_JSON_ERR_NONE : KI_JSON_ERR_MEMORY;
+}
+
+// Outs location of value referred to by JSON Pointer (RFC 6901) path of path_length bytes, which may not exist yet.
+// If change is true, shared values on the way are replaced with copies first, so the location can be changed.
+static enum ki_json_err_type patch_locate(struct patch* patch, const char* path, size_t path_length, bool change, struct patch_location* location)
+{
+    location->parent = NULL;
+    location->name = NULL;
+    location->name_length = 0;
+    location->index = 0;
+    location->end = false;
+
+    if (path_length == 0)
+        return KI_JSON_ERR_NONE;
+
+    if (path[0] != '/')
+        return KI_JSON_ERR_INVALID_PATCH;
+
+    if (change && ki_json_val_is_shared(*patch->doc))
+    {
+        struct ki_json_val* copy = ki_json_val_unshare(*patch->doc);
+
+        if (copy == NULL)
+            return KI_JSON_ERR_MEMORY;
+
+        *patch->doc = copy;
+    }
+
+    struct ki_json_val* parent = *patch->doc;
+    size_t start = 1;
+
+    while (true)
+    {
+        const char* slash = memchr(path + start, '/', path_length - start);
+        size_t end = (slash != NULL) ? (size_t)(slash - path) : path_length;
+
+        if (slash == NULL)
+            break;
+
+        enum ki_json_err_type err = patch_child(patch, parent, path + start, end - start, change, &parent);
+
+        if (err != KI_JSON_ERR_NONE)
+            return err;
+
+        start = end + 1;
+    }
+
+    const char* token = path + start;
+    size_t token_length = path_length - start;
+
+    location->parent = parent;
+
+    if (parent->type == KI_JSON_VAL_OBJECT)
+        return patch_token(patch, token, token_length, &location->name, &location->name_length);
+
+    if (parent->type != KI_JSON_VAL_ARRAY)
+        return KI_JSON_ERR_PATH_NOT_FOUND;
+
+    //"-" refers to the value past the last one
+    if (token_length == 1 && token[0] == '-')
+    {
+        location->index = parent->value.array.count;
+        location->end = true;
+        return KI_JSON_ERR_NONE;
+    }
+
+    return patch_index(token, token_length, &location->index) ? KI_JSON_ERR_NONE : KI_JSON_ERR_PATH_NOT_FOUND;
+}
+
+// Outs value at location, or NULL with its number if it is a packed number.
+// Returns true on success, false if there is none.
+static bool patch_location_find(struct patch* patch, const struct patch_location* location, struct ki_json_val** val, double* number)
+{
+    *val = NULL;
+
+    if (location->parent == NULL)
+    {
+        *val = *patch->doc;
+        return true;
+    }
+
+    if (location->parent->type == KI_JSON_VAL_OBJECT)
+    {
+        *val = ki_json_object_getn(&location->parent->value.object, location->name, location->name_length);
+        return *val != NULL;
+    }
+
+    struct ki_json_array* array = &location->parent->value.array;
+
+    if (location->index >= array->count)
+        return false;
+
+    if (array->storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        *number = ki_json_array_number_at(array, location->index);
+    else
+        *val = ki_json_array_at(array, location->index);
+
+    return true;
+}
+
+// Outs copy of value at location, shared if possible.
+static enum ki_json_err_type patch_location_copy(struct patch* patch, const struct patch_location* location, struct ki_json_val** copy)
+{
+    double number = 0.0;
+    struct ki_json_val* val = NULL;
+
+    *copy = NULL;
+
+    if (!patch_location_find(patch, location, &val, &number))
+        return KI_JSON_ERR_PATH_NOT_FOUND;
+
+    if (location->parent != NULL && location->parent->type == KI_JSON_VAL_ARRAY)
+        *copy = patch_element_copy(&location->parent->value.array, location->index);
+    else
+        *copy = ki_json_val_share(val);
+
+    return (*copy != NULL) ? KI_JSON_ERR_NONE : KI_JSON_ERR_MEMORY;
+}
+
+/* Operations */
+
+// Adds value (taken over) at location of path, replacing the value of a json object or the root that is there already.
+static enum ki_json_err_type patch_add_at(struct patch* patch, const struct patch_location* location, const char* path, size_t path_length, struct ki_json_val* value)
+{
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+
+    if (!patch_undo_reserve(patch))
+    {
+        ki_json_val_free(value);
+        return KI_JSON_ERR_MEMORY;
+    }
+
+    if (location->parent == NULL)
+    {
+        struct ki_json_val* previous = *patch->doc;
+        *patch->doc = value;
+
+        patch_undo_push(patch, PATCH_UNDO_REPLACE, path, path_length, NULL, previous);
+        return KI_JSON_ERR_NONE;
+    }
+
+    if (location->parent->type == KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_object* object = &location->parent->value.object;
+        struct ki_json_val* existing = ki_json_object_getn(object, location->name, location->name_length);
+        struct ki_json_val* previous = NULL;
+
+        //replaced value is kept to be put back
+        if (existing != NULL && patch->atomic && (previous = ki_json_val_share(existing)) == NULL)
+            err = KI_JSON_ERR_MEMORY;
+
+        if (err == KI_JSON_ERR_NONE)
+            err = ki_json_object_setn(object, location->name, location->name_length, value);
+
+        if (err != KI_JSON_ERR_NONE)
+        {
+            ki_json_val_free(previous);
+            ki_json_val_free(value);
+            return err;
+        }
+
+        patch_undo_push(patch, (existing != NULL) ? PATCH_UNDO_REPLACE : PATCH_UNDO_REMOVE, path, path_length, NULL, previous);
+        return KI_JSON_ERR_NONE;
+    }
+
+    err = ki_json_array_insert(&location->parent->value.array, value, location->index);
+
+    if (err != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(value);
+        return err;
+    }
+
+    patch_undo_push(patch, PATCH_UNDO_REMOVE, path, path_length, NULL, NULL);
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Adds value (taken over) at path, replacing the value of a json object or the root that is there already.
+static enum ki_json_err_type patch_add(struct patch* patch, const char* path, size_t path_length, struct ki_json_val* value)
+{
+    struct patch_location location;
+    enum ki_json_err_type err = patch_locate(patch, path, path_length, true, &location);
+
+    if (err != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(value);
+        return err;
+    }
+
+    return patch_add_at(patch, &location, path, path_length, value);
+}
+
+// Removes value at path, outing a copy of it if removed isn't NULL.
+static enum ki_json_err_type patch_remove(struct patch* patch, const char* path, size_t path_length, struct ki_json_val** removed)
+{
+    struct patch_location location;
+    enum ki_json_err_type err = patch_locate(patch, path, path_length, true, &location);
+
+    if (err != KI_JSON_ERR_NONE)
+        return err;
+
+    //the document itself can't be removed
+    if (location.parent == NULL)
+        return KI_JSON_ERR_INVALID_PATCH;
+
+    struct ki_json_val* copy = NULL;
+    struct ki_json_val* val = NULL;
+    double number = 0.0;
+
+    if (!patch_location_find(patch, &location, &val, &number))
+        return KI_JSON_ERR_PATH_NOT_FOUND;
+
+    if (!patch_undo_reserve(patch))
+        return KI_JSON_ERR_MEMORY;
+
+    if (patch->atomic || removed != NULL)
+    {
+        err = patch_location_copy(patch, &location, &copy);
+
+        if (err != KI_JSON_ERR_NONE)
+            return err;
+    }
+
+    if (location.parent->type == KI_JSON_VAL_OBJECT)
+        ki_json_object_removen(&location.parent->value.object, location.name, location.name_length);
+    else
+        ki_json_array_remove_at(&location.parent->value.array, location.index);
+
+    if (removed == NULL)
+    {
+        patch_undo_push(patch, PATCH_UNDO_ADD, path, path_length, NULL, copy);
+        return KI_JSON_ERR_NONE;
+    }
+
+    if (!patch->atomic)
+    {
+        *removed = copy;
+        return KI_JSON_ERR_NONE;
+    }
+
+    patch_undo_push(patch, PATCH_UNDO_ADD, path, path_length, NULL, copy);
+    *removed = ki_json_val_share(copy);
+
+    return (*removed != NULL) ? KI_JSON_ERR_NONE : KI_JSON_ERR_MEMORY;
+}
+
+// Replaces value at path with value (taken over).
+static enum ki_json_err_type patch_replace(struct patch* patch, const char* path, size_t path_length, struct ki_json_val* value)
+{
+    struct patch_location location;
+    enum ki_json_err_type err = patch_locate(patch, path, path_length, true, &location);
+    struct ki_json_val* val = NULL;
+    double number = 0.0;
+
+    if (err == KI_JSON_ERR_NONE && !patch_location_find(patch, &location, &val, &number))
+        err = KI_JSON_ERR_PATH_NOT_FOUND;
+
+    if (err != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(value);
+        return err;
+    }
+
+    //json objects & the root are replaced the same way as they're added to
+    if (location.parent == NULL || location.parent->type == KI_JSON_VAL_OBJECT)
+        return patch_add_at(patch, &location, path, path_length, value);
+
+    struct ki_json_val* previous = NULL;
+
+    if (!patch_undo_reserve(patch) || (patch->atomic && (previous = patch_element_copy(&location.parent->value.array, location.index)) == NULL))
+        err = KI_JSON_ERR_MEMORY;
+
+    if (err == KI_JSON_ERR_NONE)
+        err = ki_json_array_set(&location.parent->value.array, location.index, value);
+
+    if (err != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(previous);
+        ki_json_val_free(value);
+        return err;
+    }
+
+    patch_undo_push(patch, PATCH_UNDO_REPLACE, path, path_length, NULL, previous);
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Whether value at path equals value.
+static enum ki_json_err_type patch_test(struct patch* patch, const char* path, size_t path_length, struct ki_json_val* value)
+{
+    struct patch_location location;
+    enum ki_json_err_type err = patch_locate(patch, path, path_length, false, &location);
+
+    if (err != KI_JSON_ERR_NONE)
+        return err;
+
+    struct ki_json_val* val = NULL;
+    double number = 0.0;
+
+    if (!patch_location_find(patch, &location, &val, &number))
+        return KI_JSON_ERR_PATH_NOT_FOUND;
+
+    bool equal = (val != NULL) ? ki_json_val_equal(val, value) : (value->type == KI_JSON_VAL_NUMBER && value->value.number == number);
+
+    return equal ? KI_JSON_ERR_NONE : KI_JSON_ERR_TEST_FAILED;
+}
+
+// Outs string of member name of operation op, NULL if it has none.
+static void patch_op_string(struct ki_json_val* op, const char* name, const char** string, size_t* length)
+{
+    struct ki_json_val* val = ki_json_object_get(&op->value.object, name);
+
+    *string = (val != NULL && val->type == KI_JSON_VAL_STRING) ? ki_json_val_get_stringn(val, length) : NULL;
+}
+
+// Applies operation op of a JSON Patch.
+static enum ki_json_err_type patch_apply_op(struct patch* patch, struct ki_json_val* op)
+{
+    if (op->type != KI_JSON_VAL_OBJECT)
+        return KI_JSON_ERR_INVALID_PATCH;
+
+    const char* name = NULL;
+    const char* path = NULL;
+    const char* from = NULL;
+    size_t name_length = 0;
+    size_t path_length = 0;
+    size_t from_length = 0;
+
+    patch_op_string(op, "op", &name, &name_length);
+    patch_op_string(op, "path", &path, &path_length);
+    patch_op_string(op, "from", &from, &from_length);
+
+    struct ki_json_val* value = ki_json_object_get(&op->value.object, "value");
+
+    if (name == NULL || path == NULL)
+        return KI_JSON_ERR_INVALID_PATCH;
+
+    if (strcmp(name, "remove") == 0)
+        return patch_remove(patch, path, path_length, NULL);
+
+    if (strcmp(name, "add") == 0 || strcmp(name, "replace") == 0 || strcmp(name, "test") == 0)
+    {
+        if (value == NULL)
+            return KI_JSON_ERR_INVALID_PATCH;
+
+        if (name[0] == 't')
+            return patch_test(patch, path, path_length, value);
+
+        //values are shared with the patch instead of copied
+        struct ki_json_val* shared = ki_json_val_share(value);
+
+        if (shared == NULL)
+            return KI_JSON_ERR_MEMORY;
+
+        return (name[0] == 'a') ? patch_add(patch, path, path_length, shared) : patch_replace(patch, path, path_length, shared);
+    }
+
+    if (from == NULL || (strcmp(name, "move") != 0 && strcmp(name, "copy") != 0))
+        return KI_JSON_ERR_INVALID_PATCH;
+
+    struct ki_json_val* moved = NULL;
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+
+    if (name[0] == 'c')
+    {
+        struct patch_location location;
+        err = patch_locate(patch, from, from_length, false, &location);
+
+        if (err == KI_JSON_ERR_NONE)
+            err = patch_location_copy(patch, &location, &moved);
+    }
+    else
+    {
+        if (from_length == path_length && memcmp(from, path, path_length) == 0)
+            return KI_JSON_ERR_NONE;
+
+        //values can't be moved into themselves
+        if (from_length < path_length && memcmp(from, path, from_length) == 0 && path[from_length] == '/')
+            return KI_JSON_ERR_INVALID_PATCH;
+
+        err = patch_remove(patch, from, from_length, &moved);
+    }
+
+    return (err == KI_JSON_ERR_NONE) ? patch_add(patch, path, path_length, moved) : err;
+}
+
+/* Rolling back */
+
+// Undoes change logged by entry, taking over its value.
+// NOTE: Changes are undone in reverse order, so everything is as it was right after the change.
+static void patch_undo_apply(struct patch* patch, struct patch_undo_entry* entry)
+{
+    //Merge Patch
+    if (entry->object != NULL)
+    {
+        if (entry->type == PATCH_UNDO_REMOVE)
+            ki_json_object_removen(entry->object, entry->path, entry->path_length);
+        else if (ki_json_object_setn(entry->object, entry->path, entry->path_length, entry->value) != KI_JSON_ERR_NONE)
+            ki_json_val_free(entry->value);
+
+        return;
+    }
+
+    struct patch_location location;
+
+    if (patch_locate(patch, entry->path, entry->path_length, true, &location) != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(entry->value);
+        return;
+    }
+
+    if (location.parent == NULL)
+    {
+        ki_json_val_free(*patch->doc);
+        *patch->doc = entry->value;
+        return;
+    }
+
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+
+    if (location.parent->type == KI_JSON_VAL_OBJECT)
+    {
+        if (entry->type == PATCH_UNDO_REMOVE)
+            ki_json_object_removen(&location.parent->value.object, location.name, location.name_length);
+        else
+            err = ki_json_object_setn(&location.parent->value.object, location.name, location.name_length, entry->value);
+    }
+    else
+    {
+        struct ki_json_array* array = &location.parent->value.array;
+
+        //the value added by "-" is the last one
+        if (entry->type == PATCH_UNDO_REMOVE)
+            ki_json_array_remove_at(array, location.end ? array->count - 1 : location.index);
+        else if (entry->type == PATCH_UNDO_ADD)
+            err = ki_json_array_insert(array, entry->value, location.index);
+        else
+            err = ki_json_array_set(array, location.index, entry->value);
+    }
+
+    if (err != KI_JSON_ERR_NONE)
+        ki_json_val_free(entry->value);
+}
+
+// Undoes every logged change, newest first.
+static void patch_rollback(struct patch* patch)
+{
+    //undoing changes isn't logged itself
+    patch->atomic = false;
+
+    while (patch->undo_count > 0)
+        patch_undo_apply(patch, &patch->undo[--patch->undo_count]);
+}
+
+static void patch_init(struct patch* patch, struct ki_json_val** doc, bool atomic)
+{
+    patch->doc = doc;
+    patch->atomic = atomic;
+    patch->undo = NULL;
+    patch->undo_count = 0;
+    patch->undo_capacity = 0;
+    patch->name = NULL;
+    patch->name_capacity = 0;
+    patch->allocator = ki_json_allocator_resolve(NULL);
+}
+
+// Frees everything of patch, rolling back logged changes if err isn't KI_JSON_ERR_NONE.
+// Returns err.
+static enum ki_json_err_type patch_fini(struct patch* patch, enum ki_json_err_type err)
+{
+    if (err != KI_JSON_ERR_NONE)
+        patch_rollback(patch);
+
+    //kept values aren't needed anymore once done
+    for (size_t i = 0; i < patch->undo_count; i++)
+        ki_json_val_free(patch->undo[i].value);
+
+    if (patch->undo != NULL)
+        ki_json_dealloc(patch->allocator, patch->undo, sizeof(*patch->undo) * patch->undo_capacity);
+
+    if (patch->name != NULL)
+        ki_json_dealloc(patch->allocator, patch->name, patch->name_capacity);
+
+    return err;
+}
+
+// Applies JSON Patch patch to *doc, see ki_json_patch_apply().
+static enum ki_json_err_type patch_apply(struct ki_json_val** doc, struct ki_json_val* patch_val, bool atomic)
+{
+    assert(doc && *doc && patch_val);
+
+    if (patch_val->type != KI_JSON_VAL_ARRAY)
+        return KI_JSON_ERR_INVALID_PATCH;
+
+    if (ki_json_val_is_frozen(*doc))
+        return KI_JSON_ERR_INVALID_ARGS;
+
+    struct patch patch;
+    patch_init(&patch, doc, atomic);
+
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+    struct ki_json_array* ops = &patch_val->value.array;
+
+    //operations are json objects, never packed numbers
+    for (size_t i = 0; i < ops->count && err == KI_JSON_ERR_NONE; i++)
+        err = (ops->storage != KI_JSON_ARRAY_STORAGE_NUMBERS) ? patch_apply_op(&patch, ki_json_array_at(ops, i)) : KI_JSON_ERR_INVALID_PATCH;
+
+    return patch_fini(&patch, err);
+}
+
+/* Merging */
+
+// Sets value (taken over) with name of name_length bytes in json object of the document.
+static enum ki_json_err_type merge_set(struct patch* patch, struct ki_json_object* object, const char* name, size_t name_length, struct ki_json_val* value)
+{
+    struct ki_json_val* existing = ki_json_object_getn(object, name, name_length);
+    struct ki_json_val* previous = NULL;
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+
+    if (!patch_undo_reserve(patch) || (existing != NULL && patch->atomic && (previous = ki_json_val_share(existing)) == NULL))
+        err = KI_JSON_ERR_MEMORY;
+
+    if (err == KI_JSON_ERR_NONE)
+        err = ki_json_object_setn(object, name, name_length, value);
+
+    if (err != KI_JSON_ERR_NONE)
+    {
+        ki_json_val_free(previous);
+        ki_json_val_free(value);
+        return err;
+    }
+
+    patch_undo_push(patch, (existing != NULL) ? PATCH_UNDO_REPLACE : PATCH_UNDO_REMOVE, name, name_length, object, previous);
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Removes value with name of name_length bytes from json object of the document, if there is one.
+static enum ki_json_err_type merge_remove(struct patch* patch, struct ki_json_object* object, const char* name, size_t name_length)
+{
+    struct ki_json_val* existing = ki_json_object_getn(object, name, name_length);
+    struct ki_json_val* previous = NULL;
+
+    if (existing == NULL)
+        return KI_JSON_ERR_NONE;
+
+    if (!patch_undo_reserve(patch) || (patch->atomic && (previous = ki_json_val_share(existing)) == NULL))
+        return KI_JSON_ERR_MEMORY;
+
+    ki_json_object_removen(object, name, name_length);
+    patch_undo_push(patch, PATCH_UNDO_ADD, name, name_length, object, previous);
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Merges pair at index of Merge Patch frame into its json object of the document, pushing a frame to merge json objects.
+static enum ki_json_err_type merge_pair(struct patch* patch, struct merge_frame** frames, size_t* count, size_t* capacity, struct merge_frame* inline_frames)
+{
+    struct merge_frame* frame = &(*frames)[*count - 1];
+    struct ki_json_pair* pair = &frame->patch->pairs[frame->next++];
+    struct ki_json_object* target = frame->target;
+
+    if (pair->value->type == KI_JSON_VAL_NULL)
+        return merge_remove(patch, target, pair->name, pair->name_length);
+
+    if (pair->value->type != KI_JSON_VAL_OBJECT)
+    {
+        //values are shared with the patch instead of copied
+        struct ki_json_val* shared = ki_json_val_share(pair->value);
+
+        return (shared != NULL) ? merge_set(patch, target, pair->name, pair->name_length, shared) : KI_JSON_ERR_MEMORY;
+    }
+
+    struct ki_json_val* child = ki_json_object_getn(target, pair->name, pair->name_length);
+
+    if (child != NULL && child->type == KI_JSON_VAL_OBJECT)
+    {
+        child = ki_json_object_getn_mut(target, pair->name, pair->name_length);
+
+        if (child == NULL)
+            return KI_JSON_ERR_MEMORY;
+    }
+    else
+    {
+        //anything else is replaced by the patch merged into an empty json object
+        child = ki_json_val_create_object(pair->value->value.object.count);
+
+        if (child == NULL)
+            return KI_JSON_ERR_MEMORY;
+
+        enum ki_json_err_type err = merge_set(patch, target, pair->name, pair->name_length, child);
+
+        if (err != KI_JSON_ERR_NONE)
+            return err;
+    }
+
+    if (*count == *capacity)
+    {
+        size_t new_capacity = *capacity * 2;
+        struct merge_frame* new_frames = NULL;
+
+        if (*frames == inline_frames)
+        {
+            new_frames = ki_json_alloc(patch->allocator, sizeof(*new_frames) * new_capacity);
+
+            if (new_frames != NULL)
+                memcpy(new_frames, *frames, sizeof(*new_frames) * *count);
+        }
+        else
+        {
+            new_frames = ki_json_realloc(patch->allocator, *frames, sizeof(*new_frames) * *capacity, sizeof(*new_frames) * new_capacity);
+        }
+
+        if (new_frames == NULL)
+            return KI_JSON_ERR_MEMORY;
+
+        *frames = new_frames;
+        *capacity = new_capacity;
+    }
+
+    frame = &(*frames)[(*count)++];
+    frame->target = &child->value.object;
+    frame->patch = &pair->value->value.object;
+    frame->next = 0;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Merges Merge Patch patch into *doc, see ki_json_merge_patch().
+static enum ki_json_err_type merge_apply(struct ki_json_val** doc, struct ki_json_val* patch_val, bool atomic)
+{
+    assert(doc && *doc && patch_val);
+
+    if (ki_json_val_is_frozen(*doc))
+        return KI_JSON_ERR_INVALID_ARGS;
+
+    struct patch patch;
+    patch_init(&patch, doc, atomic);
+
+    //anything but json objects replaces the document
+    if (patch_val->type != KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_val* shared = ki_json_val_share(patch_val);
+
+        return patch_fini(&patch, (shared != NULL) ? patch_add(&patch, "", 0, shared) : KI_JSON_ERR_MEMORY);
+    }
+
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+
+    if ((*doc)->type != KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_val* object = ki_json_val_create_object(patch_val->value.object.count);
+
+        err = (object != NULL) ? patch_add(&patch, "", 0, object) : KI_JSON_ERR_MEMORY;
+    }
+    else if (ki_json_val_is_shared(*doc))
+    {
+        struct ki_json_val* copy = ki_json_val_unshare(*doc);
+
+        if (copy != NULL)
+            *doc = copy;
+        else
+            err = KI_JSON_ERR_MEMORY;
+    }
+
+    struct merge_frame inline_frames[MERGE_STACK_INLINE_SIZE];
+    struct merge_frame* frames = inline_frames;
+    size_t count = 0;
+    size_t capacity = MERGE_STACK_INLINE_SIZE;
+
+    if (err == KI_JSON_ERR_NONE)
+    {
+        frames[0].target = &(*doc)->value.object;
+        frames[0].patch = &patch_val->value.object;
+        frames[0].next = 0;
+        count = 1;
+    }
+
+    while (err == KI_JSON_ERR_NONE && count > 0)
+    {
+        struct merge_frame* frame = &frames[count - 1];
+
+        if (frame->next == frame->patch->count)
+            count--;
+        else
+            err = merge_pair(&patch, &frames, &count, &capacity, inline_frames);
+    }
+
+    if (frames != inline_frames)
+        ki_json_dealloc(patch.allocator, frames, sizeof(*frames) * capacity);
+
+    return patch_fini(&patch, err);
+}
+
+/* Public */
+
+// Returns JSON Patch (RFC 6902) turning json value a into json value b, a json array of "add", "remove" & "replace" operations.
+// Values equal in both (the very same values first of all, see ki_json_val_share()) are skipped without looking into them,
+// values of arrays are matched up by their longest common subsequence after skipping equal values at their start & end.
+// NOTE 1: Values in the patch are shared with b (see ki_json_val_share()), free the patch using ki_json_val_free().
+// NOTE 2: Looking up names may build hash indices of big json objects, like ki_json_object_get() does.
+// Returns NULL on fail.
+struct ki_json_val* ki_json_diff(struct ki_json_val* a, struct ki_json_val* b)
+{
+    assert(a && b);
+
+    struct diff diff;
+    diff.allocator = ki_json_allocator_resolve(NULL);
+    diff.path.chars = NULL;
+    diff.path.length = 0;
+    diff.path.capacity = 0;
+    diff.stack.frames = diff.stack.inline_frames;
+    diff.stack.count = 0;
+    diff.stack.capacity = DIFF_STACK_INLINE_SIZE;
+    diff.patch = ki_json_val_create_array(8);
+
+    if (diff.patch == NULL)
+        return NULL;
+
+    bool success = true;
+
+    switch (diff_vals(&diff, a, b))
+    {
+        case DIFF_RESULT_REPLACE:
+            success = diff_add_op_shared(&diff, "replace", b);
+            break;
+        case DIFF_RESULT_FAIL:
+            success = false;
+            break;
+        default: //DIFF_RESULT_EQUAL, DIFF_RESULT_PUSHED
+            break;
+    }
+
+    while (success && diff.stack.count > 0)
+    {
+        //frames move once the stack grows, only hold on to one until pushing
+        struct diff_frame* frame = &diff.stack.frames[diff.stack.count - 1];
+
+        diff.path.length = frame->path_length;
+
+        if (frame->a->type == KI_JSON_VAL_OBJECT)
+        {
+            if (frame->next < frame->a->value.object.count + frame->b->value.object.count)
+            {
+                success = diff_object_next(&diff, frame);
+                continue;
+            }
+        }
+        else if (frame->next < frame->step_count)
+        {
+            success = diff_array_next(&diff, frame);
+            continue;
+        }
+
+        diff_stack_pop(&diff);
+    }
+
+    while (diff.stack.count > 0)
+        diff_stack_pop(&diff);
+
+    if (diff.stack.frames != diff.stack.inline_frames)
+        ki_json_dealloc(diff.allocator, diff.stack.frames, sizeof(*diff.stack.frames) * diff.stack.capacity);
+
+    if (diff.path.chars != NULL)
+        ki_json_dealloc(diff.allocator, diff.path.chars, diff.path.capacity);
+
+    if (!success)
+    {
+        ki_json_val_free(diff.patch);
+        return NULL;
+    }
+
+    return diff.patch;
+}
+
+// Applies JSON Patch (RFC 6902) patch to json value *doc in place, one operation after another.
+// Only the values on the way to what is changed are looked at, values are shared with the patch instead of copied.
+// NOTE 1: *doc may be replaced, by operations on the root or when it is shared (see ki_json_val_unshare()).
+// NOTE 2: Operations applied before one fails stay applied, see ki_json_patch_apply_atomic().
+// NOTE 3: Frozen values can't be patched (see ki_json_val_freeze()), failing with KI_JSON_ERR_INVALID_ARGS.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_INVALID_PATCH, KI_JSON_ERR_PATH_NOT_FOUND, KI_JSON_ERR_OUT_OF_BOUNDS,
+// KI_JSON_ERR_TEST_FAILED or KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_patch_apply(struct ki_json_val** doc, struct ki_json_val* patch)
+{
+    return patch_apply(doc, patch, false);
+}
+
+// Applies JSON Patch (RFC 6902) patch to json value *doc in place, all operations or none of them, see ki_json_patch_apply().
+// Every change is logged along with what it replaced, undoing them in reverse order on fail.
+// NOTE: Values removed & added back on fail end up last in their json objects.
+enum ki_json_err_type ki_json_patch_apply_atomic(struct ki_json_val** doc, struct ki_json_val* patch)
+{
+    return patch_apply(doc, patch, true);
+}
+
+// Merges JSON Merge Patch (RFC 7386) patch into json value *doc in place:
+// json objects are merged name by name, null removes the value of a name & anything else replaces what is there.
+// NOTE 1: *doc may be replaced, by patches that aren't json objects or when it is shared (see ki_json_val_unshare()).
+// NOTE 2: Values merged before failing stay merged, see ki_json_merge_patch_atomic().
+// NOTE 3: Frozen values can't be patched (see ki_json_val_freeze()), failing with KI_JSON_ERR_INVALID_ARGS.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_merge_patch(struct ki_json_val** doc, struct ki_json_val* patch)
+{
+    return merge_apply(doc, patch, false);
+}
+
+// Merges JSON Merge Patch (RFC 7386) patch into json value *doc in place, completely or not at all, see ki_json_merge_patch().
+// NOTE: Values removed & added back on fail end up last in their json objects.
+enum ki_json_err_type ki_json_merge_patch_atomic(struct ki_json_val** doc, struct ki_json_val* patch)
+{
+    return merge_apply(doc, patch, true);
+}
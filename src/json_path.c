@@ -0,0 +1,2211 @@
+#include "ki_json/json_path.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ki_json/json.h"
+#include "ki_json/json_parser.h"
+#include "json/json_internal.h"
+
+// Most segments of paths run on json text, the segments values matched are kept as bits of a uint64_t
+#define PATH_STREAM_MAX_SEGMENTS 63
+// Amount of nodes, filter values & containers kept inline while running a path before allocating
+#define PATH_INLINE_COUNT 32
+// Bounds of indices & slices, integers doubles represent exactly (I-JSON)
+#define PATH_INT_MAX INT64_C(9007199254740991)
+
+enum path_op_type
+{
+    // Segments, followed by their selectors
+    PATH_OP_CHILD,
+    PATH_OP_DESCENDANT,
+    // Selectors, names & indices are also the steps of singular queries in filters
+    PATH_OP_NAME,
+    PATH_OP_WILDCARD,
+    PATH_OP_INDEX,
+    PATH_OP_SLICE,
+    // Filter selector, followed by its logical expression in postfix order
+    PATH_OP_FILTER,
+    // Filter expressions, run on a stack of values
+    PATH_OP_LITERAL, //pushes literal
+    PATH_OP_QUERY, //pushes value singular query refers to (NULL if none), followed by its steps
+    PATH_OP_EXISTS, //whether there is a value
+    PATH_OP_EQ,
+    PATH_OP_NE,
+    PATH_OP_LT,
+    PATH_OP_LE,
+    PATH_OP_GT,
+    PATH_OP_GE,
+    PATH_OP_NOT,
+    PATH_OP_AND,
+    PATH_OP_OR,
+    // Opening parenthesis, only ever on the compiler's stack of operators
+    PATH_OP_PAREN
+};
+
+struct path_op
+{
+    enum path_op_type type;
+    // Amount of ops following this one that belong to it: selectors of segments, expressions of filters & steps of queries
+    size_t length;
+    union
+    {
+        // PATH_OP_NAME, name is at offset in the path's names, null-terminated
+        struct
+        {
+            size_t offset;
+            size_t length;
+            // Hash of name, see ki_json_hash_bytes()
+            size_t hash;
+        } name;
+        // PATH_OP_INDEX, counting from the end if negative
+        int64_t index;
+        // PATH_OP_SLICE
+        struct
+        {
+            int64_t start;
+            int64_t end;
+            int64_t step;
+            bool has_start;
+            bool has_end;
+        } slice;
+        // PATH_OP_FILTER, most values on its stack at once
+        size_t depth;
+        // PATH_OP_LITERAL
+        struct ki_json_val* literal;
+        // PATH_OP_QUERY, whether it starts at the root ($) instead of the current node (@)
+        bool absolute;
+        // PATH_OP_CHILD & PATH_OP_DESCENDANT, whether selectors need the amount of values of json arrays (negative indices)
+        bool needs_count;
+    } arg;
+};
+
+// Compiled JSONPath query, a single allocation holding its ops, followed by the index of the op of each segment,
+// followed by names.
+struct ki_json_path
+{
+    const struct ki_json_allocator* allocator;
+    // Size of the allocation in bytes
+    size_t size;
+    size_t op_count;
+    size_t segment_count;
+    // Most values on the stack of any filter
+    size_t filter_depth;
+    // Whether filters have queries starting at the root ($)
+    bool absolute_filters;
+    struct path_op ops[];
+};
+
+// Returns indices of the ops of path's segments.
+static const size_t* path_segments(const struct ki_json_path* path)
+{
+    return (const size_t*)&path->ops[path->op_count];
+}
+
+// Returns name of name selector op of path.
+static const char* path_name(const struct ki_json_path* path, const struct path_op* op)
+{
+    return (const char*)&path_segments(path)[path->segment_count] + op->arg.name.offset;
+}
+
+/* Compiling */
+
+struct path_compiler
+{
+    const char* path;
+    size_t length;
+    // Offset of the next byte to compile
+    size_t offset;
+    const struct ki_json_allocator* allocator;
+
+    struct path_op* ops;
+    size_t op_count;
+    size_t op_capacity;
+
+    // Names of name selectors, null-terminated one after another, also used as scratch space
+    char* names;
+    size_t names_used;
+    size_t names_size;
+
+    // Operators of the filter being compiled that aren't emitted yet, innermost last
+    enum path_op_type* operators;
+    size_t operator_count;
+    size_t operator_capacity;
+
+    size_t segment_count;
+    // Amount of values on the stack of the filter being compiled & most values there were on it so far
+    size_t filter_height;
+    size_t filter_depth;
+    bool absolute_filters;
+};
+
+static void compiler_init(struct path_compiler* compiler, const char* path, size_t length)
+{
+    memset(compiler, 0, sizeof(*compiler));
+
+    compiler->path = path;
+    compiler->length = length;
+    compiler->allocator = ki_json_allocator_resolve(NULL);
+}
+
+// Frees everything compiler holds, along with literals of ops not handed over to a path.
+static void compiler_fini(struct path_compiler* compiler)
+{
+    for (size_t i = 0; i < compiler->op_count; i++)
+    {
+        if (compiler->ops[i].type == PATH_OP_LITERAL)
+            ki_json_val_free(compiler->ops[i].arg.literal);
+    }
+
+    ki_json_dealloc(compiler->allocator, compiler->ops, sizeof(*compiler->ops) * compiler->op_capacity);
+    ki_json_dealloc(compiler->allocator, compiler->names, compiler->names_size);
+    ki_json_dealloc(compiler->allocator, compiler->operators, sizeof(*compiler->operators) * compiler->operator_capacity);
+}
+
+// Returns character pos bytes after the compiler's offset, '\0' past the end of the path.
+static char compiler_peek(const struct path_compiler* compiler, size_t pos)
+{
+    if (compiler->offset + pos >= compiler->length)
+        return '\0';
+
+    return compiler->path[compiler->offset + pos];
+}
+
+// Skips blanks (spaces, horizontal tabs, line feeds & carriage returns).
+// Returns whether there were any.
+static bool compiler_skip_blank(struct path_compiler* compiler)
+{
+    size_t start = compiler->offset;
+
+    while (compiler->offset < compiler->length && (compiler->path[compiler->offset] == ' ' || compiler->path[compiler->offset] == '\t'
+           || compiler->path[compiler->offset] == '\n' || compiler->path[compiler->offset] == '\r'))
+        compiler->offset++;
+
+    return compiler->offset != start;
+}
+
+// Adds zeroed op of given type.
+// NOTE: Ops move once more are added, only hold on to the op until then.
+// Returns NULL on fail.
+static struct path_op* compiler_emit(struct path_compiler* compiler, enum path_op_type type)
+{
+    if (compiler->op_count == compiler->op_capacity)
+    {
+        size_t new_capacity = (compiler->op_capacity > 0) ? compiler->op_capacity * 2 : 16;
+        struct path_op* new_ops = ki_json_realloc(compiler->allocator, compiler->ops, sizeof(*new_ops) * compiler->op_capacity, sizeof(*new_ops) * new_capacity);
+
+        if (new_ops == NULL)
+            return NULL;
+
+        compiler->ops = new_ops;
+        compiler->op_capacity = new_capacity;
+    }
+
+    struct path_op* op = &compiler->ops[compiler->op_count++];
+
+    memset(op, 0, sizeof(*op));
+    op->type = type;
+
+    return op;
+}
+
+// Adds op of filter expression, keeping track of how many values are on the filter's stack.
+// Returns NULL on fail.
+static struct path_op* compiler_emit_expression(struct path_compiler* compiler, enum path_op_type type)
+{
+    switch (type)
+    {
+        case PATH_OP_LITERAL:
+        case PATH_OP_QUERY:
+            compiler->filter_height++;
+            break;
+        case PATH_OP_EXISTS:
+        case PATH_OP_NOT:
+            break;
+        default: //binary operators
+            compiler->filter_height--;
+            break;
+    }
+
+    if (compiler->filter_height > compiler->filter_depth)
+        compiler->filter_depth = compiler->filter_height;
+
+    return compiler_emit(compiler, type);
+}
+
+// Ensures names have room for size more bytes after the used ones.
+// Returns pointer to the first unused byte, NULL on fail.
+static char* compiler_reserve_names(struct path_compiler* compiler, size_t size)
+{
+    if (compiler->names_size - compiler->names_used >= size)
+        return compiler->names + compiler->names_used;
+
+    size_t new_size = (compiler->names_size > 0) ? compiler->names_size : 64;
+
+    while (new_size - compiler->names_used < size)
+        new_size *= 2;
+
+    char* new_names = ki_json_realloc(compiler->allocator, compiler->names, compiler->names_size, new_size);
+
+    if (new_names == NULL)
+        return NULL;
+
+    compiler->names = new_names;
+    compiler->names_size = new_size;
+
+    return compiler->names + compiler->names_used;
+}
+
+// Whether character may start a member name shorthand (.name), any byte of a multibyte utf8 character included.
+static bool char_is_name_first(char character)
+{
+    return (character >= 'a' && character <= 'z') || (character >= 'A' && character <= 'Z') || character == '_' || (unsigned char)character >= 0x80;
+}
+
+// Whether character may be part of a member name shorthand (.name).
+static bool char_is_name_char(char character)
+{
+    return char_is_name_first(character) || (character >= '0' && character <= '9');
+}
+
+static bool char_is_digit(char character)
+{
+    return character >= '0' && character <= '9';
+}
+
+// Reads 4 hex digits at the compiler's offset into value.
+// Returns true on success, false on fail.
+static bool compile_hex4(struct path_compiler* compiler, uint32_t* value)
+{
+    *value = 0;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        char character = compiler_peek(compiler, i);
+        uint32_t digit = 0;
+
+        if (character >= '0' && character <= '9')
+            digit = (uint32_t)(character - '0');
+        else if (character >= 'a' && character <= 'f')
+            digit = (uint32_t)(character - 'a' + 10);
+        else if (character >= 'A' && character <= 'F')
+            digit = (uint32_t)(character - 'A' + 10);
+        else
+            return false;
+
+        *value = *value * 16 + digit;
+    }
+
+    compiler->offset += 4;
+
+    return true;
+}
+
+// Decodes unicode escape sequence after its "\u" (a surrogate pair takes two) into utf8 bytes at out.
+// Returns amount of bytes on success, 0 on fail.
+static size_t compile_unicode(struct path_compiler* compiler, char* out)
+{
+    uint32_t codepoint = 0;
+
+    if (!compile_hex4(compiler, &codepoint) || (codepoint >= 0xDC00 && codepoint <= 0xDFFF))
+        return 0;
+
+    if (codepoint >= 0xD800 && codepoint <= 0xDBFF)
+    {
+        uint32_t low = 0;
+
+        if (compiler_peek(compiler, 0) != '\\' || compiler_peek(compiler, 1) != 'u')
+            return 0;
+
+        compiler->offset += 2;
+
+        if (!compile_hex4(compiler, &low) || low < 0xDC00 || low > 0xDFFF)
+            return 0;
+
+        codepoint = (codepoint - 0xD800) * 0x400 + (low - 0xDC00) + 0x10000;
+    }
+
+    if (codepoint < 0x80)
+    {
+        out[0] = (char)codepoint;
+        return 1;
+    }
+
+    if (codepoint < 0x800)
+    {
+        out[0] = (char)(0xC0 | (codepoint >> 6));
+        out[1] = (char)(0x80 | (codepoint & 0x3F));
+        return 2;
+    }
+
+    if (codepoint < 0x10000)
+    {
+        out[0] = (char)(0xE0 | (codepoint >> 12));
+        out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (codepoint & 0x3F));
+        return 3;
+    }
+
+    out[0] = (char)(0xF0 | (codepoint >> 18));
+    out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (codepoint & 0x3F));
+    return 4;
+}
+
+// Decodes single- or double-quoted string literal at the compiler's offset into names, null-terminating it.
+// Outs offset of the string in names & its length, names_used isn't moved past it.
+// Returns true on success, false on fail.
+static bool compile_string(struct path_compiler* compiler, size_t* offset, size_t* length)
+{
+    char quote = compiler->path[compiler->offset++];
+
+    //decoded string is never longer than the rest of the path
+    char* out = compiler_reserve_names(compiler, compiler->length - compiler->offset + 1);
+
+    if (out == NULL)
+        return false;
+
+    size_t out_length = 0;
+
+    while (true)
+    {
+        if (compiler->offset >= compiler->length)
+            return false;
+
+        char character = compiler->path[compiler->offset++];
+
+        if (character == quote)
+            break;
+
+        //control characters must be escaped
+        if ((unsigned char)character < 0x20)
+            return false;
+
+        if (character != '\\')
+        {
+            out[out_length++] = character;
+            continue;
+        }
+
+        character = compiler_peek(compiler, 0);
+        compiler->offset++;
+
+        switch (character)
+        {
+            case 'b': out[out_length++] = '\b'; break;
+            case 'f': out[out_length++] = '\f'; break;
+            case 'n': out[out_length++] = '\n'; break;
+            case 'r': out[out_length++] = '\r'; break;
+            case 't': out[out_length++] = '\t'; break;
+            case '/': out[out_length++] = '/'; break;
+            case '\\': out[out_length++] = '\\'; break;
+            case 'u':
+            {
+                size_t count = compile_unicode(compiler, out + out_length);
+
+                if (count == 0)
+                    return false;
+
+                out_length += count;
+                break;
+            }
+            default:
+                //only the quote the string is in may be escaped
+                if (character != quote)
+                    return false;
+
+                out[out_length++] = quote;
+                break;
+        }
+    }
+
+    out[out_length] = '\0';
+
+    *offset = compiler->names_used;
+    *length = out_length;
+
+    return true;
+}
+
+// Copies member name shorthand (.name) at the compiler's offset into names, see compile_string().
+// Returns true on success, false on fail.
+static bool compile_shorthand(struct path_compiler* compiler, size_t* offset, size_t* length)
+{
+    if (!char_is_name_first(compiler_peek(compiler, 0)))
+        return false;
+
+    size_t start = compiler->offset;
+
+    while (char_is_name_char(compiler_peek(compiler, 0)))
+        compiler->offset++;
+
+    size_t name_length = compiler->offset - start;
+    char* out = compiler_reserve_names(compiler, name_length + 1);
+
+    if (out == NULL)
+        return false;
+
+    memcpy(out, compiler->path + start, name_length);
+    out[name_length] = '\0';
+
+    *offset = compiler->names_used;
+    *length = name_length;
+
+    return true;
+}
+
+// Adds name selector for the name compiled into names at offset.
+// Returns true on success, false on fail.
+static bool compile_name(struct path_compiler* compiler, size_t offset, size_t length)
+{
+    struct path_op* op = compiler_emit(compiler, PATH_OP_NAME);
+
+    if (op == NULL)
+        return false;
+
+    op->arg.name.offset = offset;
+    op->arg.name.length = length;
+    op->arg.name.hash = ki_json_hash_bytes(compiler->names + offset, length);
+
+    compiler->names_used += length + 1;
+
+    return true;
+}
+
+// Reads integer at the compiler's offset, without leading zeros & within PATH_INT_MAX.
+// Returns true on success, false on fail.
+static bool compile_int(struct path_compiler* compiler, int64_t* value)
+{
+    bool negative = (compiler_peek(compiler, 0) == '-');
+
+    if (negative)
+        compiler->offset++;
+
+    if (!char_is_digit(compiler_peek(compiler, 0)))
+        return false;
+
+    //"-0" & leading zeros aren't integers
+    if (compiler_peek(compiler, 0) == '0')
+    {
+        compiler->offset++;
+        *value = 0;
+
+        return !negative && !char_is_digit(compiler_peek(compiler, 0));
+    }
+
+    int64_t result = 0;
+
+    while (char_is_digit(compiler_peek(compiler, 0)))
+    {
+        result = result * 10 + (compiler_peek(compiler, 0) - '0');
+        compiler->offset++;
+
+        if (result > PATH_INT_MAX)
+            return false;
+    }
+
+    *value = negative ? -result : result;
+
+    return true;
+}
+
+// Adds literal value, taking it over.
+// Returns true on success, false on fail (value is freed).
+static bool compile_literal(struct path_compiler* compiler, struct ki_json_val* value)
+{
+    if (value == NULL)
+        return false;
+
+    struct path_op* op = compiler_emit_expression(compiler, PATH_OP_LITERAL);
+
+    if (op == NULL)
+    {
+        ki_json_val_free(value);
+        return false;
+    }
+
+    op->arg.literal = value;
+
+    return true;
+}
+
+// Compiles number literal at the compiler's offset.
+// Returns true on success, false on fail.
+static bool compile_number(struct path_compiler* compiler)
+{
+    size_t start = compiler->offset;
+
+    //"-0" is a number, though it's no integer
+    if (compiler_peek(compiler, 0) == '-')
+        compiler->offset++;
+
+    if (compiler_peek(compiler, 0) == '0')
+    {
+        compiler->offset++;
+    }
+    else
+    {
+        if (!char_is_digit(compiler_peek(compiler, 0)))
+            return false;
+
+        while (char_is_digit(compiler_peek(compiler, 0)))
+            compiler->offset++;
+    }
+
+    if (compiler_peek(compiler, 0) == '.')
+    {
+        compiler->offset++;
+
+        if (!char_is_digit(compiler_peek(compiler, 0)))
+            return false;
+
+        while (char_is_digit(compiler_peek(compiler, 0)))
+            compiler->offset++;
+    }
+
+    if (compiler_peek(compiler, 0) == 'e' || compiler_peek(compiler, 0) == 'E')
+    {
+        compiler->offset++;
+
+        if (compiler_peek(compiler, 0) == '+' || compiler_peek(compiler, 0) == '-')
+            compiler->offset++;
+
+        if (!char_is_digit(compiler_peek(compiler, 0)))
+            return false;
+
+        while (char_is_digit(compiler_peek(compiler, 0)))
+            compiler->offset++;
+    }
+
+    //path doesn't have to be null-terminated, so copy number over to names for strtod()
+    size_t length = compiler->offset - start;
+    char* copy = compiler_reserve_names(compiler, length + 1);
+
+    if (copy == NULL)
+        return false;
+
+    memcpy(copy, compiler->path + start, length);
+    copy[length] = '\0';
+
+    return compile_literal(compiler, ki_json_val_create_from_number(strtod(copy, NULL)));
+}
+
+// Whether keyword is at the compiler's offset, not followed by any more characters of a name.
+static bool compiler_has_keyword(const struct path_compiler* compiler, const char* keyword)
+{
+    size_t length = strlen(keyword);
+
+    return compiler->length - compiler->offset >= length && memcmp(compiler->path + compiler->offset, keyword, length) == 0
+        && !char_is_name_char(compiler_peek(compiler, length));
+}
+
+// Compiles singular query of a filter at the compiler's offset ("@" or "$", followed by names & indices only).
+// Returns true on success, false on fail (queries selecting more than one value aren't supported).
+static bool compile_singular_query(struct path_compiler* compiler)
+{
+    bool absolute = (compiler->path[compiler->offset++] == '$');
+    size_t query = compiler->op_count;
+    struct path_op* op = compiler_emit_expression(compiler, PATH_OP_QUERY);
+
+    if (op == NULL)
+        return false;
+
+    op->arg.absolute = absolute;
+    compiler->absolute_filters |= absolute;
+
+    while (true)
+    {
+        size_t before = compiler->offset;
+        size_t offset = 0;
+        size_t length = 0;
+
+        compiler_skip_blank(compiler);
+
+        if (compiler_peek(compiler, 0) == '.')
+        {
+            compiler->offset++;
+
+            //wildcards & descendants select any amount of values
+            if (!compile_shorthand(compiler, &offset, &length) || !compile_name(compiler, offset, length))
+                return false;
+
+            continue;
+        }
+
+        if (compiler_peek(compiler, 0) != '[')
+        {
+            compiler->offset = before;
+            break;
+        }
+
+        compiler->offset++;
+        compiler_skip_blank(compiler);
+
+        char character = compiler_peek(compiler, 0);
+
+        if (character == '\'' || character == '\"')
+        {
+            if (!compile_string(compiler, &offset, &length) || !compile_name(compiler, offset, length))
+                return false;
+        }
+        else
+        {
+            int64_t index = 0;
+
+            if (!compile_int(compiler, &index) || (op = compiler_emit(compiler, PATH_OP_INDEX)) == NULL)
+                return false;
+
+            op->arg.index = index;
+        }
+
+        compiler_skip_blank(compiler);
+
+        //slices & unions select any amount of values
+        if (compiler_peek(compiler, 0) != ']')
+            return false;
+
+        compiler->offset++;
+    }
+
+    compiler->ops[query].length = compiler->op_count - query - 1;
+
+    return true;
+}
+
+// Compiles comparable (literal or singular query) or test at the compiler's offset, outs whether it is a query.
+// Returns true on success, false on fail.
+static bool compile_operand(struct path_compiler* compiler, bool* is_query)
+{
+    char character = compiler_peek(compiler, 0);
+
+    *is_query = (character == '@' || character == '$');
+
+    if (*is_query)
+        return compile_singular_query(compiler);
+
+    if (character == '\'' || character == '\"')
+    {
+        size_t offset = 0;
+        size_t length = 0;
+
+        //names only hold the string until it's copied
+        return compile_string(compiler, &offset, &length) && compile_literal(compiler, ki_json_val_create_from_stringn(compiler->names + offset, length));
+    }
+
+    if (character == '-' || char_is_digit(character))
+        return compile_number(compiler);
+
+    if (compiler_has_keyword(compiler, "true") || compiler_has_keyword(compiler, "false"))
+    {
+        bool boolean = (character == 't');
+        compiler->offset += boolean ? 4 : 5;
+
+        return compile_literal(compiler, ki_json_val_create_from_bool(boolean));
+    }
+
+    if (compiler_has_keyword(compiler, "null"))
+    {
+        compiler->offset += 4;
+
+        return compile_literal(compiler, ki_json_val_create_null());
+    }
+
+    //function extensions aren't supported
+    return false;
+}
+
+// Reads comparison operator at the compiler's offset, outs its op type.
+// Returns true if there is one, false otherwise.
+static bool compile_comparison(struct path_compiler* compiler, enum path_op_type* type)
+{
+    char first = compiler_peek(compiler, 0);
+    bool equals = (compiler_peek(compiler, 1) == '=');
+
+    if (first == '=' && equals)
+        *type = PATH_OP_EQ;
+    else if (first == '!' && equals)
+        *type = PATH_OP_NE;
+    else if (first == '<')
+        *type = equals ? PATH_OP_LE : PATH_OP_LT;
+    else if (first == '>')
+        *type = equals ? PATH_OP_GE : PATH_OP_GT;
+    else
+        return false;
+
+    compiler->offset += (equals ? 2 : 1);
+
+    return true;
+}
+
+// Returns how tightly logical operator binds, higher binding tighter.
+static int operator_precedence(enum path_op_type type)
+{
+    switch (type)
+    {
+        case PATH_OP_NOT:
+            return 3;
+        case PATH_OP_AND:
+            return 2;
+        case PATH_OP_OR:
+            return 1;
+        default: //PATH_OP_PAREN
+            return 0;
+    }
+}
+
+// Pushes logical operator or parenthesis onto the compiler's stack of operators.
+// Returns true on success, false on fail.
+static bool compiler_push_operator(struct path_compiler* compiler, enum path_op_type type)
+{
+    if (compiler->operator_count == compiler->operator_capacity)
+    {
+        size_t new_capacity = (compiler->operator_capacity > 0) ? compiler->operator_capacity * 2 : 16;
+        enum path_op_type* new_operators = ki_json_realloc(compiler->allocator, compiler->operators, sizeof(*new_operators) * compiler->operator_capacity, sizeof(*new_operators) * new_capacity);
+
+        if (new_operators == NULL)
+            return false;
+
+        compiler->operators = new_operators;
+        compiler->operator_capacity = new_capacity;
+    }
+
+    compiler->operators[compiler->operator_count++] = type;
+
+    return true;
+}
+
+// Emits operators on top of the compiler's stack binding at least as tightly as type, up to the innermost parenthesis.
+// Returns true on success, false on fail.
+static bool compiler_pop_operators(struct path_compiler* compiler, enum path_op_type type)
+{
+    while (compiler->operator_count > 0)
+    {
+        enum path_op_type top = compiler->operators[compiler->operator_count - 1];
+
+        if (top == PATH_OP_PAREN || operator_precedence(top) < operator_precedence(type))
+            break;
+
+        compiler->operator_count--;
+
+        if (compiler_emit_expression(compiler, top) == NULL)
+            return false;
+    }
+
+    return true;
+}
+
+// Compiles filter selector after its "?" into postfix order (shunting-yard), so running it needs no recursion.
+// Returns true on success, false on fail.
+static bool compile_filter(struct path_compiler* compiler)
+{
+    size_t filter = compiler->op_count;
+
+    if (compiler_emit(compiler, PATH_OP_FILTER) == NULL)
+        return false;
+
+    compiler->operator_count = 0;
+    compiler->filter_height = 0;
+
+    size_t filter_depth = compiler->filter_depth;
+    compiler->filter_depth = 0;
+
+    //whether next token should be an operand, instead of a binary operator or the end of a parenthesis
+    bool expect_operand = true;
+
+    while (true)
+    {
+        compiler_skip_blank(compiler);
+
+        char character = compiler_peek(compiler, 0);
+
+        if (expect_operand)
+        {
+            if (character == '!' || character == '(')
+            {
+                compiler->offset++;
+
+                if (!compiler_push_operator(compiler, (character == '!') ? PATH_OP_NOT : PATH_OP_PAREN))
+                    return false;
+
+                continue;
+            }
+
+            //only parentheses & tests can be negated
+            bool negated = (compiler->operator_count > 0 && compiler->operators[compiler->operator_count - 1] == PATH_OP_NOT);
+            bool is_query = false;
+            enum path_op_type comparison = PATH_OP_EQ;
+
+            if (!compile_operand(compiler, &is_query))
+                return false;
+
+            compiler_skip_blank(compiler);
+
+            if (compile_comparison(compiler, &comparison))
+            {
+                compiler_skip_blank(compiler);
+
+                if (negated || !compile_operand(compiler, &is_query) || compiler_emit_expression(compiler, comparison) == NULL)
+                    return false;
+            }
+            else if (!is_query || compiler_emit_expression(compiler, PATH_OP_EXISTS) == NULL)
+            {
+                //literals on their own are no tests
+                return false;
+            }
+
+            if (!compiler_pop_operators(compiler, PATH_OP_NOT))
+                return false;
+
+            expect_operand = false;
+        }
+        else if ((character == '&' || character == '|') && compiler_peek(compiler, 1) == character)
+        {
+            enum path_op_type type = (character == '&') ? PATH_OP_AND : PATH_OP_OR;
+            compiler->offset += 2;
+
+            if (!compiler_pop_operators(compiler, type) || !compiler_push_operator(compiler, type))
+                return false;
+
+            expect_operand = true;
+        }
+        else if (character == ')')
+        {
+            compiler->offset++;
+
+            if (!compiler_pop_operators(compiler, PATH_OP_OR) || compiler->operator_count == 0)
+                return false;
+
+            //parenthesis closed counts as a single operand
+            compiler->operator_count--;
+
+            if (!compiler_pop_operators(compiler, PATH_OP_NOT))
+                return false;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    if (!compiler_pop_operators(compiler, PATH_OP_OR) || compiler->operator_count > 0)
+        return false;
+
+    compiler->ops[filter].length = compiler->op_count - filter - 1;
+    compiler->ops[filter].arg.depth = compiler->filter_depth;
+
+    if (compiler->filter_depth < filter_depth)
+        compiler->filter_depth = filter_depth;
+
+    return true;
+}
+
+// Compiles selector inside of brackets at the compiler's offset.
+// Returns true on success, false on fail.
+static bool compile_selector(struct path_compiler* compiler)
+{
+    char character = compiler_peek(compiler, 0);
+
+    if (character == '\'' || character == '\"')
+    {
+        size_t offset = 0;
+        size_t length = 0;
+
+        return compile_string(compiler, &offset, &length) && compile_name(compiler, offset, length);
+    }
+
+    if (character == '*')
+    {
+        compiler->offset++;
+
+        return compiler_emit(compiler, PATH_OP_WILDCARD) != NULL;
+    }
+
+    if (character == '?')
+    {
+        compiler->offset++;
+        compiler_skip_blank(compiler);
+
+        return compile_filter(compiler);
+    }
+
+    if (character != '-' && character != ':' && !char_is_digit(character))
+        return false;
+
+    int64_t start = 0;
+    bool has_start = (character != ':');
+
+    if (has_start && !compile_int(compiler, &start))
+        return false;
+
+    compiler_skip_blank(compiler);
+
+    if (compiler_peek(compiler, 0) != ':')
+    {
+        struct path_op* op = compiler_emit(compiler, PATH_OP_INDEX);
+
+        if (op == NULL)
+            return false;
+
+        op->arg.index = start;
+        return true;
+    }
+
+    compiler->offset++;
+    compiler_skip_blank(compiler);
+
+    int64_t end = 0;
+    int64_t step = 1;
+    bool has_end = (compiler_peek(compiler, 0) == '-' || char_is_digit(compiler_peek(compiler, 0)));
+
+    if (has_end && !compile_int(compiler, &end))
+        return false;
+
+    compiler_skip_blank(compiler);
+
+    if (compiler_peek(compiler, 0) == ':')
+    {
+        compiler->offset++;
+        compiler_skip_blank(compiler);
+
+        character = compiler_peek(compiler, 0);
+
+        if ((character == '-' || char_is_digit(character)) && !compile_int(compiler, &step))
+            return false;
+    }
+
+    struct path_op* op = compiler_emit(compiler, PATH_OP_SLICE);
+
+    if (op == NULL)
+        return false;
+
+    op->arg.slice.start = start;
+    op->arg.slice.end = end;
+    op->arg.slice.step = step;
+    op->arg.slice.has_start = has_start;
+    op->arg.slice.has_end = has_end;
+
+    return true;
+}
+
+// Compiles selectors in brackets at the compiler's offset, separated by commas.
+// Returns true on success, false on fail.
+static bool compile_bracketed(struct path_compiler* compiler)
+{
+    compiler->offset++; //skip [
+
+    while (true)
+    {
+        compiler_skip_blank(compiler);
+
+        if (!compile_selector(compiler))
+            return false;
+
+        compiler_skip_blank(compiler);
+
+        char character = compiler_peek(compiler, 0);
+        compiler->offset++;
+
+        if (character == ']')
+            return true;
+
+        if (character != ',')
+            return false;
+    }
+}
+
+// Whether selectors of segment op need the amount of values of json arrays to select from them.
+static bool segment_needs_count(const struct path_op* segment)
+{
+    for (size_t i = 1; i <= segment->length; i += 1 + segment[i].length)
+    {
+        const struct path_op* op = &segment[i];
+
+        if (op->type == PATH_OP_INDEX && op->arg.index < 0)
+            return true;
+
+        if (op->type == PATH_OP_SLICE && (op->arg.slice.step < 0 || (op->arg.slice.has_start && op->arg.slice.start < 0)
+            || (op->arg.slice.has_end && op->arg.slice.end < 0)))
+            return true;
+    }
+
+    return false;
+}
+
+// Compiles child or descendant segment at the compiler's offset.
+// Returns true on success, false on fail.
+static bool compile_segment(struct path_compiler* compiler)
+{
+    size_t segment = compiler->op_count;
+    bool descendant = (compiler_peek(compiler, 0) == '.' && compiler_peek(compiler, 1) == '.');
+
+    if (compiler_emit(compiler, descendant ? PATH_OP_DESCENDANT : PATH_OP_CHILD) == NULL)
+        return false;
+
+    bool compiled = false;
+
+    if (compiler_peek(compiler, 0) == '.')
+    {
+        compiler->offset += descendant ? 2 : 1;
+
+        size_t offset = 0;
+        size_t length = 0;
+
+        if (descendant && compiler_peek(compiler, 0) == '[')
+        {
+            compiled = compile_bracketed(compiler);
+        }
+        else if (compiler_peek(compiler, 0) == '*')
+        {
+            compiler->offset++;
+            compiled = (compiler_emit(compiler, PATH_OP_WILDCARD) != NULL);
+        }
+        else
+        {
+            compiled = compile_shorthand(compiler, &offset, &length) && compile_name(compiler, offset, length);
+        }
+    }
+    else if (compiler_peek(compiler, 0) == '[')
+    {
+        compiled = compile_bracketed(compiler);
+    }
+
+    if (!compiled)
+        return false;
+
+    struct path_op* op = &compiler->ops[segment];
+    op->length = compiler->op_count - segment - 1;
+    op->arg.needs_count = segment_needs_count(op);
+
+    compiler->segment_count++;
+
+    return true;
+}
+
+// Compiles the whole path, "$" followed by segments.
+// Returns true on success, false on fail.
+static bool compile_query(struct path_compiler* compiler)
+{
+    if (compiler_peek(compiler, 0) != '$')
+        return false;
+
+    compiler->offset++;
+
+    while (true)
+    {
+        //blanks may only separate segments
+        bool blank = compiler_skip_blank(compiler);
+
+        if (compiler->offset == compiler->length)
+            return !blank;
+
+        if (!compile_segment(compiler))
+            return false;
+    }
+}
+
+/* Running */
+
+// Value on the stack of a filter, a json value (NULL if there is none) or a boolean.
+struct path_value
+{
+    struct ki_json_val* val;
+    // Whether val was parsed from json text for the filter, so it's freed once used
+    bool owned;
+    bool truth;
+};
+
+// List of values selected by a segment.
+struct path_list
+{
+    struct ki_json_val** nodes;
+    // Amount of values selected, may be more than capacity for bounded lists
+    size_t count;
+    size_t capacity;
+    // Whether nodes are the caller's results, which never grow & keep only the first capacity values
+    bool bounded;
+    struct ki_json_val* inline_nodes[PATH_INLINE_COUNT];
+};
+
+struct path_query
+{
+    const struct ki_json_path* path;
+    // Root of the json tree, NULL when running filters on json text
+    struct ki_json_val* root;
+    // Json text starting with the value filters are run on, when there is no json tree.
+    // Values queries of filters refer to are found by reading it with scanner & parsed one at a time using parser.
+    const char* json;
+    size_t length;
+    struct ki_json_scanner* scanner;
+    struct ki_json_parser* parser;
+    // Error reading json text failed with
+    enum ki_json_err_type err;
+    // Stack of filters, with room for the values of any filter of path
+    struct path_value* stack;
+    // Values left to look into by descendant segments, last one first
+    struct ki_json_val** descendants;
+    size_t descendant_count;
+    size_t descendant_capacity;
+    struct path_value inline_stack[PATH_INLINE_COUNT];
+    struct ki_json_val* inline_descendants[PATH_INLINE_COUNT];
+};
+
+static void path_list_init(struct path_list* list)
+{
+    list->nodes = list->inline_nodes;
+    list->count = 0;
+    list->capacity = PATH_INLINE_COUNT;
+    list->bounded = false;
+}
+
+static void path_list_fini(struct path_list* list, const struct ki_json_allocator* allocator)
+{
+    if (list->nodes != list->inline_nodes && !list->bounded)
+        ki_json_dealloc(allocator, list->nodes, sizeof(*list->nodes) * list->capacity);
+}
+
+// Adds value to list, growing it if it isn't bounded.
+// Returns true on success, false on fail.
+static bool path_list_add(struct path_list* list, const struct ki_json_allocator* allocator, struct ki_json_val* val)
+{
+    if (list->count < list->capacity)
+    {
+        list->nodes[list->count++] = val;
+        return true;
+    }
+
+    if (list->bounded)
+    {
+        list->count++;
+        return true;
+    }
+
+    size_t new_capacity = list->capacity * 2;
+    struct ki_json_val** new_nodes = NULL;
+
+    if (list->nodes == list->inline_nodes)
+    {
+        new_nodes = ki_json_alloc(allocator, sizeof(*new_nodes) * new_capacity);
+
+        if (new_nodes != NULL)
+            memcpy(new_nodes, list->nodes, sizeof(*new_nodes) * list->count);
+    }
+    else
+    {
+        new_nodes = ki_json_realloc(allocator, list->nodes, sizeof(*new_nodes) * list->capacity, sizeof(*new_nodes) * new_capacity);
+    }
+
+    if (new_nodes == NULL)
+        return false;
+
+    list->nodes = new_nodes;
+    list->capacity = new_capacity;
+    list->nodes[list->count++] = val;
+
+    return true;
+}
+
+// Returns true on success, false on fail.
+static bool path_query_init(struct path_query* query, const struct ki_json_path* path, struct ki_json_val* root)
+{
+    query->path = path;
+    query->root = root;
+    query->json = NULL;
+    query->length = 0;
+    query->scanner = NULL;
+    query->parser = NULL;
+    query->err = KI_JSON_ERR_NONE;
+    query->stack = query->inline_stack;
+    query->descendants = query->inline_descendants;
+    query->descendant_count = 0;
+    query->descendant_capacity = PATH_INLINE_COUNT;
+
+    if (path->filter_depth > PATH_INLINE_COUNT)
+        query->stack = ki_json_alloc(path->allocator, sizeof(*query->stack) * path->filter_depth);
+
+    return query->stack != NULL;
+}
+
+static void path_query_fini(struct path_query* query)
+{
+    if (query->stack != query->inline_stack)
+        ki_json_dealloc(query->path->allocator, query->stack, sizeof(*query->stack) * query->path->filter_depth);
+
+    if (query->descendants != query->inline_descendants)
+        ki_json_dealloc(query->path->allocator, query->descendants, sizeof(*query->descendants) * query->descendant_capacity);
+}
+
+// Pushes val onto the query's stack of values left to look into.
+// Returns true on success, false on fail.
+static bool path_query_push(struct path_query* query, struct ki_json_val* val)
+{
+    if (query->descendant_count == query->descendant_capacity)
+    {
+        size_t new_capacity = query->descendant_capacity * 2;
+        struct ki_json_val** new_descendants = NULL;
+
+        if (query->descendants == query->inline_descendants)
+        {
+            new_descendants = ki_json_alloc(query->path->allocator, sizeof(*new_descendants) * new_capacity);
+
+            if (new_descendants != NULL)
+                memcpy(new_descendants, query->descendants, sizeof(*new_descendants) * query->descendant_count);
+        }
+        else
+        {
+            new_descendants = ki_json_realloc(query->path->allocator, query->descendants, sizeof(*new_descendants) * query->descendant_capacity, sizeof(*new_descendants) * new_capacity);
+        }
+
+        if (new_descendants == NULL)
+            return false;
+
+        query->descendants = new_descendants;
+        query->descendant_capacity = new_capacity;
+    }
+
+    query->descendants[query->descendant_count++] = val;
+
+    return true;
+}
+
+// Outs index of array of count values selected by index selector, counting from the end if negative.
+// Returns true if there is such a value, false otherwise.
+static bool path_index(int64_t selector, int64_t count, int64_t* index)
+{
+    *index = (selector >= 0) ? selector : count + selector;
+
+    return *index >= 0 && *index < count;
+}
+
+static int64_t path_clamp(int64_t value, int64_t min, int64_t max)
+{
+    return (value < min) ? min : ((value > max) ? max : value);
+}
+
+// Outs bounds of indices of array of count values selected by slice op (RFC 9535, 2.3.4.2.2).
+// Indices from lower up to upper (excluding upper) are selected for positive steps,
+// from upper down to lower (excluding lower) for negative ones.
+// Returns false if slice selects nothing (step 0), true otherwise.
+static bool path_slice_bounds(const struct path_op* op, int64_t count, int64_t* lower, int64_t* upper)
+{
+    int64_t step = op->arg.slice.step;
+    int64_t start = op->arg.slice.start;
+    int64_t end = op->arg.slice.end;
+
+    if (step == 0)
+        return false;
+
+    if (op->arg.slice.has_start && start < 0)
+        start += count;
+
+    if (op->arg.slice.has_end && end < 0)
+        end += count;
+
+    if (step > 0)
+    {
+        *lower = op->arg.slice.has_start ? path_clamp(start, 0, count) : 0;
+        *upper = op->arg.slice.has_end ? path_clamp(end, 0, count) : count;
+    }
+    else
+    {
+        *upper = op->arg.slice.has_start ? path_clamp(start, -1, count - 1) : count - 1;
+        *lower = op->arg.slice.has_end ? path_clamp(end, -1, count - 1) : -1;
+    }
+
+    return true;
+}
+
+// Whether slice op selects index of array of count values.
+static bool path_slice_has(const struct path_op* op, int64_t index, int64_t count)
+{
+    int64_t lower = 0;
+    int64_t upper = 0;
+    int64_t step = op->arg.slice.step;
+
+    if (!path_slice_bounds(op, count, &lower, &upper))
+        return false;
+
+    if (step > 0)
+        return index >= lower && index < upper && (index - lower) % step == 0;
+
+    return index > lower && index <= upper && (upper - index) % -step == 0;
+}
+
+// Returns value of json object or json array val selected by name or index op.
+// Returns NULL if there is none.
+static struct ki_json_val* path_step(const struct ki_json_path* path, const struct path_op* op, struct ki_json_val* val)
+{
+    if (op->type == PATH_OP_NAME)
+    {
+        size_t index = 0;
+
+        if (val->type != KI_JSON_VAL_OBJECT || !ki_json_object_find_hashed(&val->value.object, path_name(path, op), op->arg.name.length, op->arg.name.hash, &index))
+            return NULL;
+
+        return val->value.object.pairs[index].value;
+    }
+
+    int64_t index = 0;
+
+    if (val->type != KI_JSON_VAL_ARRAY || !path_index(op->arg.index, (int64_t)val->value.array.count, &index))
+        return NULL;
+
+    return ki_json_array_unpacked_at(&val->value.array, (size_t)index);
+}
+
+// Where a scanner is, see struct ki_json_scanner.
+struct path_position
+{
+    size_t offset;
+    size_t depth;
+    bool first;
+    bool done;
+};
+
+static struct path_position path_position_save(const struct ki_json_scanner* scanner)
+{
+    struct path_position position = {
+        .offset = scanner->offset,
+        .depth = scanner->depth,
+        .first = scanner->first,
+        .done = scanner->done
+    };
+
+    return position;
+}
+
+static void path_position_restore(struct ki_json_scanner* scanner, const struct path_position* position)
+{
+    scanner->offset = position->offset;
+    scanner->depth = position->depth;
+    scanner->first = position->first;
+    scanner->done = position->done;
+}
+
+// Counts values of json array scanner just started reading, going back to its start after.
+// Returns KI_JSON_ERR_NONE on success, the error reading fails with on fail.
+static enum ki_json_err_type path_count(struct ki_json_scanner* scanner, size_t* count)
+{
+    struct path_position position = path_position_save(scanner);
+    struct ki_json_scan_value value;
+    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
+    size_t end = 0;
+
+    *count = 0;
+
+    while ((err_type = ki_json_scan_next(scanner, &value)) == KI_JSON_ERR_NONE && value.event != KI_JSON_SCAN_END)
+    {
+        if (value.event != KI_JSON_SCAN_SCALAR && (err_type = ki_json_scan_skip(scanner, &end)) != KI_JSON_ERR_NONE)
+            break;
+
+        (*count)++;
+    }
+
+    path_position_restore(scanner, &position);
+
+    return err_type;
+}
+
+// Finds value singular query op refers to in the query's json text, skipping everything else, & parses it to val.
+// Outs NULL to val if there is none.
+// Returns KI_JSON_ERR_NONE on success, the error reading or parsing fails with on fail.
+static enum ki_json_err_type path_resolve_text(struct path_query* query, const struct path_op* op, struct ki_json_val** val)
+{
+    struct ki_json_scanner* scanner = query->scanner;
+    struct ki_json_scan_value value;
+    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
+    size_t end = 0;
+
+    *val = NULL;
+
+    ki_json_scanner_reset(scanner, query->json, query->length);
+
+    if ((err_type = ki_json_scan_next(scanner, &value)) != KI_JSON_ERR_NONE)
+        return err_type;
+
+    for (size_t j = 1; j <= op->length; j++)
+    {
+        const struct path_op* step = &op[j];
+        int64_t index = 0;
+
+        if (value.event != ((step->type == PATH_OP_NAME) ? KI_JSON_SCAN_OBJECT : KI_JSON_SCAN_ARRAY))
+            return KI_JSON_ERR_NONE;
+
+        if (step->type == PATH_OP_INDEX)
+        {
+            size_t count = SIZE_MAX;
+
+            if (step->arg.index < 0 && (err_type = path_count(scanner, &count)) != KI_JSON_ERR_NONE)
+                return err_type;
+
+            if (!path_index(step->arg.index, (count != SIZE_MAX) ? (int64_t)count : PATH_INT_MAX, &index))
+                return KI_JSON_ERR_NONE;
+        }
+
+        for (int64_t i = 0; true; i++)
+        {
+            if ((err_type = ki_json_scan_next(scanner, &value)) != KI_JSON_ERR_NONE)
+                return err_type;
+
+            if (value.event == KI_JSON_SCAN_END)
+                return KI_JSON_ERR_NONE;
+
+            bool found = (step->type == PATH_OP_NAME) ? (value.name_length == step->arg.name.length && memcmp(value.name, path_name(query->path, step), value.name_length) == 0)
+                                                      : (i == index);
+
+            if (found)
+                break;
+
+            if (value.event != KI_JSON_SCAN_SCALAR && (err_type = ki_json_scan_skip(scanner, &end)) != KI_JSON_ERR_NONE)
+                return err_type;
+        }
+    }
+
+    end = value.end;
+
+    if (value.event != KI_JSON_SCAN_SCALAR && (err_type = ki_json_scan_skip(scanner, &end)) != KI_JSON_ERR_NONE)
+        return err_type;
+
+    struct ki_json_parser_err err;
+    *val = ki_json_parser_parse(query->parser, query->json + value.start, end - value.start, &err);
+
+    return (*val != NULL) ? KI_JSON_ERR_NONE : err.type;
+}
+
+// Returns value singular query op refers to, starting at node or the root, NULL if there is none.
+// Outs whether it was parsed from the query's json text to owned, which is then to be freed once used.
+static struct ki_json_val* path_resolve(struct path_query* query, const struct path_op* op, struct ki_json_val* node, bool* owned)
+{
+    *owned = false;
+
+    if (query->json != NULL)
+    {
+        struct ki_json_val* val = NULL;
+        enum ki_json_err_type err_type = path_resolve_text(query, op, &val);
+
+        if (query->err == KI_JSON_ERR_NONE)
+            query->err = err_type;
+
+        *owned = (val != NULL);
+        return val;
+    }
+
+    struct ki_json_val* val = op->arg.absolute ? query->root : node;
+
+    for (size_t j = 1; j <= op->length && val != NULL; j++)
+        val = path_step(query->path, &op[j], val);
+
+    return val;
+}
+
+// Frees value on the stack of a filter if it was parsed for it.
+static void path_value_release(struct path_value* value)
+{
+    if (value->owned)
+        ki_json_val_free(value->val);
+
+    value->val = NULL;
+    value->owned = false;
+}
+
+// Whether json value a is less than json value b, only numbers & strings are ordered.
+static bool path_less(const struct ki_json_val* a, const struct ki_json_val* b)
+{
+    if (a == NULL || b == NULL || a->type != b->type)
+        return false;
+
+    if (a->type == KI_JSON_VAL_NUMBER)
+        return a->value.number < b->value.number;
+
+    if (a->type != KI_JSON_VAL_STRING)
+        return false;
+
+    //utf8 bytes are ordered like the code points they encode
+    size_t a_length = 0;
+    size_t b_length = 0;
+    const char* a_string = ki_json_val_get_stringn(a, &a_length);
+    const char* b_string = ki_json_val_get_stringn(b, &b_length);
+    int order = memcmp(a_string, b_string, (a_length < b_length) ? a_length : b_length);
+
+    return order < 0 || (order == 0 && a_length < b_length);
+}
+
+// Whether json values a & b are equal, either of them being NULL (no value) only equals the other being NULL too.
+static bool path_equal(struct ki_json_val* a, struct ki_json_val* b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+
+    return ki_json_val_equal(a, b);
+}
+
+// Runs filter op on json value node, returns whether it selects node.
+static bool path_filter(struct path_query* query, const struct path_op* filter, struct ki_json_val* node)
+{
+    struct path_value* stack = query->stack;
+    size_t top = 0;
+
+    for (size_t i = 1; i <= filter->length; i++)
+    {
+        const struct path_op* op = &filter[i];
+
+        switch (op->type)
+        {
+            case PATH_OP_LITERAL:
+                stack[top].val = op->arg.literal;
+                stack[top].owned = false;
+                top++;
+                break;
+            case PATH_OP_QUERY:
+                stack[top].val = path_resolve(query, op, node, &stack[top].owned);
+                top++;
+                i += op->length;
+                break;
+            case PATH_OP_EXISTS:
+                stack[top - 1].truth = (stack[top - 1].val != NULL);
+                path_value_release(&stack[top - 1]);
+                break;
+            case PATH_OP_NOT:
+                stack[top - 1].truth = !stack[top - 1].truth;
+                break;
+            case PATH_OP_AND:
+                top--;
+                stack[top - 1].truth = stack[top - 1].truth && stack[top].truth;
+                break;
+            case PATH_OP_OR:
+                top--;
+                stack[top - 1].truth = stack[top - 1].truth || stack[top].truth;
+                break;
+            default: //comparisons
+            {
+                top--;
+
+                struct ki_json_val* a = stack[top - 1].val;
+                struct ki_json_val* b = stack[top].val;
+                bool truth = false;
+
+                switch (op->type)
+                {
+                    case PATH_OP_EQ: truth = path_equal(a, b); break;
+                    case PATH_OP_NE: truth = !path_equal(a, b); break;
+                    case PATH_OP_LT: truth = path_less(a, b); break;
+                    case PATH_OP_LE: truth = path_less(a, b) || path_equal(a, b); break;
+                    case PATH_OP_GT: truth = path_less(b, a); break;
+                    default: truth = path_less(b, a) || path_equal(a, b); break; //PATH_OP_GE
+                }
+
+                path_value_release(&stack[top - 1]);
+                path_value_release(&stack[top]);
+                stack[top - 1].truth = truth;
+                break;
+            }
+        }
+    }
+
+    assert(top == 1);
+
+    return stack[0].truth;
+}
+
+// Adds values of json value node selected by selector op to out.
+// Returns true on success, false on fail.
+static bool path_select(struct path_query* query, const struct path_op* op, struct ki_json_val* node, struct path_list* out)
+{
+    const struct ki_json_allocator* allocator = query->path->allocator;
+
+    if (op->type == PATH_OP_NAME)
+    {
+        struct ki_json_val* val = path_step(query->path, op, node);
+
+        return val == NULL || path_list_add(out, allocator, val);
+    }
+
+    if (node->type == KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_object* object = &node->value.object;
+
+        if (op->type != PATH_OP_WILDCARD && op->type != PATH_OP_FILTER)
+            return true;
+
+        for (size_t i = 0; i < object->count; i++)
+        {
+            struct ki_json_val* val = object->pairs[i].value;
+
+            if ((op->type == PATH_OP_WILDCARD || path_filter(query, op, val)) && !path_list_add(out, allocator, val))
+                return false;
+        }
+
+        return true;
+    }
+
+    if (node->type != KI_JSON_VAL_ARRAY)
+        return true;
+
+    struct ki_json_array* array = &node->value.array;
+    int64_t count = (int64_t)array->count;
+    int64_t index = 0;
+    int64_t lower = 0;
+    int64_t upper = 0;
+
+    switch (op->type)
+    {
+        case PATH_OP_INDEX:
+        {
+            if (!path_index(op->arg.index, count, &index))
+                return true;
+
+            struct ki_json_val* val = ki_json_array_unpacked_at(array, (size_t)index);
+
+            return val != NULL && path_list_add(out, allocator, val);
+        }
+        case PATH_OP_SLICE:
+        {
+            if (!path_slice_bounds(op, count, &lower, &upper))
+                return true;
+
+            int64_t step = op->arg.slice.step;
+
+            for (index = (step > 0) ? lower : upper; (step > 0) ? index < upper : index > lower; index += step)
+            {
+                struct ki_json_val* val = ki_json_array_unpacked_at(array, (size_t)index);
+
+                if (val == NULL || !path_list_add(out, allocator, val))
+                    return false;
+            }
+
+            return true;
+        }
+        default: //PATH_OP_WILDCARD & PATH_OP_FILTER
+        {
+            for (index = 0; index < count; index++)
+            {
+                struct ki_json_val* val = ki_json_array_unpacked_at(array, (size_t)index);
+
+                if (val == NULL)
+                    return false;
+
+                if ((op->type == PATH_OP_WILDCARD || path_filter(query, op, val)) && !path_list_add(out, allocator, val))
+                    return false;
+            }
+
+            return true;
+        }
+    }
+}
+
+// Adds values of json value node selected by selectors of segment op to out.
+// Returns true on success, false on fail.
+static bool path_select_all(struct path_query* query, const struct path_op* segment, struct ki_json_val* node, struct path_list* out)
+{
+    for (size_t i = 1; i <= segment->length; i += 1 + segment[i].length)
+    {
+        if (!path_select(query, &segment[i], node, out))
+            return false;
+    }
+
+    return true;
+}
+
+// Adds values selected by segment op from the values of in to out.
+// Descendant segments look into each value & everything inside of it, the value before its values,
+// using the query's stack instead of recursing.
+// Returns true on success, false on fail.
+static bool path_segment(struct path_query* query, const struct path_op* segment, const struct path_list* in, struct path_list* out)
+{
+    for (size_t i = 0; i < in->count; i++)
+    {
+        if (segment->type == PATH_OP_CHILD)
+        {
+            if (!path_select_all(query, segment, in->nodes[i], out))
+                return false;
+
+            continue;
+        }
+
+        query->descendant_count = 0;
+
+        if (!path_query_push(query, in->nodes[i]))
+            return false;
+
+        while (query->descendant_count > 0)
+        {
+            struct ki_json_val* node = query->descendants[--query->descendant_count];
+
+            if (!path_select_all(query, segment, node, out))
+                return false;
+
+            //only json objects & json arrays have values to select from, packed numbers don't
+            if (node->type == KI_JSON_VAL_OBJECT)
+            {
+                struct ki_json_object* object = &node->value.object;
+
+                for (size_t j = object->count; j > 0; j--)
+                {
+                    struct ki_json_val* val = object->pairs[j - 1].value;
+
+                    if ((val->type == KI_JSON_VAL_OBJECT || val->type == KI_JSON_VAL_ARRAY) && !path_query_push(query, val))
+                        return false;
+                }
+            }
+            else if (node->type == KI_JSON_VAL_ARRAY && node->value.array.storage != KI_JSON_ARRAY_STORAGE_NUMBERS)
+            {
+                struct ki_json_array* array = &node->value.array;
+
+                for (size_t j = array->count; j > 0; j--)
+                {
+                    struct ki_json_val* val = ki_json_array_at(array, j - 1);
+
+                    if ((val->type == KI_JSON_VAL_OBJECT || val->type == KI_JSON_VAL_ARRAY) && !path_query_push(query, val))
+                        return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/* Streaming */
+
+// Json object or json array being read by ki_json_path_query_string().
+struct path_frame
+{
+    // Segments values inside of it may be selected by, bit k for segment k
+    uint64_t states;
+    // Index of the next value of json arrays
+    size_t index;
+    // Amount of values of json arrays, only counted if selectors need it (SIZE_MAX otherwise)
+    size_t count;
+    // Index of the container in matches if it was selected by the whole path, SIZE_MAX otherwise
+    size_t match;
+    bool is_array;
+};
+
+struct path_stream
+{
+    const struct ki_json_path* path;
+    const char* json;
+    struct ki_json_scanner scanner;
+    // Query running filters on values of json text, with its own scanner & its parser (created once needed)
+    struct path_query query;
+    struct ki_json_scanner query_scanner;
+
+    struct path_frame* frames;
+    size_t frame_count;
+    size_t frame_capacity;
+
+    struct ki_json_path_match* matches;
+    size_t capacity;
+    size_t count;
+
+    struct path_frame inline_frames[PATH_INLINE_COUNT];
+};
+
+// Pushes container the scanner just started reading onto the stream's stack.
+// Returns pushed frame on success, NULL on fail.
+static struct path_frame* stream_push(struct path_stream* stream, uint64_t states, size_t match, bool is_array)
+{
+    if (stream->frame_count == stream->frame_capacity)
+    {
+        size_t new_capacity = stream->frame_capacity * 2;
+        struct path_frame* new_frames = NULL;
+
+        if (stream->frames == stream->inline_frames)
+        {
+            new_frames = ki_json_alloc(stream->path->allocator, sizeof(*new_frames) * new_capacity);
+
+            if (new_frames != NULL)
+                memcpy(new_frames, stream->frames, sizeof(*new_frames) * stream->frame_count);
+        }
+        else
+        {
+            new_frames = ki_json_realloc(stream->path->allocator, stream->frames, sizeof(*new_frames) * stream->frame_capacity, sizeof(*new_frames) * new_capacity);
+        }
+
+        if (new_frames == NULL)
+            return NULL;
+
+        stream->frames = new_frames;
+        stream->frame_capacity = new_capacity;
+    }
+
+    struct path_frame* frame = &stream->frames[stream->frame_count++];
+    frame->states = states;
+    frame->index = 0;
+    frame->count = SIZE_MAX;
+    frame->match = match;
+    frame->is_array = is_array;
+
+    return frame;
+}
+
+// Sets length of match at index (SIZE_MAX for none) to end at offset end.
+static void stream_finish(struct path_stream* stream, size_t match, size_t end)
+{
+    if (match != SIZE_MAX)
+        stream->matches[match].length = end - stream->matches[match].offset;
+}
+
+// Returns segments value read inside of container frame matched, outs segments whose filters may select value to filters.
+static uint64_t stream_states(struct path_stream* stream, struct path_frame* frame, const struct ki_json_scan_value* value, uint64_t* filters)
+{
+    const struct ki_json_path* path = stream->path;
+    const size_t* segments = path_segments(path);
+
+    int64_t index = frame->is_array ? (int64_t)frame->index++ : 0;
+    int64_t count = (frame->count != SIZE_MAX) ? (int64_t)frame->count : PATH_INT_MAX;
+    uint64_t states = 0;
+
+    *filters = 0;
+
+    for (size_t k = 0; k < path->segment_count; k++)
+    {
+        if ((frame->states & ((uint64_t)1 << k)) == 0)
+            continue;
+
+        const struct path_op* segment = &path->ops[segments[k]];
+        bool selected = false;
+        bool filtered = false;
+
+        //descendant segments select from everything inside of the values they select from too
+        if (segment->type == PATH_OP_DESCENDANT)
+            states |= (uint64_t)1 << k;
+
+        for (size_t i = 1; i <= segment->length && !selected; i += 1 + segment[i].length)
+        {
+            const struct path_op* op = &segment[i];
+            int64_t selected_index = 0;
+
+            switch (op->type)
+            {
+                case PATH_OP_NAME:
+                    selected = !frame->is_array && value->name_length == op->arg.name.length && memcmp(value->name, path_name(path, op), value->name_length) == 0;
+                    break;
+                case PATH_OP_WILDCARD:
+                    selected = true;
+                    break;
+                case PATH_OP_INDEX:
+                    selected = frame->is_array && path_index(op->arg.index, count, &selected_index) && selected_index == index;
+                    break;
+                case PATH_OP_SLICE:
+                    selected = frame->is_array && path_slice_has(op, index, count);
+                    break;
+                default: //PATH_OP_FILTER
+                    filtered = true;
+                    break;
+            }
+        }
+
+        if (selected)
+            states |= (uint64_t)1 << (k + 1);
+        else if (filtered)
+            *filters |= (uint64_t)1 << k;
+    }
+
+    return states;
+}
+
+// Runs filters of segments given by filters on value of json text at offset start,
+// adding segments it is selected by to states.
+// Returns KI_JSON_ERR_NONE on success, the error reading or parsing fails with on fail.
+static enum ki_json_err_type stream_filter(struct path_stream* stream, uint64_t filters, size_t start, uint64_t* states)
+{
+    const struct ki_json_path* path = stream->path;
+    const size_t* segments = path_segments(path);
+    struct path_query* query = &stream->query;
+
+    if (query->parser == NULL && (query->parser = ki_json_parser_create(NULL)) == NULL)
+        return KI_JSON_ERR_MEMORY;
+
+    query->json = stream->json + start;
+    query->length = stream->scanner.length - start;
+
+    for (size_t k = 0; k < path->segment_count && query->err == KI_JSON_ERR_NONE; k++)
+    {
+        if ((filters & ((uint64_t)1 << k)) == 0)
+            continue;
+
+        const struct path_op* segment = &path->ops[segments[k]];
+
+        for (size_t i = 1; i <= segment->length; i += 1 + segment[i].length)
+        {
+            if (segment[i].type == PATH_OP_FILTER && path_filter(query, &segment[i], NULL))
+            {
+                *states |= (uint64_t)1 << (k + 1);
+                break;
+            }
+        }
+    }
+
+    return query->err;
+}
+
+// Whether selectors of any of the segments given by states need the amount of values of json arrays.
+static bool stream_needs_count(const struct ki_json_path* path, uint64_t states)
+{
+    const size_t* segments = path_segments(path);
+
+    for (size_t k = 0; k < path->segment_count; k++)
+    {
+        if ((states & ((uint64_t)1 << k)) != 0 && path->ops[segments[k]].arg.needs_count)
+            return true;
+    }
+
+    return false;
+}
+
+// Reads json text of the stream value by value, adding values selected by the whole path to its matches.
+// Returns KI_JSON_ERR_NONE on success, the error reading fails with on fail.
+static enum ki_json_err_type stream_run(struct path_stream* stream)
+{
+    const uint64_t selected = (uint64_t)1 << stream->path->segment_count;
+    struct ki_json_scan_value value;
+    enum ki_json_err_type err_type = KI_JSON_ERR_NONE;
+
+    while (true)
+    {
+        if ((err_type = ki_json_scan_next(&stream->scanner, &value)) != KI_JSON_ERR_NONE)
+            return err_type;
+
+        if (value.event == KI_JSON_SCAN_DONE)
+            return KI_JSON_ERR_NONE;
+
+        if (value.event == KI_JSON_SCAN_END)
+        {
+            stream->frame_count--;
+            stream_finish(stream, stream->frames[stream->frame_count].match, value.end);
+            continue;
+        }
+
+        //root value matched no segments yet
+        uint64_t states = 1;
+        uint64_t filters = 0;
+
+        if (stream->frame_count > 0)
+            states = stream_states(stream, &stream->frames[stream->frame_count - 1], &value, &filters);
+
+        size_t end = value.end;
+
+        if (filters != 0 && (err_type = stream_filter(stream, filters, value.start, &states)) != KI_JSON_ERR_NONE)
+            return err_type;
+
+        size_t match = SIZE_MAX;
+
+        if ((states & selected) != 0)
+        {
+            if (stream->count < stream->capacity)
+            {
+                match = stream->count;
+                stream->matches[match].offset = value.start;
+            }
+
+            stream->count++;
+        }
+
+        states &= ~selected;
+
+        if (value.event == KI_JSON_SCAN_SCALAR)
+        {
+            stream_finish(stream, match, value.end);
+            continue;
+        }
+
+        //nothing inside of it can be selected
+        if (states == 0)
+        {
+            if ((err_type = ki_json_scan_skip(&stream->scanner, &end)) != KI_JSON_ERR_NONE)
+                return err_type;
+
+            stream_finish(stream, match, end);
+            continue;
+        }
+
+        struct path_frame* frame = stream_push(stream, states, match, value.event == KI_JSON_SCAN_ARRAY);
+
+        if (frame == NULL)
+            return KI_JSON_ERR_MEMORY;
+
+        if (frame->is_array && stream_needs_count(stream->path, states) && (err_type = path_count(&stream->scanner, &frame->count)) != KI_JSON_ERR_NONE)
+            return err_type;
+    }
+}
+
+/* Public */
+
+// Compiles null-terminated JSONPath query, for ex.: "$.store.book[?@.price < 10].title".
+// Path must be freed using ki_json_path_free() when done.
+// Returns NULL on fail (invalid or unsupported query or allocation fail).
+struct ki_json_path* ki_json_path_compile(const char* path)
+{
+    assert(path);
+
+    return ki_json_path_compilen(path, strlen(path));
+}
+
+// Compiles JSONPath query of length bytes, see ki_json_path_compile().
+// Returns NULL on fail.
+struct ki_json_path* ki_json_path_compilen(const char* path, size_t length)
+{
+    assert(path || length == 0);
+
+    struct path_compiler compiler;
+    compiler_init(&compiler, path, length);
+
+    if (!compile_query(&compiler))
+    {
+        compiler_fini(&compiler);
+        return NULL;
+    }
+
+    size_t size = sizeof(struct ki_json_path) + sizeof(struct path_op) * compiler.op_count + sizeof(size_t) * compiler.segment_count + compiler.names_used;
+    struct ki_json_path* compiled = ki_json_alloc(compiler.allocator, size);
+
+    if (compiled == NULL)
+    {
+        compiler_fini(&compiler);
+        return NULL;
+    }
+
+    compiled->allocator = compiler.allocator;
+    compiled->size = size;
+    compiled->op_count = compiler.op_count;
+    compiled->segment_count = compiler.segment_count;
+    compiled->filter_depth = compiler.filter_depth;
+    compiled->absolute_filters = compiler.absolute_filters;
+
+    if (compiler.op_count > 0)
+        memcpy(compiled->ops, compiler.ops, sizeof(struct path_op) * compiler.op_count);
+
+    size_t* segments = (size_t*)path_segments(compiled);
+
+    for (size_t i = 0, k = 0; i < compiled->op_count; i += 1 + compiled->ops[i].length)
+        segments[k++] = i;
+
+    if (compiler.names_used > 0)
+        memcpy(&segments[compiled->segment_count], compiler.names, compiler.names_used);
+
+    //literals belong to the compiled path now
+    compiler.op_count = 0;
+    compiler_fini(&compiler);
+
+    return compiled;
+}
+
+void ki_json_path_free(struct ki_json_path* path)
+{
+    if (path == NULL)
+        return;
+
+    for (size_t i = 0; i < path->op_count; i++)
+    {
+        if (path->ops[i].type == PATH_OP_LITERAL)
+            ki_json_val_free(path->ops[i].arg.literal);
+    }
+
+    ki_json_dealloc(path->allocator, path, path->size);
+}
+
+// Runs compiled path on json tree val, outs the values it selects to results in the order RFC 9535 gives them.
+// Results has room for capacity values (may be NULL if 0), only the first capacity values are written.
+// Outs amount of values selected to count, which may be more than capacity.
+// NOTE: Looking up names may build hash indices of big json objects, like ki_json_object_get() does,
+// & numbers of packed arrays are unpacked when selected from (see KI_JSON_ARRAY_STORAGE_NUMBERS).
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_path_query(const struct ki_json_path* path, struct ki_json_val* val, struct ki_json_val** results, size_t capacity, size_t* count)
+{
+    assert(path && val && (results || capacity == 0) && count);
+
+    *count = 0;
+
+    struct path_query query;
+
+    if (!path_query_init(&query, path, val))
+        return KI_JSON_ERR_MEMORY;
+
+    //values selected by the last segment go right into results
+    struct path_list lists[2];
+    struct path_list output = { .nodes = results, .count = 0, .capacity = capacity, .bounded = true };
+    struct path_list* in = &lists[0];
+
+    path_list_init(&lists[0]);
+    path_list_init(&lists[1]);
+
+    bool success = path_list_add((path->segment_count > 0) ? in : &output, path->allocator, val);
+    const size_t* segments = path_segments(path);
+
+    for (size_t k = 0; k < path->segment_count && success && in->count > 0; k++)
+    {
+        struct path_list* out = (k + 1 < path->segment_count) ? ((in == &lists[0]) ? &lists[1] : &lists[0]) : &output;
+        out->count = 0;
+
+        success = path_segment(&query, &path->ops[segments[k]], in, out);
+        in = out;
+    }
+
+    path_list_fini(&lists[0], path->allocator);
+    path_list_fini(&lists[1], path->allocator);
+    path_query_fini(&query);
+
+    if (!success)
+        return KI_JSON_ERR_MEMORY;
+
+    *count = output.count;
+
+    return KI_JSON_ERR_NONE;
+}
+
+// Runs compiled path on json text of length bytes while reading it, without parsing it to a json tree.
+// Outs where the values it selects are in json to matches, see ki_json_path_query().
+// Values are skipped without being looked into once path can't select anything inside of them,
+// only values filters are run on are parsed (one at a time), as are json arrays counted for negative indices first.
+// NOTE 1: Values are matched once each in the order they appear in json, unlike in ki_json_path_query().
+// NOTE 2: Paths with more than 63 segments or filters referring to the root ("$") can't be run on json text,
+// failing with KI_JSON_ERR_INVALID_ARGS.
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_INVALID_ARGS, KI_JSON_ERR_MEMORY or the error parsing json fails with on fail.
+enum ki_json_err_type ki_json_path_query_string(const struct ki_json_path* path, const char* json, size_t length, struct ki_json_path_match* matches, size_t capacity, size_t* count)
+{
+    assert(path && (json || length == 0) && (matches || capacity == 0) && count);
+
+    *count = 0;
+
+    if (path->segment_count > PATH_STREAM_MAX_SEGMENTS || path->absolute_filters)
+        return KI_JSON_ERR_INVALID_ARGS;
+
+    struct path_stream stream;
+    stream.path = path;
+    stream.json = json;
+    stream.frames = stream.inline_frames;
+    stream.frame_count = 0;
+    stream.frame_capacity = PATH_INLINE_COUNT;
+    stream.matches = matches;
+    stream.capacity = capacity;
+    stream.count = 0;
+
+    if (!path_query_init(&stream.query, path, NULL))
+        return KI_JSON_ERR_MEMORY;
+
+    ki_json_scanner_init(&stream.scanner, json, length);
+    ki_json_scanner_init(&stream.query_scanner, NULL, 0);
+    stream.query.scanner = &stream.query_scanner;
+
+    enum ki_json_err_type err_type = stream_run(&stream);
+
+    ki_json_scanner_fini(&stream.scanner);
+    ki_json_scanner_fini(&stream.query_scanner);
+    ki_json_parser_free(stream.query.parser);
+    path_query_fini(&stream.query);
+
+    if (stream.frames != stream.inline_frames)
+        ki_json_dealloc(path->allocator, stream.frames, sizeof(*stream.frames) * stream.frame_capacity);
+
+    if (err_type != KI_JSON_ERR_NONE)
+        return err_type;
+
+    *count = stream.count;
+
+    return KI_JSON_ERR_NONE;
+}
@@ -0,0 +1,387 @@
+#include "ki_json/json_pointer.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ki_json/json.h"
+#include "json/json_internal.h"
+
+// Index of reference tokens that aren't array indices
+#define POINTER_INDEX_NONE SIZE_MAX
+// Index of "-", the value past the last one of an array
+#define POINTER_INDEX_END (SIZE_MAX - 1)
+
+struct pointer_token
+{
+    // Name, unescaped & null-terminated
+    const char* name;
+    size_t name_length;
+    // Hash of name, see ki_json_hash_bytes()
+    size_t hash;
+    // Index for json arrays, POINTER_INDEX_NONE or POINTER_INDEX_END otherwise
+    size_t index;
+    // Index of the pair the name was last found at, tried first as documents tend to share their layout
+    // NOTE: Only a hint, read & written atomically by any thread resolving the pointer.
+    size_t hint;
+};
+
+// Compiled JSON Pointer, a single allocation holding its tokens followed by their names.
+struct ki_json_pointer
+{
+    const struct ki_json_allocator* allocator;
+    // Size of the allocation in bytes
+    size_t size;
+    size_t count;
+    struct pointer_token tokens[];
+};
+
+/* Compiling */
+
+// Returns index given by name of name_length bytes, digits without leading zeros or "-".
+static size_t pointer_index(const char* name, size_t name_length)
+{
+    if (name_length == 1 && name[0] == '-')
+        return POINTER_INDEX_END;
+
+    if (name_length == 0 || (name[0] == '0' && name_length > 1))
+        return POINTER_INDEX_NONE;
+
+    size_t index = 0;
+
+    for (size_t i = 0; i < name_length; i++)
+    {
+        //indices this big can't be in any array anyway
+        if (name[i] < '0' || name[i] > '9' || index >= (POINTER_INDEX_END - 9) / 10)
+            return POINTER_INDEX_NONE;
+
+        index = index * 10 + (size_t)(name[i] - '0');
+    }
+
+    return index;
+}
+
+// Unescapes reference token of token_length bytes ("~1" as '/' & "~0" as '~') into names, null-terminating it.
+// Returns length of name on success, SIZE_MAX for invalid escapes.
+static size_t pointer_unescape(const char* token, size_t token_length, char* names)
+{
+    size_t length = 0;
+
+    for (size_t i = 0; i < token_length; i++)
+    {
+        if (token[i] != '~')
+        {
+            names[length++] = token[i];
+            continue;
+        }
+
+        if (i + 1 == token_length || (token[i + 1] != '0' && token[i + 1] != '1'))
+            return SIZE_MAX;
+
+        names[length++] = (token[++i] == '0') ? '~' : '/';
+    }
+
+    names[length] = '\0';
+
+    return length;
+}
+
+/* Resolving */
+
+// Finds index of pair with the name of token in json object, trying the pair it was last found at first.
+// Returns true on success, false if there's no such pair.
+static bool pointer_find(const struct pointer_token* token, struct ki_json_object* object, size_t* index)
+{
+    //hints are shared by all threads resolving the pointer, which is const to them otherwise
+    size_t* hint = (size_t*)&token->hint;
+    size_t last = __atomic_load_n(hint, __ATOMIC_RELAXED);
+
+    if (last < object->count)
+    {
+        const struct ki_json_pair* pair = &object->pairs[last];
+
+        if (pair->hash == token->hash && pair->name_length == token->name_length && memcmp(pair->name, token->name, token->name_length) == 0)
+        {
+            *index = last;
+            return true;
+        }
+    }
+
+    if (!ki_json_object_find_hashed(object, token->name, token->name_length, token->hash, index))
+        return false;
+
+    __atomic_store_n(hint, *index, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+// Returns value of json object or json array val referred to by token.
+// If change is true, a shared value is replaced with a copy first (see ki_json_object_get_mut()).
+// Returns NULL if there is none (err is KI_JSON_ERR_PATH_NOT_FOUND) or on fail (err is KI_JSON_ERR_MEMORY).
+static struct ki_json_val* pointer_child(const struct pointer_token* token, struct ki_json_val* val, bool change, enum ki_json_err_type* err)
+{
+    *err = KI_JSON_ERR_PATH_NOT_FOUND;
+
+    if (val->type == KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_object* object = &val->value.object;
+        size_t index = 0;
+
+        if (!pointer_find(token, object, &index))
+            return NULL;
+
+        struct ki_json_val* child = object->pairs[index].value;
+
+        if (change && ki_json_val_is_shared(child))
+        {
+            child = ki_json_val_unshare(child);
+
+            if (child == NULL)
+            {
+                *err = KI_JSON_ERR_MEMORY;
+                return NULL;
+            }
+
+            object->pairs[index].value = child;
+        }
+
+        *err = KI_JSON_ERR_NONE;
+        return child;
+    }
+
+    //indices of other tokens are never below count
+    if (val->type != KI_JSON_VAL_ARRAY || token->index >= val->value.array.count)
+        return NULL;
+
+    struct ki_json_val* child = change ? ki_json_array_at_mut(&val->value.array, token->index) : ki_json_array_unpacked_at(&val->value.array, token->index);
+
+    *err = (child != NULL) ? KI_JSON_ERR_NONE : KI_JSON_ERR_MEMORY;
+    return child;
+}
+
+// Returns json object or json array holding the value referred to by the last token of pointer in json tree *val,
+// replacing shared values on the way with copies first.
+// Returns NULL if there is none (err is KI_JSON_ERR_PATH_NOT_FOUND) or on fail (err is KI_JSON_ERR_MEMORY).
+static struct ki_json_val* pointer_parent_mut(const struct ki_json_pointer* pointer, struct ki_json_val** val, enum ki_json_err_type* err)
+{
+    assert(pointer->count > 0);
+
+    struct ki_json_val* parent = ki_json_val_unshare(*val);
+
+    if (parent == NULL)
+    {
+        *err = KI_JSON_ERR_MEMORY;
+        return NULL;
+    }
+
+    *val = parent;
+
+    for (size_t i = 0; i + 1 < pointer->count && parent != NULL; i++)
+    {
+        //packed numbers hold no values to look into
+        if (parent->type == KI_JSON_VAL_ARRAY && parent->value.array.storage == KI_JSON_ARRAY_STORAGE_NUMBERS)
+        {
+            *err = KI_JSON_ERR_PATH_NOT_FOUND;
+            return NULL;
+        }
+
+        parent = pointer_child(&pointer->tokens[i], parent, true, err);
+    }
+
+    if (parent != NULL && parent->type != KI_JSON_VAL_OBJECT && parent->type != KI_JSON_VAL_ARRAY)
+    {
+        *err = KI_JSON_ERR_PATH_NOT_FOUND;
+        return NULL;
+    }
+
+    return parent;
+}
+
+/* Public */
+
+// Compiles null-terminated JSON Pointer, for ex.: "/a/b/0/c" ("" refers to the whole tree).
+// Pointer must be freed using ki_json_pointer_free() when done.
+// Returns NULL on fail (invalid pointer or allocation fail).
+struct ki_json_pointer* ki_json_pointer_compile(const char* pointer)
+{
+    assert(pointer);
+
+    return ki_json_pointer_compilen(pointer, strlen(pointer));
+}
+
+// Compiles JSON Pointer of length bytes, see ki_json_pointer_compile().
+// Returns NULL on fail.
+struct ki_json_pointer* ki_json_pointer_compilen(const char* pointer, size_t length)
+{
+    assert(pointer || length == 0);
+
+    //every token starts with '/'
+    if (length > 0 && pointer[0] != '/')
+        return NULL;
+
+    size_t count = 0;
+
+    for (size_t i = 0; i < length; i++)
+        count += (pointer[i] == '/');
+
+    //names take no more than the pointer itself, with a null-terminator instead of each '/'
+    size_t size = sizeof(struct ki_json_pointer) + sizeof(struct pointer_token) * count + length;
+    const struct ki_json_allocator* allocator = ki_json_allocator_resolve(NULL);
+    struct ki_json_pointer* compiled = ki_json_alloc(allocator, size);
+
+    if (compiled == NULL)
+        return NULL;
+
+    compiled->allocator = allocator;
+    compiled->size = size;
+    compiled->count = count;
+
+    char* names = (char*)&compiled->tokens[count];
+    size_t start = 1;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const char* slash = memchr(pointer + start, '/', length - start);
+        size_t end = (slash != NULL) ? (size_t)(slash - pointer) : length;
+
+        struct pointer_token* token = &compiled->tokens[i];
+        token->name = names;
+        token->name_length = pointer_unescape(pointer + start, end - start, names);
+
+        if (token->name_length == SIZE_MAX)
+        {
+            ki_json_dealloc(allocator, compiled, size);
+            return NULL;
+        }
+
+        token->hash = ki_json_hash_bytes(token->name, token->name_length);
+        token->index = pointer_index(token->name, token->name_length);
+        token->hint = 0;
+
+        names += token->name_length + 1;
+        start = end + 1;
+    }
+
+    return compiled;
+}
+
+void ki_json_pointer_free(struct ki_json_pointer* pointer)
+{
+    if (pointer == NULL)
+        return;
+
+    ki_json_dealloc(pointer->allocator, pointer, pointer->size);
+}
+
+// Returns amount of reference tokens of compiled pointer, 0 for the whole tree.
+size_t ki_json_pointer_count(const struct ki_json_pointer* pointer)
+{
+    assert(pointer);
+
+    return pointer->count;
+}
+
+// Returns val referred to by compiled pointer in json tree val.
+// NOTE: Looking up names may build hash indices of big json objects, like ki_json_object_get() does,
+// & numbers of packed arrays are unpacked (see KI_JSON_ARRAY_STORAGE_NUMBERS).
+// Returns NULL if there is none.
+struct ki_json_val* ki_json_pointer_get(const struct ki_json_pointer* pointer, struct ki_json_val* val)
+{
+    assert(pointer && val);
+
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+
+    for (size_t i = 0; i < pointer->count && val != NULL; i++)
+    {
+        //packed numbers are only unpacked for values that are there
+        if (val->type == KI_JSON_VAL_ARRAY && val->value.array.storage == KI_JSON_ARRAY_STORAGE_NUMBERS && i + 1 < pointer->count)
+            return NULL;
+
+        val = pointer_child(&pointer->tokens[i], val, false, &err);
+    }
+
+    return val;
+}
+
+// Sets val referred to by compiled pointer in json tree *val to value, adding it if there is none yet.
+// Json objects get a pair with the name added, json arrays get value added to their end for "-" or an index equal to their count.
+// Shared values on the way are replaced with copies first (see ki_json_object_get_mut()).
+// NOTE 1: Ownership of value is given to the tree, and will be freed once done. Value is left to the caller on fail.
+// NOTE 2: *val is replaced if pointer refers to the whole tree or it is shared (see ki_json_val_unshare()).
+// Returns KI_JSON_ERR_NONE on success, KI_JSON_ERR_PATH_NOT_FOUND, KI_JSON_ERR_OUT_OF_BOUNDS or KI_JSON_ERR_MEMORY on fail.
+enum ki_json_err_type ki_json_pointer_set(const struct ki_json_pointer* pointer, struct ki_json_val** val, struct ki_json_val* value)
+{
+    assert(pointer && val && *val && value);
+
+    if (pointer->count == 0)
+    {
+        if (*val != value)
+            ki_json_val_free(*val);
+
+        *val = value;
+        return KI_JSON_ERR_NONE;
+    }
+
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+    struct ki_json_val* parent = pointer_parent_mut(pointer, val, &err);
+
+    if (parent == NULL)
+        return err;
+
+    const struct pointer_token* token = &pointer->tokens[pointer->count - 1];
+
+    if (parent->type == KI_JSON_VAL_OBJECT)
+    {
+        struct ki_json_object* object = &parent->value.object;
+        size_t index = 0;
+
+        if (!pointer_find(token, object, &index))
+            return ki_json_object_addn(object, token->name, token->name_length, value);
+
+        if (object->pairs[index].value != value)
+            ki_json_val_free(object->pairs[index].value);
+
+        object->pairs[index].value = value;
+
+        return KI_JSON_ERR_NONE;
+    }
+
+    struct ki_json_array* array = &parent->value.array;
+
+    if (token->index == POINTER_INDEX_END || token->index == array->count)
+        return ki_json_array_add(array, value);
+
+    if (token->index == POINTER_INDEX_NONE)
+        return KI_JSON_ERR_PATH_NOT_FOUND;
+
+    return ki_json_array_set(array, token->index, value);
+}
+
+// Removes val referred to by compiled pointer from json tree *val.
+// Shared values on the way are replaced with copies first (see ki_json_object_get_mut()).
+// NOTE 1: The whole tree can't be removed.
+// NOTE 2: *val is replaced if it is shared (see ki_json_val_unshare()).
+// Returns true on success, false on fail.
+bool ki_json_pointer_remove(const struct ki_json_pointer* pointer, struct ki_json_val** val)
+{
+    assert(pointer && val && *val);
+
+    if (pointer->count == 0)
+        return false;
+
+    enum ki_json_err_type err = KI_JSON_ERR_NONE;
+    struct ki_json_val* parent = pointer_parent_mut(pointer, val, &err);
+
+    if (parent == NULL)
+        return false;
+
+    const struct pointer_token* token = &pointer->tokens[pointer->count - 1];
+
+    if (parent->type == KI_JSON_VAL_OBJECT)
+        return ki_json_object_removen(&parent->value.object, token->name, token->name_length);
+
+    //indices of other tokens are never below count
+    return token->index < parent->value.array.count && ki_json_array_remove_at(&parent->value.array, token->index);
+}